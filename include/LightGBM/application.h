@@ -43,6 +43,12 @@ class Application {
   /*! \brief Load data, including training data and validation data*/
   void LoadData();
 
+  /*!
+  * \brief Initial scores of continued training computed from the bins of a dataset,
+  *        read from or written to the cache file if init_score_cache is enabled
+  */
+  void PredictInitScoreOnBins(const Dataset* dataset, double* init_score) const;
+
   /*! \brief Initialization before training*/
   void InitTrain();
 
@@ -58,6 +64,12 @@ class Application {
   /*! \brief Main Convert model logic */
   void ConvertModel();
 
+  /*! \brief Main Compact model logic */
+  void CompactModel();
+
+  /*! \brief Predict leaf indices of data, writing them to the output result file */
+  std::vector<std::vector<int>> PredictLeafIndex();
+
   /*! \brief All configs */
   Config config_;
   /*! \brief Training data */
@@ -81,6 +93,9 @@ inline void Application::Run() {
     Predict();
   } else if (config_.task == TaskType::kConvertModel) {
     ConvertModel();
+  } else if (config_.task == TaskType::kCompactModel) {
+    InitPredict();
+    CompactModel();
   } else {
     InitTrain();
     Train();
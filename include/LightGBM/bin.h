@@ -338,6 +338,11 @@ class Bin {
   */
   virtual size_t SizesInByte() const = 0;
 
+  /*!
+  * \brief Get sizes in byte of the data in memory, the same as SizesInByte unless the layouts differ
+  */
+  virtual size_t MemorySizesInByte() const { return SizesInByte(); }
+
   /*! \brief Number of all data */
   virtual data_size_t num_data() const = 0;
 
@@ -385,6 +390,24 @@ class Bin {
   virtual void ConstructHistogram(data_size_t start, data_size_t end,
                                   const score_t* ordered_gradients, HistogramBinEntry* out) const = 0;
 
+  /*!
+  * \brief Construct histogram of the data in [start, end) with leaf_ids[i] == leaf_id, by a sequential masked scan
+  *        that reads the gradients in place, without data indices
+  * \param leaf_ids Leaf id of each data
+  * \param leaf_id Leaf id of the used data
+  * \param start start index of data
+  * \param end end index of data
+  * \param gradients Pointer to gradients, the i-th data's gradient is gradients[i]
+  * \param hessians Pointer to hessians, the i-th data's hessian is hessians[i]
+  * \param out Output Result
+  */
+  virtual void ConstructHistogramOfLeafId(const uint8_t* leaf_ids, uint8_t leaf_id, data_size_t start, data_size_t end,
+                                          const score_t* gradients, const score_t* hessians,
+                                          HistogramBinEntry* out) const = 0;
+
+  virtual void ConstructHistogramOfLeafId(const uint8_t* leaf_ids, uint8_t leaf_id, data_size_t start, data_size_t end,
+                                          const score_t* gradients, HistogramBinEntry* out) const = 0;
+
   /*!
   * \brief Split data according to threshold, if bin <= threshold, will put into left(lte_indices), else put into right(gt_indices)
   * \param min_bin min_bin of current used feature
@@ -441,19 +464,21 @@ class Bin {
   * \param sparse_rate Sparse rate of this bins( num_bin0/num_data )
   * \param is_enable_sparse True if enable sparse feature
   * \param sparse_threshold Threshold for treating a feature as a sparse feature
+  * \param is_enable_bitmap True if enable bitmaps for dense bins with 2 bins
   * \param is_sparse Will set to true if this bin is sparse
   * \return The bin data object
   */
   static Bin* CreateBin(data_size_t num_data, int num_bin,
-    double sparse_rate, bool is_enable_sparse, double sparse_threshold, bool* is_sparse);
+    double sparse_rate, bool is_enable_sparse, double sparse_threshold, bool is_enable_bitmap, bool* is_sparse);
 
   /*!
   * \brief Create object for bin data of one feature, used for dense feature
   * \param num_data Total number of data
   * \param num_bin Number of bin
+  * \param is_enable_bitmap True if enable bitmaps when num_bin <= 2
   * \return The bin data object
   */
-  static Bin* CreateDenseBin(data_size_t num_data, int num_bin);
+  static Bin* CreateDenseBin(data_size_t num_data, int num_bin, bool is_enable_bitmap);
 
   /*!
   * \brief Create object for bin data of one feature, used for sparse feature
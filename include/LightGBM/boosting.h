@@ -76,6 +76,28 @@ class LIGHTGBM_EXPORT Boosting {
   */
   virtual void RefitTree(const std::vector<std::vector<int>>& tree_leaf_prediction) = 0;
 
+  /*!
+  * \brief Make the model smaller and faster to predict, keeping the predictions of the whole model.
+  *        Merges sibling leaves with equal outputs, folds constant iterations and iterations with the same tree
+  *        structures into earlier ones, and renumbers the nodes of each tree by visit frequency.
+  *        Leaf indices and predictions with a limited number of iterations change
+  * \param tree_leaf_prediction Leaf index of each tree for sample records to count visits, the data counts saved in the trees are used if empty
+  * \return Number of removed iterations
+  */
+  virtual int CompactModel(const std::vector<std::vector<int>>& tree_leaf_prediction) = 0;
+
+  /*!
+  * \brief Get the current and peak sizes in byte of the dataset, the learner buffers and the model as JSON
+  * \return JSON object keyed by component name, each with ``current`` and ``peak`` sizes in byte
+  */
+  virtual std::string MemoryUsageToJSON() const = 0;
+
+  /*!
+  * \brief Get the counts of the decisions made by the tree learner since it was created as JSON
+  * \return JSON object keyed by name, empty without training data
+  */
+  virtual std::string TrainingStatsToJSON() const = 0;
+
   /*!
   * \brief Training logic
   * \param gradients nullptr for using default objective, otherwise use self-defined boosting
@@ -84,11 +106,34 @@ class LIGHTGBM_EXPORT Boosting {
   */
   virtual bool TrainOneIter(const score_t* gradients, const score_t* hessians) = 0;
 
+  /*!
+  * \brief Get the internal buffers of gradients and Hessians for training data,
+  *        self-defined boosting can fill them in place and pass them to TrainOneIter
+  * \param out_gradients Pointer to the gradients buffer
+  * \param out_hessians Pointer to the Hessians buffer
+  * \return Length of each buffer
+  */
+  virtual int64_t GetGradientBuffers(score_t** out_gradients, score_t** out_hessians) = 0;
+
   /*!
   * \brief Rollback one iteration
   */
   virtual void RollbackOneIter() = 0;
 
+  /*!
+  * \brief Output metrics of the current iteration and check early stopping,
+  *        when it is met the trees of the last early_stopping_round iterations are rolled back
+  * \return True if early stopping is met
+  */
+  virtual bool EvalAndCheckEarlyStopping() = 0;
+
+  /*!
+  * \brief Resume training from the latest checkpoint all machines have, when checkpoint_freq > 0.
+  *        Should be called after all validation data are added
+  * \return True if resumed
+  */
+  virtual bool ResumeFromCheckpoint() = 0;
+
   /*!
   * \brief return current iteration
   */
@@ -134,6 +179,12 @@ class LIGHTGBM_EXPORT Boosting {
   virtual void PredictRaw(const double* features, double* output,
                           const PredictionEarlyStopInstance* early_stop) const = 0;
 
+  /*!
+  * \brief Prediction for one record of float32 feature values, gives the same result as the double one
+  */
+  virtual void PredictRaw(const float* features, double* output,
+                          const PredictionEarlyStopInstance* early_stop) const = 0;
+
   virtual void PredictRawByMap(const std::unordered_map<int, double>& features, double* output,
                                const PredictionEarlyStopInstance* early_stop) const = 0;
 
@@ -147,6 +198,9 @@ class LIGHTGBM_EXPORT Boosting {
   virtual void Predict(const double* features, double* output,
                        const PredictionEarlyStopInstance* early_stop) const = 0;
 
+  virtual void Predict(const float* features, double* output,
+                       const PredictionEarlyStopInstance* early_stop) const = 0;
+
   virtual void PredictByMap(const std::unordered_map<int, double>& features, double* output,
                             const PredictionEarlyStopInstance* early_stop) const = 0;
 
@@ -159,6 +213,9 @@ class LIGHTGBM_EXPORT Boosting {
   virtual void PredictLeafIndex(
     const double* features, double* output) const = 0;
 
+  virtual void PredictLeafIndex(
+    const float* features, double* output) const = 0;
+
   virtual void PredictLeafIndexByMap(
     const std::unordered_map<int, double>& features, double* output) const = 0;
 
@@ -171,6 +228,51 @@ class LIGHTGBM_EXPORT Boosting {
   virtual void PredictContrib(const double* features, double* output,
                               const PredictionEarlyStopInstance* early_stop) const = 0;
 
+  /*!
+  * \brief Initial work for the prediction on pre-binned features. The bins of each feature are derived
+  *        from all split thresholds of the model, so integer comparisons give the same decisions.
+  *        The tables are only rebuilt after the model changed
+  * \param num_iteration number of used iteration
+  */
+  virtual void InitPredictByBins(int num_iteration) = 0;
+
+  /*!
+  * \brief Get upper bounds of the bins of one feature for pre-binned prediction, valid after InitPredictByBins.
+  *        Value x falls in the first bin with x <= upper bound, or in bin out_bounds->size() if larger than all,
+  *        NaN falls in bin out_bounds->size() + 1
+  * \param feature_idx Index of feature
+  * \param out_bounds Sorted upper bounds of bins
+  * \return False if the feature is categorical, whose category is used as its bin
+  */
+  virtual bool GetFeatureBinUpperBounds(int feature_idx, std::vector<double>* out_bounds) const = 0;
+
+  /*!
+  * \brief Prediction for one record of pre-binned features, not sigmoid transform
+  * \param feature_bins Bin of each feature on this record
+  * \param output Prediction result for this record
+  */
+  virtual void PredictRawByBins(const uint16_t* feature_bins, double* output) const = 0;
+
+  virtual void PredictByBins(const uint16_t* feature_bins, double* output) const = 0;
+
+  virtual void PredictLeafIndexByBins(const uint16_t* feature_bins, double* output) const = 0;
+
+  /*!
+  * \brief Check if all models can be evaluated exactly on the bins of a dataset, which holds when every split
+  *        threshold is a bin boundary, e.g. when continuing training on the data binned the same way as the model.
+  *        The models mapped to the bins are kept for PredictRawOnDatasetBins
+  * \param data Dataset with constructed bin mappers
+  */
+  virtual bool CanPredictOnDatasetBins(const Dataset* data) = 0;
+
+  /*!
+  * \brief Raw prediction of all models for all records of a dataset, evaluated on its bins, not sigmoid transform.
+  *        Should only be called if CanPredictOnDatasetBins returns true, releases the models it mapped
+  * \param data Dataset
+  * \param out_score Prediction result, num_data * num_tree_per_iteration, class major
+  */
+  virtual void PredictRawOnDatasetBins(const Dataset* data, double* out_score) = 0;
+
   /*!
   * \brief Dump model to json format string
   * \param start_iteration The model will be saved start from
@@ -252,6 +354,12 @@ class LIGHTGBM_EXPORT Boosting {
   */
   virtual int NumberOfTotalModel() const = 0;
 
+  /*!
+  * \brief Get version of the model, which changes whenever the sub-models are changed
+  * \return Version of the model
+  */
+  virtual int64_t ModelVersion() const = 0;
+
   /*!
   * \brief Get number of models per iteration
   * \return Number of models per iteration
@@ -274,6 +382,21 @@ class LIGHTGBM_EXPORT Boosting {
   */
   virtual void InitPredict(int num_iteration, bool is_pred_contrib) = 0;
 
+  /*!
+  * \brief Initial work for the prediction on sparse records by map. Caches the leaf of each tree
+  *        when all its features are zero and the trees of each feature, so only the trees
+  *        touched by the features of a record need to be traversed.
+  *        The caches are only rebuilt after the model changed
+  */
+  virtual void InitPredictByMap() = 0;
+
+  /*!
+  * \brief Split the trees of a single record prediction over threads, for large models.
+  *        Only applies out of parallel regions and without early stopping
+  * \param min_num_trees Minimal number of used trees to predict by tree parallel, <= 0 means never
+  */
+  virtual void InitPredictTreeParallel(int min_num_trees) = 0;
+
   /*!
   * \brief Name of submodel
   */
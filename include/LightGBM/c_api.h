@@ -27,12 +27,21 @@ typedef void* BoosterHandle;  /*!< \brief Handle of booster. */
 #define C_API_DTYPE_INT32   (2)  /*!< \brief int32. */
 #define C_API_DTYPE_INT64   (3)  /*!< \brief int64. */
 #define C_API_DTYPE_INT8    (4)  /*!< \brief int8. */
+#define C_API_DTYPE_UINT8   (5)  /*!< \brief uint8. */
+#define C_API_DTYPE_UINT16  (6)  /*!< \brief uint16. */
 
 #define C_API_PREDICT_NORMAL     (0)  /*!< \brief Normal prediction, with transform (if needed). */
 #define C_API_PREDICT_RAW_SCORE  (1)  /*!< \brief Predict raw score. */
 #define C_API_PREDICT_LEAF_INDEX (2)  /*!< \brief Predict leaf index. */
 #define C_API_PREDICT_CONTRIB    (3)  /*!< \brief Predict feature contributions (SHAP values). */
 
+#define C_API_TRAINING_IDLE          (0)  /*!< \brief No background training was started. */
+#define C_API_TRAINING_RUNNING       (1)  /*!< \brief Background training is in progress. */
+#define C_API_TRAINING_FINISHED      (2)  /*!< \brief All iterations are done or no more splits can be made. */
+#define C_API_TRAINING_EARLY_STOPPED (3)  /*!< \brief Early stopping was met, the model is rolled back to the best iteration. */
+#define C_API_TRAINING_CANCELLED     (4)  /*!< \brief Training was cancelled at an iteration boundary. */
+#define C_API_TRAINING_FAILED        (5)  /*!< \brief Training stopped with an error. */
+
 /*!
  * \brief Get string message of the last error.
  * \return Error information
@@ -310,7 +319,8 @@ LIGHTGBM_C_EXPORT int LGBM_DatasetDumpText(DatasetHandle handle,
  * \brief Set vector to a content in info.
  * \note
  * - \a group only works for ``C_API_DTYPE_INT32``;
- * - \a label and \a weight only work for ``C_API_DTYPE_FLOAT32``;
+ * - \a label and \a weight work for ``C_API_DTYPE_FLOAT32`` and ``C_API_DTYPE_FLOAT64``,
+ *   double values are converted directly into the internal storage;
  * - \a init_score only works for ``C_API_DTYPE_FLOAT64``.
  * \param handle Handle of dataset
  * \param field_name Field name, can be \a label, \a weight, \a init_score, \a group
@@ -495,6 +505,27 @@ LIGHTGBM_C_EXPORT int LGBM_BoosterRefit(BoosterHandle handle,
                                         int32_t nrow,
                                         int32_t ncol);
 
+/*!
+ * \brief Make the model smaller and faster to predict, keeping the predictions of the whole model.
+ *        Sibling leaves with equal outputs are merged, constant iterations and iterations with the same tree structures
+ *        are folded into earlier ones, and the nodes of each tree are renumbered by visit frequency.
+ *        Use ``LGBM_BoosterSaveModelToString`` or ``LGBM_BoosterSaveModel`` to get the compacted model.
+ * \note
+ * Leaf indices and predictions with a limited number of iterations change.
+ * \param handle Handle of booster
+ * \param leaf_preds Pointer to predicted leaf indices of sample rows, used to count visits of nodes;
+ *                   can be ``NULL`` to use the data counts saved in the model
+ * \param nrow Number of rows of ``leaf_preds``
+ * \param ncol Number of columns of ``leaf_preds``
+ * \param[out] out_num_removed_iterations Number of iterations folded into others
+ * \return 0 when succeed, -1 when failure happens
+ */
+LIGHTGBM_C_EXPORT int LGBM_BoosterCompactModel(BoosterHandle handle,
+                                               const int32_t* leaf_preds,
+                                               int32_t nrow,
+                                               int32_t ncol,
+                                               int* out_num_removed_iterations);
+
 /*!
  * \brief Update the model by specifying gradient and Hessian directly
  *        (this can be used to support customized loss functions).
@@ -509,6 +540,112 @@ LIGHTGBM_C_EXPORT int LGBM_BoosterUpdateOneIterCustom(BoosterHandle handle,
                                                       const float* hess,
                                                       int* is_finished);
 
+/*!
+ * \brief Update the model by specifying double precision gradient and Hessian directly.
+ * \note
+ * Unlike ``LGBM_BoosterUpdateOneIterCustom``, no intermediate float arrays are needed on the caller side:
+ * the values are converted straight into the internal gradient buffers of the booster.
+ * \param handle Handle of booster
+ * \param grad The first order derivative (gradient) statistics, length ``num_class * num_data``
+ * \param hess The second order derivative (Hessian) statistics, length ``num_class * num_data``
+ * \param[out] is_finished 1 means the update was successfully finished (cannot split any more), 0 indicates failure
+ * \return 0 when succeed, -1 when failure happens
+ */
+LIGHTGBM_C_EXPORT int LGBM_BoosterUpdateOneIterCustomFloat64(BoosterHandle handle,
+                                                             const double* grad,
+                                                             const double* hess,
+                                                             int* is_finished);
+
+/*!
+ * \brief Get pointers to the internal gradient and Hessian buffers of training data.
+ * \note
+ * The buffers can be filled in place by customized loss functions and then consumed by
+ * ``LGBM_BoosterUpdateOneIterInplace``, which avoids copying ``num_data * num_class`` values per iteration.
+ * Both pointers stay valid until the training data of the booster is reset.
+ * \param handle Handle of booster
+ * \param[out] out_len Length of each buffer, equal to ``num_class * num_data``
+ * \param[out] out_grad Pointer to the gradients buffer
+ * \param[out] out_hess Pointer to the Hessians buffer
+ * \return 0 when succeed, -1 when failure happens
+ */
+LIGHTGBM_C_EXPORT int LGBM_BoosterGetGradientBuffers(BoosterHandle handle,
+                                                     int64_t* out_len,
+                                                     float** out_grad,
+                                                     float** out_hess);
+
+/*!
+ * \brief Update the model for one iteration with the gradient and Hessian
+ *        already written to the buffers from ``LGBM_BoosterGetGradientBuffers``.
+ * \param handle Handle of booster
+ * \param[out] is_finished 1 means the update was successfully finished (cannot split any more), 0 indicates failure
+ * \return 0 when succeed, -1 when failure happens
+ */
+LIGHTGBM_C_EXPORT int LGBM_BoosterUpdateOneIterInplace(BoosterHandle handle,
+                                                       int* is_finished);
+
+/*!
+ * \brief Start training for ``num_iterations`` iterations on a background thread and return immediately.
+ * \note
+ * - Early stopping follows the ``early_stopping_round`` parameter of the booster and its validation data;
+ * - while training is running, use ``LGBM_BoosterGetTrainingProgress`` and ``LGBM_BoosterGetTrainingEval`` to poll it,
+ *   other calls that modify the booster, or return its gradient or score buffers, fail until
+ *   ``LGBM_BoosterWaitTraining`` returns, and calls that read the model wait for the current iteration;
+ * - freeing the booster cancels the training and waits for it.
+ * \param handle Handle of booster
+ * \param num_iterations Number of iterations to train
+ * \return 0 when succeed, -1 when failure happens
+ */
+LIGHTGBM_C_EXPORT int LGBM_BoosterStartTraining(BoosterHandle handle,
+                                                int num_iterations);
+
+/*!
+ * \brief Get progress of the background training without blocking.
+ * \param handle Handle of booster
+ * \param[out] out_status Training status, one of ``C_API_TRAINING_*``
+ * \param[out] out_iteration Number of iterations finished since ``LGBM_BoosterStartTraining``
+ * \param[out] out_elapsed_seconds Seconds elapsed since ``LGBM_BoosterStartTraining``, frozen once training ends
+ * \return 0 when succeed, -1 when failure happens
+ */
+LIGHTGBM_C_EXPORT int LGBM_BoosterGetTrainingProgress(BoosterHandle handle,
+                                                      int* out_status,
+                                                      int* out_iteration,
+                                                      double* out_elapsed_seconds);
+
+/*!
+ * \brief Get the evaluation results of the background training without blocking.
+ * \note
+ * Results are taken after every ``metric_freq`` iterations and after the last one,
+ * ``out_len`` is 0 before the first evaluation.
+ * You should pre-allocate memory for ``out_results``, you can get its length by ``LGBM_BoosterGetEvalCounts``.
+ * \param handle Handle of booster
+ * \param data_idx Index of data, 0: training data, 1: 1st validation data, 2: 2nd validation data and so on
+ * \param[out] out_iteration Number of iterations finished when the results were taken
+ * \param[out] out_len Length of output result
+ * \param[out] out_results Array with evaluation results
+ * \return 0 when succeed, -1 when failure happens
+ */
+LIGHTGBM_C_EXPORT int LGBM_BoosterGetTrainingEval(BoosterHandle handle,
+                                                  int data_idx,
+                                                  int* out_iteration,
+                                                  int* out_len,
+                                                  double* out_results);
+
+/*!
+ * \brief Request cancellation of the background training, it stops after the current iteration.
+ * \param handle Handle of booster
+ * \return 0 when succeed, -1 when failure happens
+ */
+LIGHTGBM_C_EXPORT int LGBM_BoosterCancelTraining(BoosterHandle handle);
+
+/*!
+ * \brief Wait until the background training ends.
+ * \param handle Handle of booster
+ * \param[out] out_status Final training status, one of ``C_API_TRAINING_*``
+ * \return 0 when succeed, -1 when failure happens (including when the training itself failed)
+ */
+LIGHTGBM_C_EXPORT int LGBM_BoosterWaitTraining(BoosterHandle handle,
+                                               int* out_status);
+
 /*!
  * \brief Rollback one iteration.
  * \param handle Handle of booster
@@ -626,6 +763,22 @@ LIGHTGBM_C_EXPORT int LGBM_BoosterGetPredict(BoosterHandle handle,
                                              int64_t* out_len,
                                              double* out_result);
 
+/*!
+ * \brief Get pointer to the raw scores of training data, without copy and transformation
+ *        (this can be used to support customized loss functions).
+ * \note
+ * The scores are stored class by class, i.e. the score of ``i``-th data in ``k``-th class is
+ * ``out_result[k * num_data + i]``.
+ * The returned memory is owned by the booster and stays valid until the training data of the booster is reset.
+ * \param handle Handle of booster
+ * \param[out] out_len Length of the scores, equal to ``num_class * num_data``
+ * \param[out] out_result Pointer to the raw training scores
+ * \return 0 when succeed, -1 when failure happens
+ */
+LIGHTGBM_C_EXPORT int LGBM_BoosterGetTrainingScore(BoosterHandle handle,
+                                                   int64_t* out_len,
+                                                   const double** out_result);
+
 /*!
  * \brief Make prediction for file.
  * \param handle Handle of booster
@@ -831,6 +984,102 @@ LIGHTGBM_C_EXPORT int LGBM_BoosterPredictForMat(BoosterHandle handle,
                                                 int64_t* out_len,
                                                 double* out_result);
 
+/*!
+ * \brief Make prediction for a new dataset with several boosters at once.
+ *        The input rows are converted once and shared by all boosters.
+ * \note
+ * You should pre-allocate memory for ``out_result``, its length is equal to ``num_data`` times
+ * the sum of the number of predictions of one row over boosters, see ``LGBM_BoosterPredictForMat``.
+ * The predictions of one row are stored in the order of ``handles``.
+ * \param handles Handles of boosters, the same booster can appear more than once
+ * \param num_boosters Number of boosters
+ * \param data Pointer to the data space
+ * \param data_type Type of ``data`` pointer, can be ``C_API_DTYPE_FLOAT32`` or ``C_API_DTYPE_FLOAT64``
+ * \param nrow Number of rows
+ * \param ncol Number of columns
+ * \param is_row_major 1 for row-major, 0 for column-major
+ * \param predict_type What should be predicted
+ *   - ``C_API_PREDICT_NORMAL``: normal prediction, with transform (if needed);
+ *   - ``C_API_PREDICT_RAW_SCORE``: raw score;
+ *   - ``C_API_PREDICT_LEAF_INDEX``: leaf index;
+ *   - ``C_API_PREDICT_CONTRIB``: feature contributions (SHAP values)
+ * \param num_iteration Number of iteration for prediction of every booster, <= 0 means no limit
+ * \param parameter Other parameters for prediction, e.g. early stopping for prediction
+ * \param[out] out_len Length of output result
+ * \param[out] out_result Pointer to array with predictions
+ * \return 0 when succeed, -1 when failure happens
+ */
+LIGHTGBM_C_EXPORT int LGBM_BoosterPredictForMatMulti(const BoosterHandle* handles,
+                                                     int num_boosters,
+                                                     const void* data,
+                                                     int data_type,
+                                                     int32_t nrow,
+                                                     int32_t ncol,
+                                                     int is_row_major,
+                                                     int predict_type,
+                                                     int num_iteration,
+                                                     const char* parameter,
+                                                     int64_t* out_len,
+                                                     double* out_result);
+
+/*!
+ * \brief Make prediction for a new dataset of pre-binned features.
+ *        Numerical splits are evaluated by integer comparisons on the bins,
+ *        and give the same result as prediction on the raw feature values.
+ * \note
+ * The bins of each feature are derived from the split thresholds of the model,
+ * use ``LGBM_BoosterGetFeatureBinUpperBounds`` to get them.
+ * Categorical features are passed as their category.
+ * You should pre-allocate memory for ``out_result``:
+ *   - for normal and raw score, its length is equal to ``num_class * num_data``;
+ *   - for leaf index, its length is equal to ``num_class * num_data * num_iteration``.
+ * \param handle Handle of booster
+ * \param data Pointer to the data space
+ * \param data_type Type of ``data`` pointer, can be ``C_API_DTYPE_UINT8`` or ``C_API_DTYPE_UINT16``
+ * \param nrow Number of rows
+ * \param ncol Number of columns
+ * \param is_row_major 1 for row-major, 0 for column-major
+ * \param predict_type What should be predicted
+ *   - ``C_API_PREDICT_NORMAL``: normal prediction, with transform (if needed);
+ *   - ``C_API_PREDICT_RAW_SCORE``: raw score;
+ *   - ``C_API_PREDICT_LEAF_INDEX``: leaf index
+ * \param num_iteration Number of iteration for prediction, <= 0 means no limit
+ * \param parameter Other parameters for prediction
+ * \param[out] out_len Length of output result
+ * \param[out] out_result Pointer to array with predictions
+ * \return 0 when succeed, -1 when failure happens
+ */
+LIGHTGBM_C_EXPORT int LGBM_BoosterPredictForBins(BoosterHandle handle,
+                                                 const void* data,
+                                                 int data_type,
+                                                 int32_t nrow,
+                                                 int32_t ncol,
+                                                 int is_row_major,
+                                                 int predict_type,
+                                                 int num_iteration,
+                                                 const char* parameter,
+                                                 int64_t* out_len,
+                                                 double* out_result);
+
+/*!
+ * \brief Get upper bounds of the bins of one feature, used to pre-bin data for ``LGBM_BoosterPredictForBins``.
+ *        Value ``x`` falls in the first bin ``b`` with ``x <= out_bounds[b]``, or in bin ``out_len`` if it is larger than all bounds;
+ *        NaN falls in bin ``out_len + 1``.
+ * \note
+ * The bounds only depend on the split thresholds of the model, so they are persisted with the model.
+ * \param handle Handle of booster
+ * \param feature_idx Index of feature
+ * \param buffer_len Length of pre-allocated ``out_bounds``, nothing is copied if it is too small
+ * \param[out] out_len Number of upper bounds, -1 if the feature is categorical and its category is used as bin
+ * \param[out] out_bounds Sorted upper bounds of bins
+ * \return 0 when succeed, -1 when failure happens
+ */
+LIGHTGBM_C_EXPORT int LGBM_BoosterGetFeatureBinUpperBounds(BoosterHandle handle,
+                                                           int feature_idx,
+                                                           int64_t buffer_len,
+                                                           int64_t* out_len,
+                                                           double* out_bounds);
+
 /*!
  * \brief Make prediction for a new dataset. This method re-uses the internal predictor structure
  *        from previous calls and is optimized for single row invocation.
@@ -866,6 +1115,19 @@ LIGHTGBM_C_EXPORT int LGBM_BoosterPredictForMatSingleRow(BoosterHandle handle,
                                                          int64_t* out_len,
                                                          double* out_result);
 
+/*!
+ * \brief Get statistics of the cache of single row predictions, which is enabled by ``pred_cache_size``.
+ * \param handle Handle of booster
+ * \param[out] out_hits Number of single row predictions returned from the cache
+ * \param[out] out_misses Number of single row predictions not found in the cache
+ * \param[out] out_num_entries Number of predictions currently in the cache
+ * \return 0 when succeed, -1 when failure happens
+ */
+LIGHTGBM_C_EXPORT int LGBM_BoosterGetPredictCacheStats(BoosterHandle handle,
+                                                       int64_t* out_hits,
+                                                       int64_t* out_misses,
+                                                       int64_t* out_num_entries);
+
 /*!
  * \brief Make prediction for a new dataset presented in a form of array of pointers to rows.
  * \note
@@ -947,6 +1209,42 @@ LIGHTGBM_C_EXPORT int LGBM_BoosterDumpModel(BoosterHandle handle,
                                             int64_t* out_len,
                                             char* out_str);
 
+/*!
+ * \brief Get the memory usage of the booster as JSON.
+ * \note
+ * Reports the current and peak sizes in byte of the training dataset, gradients, bagging buffers, score updaters,
+ * histogram pool, data partition, other learner buffers, models and their total.
+ * Peaks are sampled after initialization and at the end of each iteration.
+ * Only ``models`` is reported for a booster without training data.
+ * \param handle Handle of booster
+ * \param buffer_len String buffer length, if ``buffer_len < out_len``, you should re-allocate buffer
+ * \param[out] out_len Actual output length
+ * \param[out] out_str JSON format string of memory usage, should pre-allocate memory
+ * \return 0 when succeed, -1 when failure happens
+ */
+LIGHTGBM_C_EXPORT int LGBM_BoosterGetMemoryUsage(BoosterHandle handle,
+                                                 int64_t buffer_len,
+                                                 int64_t* out_len,
+                                                 char* out_str);
+
+/*!
+ * \brief Get the counts of the decisions made while training the booster as JSON.
+ * \note
+ * Counts the feature group histograms of the serial tree learner by source: ``constructed_histograms``
+ * from data, ``subtracted_histograms`` from the parent and ``skipped_histograms``, since the booster was created.
+ * ``leaf_id_histograms`` counts the constructed ones of leaves scanned by their leaf ids.
+ * An empty object is returned for a booster without training data.
+ * \param handle Handle of booster
+ * \param buffer_len String buffer length, if ``buffer_len < out_len``, you should re-allocate buffer
+ * \param[out] out_len Actual output length
+ * \param[out] out_str JSON format string of the counts, should pre-allocate memory
+ * \return 0 when succeed, -1 when failure happens
+ */
+LIGHTGBM_C_EXPORT int LGBM_BoosterGetTrainingStats(BoosterHandle handle,
+                                                  int64_t buffer_len,
+                                                  int64_t* out_len,
+                                                  char* out_str);
+
 /*!
  * \brief Get leaf value.
  * \param handle Handle of booster
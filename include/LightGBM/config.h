@@ -24,7 +24,7 @@ namespace LightGBM {
 
 /*! \brief Types of tasks */
 enum TaskType {
-  kTrain, kPredict, kConvertModel, KRefitTree
+  kTrain, kPredict, kConvertModel, KRefitTree, kCompactModel
 };
 const int kDefaultNumLeaves = 31;
 
@@ -91,12 +91,13 @@ struct Config {
   // [doc-only]
   // type = enum
   // default = train
-  // options = train, predict, convert_model, refit
+  // options = train, predict, convert_model, refit, compact_model
   // alias = task_type
   // desc = ``train``, for training, aliases: ``training``
   // desc = ``predict``, for prediction, aliases: ``prediction``, ``test``
   // desc = ``convert_model``, for converting model file into if-else format, see more information in `IO Parameters <#io-parameters>`__
   // desc = ``refit``, for refitting existing models with new data, aliases: ``refit_tree``
+  // desc = ``compact_model``, for making existing models smaller and faster to predict without changing their predictions; when ``data`` is set, its rows are used to order the tree nodes by visit frequency
   // desc = **Note**: can be used only in CLI version; for language-specific packages you can use the correspondent functions
   TaskType task = TaskType::kTrain;
 
@@ -216,6 +217,21 @@ struct Config {
   // desc = ``<= 0`` means no limit
   int max_depth = -1;
 
+  // check = >0
+  // desc = number of leaves split in one round of tree growth, the leaves with the largest split gains are chosen
+  // desc = the histograms of all new leaves of a round are constructed in one pass, which keeps more threads busy on wide trees
+  // desc = ``1`` means leaf-wise growth, a value ``>= num_leaves`` splits every splittable leaf in each round, i.e. depth-wise growth
+  // desc = **Note**: only supported by the ``serial`` tree learner on ``cpu``
+  int leaf_batch_size = 1;
+
+  // check = >=0.0
+  // check = <=1.0
+  // desc = leaves with at least this fraction of the training data store a leaf id per data instead of a list of data indices
+  // desc = their splits and histograms scan all data sequentially instead of moving indices and gathering gradients, which is faster for leaves with most of the data
+  // desc = ``0.0`` means lists of data indices only
+  // desc = **Note**: only supported by the ``serial`` tree learner on ``cpu``, and not used for datasets with sparse features or with ``cegb_penalty_feature_lazy``
+  double leaf_id_partition_fraction = 0.0;
+
   // alias = min_data_per_leaf, min_data, min_child_samples
   // check = >=0
   // desc = minimal number of data in one leaf. Can be used to deal with over-fitting
@@ -289,6 +305,23 @@ struct Config {
   // desc = random seed for ``feature_fraction``
   int feature_fraction_seed = 2;
 
+  // desc = used for feature pruning, a feature is pruned after ``feature_pruning_rounds`` trees in a row, which evaluated the feature and found no split on it with gain larger than ``feature_pruning_gain_ratio`` times the largest split gain of all features in the tree
+  // desc = pruned features are skipped in histogram construction and split finding, except in the trees rechecking them
+  // desc = in multi-class classification, the trees of each class count, prune and recheck the features separately
+  // desc = ``<= 0`` means disable
+  // desc = **Note**: can be used only with ``serial`` tree learner
+  int feature_pruning_rounds = 0;
+
+  // check = >=0.0
+  // check = <1.0
+  // desc = used for feature pruning, fraction of the largest split gain in a tree the split gain of a feature needs to exceed to be kept
+  // desc = the gain is relative, so the most useful features are never pruned as the gains shrink over the iterations
+  double feature_pruning_gain_ratio = 0.01;
+
+  // check = >0
+  // desc = used for feature pruning, pruned features are evaluated again every ``feature_pruning_recheck_freq`` trees, and kept again if they have a split with enough gain
+  int feature_pruning_recheck_freq = 10;
+
   // alias = early_stopping_rounds, early_stopping, n_iter_no_change
   // desc = will stop training if one metric of one validation data doesn't improve in last ``early_stopping_round`` rounds
   // desc = ``<= 0`` means disable
@@ -481,6 +514,11 @@ struct Config {
   // desc = ``< 0`` means no limit
   double histogram_pool_size = -1.0;
 
+  // desc = max memory in MB used by the training dataset, the learner buffers and the model
+  // desc = when the sampled usage exceeds it at the end of an iteration, the histogram pool is shrunk (at least 2 histograms are kept), and a warning is given if it is still exceeded
+  // desc = ``<= 0`` means no limit
+  double memory_budget = -1.0;
+
   // alias = data_seed
   // desc = random seed for data partition in parallel learning (excluding the ``feature_parallel`` mode)
   int data_random_seed = 1;
@@ -496,6 +534,20 @@ struct Config {
   // desc = **Note**: can be used only in CLI version
   int snapshot_freq = -1;
 
+  // desc = frequency of saving checkpoints to resume training from, set this to positive value to enable this function
+  // desc = a checkpoint holds the model, training and validation scores, early stopping state and random states, so resumed training gives the same model as uninterrupted training
+  // desc = in parallel learning every machine saves its own checkpoint, and a checkpoint counts only after all machines saved it
+  // desc = when training starts, it resumes from the latest checkpoint that all machines have, the last two checkpoints are kept
+  // desc = with bagging, it is rounded up to a multiple of ``bagging_freq``
+  // desc = **Note**: only supported by ``gbdt`` and ``goss`` boosting, the training data and parameters must not change between runs
+  // desc = **Note**: can be used only in CLI version
+  int checkpoint_freq = -1;
+
+  // desc = prefix of checkpoint files, default is ``output_model`` followed by ``.checkpoint``
+  // desc = files are named ``<prefix>.rank_<rank>.iter_<iteration>``, plus ``<prefix>.rank_<rank>.latest`` pointing to the latest complete one
+  // desc = **Note**: can be used only in CLI version
+  std::string checkpoint_prefix = "";
+
   // alias = model_input, model_in
   // desc = filename of input model
   // desc = for ``prediction`` task, this model will be applied to prediction data
@@ -522,9 +574,17 @@ struct Config {
   // desc = **Note**: works only in case of loading data directly from file
   std::vector<std::string> valid_data_initscores;
 
+  // desc = used only for ``train`` task with ``input_model`` (continued training) in CLI version
+  // desc = the initial scores of the input model are computed from the bins of training and validation data when all its split thresholds are bin boundaries of the data, otherwise from the raw features while parsing
+  // desc = set this to ``true`` to cache the initial scores computed from the bins in ``data_file`` + ``.init_score_cache``, which is reused while the input model and the binned data are unchanged
+  // desc = **Note**: not used in parallel learning
+  bool init_score_cache = false;
+
   // alias = is_pre_partition
   // desc = used for parallel learning (excluding the ``feature_parallel`` mode)
   // desc = ``true`` if training data are pre-partitioned, and different machines use different partitions
+  // desc = when ``true``, validation data are also treated as partitioned, and validation metrics are merged over all machines
+  // desc = when ``false``, each machine only reads the lines in its own byte range of a shared text data file, unless a query file is used
   bool pre_partition = false;
 
   // alias = is_enable_bundle, bundle
@@ -548,6 +608,13 @@ struct Config {
   // desc = the threshold of zero elements percentage for treating a feature as a sparse one
   double sparse_threshold = 0.8;
 
+  // alias = bitmap_bin
+  // desc = set this to ``true`` to store dense feature groups with at most 2 bins (e.g. single binary or flag features) as a bitmap over the data instead of 4 bits per data
+  // desc = their histograms sum the gradients of each bin by masks, which uses less memory and can be faster
+  // desc = binary dataset files are the same for both values
+  // desc = **Note**: not supported by the ``gpu`` device
+  bool enable_bitmap_bin = false;
+
   // desc = set this to ``false`` to disable the special handle of missing value
   bool use_missing = true;
 
@@ -658,6 +725,20 @@ struct Config {
   // desc = the threshold of margin in early-stopping prediction
   double pred_early_stop_margin = 10.0;
 
+  // desc = used only in ``prediction`` task
+  // desc = if ``> 0``, a single row prediction of a model with at least this number of trees splits the trees over threads
+  // desc = rows predicted in parallel, e.g. a batch of rows, are not affected
+  // desc = **Note**: does not work with ``pred_early_stop``, leaf index prediction and feature contributions
+  // desc = **Note**: the summation order of trees changes, so the result can differ from the serial one in the last bits
+  int pred_tree_parallel_threshold = 0;
+
+  // check = >=0
+  // desc = used only in ``prediction`` task
+  // desc = if ``> 0``, the booster keeps the predictions of up to this number of recently seen rows of single row prediction, and returns them for repeated rows without traversing the trees
+  // desc = the cache is cleared whenever the model changes, e.g. by training, merging or setting leaf values
+  // desc = **Note**: only the single row prediction functions of the C API use this cache
+  int pred_cache_size = 0;
+
   // desc = used only in ``prediction`` task
   // desc = control whether or not LightGBM raises an error when you try to predict on data with a different number of features than the training data
   // desc = if ``false`` (the default), a fatal error will be raised if the number of features in the dataset you predict on differs from the number seen during training
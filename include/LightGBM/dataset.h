@@ -91,6 +91,18 @@ class Metadata {
 
   void SetWeights(const label_t* weights, data_size_t len);
 
+  #ifndef LABEL_T_USE_DOUBLE
+  /*!
+  * \brief Set labels from double values, converted directly into the internal storage
+  */
+  void SetLabel(const double* label, data_size_t len);
+
+  /*!
+  * \brief Set weights from double values, converted directly into the internal storage
+  */
+  void SetWeights(const double* weights, data_size_t len);
+  #endif
+
   void SetQuery(const data_size_t* query, data_size_t len);
 
   /*!
@@ -220,6 +232,12 @@ class Metadata {
   void LoadQueryBoundaries();
   /*! \brief Load query wights */
   void LoadQueryWeights();
+  /*! \brief Copy labels of any floating type into label_ */
+  template <typename T>
+  void SetLabelInner(const T* label, data_size_t len);
+  /*! \brief Copy weights of any floating type into weights_ */
+  template <typename T>
+  void SetWeightsInner(const T* weights, data_size_t len);
   /*! \brief Filename of current data */
   std::string data_filename_;
   /*! \brief Number of data */
@@ -288,6 +306,15 @@ class Dataset {
 
   LIGHTGBM_EXPORT Dataset(data_size_t num_data);
 
+  /*!
+  * \brief Construct the feature groups from the bin mappers and the sampled data
+  * \param sample_non_zero_indices Sampled indices of each column
+  * \param sample_values Sampled values of each column, nullptr if they were released by ReleaseSampleValues,
+  *        in which case sample_non_zero_indices are the fixed indices returned by it
+  * \param num_per_col Number of sample_non_zero_indices of each column
+  * \param num_sample_values Number of sampled values of each column, which orders the features for bundling,
+  *        nullptr if it is num_per_col
+  */
   void Construct(
     std::vector<std::unique_ptr<BinMapper>>* bin_mappers,
     int num_total_features,
@@ -295,10 +322,26 @@ class Dataset {
     int** sample_non_zero_indices,
     double** sample_values,
     const int* num_per_col,
+    const int* num_sample_values,
     int num_sample_col,
     size_t total_sample_cnt,
     const Config& io_config);
 
+  /*!
+  * \brief Release the sampled values of one column once its bin mapper is found.
+  *        The sampled indices are replaced by the ones feature bundling uses (the samples not in the most frequent bin),
+  *        so Construct can be called without the sampled values
+  * \param bin_mapper Bin mapper of the column, nullptr or trivial if the column is not used
+  * \param total_sample_cnt Total number of sampled rows
+  * \param keep_indices False to release the sampled indices too, when feature bundling is disabled
+  * \param sample_values Sampled values of the column, released
+  * \param sample_indices Sampled indices of the column, replaced
+  * \param num_sample_values Output number of sampled values of the column, passed to Construct
+  */
+  static void ReleaseSampleValues(const BinMapper* bin_mapper, int total_sample_cnt, bool keep_indices,
+                                  std::vector<double>* sample_values, std::vector<int>* sample_indices,
+                                  int* num_sample_values);
+
   /*! \brief Destructor */
   LIGHTGBM_EXPORT ~Dataset();
 
@@ -415,21 +458,79 @@ class Dataset {
   */
   LIGHTGBM_EXPORT void SaveBinaryFile(const char* bin_filename);
 
+  /*!
+  * \brief Get sizes in byte of this object in memory, including the feature data and the metadata
+  */
+  size_t SizesInByte() const;
+
+  /*!
+  * \brief Hash of the bin mappers and the bins of all records, equal for datasets with the same binned features
+  */
+  size_t BinHash() const;
+
   LIGHTGBM_EXPORT void DumpTextFile(const char* text_filename);
 
   LIGHTGBM_EXPORT void CopyFeatureMapperFrom(const Dataset* dataset);
 
   LIGHTGBM_EXPORT void CreateValid(const Dataset* dataset);
 
+  /*!
+  * \brief Number of entries of the partial histograms of row blocks that ConstructHistograms
+  *        and ConstructHistogramsOfLeafId need for any leaf of this dataset
+  */
+  size_t NumRowBlockHistogramEntries() const;
+
+  /*!
+  * \brief Construct the histograms of a leaf. Large leaves with few used feature groups are tiled by row blocks,
+  *        whose partial histograms are kept in row_block_histograms, of NumRowBlockHistogramEntries() entries.
+  *        If it is nullptr, the leaf is not tiled
+  */
   void ConstructHistograms(const std::vector<int8_t>& is_feature_used,
                            const data_size_t* data_indices, data_size_t num_data,
                            int leaf_idx,
                            std::vector<std::unique_ptr<OrderedBin>>* ordered_bins,
                            const score_t* gradients, const score_t* hessians,
                            score_t* ordered_gradients, score_t* ordered_hessians,
+                           HistogramBinEntry* row_block_histograms,
                            bool is_constant_hessian,
                            HistogramBinEntry* histogram_data) const;
 
+  /*!
+  * \brief Construct the histograms of the num_data_in_leaf data with leaf_ids[i] == leaf_id, by sequential scans
+  *        of all data instead of gathering the gradients of a leaf. ordered_bins must all be nullptr
+  */
+  void ConstructHistogramsOfLeafId(const std::vector<int8_t>& is_feature_used,
+                                   const uint8_t* leaf_ids, uint8_t leaf_id, data_size_t num_data_in_leaf,
+                                   const std::vector<std::unique_ptr<OrderedBin>>& ordered_bins,
+                                   const score_t* gradients, const score_t* hessians,
+                                   HistogramBinEntry* row_block_histograms,
+                                   bool is_constant_hessian,
+                                   HistogramBinEntry* histogram_data) const;
+
+  /*! \brief Histograms of one leaf to construct by ConstructHistogramsOfLeaves */
+  struct LeafHistogramTask {
+    const std::vector<int8_t>* is_feature_used;
+    const data_size_t* data_indices;
+    data_size_t num_data;
+    int leaf_idx;
+    /*! \brief Leaf id of each data, if not nullptr the data with leaf_id are scanned instead of data_indices */
+    const uint8_t* leaf_ids;
+    uint8_t leaf_id;
+    /*! \brief Buffers of the gathered gradients of this leaf, must not overlap the ones of other leaves */
+    score_t* ordered_gradients;
+    score_t* ordered_hessians;
+    HistogramBinEntry* histogram_data;
+  };
+
+  /*!
+  * \brief Construct the histograms of several leaves at once, by one parallel pass over
+  *        the rows of all leaves and one over all (leaf, feature group) pairs
+  */
+  void ConstructHistogramsOfLeaves(const std::vector<LeafHistogramTask>& tasks,
+                                   std::vector<std::unique_ptr<OrderedBin>>* ordered_bins,
+                                   const score_t* gradients, const score_t* hessians,
+                                   bool is_constant_hessian) const;
+
   void FixHistogram(int feature_idx, double sum_gradient, double sum_hessian, data_size_t num_data,
                     HistogramBinEntry* data) const;
 
@@ -562,6 +663,9 @@ class Dataset {
   /*! \brief Get the index of label column */
   inline int label_idx() const { return label_idx_; }
 
+  /*! \brief Get the filename of data */
+  inline const char* data_filename() const { return data_filename_.c_str(); }
+
   /*! \brief Get names of current data set */
   inline const std::vector<std::string>& feature_names() const { return feature_names_; }
 
@@ -623,6 +727,32 @@ class Dataset {
   void addFeaturesFrom(Dataset* other);
 
  private:
+  /*!
+  * \brief Number of row blocks used to tile histogram construction of one leaf,
+  *        1 means one task per feature group. Only leaves with few feature groups are tiled.
+  *        It does not depend on the number of threads, so the trained models do not either
+  * \param num_data Number of data in the leaf
+  * \param num_used_group Number of feature groups to construct
+  */
+  static int NumHistogramRowBlocks(data_size_t num_data, int num_used_group);
+
+  /*!
+  * \brief Construct histograms by (row block, feature group) tiles. Every block except the
+  *        first accumulates into its own partial histograms in row_block_histograms, which are reduced
+  *        into histogram_data. If leaf_ids is not nullptr, num_data is the number of data with leaf_id,
+  *        the blocks split them as an index list of the leaf would and cover the data between them
+  */
+  void ConstructHistogramsByRowBlocks(const std::vector<int>& used_group, int num_blocks,
+                                      const data_size_t* data_indices, data_size_t num_data,
+                                      const uint8_t* leaf_ids, uint8_t leaf_id,
+                                      int leaf_idx,
+                                      const std::vector<std::unique_ptr<OrderedBin>>& ordered_bins,
+                                      const score_t* gradients, const score_t* hessians,
+                                      const score_t* ordered_gradients, const score_t* ordered_hessians,
+                                      HistogramBinEntry* row_block_histograms,
+                                      bool is_constant_hessian,
+                                      HistogramBinEntry* histogram_data) const;
+
   std::string data_filename_;
   /*! \brief Store used features */
   std::vector<std::unique_ptr<FeatureGroup>> feature_groups_;
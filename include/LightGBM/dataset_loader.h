@@ -7,6 +7,7 @@
 
 #include <LightGBM/dataset.h>
 
+#include <functional>
 #include <string>
 #include <unordered_set>
 #include <vector>
@@ -31,6 +32,44 @@ class DatasetLoader {
     int** sample_indices, int num_col, const int* num_per_col,
     size_t total_sample_size, data_size_t num_data);
 
+  /*!
+  * \brief Construct from sampled data owned by the caller, the sampled values of each column are released
+  *        as soon as its bin mapper is found, to reduce the peak memory
+  * \param sample_values Sampled values of each column, released
+  * \param sample_indices Sampled indices of each column, replaced by the indices used by feature bundling
+  */
+  LIGHTGBM_EXPORT Dataset* CostructFromSampleData(std::vector<std::vector<double>>* sample_values,
+    std::vector<std::vector<int>>* sample_indices,
+    size_t total_sample_size, data_size_t num_data);
+
+  /*! \brief Fill the sampled values and indices of one column, called concurrently for different columns */
+  using SampleColumnFunction = std::function<void(int col_idx, std::vector<double>* values, std::vector<int>* indices)>;
+
+  /*!
+  * \brief Construct from sampled data generated one column at a time, right before the bin mapper of the column is found,
+  *        so only the sampled values of the columns being binned are kept in memory
+  * \param num_col Number of columns
+  * \param get_sample_column Function to fill the sampled values and indices of one column
+  */
+  LIGHTGBM_EXPORT Dataset* CostructFromSampleColumns(int num_col, const SampleColumnFunction& get_sample_column,
+    size_t total_sample_size, data_size_t num_data);
+
+  /*! \brief Check if the initial model can be evaluated exactly on the bins of a dataset */
+  using CheckBinnedPredictFunction = std::function<bool(const Dataset* dataset)>;
+
+  /*! \brief Compute the raw scores of the initial model for all records of a dataset from its bins, num_data * num_class, class major */
+  using BinnedPredictFunction = std::function<void(const Dataset* dataset, double* init_score)>;
+
+  /*!
+  * \brief Compute the initial scores of continued training from the bins after the features are extracted,
+  *        instead of predicting the raw features of each record while parsing.
+  *        Used for the text data whose bins pass the check, otherwise the predict function of the constructor is used
+  * \param check_fun Function to check if the initial model can be evaluated on the bins of a dataset
+  * \param predict_fun Function to compute the initial scores from the bins
+  */
+  LIGHTGBM_EXPORT void SetBinnedPredictFunction(const CheckBinnedPredictFunction& check_fun,
+                                                const BinnedPredictFunction& predict_fun);
+
   /*! \brief Disable copy */
   DatasetLoader& operator=(const DatasetLoader&) = delete;
   /*! \brief Disable copy */
@@ -40,6 +79,17 @@ class DatasetLoader {
                                                         const std::unordered_set<int>& categorical_features);
 
  private:
+  /*!
+  * \brief Construct from sampled data, either from the given pointers, or from owned_values and owned_indices,
+  *        which are filled by get_sample_column if it is not empty, and released column by column
+  */
+  Dataset* CostructFromSampleData(double** sample_values,
+    int** sample_indices, int num_col, const int* num_per_col,
+    size_t total_sample_size, data_size_t num_data,
+    std::vector<std::vector<double>>* owned_values,
+    std::vector<std::vector<int>>* owned_indices,
+    const SampleColumnFunction& get_sample_column);
+
   Dataset* LoadFromBinFile(const char* data_filename, const char* bin_filename, int rank, int num_machines, int* num_global_data, std::vector<data_size_t>* used_data_indices);
 
   void SetHeader(const char* filename);
@@ -52,22 +102,51 @@ class DatasetLoader {
 
   std::vector<std::string> SampleTextDataFromFile(const char* filename, const Metadata& metadata, int rank, int num_machines, int* num_global_data, std::vector<data_size_t>* used_data_indices);
 
-  void ConstructBinMappersFromTextData(int rank, int num_machines, const std::vector<std::string>& sample_data, const Parser* parser, Dataset* dataset);
+  /*! \brief Whether each machine only reads its own byte range of the text file in parallel loading */
+  bool IsShardedTextLoad(const Metadata& metadata, int num_machines) const;
+
+  /*! \brief Byte range of text data read by one machine in sharded loading */
+  static void GetShardByteRange(size_t data_size, int rank, int num_machines, size_t* range_begin, size_t* range_end);
+
+  /*! \brief Get the global indices of local data and the number of global data of sharded loading */
+  data_size_t SyncUpShardedData(data_size_t num_local_data, int rank, int num_machines, std::vector<data_size_t>* used_data_indices);
+
+  /*! \brief Merge the samples of all machines, each machine contributes in proportion to its number of data */
+  std::vector<std::string> GatherShardedSample(const std::vector<std::string>& local_sample, data_size_t num_local_data, data_size_t num_global_data);
+
+  void ConstructBinMappersFromTextData(int rank, int num_machines, const std::vector<std::string>& sample_data, data_size_t num_sampled_from, const Parser* parser, Dataset* dataset);
 
   /*! \brief Extract local features from memory */
   void ExtractFeaturesFromMemory(std::vector<std::string>* text_data, const Parser* parser, Dataset* dataset);
 
   /*! \brief Extract local features from file */
-  void ExtractFeaturesFromFile(const char* filename, const Parser* parser, const std::vector<data_size_t>& used_data_indices, Dataset* dataset);
+  void ExtractFeaturesFromFile(const char* filename, const Parser* parser, const std::vector<data_size_t>& used_data_indices, int rank, int num_machines, Dataset* dataset);
 
   /*! \brief Check can load from binary file */
   std::string CheckCanLoadFromBin(const char* filename);
 
+  /*! \brief Decide whether the initial scores of a dataset are computed from its bins, after the bin mappers are constructed */
+  void CheckPredictOnBins(const Dataset* dataset);
+
+  /*! \brief Whether the initial model is applied to the raw features while parsing */
+  inline bool PredictWhileParsing() const {
+    return predict_fun_ != nullptr && !predict_on_bins_;
+  }
+
+  /*! \brief Set the initial scores computed from the bins, after the features are extracted */
+  void PredictOnBins(Dataset* dataset);
+
   const Config& config_;
   /*! \brief Random generator*/
   Random random_;
   /*! \brief prediction function for initial model */
   const PredictFunction& predict_fun_;
+  /*! \brief check function of prediction on bins for initial model */
+  CheckBinnedPredictFunction check_binned_predict_fun_;
+  /*! \brief prediction function on bins for initial model */
+  BinnedPredictFunction binned_predict_fun_;
+  /*! \brief whether the initial scores of the dataset being loaded are computed from its bins */
+  bool predict_on_bins_ = false;
   /*! \brief number of classes */
   int num_class_;
   /*! \brief index of label column */
@@ -29,10 +29,12 @@ class FeatureGroup {
   * \param num_data Total number of data
   * \param is_enable_sparse True if enable sparse feature
   * \param sparse_threshold Threshold for treating a feature as a sparse feature
+  * \param is_enable_bitmap True if enable bitmaps for dense groups with 2 bins
   */
   FeatureGroup(int num_feature,
     std::vector<std::unique_ptr<BinMapper>>* bin_mappers,
-    data_size_t num_data, double sparse_threshold, bool is_enable_sparse) : num_feature_(num_feature) {
+    data_size_t num_data, double sparse_threshold, bool is_enable_sparse, bool is_enable_bitmap)
+    : num_feature_(num_feature), is_enable_bitmap_(is_enable_bitmap) {
     CHECK(static_cast<int>(bin_mappers->size()) == num_feature);
     // use bin at zero to store most_freq_bin
     num_total_bin_ = 1;
@@ -50,12 +52,13 @@ class FeatureGroup {
     }
     double sparse_rate = 1.0f - static_cast<double>(cnt_non_zero) / (num_data);
     bin_data_.reset(Bin::CreateBin(num_data, num_total_bin_,
-      sparse_rate, is_enable_sparse, sparse_threshold, &is_sparse_));
+      sparse_rate, is_enable_sparse, sparse_threshold, is_enable_bitmap_, &is_sparse_));
   }
 
   FeatureGroup(int num_feature,
                std::vector<std::unique_ptr<BinMapper>>* bin_mappers,
-               data_size_t num_data, bool is_sparse) : num_feature_(num_feature) {
+               data_size_t num_data, bool is_sparse, bool is_enable_bitmap)
+    : num_feature_(num_feature), is_enable_bitmap_(is_enable_bitmap) {
     CHECK(static_cast<int>(bin_mappers->size()) == num_feature);
     // use bin at zero to store most_freq_bin
     num_total_bin_ = 1;
@@ -73,7 +76,7 @@ class FeatureGroup {
     if (is_sparse_) {
       bin_data_.reset(Bin::CreateSparseBin(num_data, num_total_bin_));
     } else {
-      bin_data_.reset(Bin::CreateDenseBin(num_data, num_total_bin_));
+      bin_data_.reset(Bin::CreateDenseBin(num_data, num_total_bin_, is_enable_bitmap_));
     }
   }
   /*!
@@ -81,9 +84,10 @@ class FeatureGroup {
   * \param memory Pointer of memory
   * \param num_all_data Number of global data
   * \param local_used_indices Local used indices, empty means using all data
+  * \param is_enable_bitmap True if enable bitmaps for dense groups with 2 bins
   */
   FeatureGroup(const void* memory, data_size_t num_all_data,
-    const std::vector<data_size_t>& local_used_indices) {
+    const std::vector<data_size_t>& local_used_indices, bool is_enable_bitmap) : is_enable_bitmap_(is_enable_bitmap) {
     const char* memory_ptr = reinterpret_cast<const char*>(memory);
     // get is_sparse
     is_sparse_ = *(reinterpret_cast<const bool*>(memory_ptr));
@@ -113,7 +117,7 @@ class FeatureGroup {
     if (is_sparse_) {
       bin_data_.reset(Bin::CreateSparseBin(num_data, num_total_bin_));
     } else {
-      bin_data_.reset(Bin::CreateDenseBin(num_data, num_total_bin_));
+      bin_data_.reset(Bin::CreateDenseBin(num_data, num_total_bin_, is_enable_bitmap_));
     }
     // get bin data
     bin_data_->LoadFromMemory(memory_ptr, local_used_indices);
@@ -213,12 +217,24 @@ class FeatureGroup {
     ret += bin_data_->SizesInByte();
     return ret;
   }
+  /*!
+  * \brief Get sizes in byte of this object in memory
+  */
+  size_t MemorySizesInByte() const {
+    size_t ret = sizeof(is_sparse_) + sizeof(num_feature_);
+    for (int i = 0; i < num_feature_; ++i) {
+      ret += bin_mappers_[i]->SizesInByte();
+    }
+    ret += bin_data_->MemorySizesInByte();
+    return ret;
+  }
   /*! \brief Disable copy */
   FeatureGroup& operator=(const FeatureGroup&) = delete;
   /*! \brief Deep copy */
   FeatureGroup(const FeatureGroup& other) {
     num_feature_ = other.num_feature_;
     is_sparse_ = other.is_sparse_;
+    is_enable_bitmap_ = other.is_enable_bitmap_;
     num_total_bin_ = other.num_total_bin_;
     bin_offsets_ = other.bin_offsets_;
 
@@ -241,6 +257,8 @@ class FeatureGroup {
   std::unique_ptr<Bin> bin_data_;
   /*! \brief True if this feature is sparse */
   bool is_sparse_;
+  /*! \brief True if dense bin data with few bins use bitmaps */
+  bool is_enable_bitmap_;
   int num_total_bin_;
 };
 
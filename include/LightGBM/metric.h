@@ -8,6 +8,7 @@
 #include <LightGBM/config.h>
 #include <LightGBM/dataset.h>
 #include <LightGBM/meta.h>
+#include <LightGBM/network.h>
 #include <LightGBM/objective_function.h>
 #include <LightGBM/utils/log.h>
 #include <LightGBM/utils/common.h>
@@ -43,6 +44,15 @@ class Metric {
   */
   virtual std::vector<double> Eval(const double* score, const ObjectiveFunction* objective) const = 0;
 
+  /*!
+  * \brief Set whether the data of this metric is only the local partition of data distributed over machines.
+  *        If so, Eval merges the partial results of all machines and must be called on all machines together
+  * \param is_distributed True if the data is partitioned over machines
+  */
+  virtual void SetDistributed(bool is_distributed) {
+    is_distributed_ = is_distributed && Network::num_machines() > 1;
+  }
+
   Metric() = default;
   /*! \brief Disable copy */
   Metric& operator=(const Metric&) = delete;
@@ -55,6 +65,34 @@ class Metric {
   * \param config Config for metric
   */
   LIGHTGBM_EXPORT static Metric* CreateMetric(const std::string& type, const Config& config);
+
+ protected:
+  /*!
+  * \brief Sum up partial sums over all machines in one collective call, no-op if data is not distributed
+  * \param partial_sums Local partial sums, replaced by the global sums
+  */
+  void GlobalSumIfDistributed(std::vector<double>* partial_sums) const {
+    if (is_distributed_) {
+      *partial_sums = Network::GlobalSum(partial_sums);
+    }
+  }
+
+  /*!
+  * \brief Sum up the loss and weights of pointwise metrics over all machines
+  * \param sum_loss Local sum of loss, replaced by the global one
+  * \param sum_weights Local sum of weights, replaced by the global one
+  */
+  void GlobalSumIfDistributed(double* sum_loss, double* sum_weights) const {
+    if (is_distributed_) {
+      std::vector<double> partial_sums{*sum_loss, *sum_weights};
+      GlobalSumIfDistributed(&partial_sums);
+      *sum_loss = partial_sums[0];
+      *sum_weights = partial_sums[1];
+    }
+  }
+
+  /*! \brief True if the data is partitioned over machines */
+  bool is_distributed_ = false;
 };
 
 /*!
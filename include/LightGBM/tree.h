@@ -9,6 +9,8 @@
 #include <LightGBM/meta.h>
 
 #include <string>
+#include <cmath>
+#include <limits>
 #include <map>
 #include <memory>
 #include <unordered_map>
@@ -113,17 +115,63 @@ class Tree {
                             const data_size_t* used_data_indices,
                             data_size_t num_data, double* score) const;
 
+  /*!
+  * \brief Adding prediction values of many tree models to scores, the bins of a small block of data are decoded
+  *        once and then used by all trees
+  * \param trees The tree models, using the inner bins of data
+  * \param data The dataset
+  * \param num_data Number of total data
+  * \param scores Will add prediction of trees[i] to scores[i]
+  */
+  static void AddPredictionToScore(const std::vector<const Tree*>& trees, const Dataset* data,
+                                   data_size_t num_data, const std::vector<double*>& scores);
+
+  /*!
+  * \brief Map the split thresholds to the bins of a dataset, so a loaded tree can be evaluated on the dataset
+  *        by AddPredictionToScore with the same results as predicting the raw feature values
+  * \param data The dataset
+  * \return False if some split can't be decided by the bins, e.g. its threshold is not a bin boundary,
+  *         then the tree is left unchanged
+  */
+  bool MapThresholdsToBins(const Dataset* data);
+
   /*!
   * \brief Prediction on one record
-  * \param feature_values Feature value of this record
+  * \param feature_values Feature value of this record, double or float
   * \return Prediction result
   */
-  inline double Predict(const double* feature_values) const;
+  template<typename T>
+  inline double Predict(const T* feature_values) const;
   inline double PredictByMap(const std::unordered_map<int, double>& feature_values) const;
 
-  inline int PredictLeafIndex(const double* feature_values) const;
+  template<typename T>
+  inline int PredictLeafIndex(const T* feature_values) const;
   inline int PredictLeafIndexByMap(const std::unordered_map<int, double>& feature_values) const;
 
+  /*!
+  * \brief Add thresholds of numerical splits to their features, and mark the features of categorical splits
+  * \param feature_thresholds Thresholds of each feature, in original feature index
+  * \param is_categorical Whether each feature is categorical
+  */
+  void AddSplitThresholds(std::vector<std::vector<double>>* feature_thresholds,
+                          std::vector<int8_t>* is_categorical) const;
+
+  /*!
+  * \brief Get the numerical splits in the space of pre-binned features, bin b of a feature is (bin_upper_bounds[b - 1], bin_upper_bounds[b]]
+  * \param bin_upper_bounds Sorted upper bounds of bins of each feature, must contain all thresholds and +-kZeroThreshold
+  * \return Three values for each node: threshold bin, zero bin and NaN bin of its feature
+  */
+  std::vector<uint32_t> NodeBins(const std::vector<std::vector<double>>& bin_upper_bounds) const;
+
+  /*!
+  * \brief Prediction on one record of pre-binned features, categorical features are passed as is
+  * \param feature_bins Bin of each feature of this record
+  * \param node_bins Numerical splits in bins, from NodeBins
+  * \return Prediction result
+  */
+  inline double PredictByBins(const uint16_t* feature_bins, const uint32_t* node_bins) const;
+  inline int PredictLeafIndexByBins(const uint16_t* feature_bins, const uint32_t* node_bins) const;
+
 
   inline void PredictContrib(const double* feature_values, int num_features, double* output);
 
@@ -173,15 +221,61 @@ class Tree {
     leaf_value_[0] = val;
   }
 
+  /*!
+  * \brief Merge sibling leaves with equal outputs into their parent, then renumber nodes and leaves in depth-first order
+  *        with the more visited child first, so the frequent paths of prediction are close in memory
+  * \param leaf_visits Number of visits of each leaf, the data counts of leaves are used if empty
+  * \return Number of removed leaves
+  */
+  int Compact(const std::vector<int>& leaf_visits);
+
+  /*! \brief Whether other has the same splits and leaf order, so their outputs can be added leaf by leaf */
+  bool HasSameStructure(const Tree& other) const;
+
+  /*! \brief Hash of the splits, equal for trees with the same structure */
+  size_t StructureHash() const;
+
+  /*!
+  * \brief Add the outputs of another tree to the leaves
+  * \param other Tree with the same structure, or a constant tree
+  */
+  void AddLeafOutputs(const Tree& other);
+
+  /*! \brief Get sizes in byte of this object */
+  size_t SizesInByte() const;
+
   /*! \brief Serialize this object to string*/
   std::string ToString() const;
 
   /*! \brief Serialize this object to json*/
   std::string ToJSON() const;
 
+  /*!
+  * \brief Append this object to a binary buffer, exactly including the inner bin thresholds
+  * \param buffer Buffer to append to
+  */
+  void SaveBinaryToString(std::string* buffer) const;
+
+  /*!
+  * \brief Load this object from a binary buffer written by SaveBinaryToString
+  * \param buffer Buffer to read from
+  * \param pos Position in buffer, moved past this object
+  * \return False if the buffer doesn't hold a valid tree
+  */
+  bool LoadBinaryFromString(const std::string& buffer, size_t* pos);
+
   /*! \brief Serialize this object to if-else statement*/
   std::string ToIfElse(int index, bool predict_leaf_index) const;
 
+  /*! \brief Largest float not above a double, comparing floats with it gives the same result as comparing in double */
+  inline static float MaxFloatNotAbove(double val) {
+    float ret = static_cast<float>(val);
+    if (static_cast<double>(ret) > val) {
+      ret = std::nextafter(ret, -std::numeric_limits<float>::infinity());
+    }
+    return ret;
+  }
+
   inline static bool IsZero(double fval) {
     if (fval > -kZeroThreshold && fval <= kZeroThreshold) {
       return true;
@@ -218,7 +312,17 @@ class Tree {
 
   std::string CategoricalDecisionIfElse(int node) const;
 
-  inline int NumericalDecision(double fval, int node) const {
+  /*! \brief Threshold of numerical split, in the precision of feature values */
+  inline double NumericalThreshold(int node, double) const {
+    return threshold_[node];
+  }
+
+  inline float NumericalThreshold(int node, float) const {
+    return threshold_float_[node];
+  }
+
+  template<typename T>
+  inline int NumericalDecision(T fval, int node) const {
     uint8_t missing_type = GetMissingType(decision_type_[node]);
     if (std::isnan(fval)) {
       if (missing_type != 2) {
@@ -233,7 +337,7 @@ class Tree {
         return right_child_[node];
       }
     }
-    if (fval <= threshold_[node]) {
+    if (fval <= NumericalThreshold(node, fval)) {
       return left_child_[node];
     } else {
       return right_child_[node];
@@ -277,6 +381,30 @@ class Tree {
     return right_child_[node];
   }
 
+  inline int NumericalDecisionByBins(uint32_t fval, int node, const uint32_t* node_bins) const {
+    // threshold bin, zero bin and NaN bin of this node
+    const uint32_t* bins = node_bins + 3 * node;
+    uint8_t missing_type = GetMissingType(decision_type_[node]);
+    if (fval == bins[2]) {
+      if (missing_type != 2) {
+        fval = bins[1];
+      }
+    }
+    if ((missing_type == 1 && fval == bins[1])
+        || (missing_type == 2 && fval == bins[2])) {
+      if (GetDecisionType(decision_type_[node], kDefaultLeftMask)) {
+        return left_child_[node];
+      } else {
+        return right_child_[node];
+      }
+    }
+    if (fval <= bins[0]) {
+      return left_child_[node];
+    } else {
+      return right_child_[node];
+    }
+  }
+
   inline int CategoricalDecisionInner(uint32_t fval, int node) const {
     int cat_idx = static_cast<int>(threshold_in_bin_[node]);
     if (Common::FindInBitset(cat_threshold_inner_.data() + cat_boundaries_inner_[cat_idx],
@@ -286,7 +414,8 @@ class Tree {
     return right_child_[node];
   }
 
-  inline int Decision(double fval, int node) const {
+  template<typename T>
+  inline int Decision(T fval, int node) const {
     if (GetDecisionType(decision_type_[node], kCategoricalMask)) {
       return CategoricalDecision(fval, node);
     } else {
@@ -306,11 +435,13 @@ class Tree {
                     double left_weight, double right_weight, float gain);
   /*!
   * \brief Find leaf index of which record belongs by features
-  * \param feature_values Feature value of this record
+  * \param feature_values Feature value of this record, double or float
   * \return Leaf index
   */
-  inline int GetLeaf(const double* feature_values) const;
+  template<typename T>
+  inline int GetLeaf(const T* feature_values) const;
   inline int GetLeafByMap(const std::unordered_map<int, double>& feature_values) const;
+  inline int GetLeafByBins(const uint16_t* feature_bins, const uint32_t* node_bins) const;
 
   /*! \brief Serialize one node to json*/
   std::string NodeToJSON(int index) const;
@@ -374,6 +505,8 @@ class Tree {
   std::vector<uint32_t> threshold_in_bin_;
   /*! \brief A non-leaf node's split threshold in feature value */
   std::vector<double> threshold_;
+  /*! \brief The largest float not above threshold_, float x <= it iff double(x) <= threshold_ */
+  std::vector<float> threshold_float_;
   int num_cat_;
   std::vector<int> cat_boundaries_inner_;
   std::vector<uint32_t> cat_threshold_inner_;
@@ -444,7 +577,8 @@ inline void Tree::Split(int leaf, int feature, int real_feature,
   leaf_depth_[leaf]++;
 }
 
-inline double Tree::Predict(const double* feature_values) const {
+template<typename T>
+inline double Tree::Predict(const T* feature_values) const {
   if (num_leaves_ > 1) {
     int leaf = GetLeaf(feature_values);
     return LeafOutput(leaf);
@@ -462,7 +596,8 @@ inline double Tree::PredictByMap(const std::unordered_map<int, double>& feature_
   }
 }
 
-inline int Tree::PredictLeafIndex(const double* feature_values) const {
+template<typename T>
+inline int Tree::PredictLeafIndex(const T* feature_values) const {
   if (num_leaves_ > 1) {
     int leaf = GetLeaf(feature_values);
     return leaf;
@@ -480,6 +615,24 @@ inline int Tree::PredictLeafIndexByMap(const std::unordered_map<int, double>& fe
   }
 }
 
+inline double Tree::PredictByBins(const uint16_t* feature_bins, const uint32_t* node_bins) const {
+  if (num_leaves_ > 1) {
+    int leaf = GetLeafByBins(feature_bins, node_bins);
+    return LeafOutput(leaf);
+  } else {
+    return leaf_value_[0];
+  }
+}
+
+inline int Tree::PredictLeafIndexByBins(const uint16_t* feature_bins, const uint32_t* node_bins) const {
+  if (num_leaves_ > 1) {
+    int leaf = GetLeafByBins(feature_bins, node_bins);
+    return leaf;
+  } else {
+    return 0;
+  }
+}
+
 inline void Tree::PredictContrib(const double* feature_values, int num_features, double* output) {
   output[num_features] += ExpectedValue();
   // Run the recursion with preallocated space for the unique path data
@@ -501,7 +654,8 @@ inline void Tree::RecomputeLeafDepths(int node, int depth) {
   }
 }
 
-inline int Tree::GetLeaf(const double* feature_values) const {
+template<typename T>
+inline int Tree::GetLeaf(const T* feature_values) const {
   int node = 0;
   if (num_cat_ > 0) {
     while (node >= 0) {
@@ -529,6 +683,24 @@ inline int Tree::GetLeafByMap(const std::unordered_map<int, double>& feature_val
   return ~node;
 }
 
+inline int Tree::GetLeafByBins(const uint16_t* feature_bins, const uint32_t* node_bins) const {
+  int node = 0;
+  if (num_cat_ > 0) {
+    while (node >= 0) {
+      if (GetDecisionType(decision_type_[node], kCategoricalMask)) {
+        node = CategoricalDecision(feature_bins[split_feature_[node]], node);
+      } else {
+        node = NumericalDecisionByBins(feature_bins[split_feature_[node]], node, node_bins);
+      }
+    }
+  } else {
+    while (node >= 0) {
+      node = NumericalDecisionByBins(feature_bins[split_feature_[node]], node, node_bins);
+    }
+  }
+  return ~node;
+}
+
 
 }  // namespace LightGBM
 
@@ -8,6 +8,7 @@
 #include <LightGBM/config.h>
 #include <LightGBM/meta.h>
 
+#include <map>
 #include <string>
 #include <vector>
 
@@ -71,6 +72,13 @@ class TreeLearner {
   virtual void SetBaggingData(const data_size_t* used_indices,
     data_size_t num_data) = 0;
 
+  /*!
+  * \brief Set the index in its iteration of the trees trained next,
+  *        the state carried from one tree to the next, e.g. for feature pruning, is kept for each index
+  * \param tree_class Index of the tree in its iteration, smaller than num_class
+  */
+  virtual void SetTreeClass(int tree_class) = 0;
+
   /*!
   * \brief Using last trained tree to predict score then adding to out_score;
   * \param out_score output score
@@ -80,6 +88,37 @@ class TreeLearner {
   virtual void RenewTreeOutput(Tree* tree, const ObjectiveFunction* obj, std::function<double(const label_t*, int)> residual_getter,
                                data_size_t total_num_data, const data_size_t* bag_indices, data_size_t bag_cnt) const = 0;
 
+  /*!
+  * \brief Add the sizes in byte of the buffers owned by this learner, keyed by component name
+  * \param sizes Output map, sizes are added to the existing values
+  */
+  virtual void AddSizesInByte(std::map<std::string, size_t>* sizes) const = 0;
+
+  /*!
+  * \brief Add the counts of the decisions made while training, keyed by name
+  * \param stats Output map, counts are added to the existing values
+  */
+  virtual void AddTrainingStats(std::map<std::string, int64_t>* stats) const = 0;
+
+  /*!
+  * \brief Shrink the histogram pool so that it fits into the given number of bytes, at least 2 histograms are kept
+  * \param max_bytes Max sizes in byte of the histogram pool
+  */
+  virtual void LimitHistogramPool(size_t max_bytes) = 0;
+
+  /*!
+  * \brief Serialize the state carried from one tree to the next, e.g. random generators, used by checkpoints
+  * \return Binary state
+  */
+  virtual std::string SaveState() const = 0;
+
+  /*!
+  * \brief Restore the state returned by SaveState
+  * \param state Binary state
+  * \return False if the state does not fit this learner
+  */
+  virtual bool LoadState(const std::string& state) = 0;
+
   TreeLearner() = default;
   /*! \brief Disable copy */
   TreeLearner& operator=(const TreeLearner&) = delete;
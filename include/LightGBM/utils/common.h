@@ -14,6 +14,7 @@
 #include <cmath>
 #include <cstdint>
 #include <cstdio>
+#include <cstring>
 #include <functional>
 #include <iomanip>
 #include <iterator>
@@ -837,6 +838,53 @@ inline static void ObtainMinMaxSum(const T1 *w, int nw, T1 *mi, T1 *ma, T2 *su)
   }
 }
 
+/*!
+* \brief Append the bytes of a plain value to a binary buffer
+*/
+template<typename T>
+inline static void AppendToBinary(const T& val, std::string* buffer) {
+  buffer->append(reinterpret_cast<const char*>(&val), sizeof(T));
+}
+
+/*!
+* \brief Append a vector of plain values to a binary buffer, prefixed by its size
+*/
+template<typename T>
+inline static void AppendToBinary(const std::vector<T>& vec, std::string* buffer) {
+  AppendToBinary(static_cast<uint64_t>(vec.size()), buffer);
+  if (!vec.empty()) {
+    buffer->append(reinterpret_cast<const char*>(vec.data()), sizeof(T) * vec.size());
+  }
+}
+
+/*!
+* \brief Read a plain value written by AppendToBinary at position *pos of buffer
+* \return False if the buffer is too short
+*/
+template<typename T>
+inline static bool ReadFromBinary(const std::string& buffer, size_t* pos, T* val) {
+  if (buffer.size() < *pos || buffer.size() - *pos < sizeof(T)) { return false; }
+  std::memcpy(val, buffer.data() + *pos, sizeof(T));
+  *pos += sizeof(T);
+  return true;
+}
+
+/*!
+* \brief Read a vector written by AppendToBinary at position *pos of buffer
+* \return False if the buffer is too short
+*/
+template<typename T>
+inline static bool ReadFromBinary(const std::string& buffer, size_t* pos, std::vector<T>* vec) {
+  uint64_t size = 0;
+  if (!ReadFromBinary(buffer, pos, &size) || (buffer.size() - *pos) / sizeof(T) < size) { return false; }
+  vec->resize(static_cast<size_t>(size));
+  if (size > 0) {
+    std::memcpy(vec->data(), buffer.data() + *pos, sizeof(T) * vec->size());
+  }
+  *pos += sizeof(T) * vec->size();
+  return true;
+}
+
 inline static std::vector<uint32_t> EmptyBitset(int n) {
   int size = n / 32;
   if (n % 32 != 0) ++size;
@@ -855,16 +903,22 @@ inline static void InsertBitset(std::vector<uint32_t>* vec, const T val) {
 }
 
 template<typename T>
-inline static std::vector<uint32_t> ConstructBitset(const T* vals, int n) {
-  std::vector<uint32_t> ret;
+inline static void ConstructBitset(const T* vals, int n, std::vector<uint32_t>* out) {
+  out->clear();
   for (int i = 0; i < n; ++i) {
     int i1 = vals[i] / 32;
     int i2 = vals[i] % 32;
-    if (static_cast<int>(ret.size()) < i1 + 1) {
-      ret.resize(i1 + 1, 0);
+    if (static_cast<int>(out->size()) < i1 + 1) {
+      out->resize(i1 + 1, 0);
     }
-    ret[i1] |= (1 << i2);
+    (*out)[i1] |= (1 << i2);
   }
+}
+
+template<typename T>
+inline static std::vector<uint32_t> ConstructBitset(const T* vals, int n) {
+  std::vector<uint32_t> ret;
+  ConstructBitset(vals, n, &ret);
   return ret;
 }
 
@@ -66,6 +66,17 @@ struct VirtualFileReader {
    * \return Number of bytes read
    */
   virtual size_t Read(void* buffer, size_t bytes) const = 0;
+  /*!
+   * \brief Move the read position
+   * \param offset Offset in bytes from the beginning of the file
+   * \return True when succeeded
+   */
+  virtual bool Seek(size_t offset) const = 0;
+  /*!
+   * \brief Get the size of the file
+   * \return Size of the file in bytes
+   */
+  virtual size_t Size() const = 0;
   /*!
    * \brief Create appropriate reader for filename
    * \param filename Filename of the data
@@ -55,6 +55,13 @@ class Log {
     GetLevel() = level;
   }
 
+  /*!
+  * \brief Gets the minimal log level of the calling thread, e.g. to pass it on to a worker thread.
+  */
+  static LogLevel CurrentLogLevel() {
+    return GetLevel();
+  }
+
   static void Debug(const char *format, ...) {
     va_list val;
     va_start(val, format);
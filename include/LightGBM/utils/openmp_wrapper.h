@@ -65,6 +65,7 @@ catch(...) { omp_except_helper.CaptureException();  }
   inline void omp_set_nested(int) {}
   inline int omp_get_num_threads() {return 1;}
   inline int omp_get_thread_num() {return 0;}
+  inline int omp_in_parallel() {return 0;}
 #ifdef __cplusplus
 };  // extern "C"
 #endif
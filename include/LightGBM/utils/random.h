@@ -32,6 +32,13 @@ class Random {
   explicit Random(int seed) {
     x = seed;
   }
+  /*!
+  * \brief Current state of the generator, used to checkpoint and restore it
+  */
+  inline unsigned int State() const { return x; }
+
+  inline void SetState(unsigned int state) { x = state; }
+
   /*!
   * \brief Generate random integer, int16 range. [0, 65536]
   * \param lower_bound lower bound
@@ -68,10 +75,24 @@ class Random {
   */
   inline std::vector<int> Sample(int N, int K) {
     std::vector<int> ret;
-    ret.reserve(K);
+    Sample(N, K, &ret);
+    return ret;
+  }
+
+  /*!
+  * \brief Sample K data from {0,1,...,N-1} into an existing buffer, to reuse its memory
+  * \param N
+  * \param K
+  * \param out K Ordered sampled data from {0,1,...,N-1}
+  */
+  inline void Sample(int N, int K, std::vector<int>* out) {
+    std::vector<int>& ret = *out;
+    ret.clear();
     if (K > N || K <= 0) {
-      return ret;
-    } else if (K == N) {
+      return;
+    }
+    ret.reserve(K);
+    if (K == N) {
       for (int i = 0; i < N; ++i) {
         ret.push_back(i);
       }
@@ -94,7 +115,6 @@ class Random {
         ret.push_back(*iter);
       }
     }
-    return ret;
   }
 
  private:
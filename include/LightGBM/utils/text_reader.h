@@ -228,6 +228,153 @@ class TextReader {
     return total_cnt;
   }
 
+  /*!
+  * \brief Size of text data in bytes, the skipped header is excluded
+  */
+  size_t DataSize() const {
+    auto reader = VirtualFileReader::Make(filename_);
+    if (!reader->Init()) {
+      Log::Fatal("Could not open %s", filename_);
+    }
+    const size_t size = reader->Size();
+    const size_t skip_bytes = static_cast<size_t>(skip_bytes_);
+    return size > skip_bytes ? size - skip_bytes : 0;
+  }
+
+  /*!
+  * \brief Read the lines that start in byte range [range_begin, range_end) of the text data.
+  *        A line crossing range_end is read completely, while a line crossing range_begin belongs to the previous range,
+  *        so consecutive ranges cover every line exactly once
+  * \param range_begin Begin of the range, offset in text data
+  * \param range_end End of the range, offset in text data
+  * \param process_fun Process function for each line, its first argument is the line index in the range
+  * \return The number of lines in the range
+  */
+  INDEX_T ReadByteRangeAndProcess(size_t range_begin, size_t range_end,
+                                  const std::function<void(INDEX_T, const char*, size_t)>& process_fun) {
+    auto reader = VirtualFileReader::Make(filename_);
+    if (!reader->Init()) {
+      return 0;
+    }
+    // start one byte earlier to know whether range_begin is the start of a line
+    size_t pos = range_begin > 0 ? range_begin - 1 : 0;
+    if (!reader->Seek(static_cast<size_t>(skip_bytes_) + pos)) {
+      Log::Fatal("Could not seek to byte %zu of %s", static_cast<size_t>(skip_bytes_) + pos, filename_);
+    }
+    const size_t buffer_size = 16 * 1024 * 1024;
+    auto buffer = std::vector<char>(buffer_size);
+    INDEX_T total_cnt = 0;
+    size_t bytes_read = 0;
+    bool in_prev_line = range_begin > 0;
+    bool in_line = false;
+    bool is_finished = false;
+    std::string line;
+    size_t read_cnt = 0;
+    while (!is_finished && (read_cnt = reader->Read(buffer.data(), buffer_size)) > 0) {
+      size_t i = 0;
+      while (i < read_cnt) {
+        const bool is_eol = buffer[i] == '\n' || buffer[i] == '\r';
+        if (in_prev_line || in_line) {
+          // find the end of current line
+          size_t j = i;
+          while (j < read_cnt && buffer[j] != '\n' && buffer[j] != '\r') { ++j; }
+          if (in_line) {
+            line.append(buffer.data() + i, j - i);
+            if (j < read_cnt) {
+              process_fun(total_cnt, line.c_str(), line.size());
+              ++total_cnt;
+              line.clear();
+            }
+          }
+          if (j < read_cnt) {
+            in_prev_line = false;
+            in_line = false;
+          }
+          pos += j - i;
+          i = j;
+        } else if (is_eol) {
+          ++pos;
+          ++i;
+        } else if (pos >= range_end) {
+          is_finished = true;
+          break;
+        } else {
+          in_line = true;
+        }
+      }
+      size_t prev_bytes_read = bytes_read;
+      bytes_read += read_cnt;
+      if (prev_bytes_read / read_progress_interval_bytes_ < bytes_read / read_progress_interval_bytes_) {
+        Log::Debug("Read %.1f GBs from %s.", 1.0 * bytes_read / kGbs, filename_);
+      }
+    }
+    // if last line of file doesn't contain end of line
+    if (in_line) {
+      Log::Info("Warning: last line of %s has no end of line, still using this line", filename_);
+      process_fun(total_cnt, line.c_str(), line.size());
+      ++total_cnt;
+    }
+    return total_cnt;
+  }
+
+  /*!
+  * \brief Read the lines that start in byte range [range_begin, range_end) into memory
+  * \return The number of lines in the range
+  */
+  INDEX_T ReadByteRangeLines(size_t range_begin, size_t range_end) {
+    return ReadByteRangeAndProcess(range_begin, range_end,
+      [=](INDEX_T, const char* buffer, size_t size) {
+      lines_.emplace_back(buffer, size);
+    });
+  }
+
+  /*!
+  * \brief Sample the lines that start in byte range [range_begin, range_end)
+  * \return The number of lines in the range
+  */
+  INDEX_T SampleFromByteRange(size_t range_begin, size_t range_end, Random* random, INDEX_T sample_cnt,
+                              std::vector<std::string>* out_sampled_data) {
+    INDEX_T cur_sample_cnt = 0;
+    return ReadByteRangeAndProcess(range_begin, range_end,
+      [&]
+    (INDEX_T line_idx, const char* buffer, size_t size) {
+      if (cur_sample_cnt < sample_cnt) {
+        out_sampled_data->emplace_back(buffer, size);
+        ++cur_sample_cnt;
+      } else {
+        const size_t idx = static_cast<size_t>(random->NextInt(0, static_cast<int>(line_idx + 1)));
+        if (idx < static_cast<size_t>(sample_cnt)) {
+          out_sampled_data->operator[](idx) = std::string(buffer, size);
+        }
+      }
+    });
+  }
+
+  /*!
+  * \brief Read the lines that start in byte range [range_begin, range_end) and process them block by block
+  * \return The number of lines in the range
+  */
+  INDEX_T ReadByteRangeAndProcessParallel(size_t range_begin, size_t range_end,
+                                          const std::function<void(INDEX_T, const std::vector<std::string>&)>& process_fun) {
+    const size_t block_size = 1 << 16;
+    INDEX_T start_idx = 0;
+    INDEX_T total_cnt = ReadByteRangeAndProcess(range_begin, range_end,
+      [&]
+    (INDEX_T, const char* buffer, size_t size) {
+      lines_.emplace_back(buffer, size);
+      if (lines_.size() >= block_size) {
+        process_fun(start_idx, lines_);
+        start_idx += static_cast<INDEX_T>(lines_.size());
+        lines_.clear();
+      }
+    });
+    if (!lines_.empty()) {
+      process_fun(start_idx, lines_);
+      lines_.clear();
+    }
+    return total_cnt;
+  }
+
   INDEX_T CountLine() {
     return ReadAllAndProcess(
       [=](INDEX_T, const char*, size_t) {
@@ -18,8 +18,10 @@
 #include <string>
 #include <chrono>
 #include <cstdio>
+#include <cstring>
 #include <ctime>
 #include <fstream>
+#include <functional>
 #include <sstream>
 #include <utility>
 
@@ -33,7 +35,8 @@ Application::Application(int argc, char** argv) {
   if (config_.num_threads > 0) {
     omp_set_num_threads(config_.num_threads);
   }
-  if (config_.data.size() == 0 && config_.task != TaskType::kConvertModel) {
+  if (config_.data.size() == 0 && config_.task != TaskType::kConvertModel
+      && config_.task != TaskType::kCompactModel) {
     Log::Fatal("No training/prediction data, application quit");
   }
   omp_set_nested(0);
@@ -87,7 +90,7 @@ void Application::LoadData() {
   PredictFunction predict_fun = nullptr;
   // need to continue training
   if (boosting_->NumberOfTotalModel() > 0 && config_.task != TaskType::KRefitTree) {
-    predictor.reset(new Predictor(boosting_.get(), -1, true, false, false, false, -1, -1));
+    predictor.reset(new Predictor(boosting_.get(), -1, true, false, false, false, -1, -1, 0));
     predict_fun = predictor->GetPredictFunction();
   }
 
@@ -99,6 +102,11 @@ void Application::LoadData() {
   Log::Debug("Loading train file...");
   DatasetLoader dataset_loader(config_, predict_fun,
                                config_.num_class, config_.data.c_str());
+  if (predict_fun != nullptr && boosting_->NumModelPerIteration() == config_.num_class) {
+    dataset_loader.SetBinnedPredictFunction(
+      [this] (const Dataset* dataset) { return boosting_->CanPredictOnDatasetBins(dataset); },
+      [this] (const Dataset* dataset, double* init_score) { PredictInitScoreOnBins(dataset, init_score); });
+  }
   // load Training data
   if (config_.is_parallel_find_bin) {
     // load data for parallel training
@@ -120,6 +128,7 @@ void Application::LoadData() {
       auto metric = std::unique_ptr<Metric>(Metric::CreateMetric(metric_type, config_));
       if (metric == nullptr) { continue; }
       metric->Init(train_data_->metadata(), train_data_->num_data());
+      metric->SetDistributed(config_.is_parallel_find_bin);
       train_metric_.push_back(std::move(metric));
     }
   }
@@ -150,6 +159,8 @@ void Application::LoadData() {
         if (metric == nullptr) { continue; }
         metric->Init(valid_datas_.back()->metadata(),
                      valid_datas_.back()->num_data());
+        // validation data is only partitioned when it is pre-partitioned
+        metric->SetDistributed(config_.is_parallel_find_bin && config_.pre_partition);
         valid_metrics_.back().push_back(std::move(metric));
       }
       valid_metrics_.back().shrink_to_fit();
@@ -163,6 +174,44 @@ void Application::LoadData() {
             std::chrono::duration<double, std::milli>(end_time - start_time) * 1e-3);
 }
 
+void Application::PredictInitScoreOnBins(const Dataset* dataset, double* init_score) const {
+  if (!config_.init_score_cache || config_.is_parallel) {
+    boosting_->PredictRawOnDatasetBins(dataset, init_score);
+    return;
+  }
+  const char* cache_token = "______LightGBM_Init_Score_Cache______\n";
+  const size_t size_of_token = std::strlen(cache_token);
+  const std::string cache_filename = std::string(dataset->data_filename()) + ".init_score_cache";
+  // the scores only depend on the model and the bins of the data
+  const size_t model_hash = std::hash<std::string>()(boosting_->SaveModelToString(0, -1));
+  const size_t data_hash = dataset->BinHash();
+  const size_t num_score = static_cast<size_t>(dataset->num_data()) * config_.num_class;
+  auto reader = VirtualFileReader::Make(cache_filename);
+  if (reader->Init() && reader->Size() == size_of_token + sizeof(size_t) * 3 + sizeof(double) * num_score) {
+    std::vector<char> token(size_of_token);
+    size_t keys[3];
+    if (reader->Read(token.data(), size_of_token) == size_of_token
+        && std::memcmp(token.data(), cache_token, size_of_token) == 0
+        && reader->Read(keys, sizeof(keys)) == sizeof(keys)
+        && keys[0] == model_hash && keys[1] == data_hash && keys[2] == num_score
+        && reader->Read(init_score, sizeof(double) * num_score) == sizeof(double) * num_score) {
+      Log::Info("Loaded initial scores from cache file %s", cache_filename.c_str());
+      return;
+    }
+  }
+  boosting_->PredictRawOnDatasetBins(dataset, init_score);
+  auto writer = VirtualFileWriter::Make(cache_filename);
+  if (!writer->Init()) {
+    Log::Warning("Could not write initial scores to cache file %s", cache_filename.c_str());
+    return;
+  }
+  const size_t keys[3] = {model_hash, data_hash, num_score};
+  writer->Write(cache_token, size_of_token);
+  writer->Write(keys, sizeof(keys));
+  writer->Write(init_score, sizeof(double) * num_score);
+  Log::Info("Saved initial scores to cache file %s", cache_filename.c_str());
+}
+
 void Application::InitTrain() {
   if (config_.is_parallel) {
     // need init network
@@ -197,6 +246,8 @@ void Application::InitTrain() {
                                Common::ConstPtrInVectorWrapper<Metric>(valid_metrics_[i]));
     Log::Debug("Number of data points in validation set #%zu: %zu", i + 1, valid_datas_[i]->num_data());
   }
+  // continue from the latest checkpoint of an interrupted run
+  boosting_->ResumeFromCheckpoint();
   Log::Info("Finished initializing training");
 }
 
@@ -213,18 +264,7 @@ void Application::Train() {
 
 void Application::Predict() {
   if (config_.task == TaskType::KRefitTree) {
-    // create predictor
-    Predictor predictor(boosting_.get(), -1, false, true, false, false, 1, 1);
-    predictor.Predict(config_.data.c_str(), config_.output_result.c_str(), config_.header, config_.predict_disable_shape_check);
-    TextReader<int> result_reader(config_.output_result.c_str(), false);
-    result_reader.ReadAllLines();
-    std::vector<std::vector<int>> pred_leaf(result_reader.Lines().size());
-    #pragma omp parallel for schedule(static)
-    for (int i = 0; i < static_cast<int>(result_reader.Lines().size()); ++i) {
-      pred_leaf[i] = Common::StringToArray<int>(result_reader.Lines()[i], '\t');
-      // Free memory
-      result_reader.Lines()[i].clear();
-    }
+    std::vector<std::vector<int>> pred_leaf = PredictLeafIndex();
     DatasetLoader dataset_loader(config_, nullptr,
                                  config_.num_class, config_.data.c_str());
     train_data_.reset(dataset_loader.LoadFromFile(config_.data.c_str(), config_.initscore_filename.c_str(),
@@ -243,13 +283,29 @@ void Application::Predict() {
     Predictor predictor(boosting_.get(), config_.num_iteration_predict, config_.predict_raw_score,
                         config_.predict_leaf_index, config_.predict_contrib,
                         config_.pred_early_stop, config_.pred_early_stop_freq,
-                        config_.pred_early_stop_margin);
+                        config_.pred_early_stop_margin, config_.pred_tree_parallel_threshold);
     predictor.Predict(config_.data.c_str(),
                       config_.output_result.c_str(), config_.header, config_.predict_disable_shape_check);
     Log::Info("Finished prediction");
   }
 }
 
+std::vector<std::vector<int>> Application::PredictLeafIndex() {
+  // create predictor
+  Predictor predictor(boosting_.get(), -1, false, true, false, false, 1, 1, 0);
+  predictor.Predict(config_.data.c_str(), config_.output_result.c_str(), config_.header, config_.predict_disable_shape_check);
+  TextReader<int> result_reader(config_.output_result.c_str(), false);
+  result_reader.ReadAllLines();
+  std::vector<std::vector<int>> pred_leaf(result_reader.Lines().size());
+  #pragma omp parallel for schedule(static)
+  for (int i = 0; i < static_cast<int>(result_reader.Lines().size()); ++i) {
+    pred_leaf[i] = Common::StringToArray<int>(result_reader.Lines()[i], '\t');
+    // Free memory
+    result_reader.Lines()[i].clear();
+  }
+  return pred_leaf;
+}
+
 void Application::InitPredict() {
   boosting_.reset(
     Boosting::CreateBoosting("gbdt", config_.input_model.c_str()));
@@ -262,5 +318,15 @@ void Application::ConvertModel() {
   boosting_->SaveModelToIfElse(-1, config_.convert_model.c_str());
 }
 
+void Application::CompactModel() {
+  std::vector<std::vector<int>> pred_leaf;
+  if (config_.data.size() > 0) {
+    pred_leaf = PredictLeafIndex();
+  }
+  boosting_->CompactModel(pred_leaf);
+  boosting_->SaveModelToFile(0, -1, config_.output_model.c_str());
+  Log::Info("Finished compacting model");
+}
+
 
 }  // namespace LightGBM
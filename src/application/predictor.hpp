@@ -35,10 +35,12 @@ class Predictor {
   * \param is_raw_score True if need to predict result with raw score
   * \param predict_leaf_index True to output leaf index instead of prediction score
   * \param predict_contrib True to output feature contributions instead of prediction score
+  * \param tree_parallel_threshold Minimal number of trees to split a single row prediction over threads, <= 0 means never
   */
   Predictor(Boosting* boosting, int num_iteration,
             bool is_raw_score, bool predict_leaf_index, bool predict_contrib,
-            bool early_stop, int early_stop_freq, double early_stop_margin) {
+            bool early_stop, int early_stop_freq, double early_stop_margin,
+            int tree_parallel_threshold) {
     early_stop_ = CreatePredictionEarlyStopInstance("none", LightGBM::PredictionEarlyStopConfig());
     if (early_stop && !boosting->NeedAccuratePrediction()) {
       PredictionEarlyStopConfig pred_early_stop_config;
@@ -59,13 +61,23 @@ class Predictor {
       num_threads_ = omp_get_num_threads();
     }
     boosting->InitPredict(num_iteration, predict_contrib);
+    boosting->InitPredictTreeParallel(tree_parallel_threshold);
     boosting_ = boosting;
     num_pred_one_row_ = boosting_->NumPredictOneRow(num_iteration, predict_leaf_index, predict_contrib);
     num_feature_ = boosting_->MaxFeatureIdx() + 1;
     predict_buf_ = std::vector<std::vector<double>>(num_threads_, std::vector<double>(num_feature_, 0.0f));
     const int kFeatureThreshold = 100000;
     const size_t KSparseThreshold = static_cast<size_t>(0.01 * num_feature_);
+    if (num_feature_ > kFeatureThreshold && !predict_contrib) {
+      boosting->InitPredictByMap();
+    }
     if (predict_leaf_index) {
+      dense_float_predict_fun_ = [=](const float* features, double* output) {
+        boosting_->PredictLeafIndex(features, output);
+      };
+      dense_predict_fun_ = [=](const double* features, double* output) {
+        boosting_->PredictLeafIndex(features, output);
+      };
       predict_fun_ = [=](const std::vector<std::pair<int, double>>& features, double* output) {
         int tid = omp_get_thread_num();
         if (num_feature_ > kFeatureThreshold && features.size() < KSparseThreshold) {
@@ -88,6 +100,12 @@ class Predictor {
         };
     } else {
       if (is_raw_score) {
+        dense_float_predict_fun_ = [=](const float* features, double* output) {
+          boosting_->PredictRaw(features, output, &early_stop_);
+        };
+        dense_predict_fun_ = [=](const double* features, double* output) {
+          boosting_->PredictRaw(features, output, &early_stop_);
+        };
         predict_fun_ = [=](const std::vector<std::pair<int, double>>& features, double* output) {
           int tid = omp_get_thread_num();
           if (num_feature_ > kFeatureThreshold && features.size() < KSparseThreshold) {
@@ -100,6 +118,12 @@ class Predictor {
           }
         };
       } else {
+        dense_float_predict_fun_ = [=](const float* features, double* output) {
+          boosting_->Predict(features, output, &early_stop_);
+        };
+        dense_predict_fun_ = [=](const double* features, double* output) {
+          boosting_->Predict(features, output, &early_stop_);
+        };
         predict_fun_ = [=](const std::vector<std::pair<int, double>>& features, double* output) {
           int tid = omp_get_thread_num();
           if (num_feature_ > kFeatureThreshold && features.size() < KSparseThreshold) {
@@ -125,6 +149,22 @@ class Predictor {
     return predict_fun_;
   }
 
+  /*!
+  * \brief Get the predict function on dense float32 rows of all features, which reads rows in place
+  * \return nullptr if not supported by the prediction type
+  */
+  inline const std::function<void(const float*, double*)>& GetDenseFloatPredictFunction() const {
+    return dense_float_predict_fun_;
+  }
+
+  /*!
+  * \brief Get the predict function on dense float64 rows, which should hold at least all features of the model
+  * \return nullptr if not supported by the prediction type
+  */
+  inline const std::function<void(const double*, double*)>& GetDensePredictFunction() const {
+    return dense_predict_fun_;
+  }
+
   /*!
   * \brief predicting on data, then saving result to disk
   * \param data_filename Filename of data
@@ -259,6 +299,10 @@ class Predictor {
   const Boosting* boosting_;
   /*! \brief function for prediction */
   PredictFunction predict_fun_;
+  /*! \brief Predict function on dense float32 rows */
+  std::function<void(const float*, double*)> dense_float_predict_fun_;
+  /*! \brief Predict function on dense float64 rows */
+  std::function<void(const double*, double*)> dense_predict_fun_;
   PredictionEarlyStopInstance early_stop_;
   int num_feature_;
   int num_pred_one_row_;
@@ -135,6 +135,9 @@ class DART: public GBDT {
         train_score_updater_->AddScore(models_[curr_tree].get(), cur_tree_id);
       }
     }
+    if (!drop_index_.empty()) {
+      ++model_version_;
+    }
     if (!config_->xgboost_dart_mode) {
       shrinkage_rate_ = config_->learning_rate / (1.0f + static_cast<double>(drop_index_.size()));
     } else {
@@ -194,6 +197,9 @@ class DART: public GBDT {
         }
       }
     }
+    if (!drop_index_.empty()) {
+      ++model_version_;
+    }
   }
   /*! \brief The weights of all trees, used to choose drop trees */
   std::vector<double> tree_weight_;
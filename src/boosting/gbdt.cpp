@@ -13,6 +13,7 @@
 
 #include <chrono>
 #include <ctime>
+#include <iomanip>
 #include <sstream>
 
 namespace LightGBM {
@@ -115,6 +116,9 @@ void GBDT::Init(const Config* config, const Dataset* train_data, const Objective
       class_need_train_[i] = objective_function_->ClassNeedTrain(i);
     }
   }
+
+  peak_memory_usage_.clear();
+  UpdateMemoryUsage(true);
 }
 
 void GBDT::AddValidDataset(const Dataset* valid_data,
@@ -125,12 +129,7 @@ void GBDT::AddValidDataset(const Dataset* valid_data,
   // for a validation dataset, we need its score and metric
   auto new_score_updater = std::unique_ptr<ScoreUpdater>(new ScoreUpdater(valid_data, num_tree_per_iteration_));
   // update score
-  for (int i = 0; i < iter_; ++i) {
-    for (int cur_tree_id = 0; cur_tree_id < num_tree_per_iteration_; ++cur_tree_id) {
-      auto curr_tree = (i + num_init_iteration_) * num_tree_per_iteration_ + cur_tree_id;
-      new_score_updater->AddScore(models_[curr_tree].get(), cur_tree_id);
-    }
-  }
+  new_score_updater->AddScore(TrainedTrees(), num_tree_per_iteration_);
   valid_score_updater_.push_back(std::move(new_score_updater));
   valid_metrics_.emplace_back();
   for (const auto& metric : valid_metrics) {
@@ -278,7 +277,8 @@ void GBDT::Bagging(int iter) {
 void GBDT::Train(int snapshot_freq, const std::string& model_output_path) {
   bool is_finished = false;
   auto start_time = std::chrono::steady_clock::now();
-  for (int iter = 0; iter < config_->num_iterations && !is_finished; ++iter) {
+  // continue from the iteration restored by ResumeFromCheckpoint
+  for (int iter = iter_; iter < config_->num_iterations && !is_finished; ++iter) {
     is_finished = TrainOneIter(nullptr, nullptr);
     if (!is_finished) {
       is_finished = EvalAndCheckEarlyStopping();
@@ -292,7 +292,12 @@ void GBDT::Train(int snapshot_freq, const std::string& model_output_path) {
       std::string snapshot_out = model_output_path + ".snapshot_iter_" + std::to_string(iter + 1);
       SaveModelToFile(0, -1, snapshot_out.c_str());
     }
+    if (config_->checkpoint_freq > 0 && !is_finished
+        && (iter + 1) % config_->checkpoint_freq == 0) {
+      SaveCheckpoint();
+    }
   }
+  UpdateMemoryUsage(true);
 }
 
 void GBDT::RefitTree(const std::vector<std::vector<int>>& tree_leaf_prediction) {
@@ -318,6 +323,199 @@ void GBDT::RefitTree(const std::vector<std::vector<int>>& tree_leaf_prediction)
       models_[model_index].reset(new_tree);
     }
   }
+  ++model_version_;
+}
+
+int GBDT::CompactModel(const std::vector<std::vector<int>>& tree_leaf_prediction) {
+  const int num_models = static_cast<int>(models_.size());
+  std::vector<std::vector<int>> leaf_visits(num_models);
+  if (!tree_leaf_prediction.empty()) {
+    for (size_t i = 0; i < tree_leaf_prediction.size(); ++i) {
+      const auto& leaf_pred = tree_leaf_prediction[i];
+      if (leaf_pred.size() != static_cast<size_t>(num_models)) {
+        Log::Fatal("Leaf predictions of row %d have %d columns, but the model has %d trees",
+                   static_cast<int>(i), static_cast<int>(leaf_pred.size()), num_models);
+      }
+      for (int model_index = 0; model_index < num_models; ++model_index) {
+        if (leaf_pred[model_index] < 0 || leaf_pred[model_index] >= models_[model_index]->num_leaves()) {
+          Log::Fatal("Leaf prediction %d of row %d is out of range, tree %d has %d leaves",
+                     leaf_pred[model_index], static_cast<int>(i), model_index, models_[model_index]->num_leaves());
+        }
+      }
+    }
+    #pragma omp parallel for schedule(static)
+    for (int model_index = 0; model_index < num_models; ++model_index) {
+      leaf_visits[model_index].resize(models_[model_index]->num_leaves(), 0);
+      for (const auto& leaf_pred : tree_leaf_prediction) {
+        ++leaf_visits[model_index][leaf_pred[model_index]];
+      }
+    }
+  }
+  int num_removed_leaves = 0;
+  #pragma omp parallel for schedule(dynamic) reduction(+:num_removed_leaves)
+  for (int model_index = 0; model_index < num_models; ++model_index) {
+    num_removed_leaves += models_[model_index]->Compact(leaf_visits[model_index]);
+  }
+  // the outputs of random forest are averaged over iterations, so its iterations are kept
+  int num_removed_iterations = 0;
+  if (!average_output_) {
+    const int num_iterations = num_models / num_tree_per_iteration_;
+    std::vector<std::unique_ptr<Tree>> kept_models;
+    // kept iterations by the hash of their tree structures
+    std::unordered_map<size_t, std::vector<int>> kept_by_structure;
+    for (int iter = 0; iter < num_iterations; ++iter) {
+      const auto trees = models_.begin() + iter * num_tree_per_iteration_;
+      bool is_constant = true;
+      size_t structure_hash = 0;
+      for (int tree_id = 0; tree_id < num_tree_per_iteration_; ++tree_id) {
+        is_constant = is_constant && trees[tree_id]->num_leaves() == 1;
+        structure_hash = structure_hash * 31 + trees[tree_id]->StructureHash();
+      }
+      int target = -1;
+      if (is_constant && !kept_models.empty()) {
+        target = 0;
+      } else {
+        for (int kept_iter : kept_by_structure[structure_hash]) {
+          bool is_same = true;
+          for (int tree_id = 0; tree_id < num_tree_per_iteration_ && is_same; ++tree_id) {
+            is_same = kept_models[kept_iter * num_tree_per_iteration_ + tree_id]->HasSameStructure(*trees[tree_id]);
+          }
+          if (is_same) {
+            target = kept_iter;
+            break;
+          }
+        }
+      }
+      if (target >= 0) {
+        for (int tree_id = 0; tree_id < num_tree_per_iteration_; ++tree_id) {
+          kept_models[target * num_tree_per_iteration_ + tree_id]->AddLeafOutputs(*trees[tree_id]);
+        }
+        ++num_removed_iterations;
+      } else {
+        kept_by_structure[structure_hash].push_back(static_cast<int>(kept_models.size()) / num_tree_per_iteration_);
+        for (int tree_id = 0; tree_id < num_tree_per_iteration_; ++tree_id) {
+          kept_models.push_back(std::move(trees[tree_id]));
+        }
+      }
+    }
+    models_ = std::move(kept_models);
+  }
+  ++model_version_;
+  num_iteration_for_pred_ = static_cast<int>(models_.size()) / num_tree_per_iteration_;
+  num_init_iteration_ = num_iteration_for_pred_;
+  iter_ = 0;
+  Log::Info("Compacted model: removed %d leaves and %d iterations, %d iterations left",
+            num_removed_leaves, num_removed_iterations, num_iteration_for_pred_);
+  return num_removed_iterations;
+}
+
+void GBDT::GetMemoryUsage(std::map<std::string, size_t>* out_sizes) const {
+  auto& sizes = *out_sizes;
+  for (auto& pair : sizes) {
+    pair.second = 0;
+  }
+  size_t models_size = models_size_in_byte_;
+  if (models_size_version_ != model_version_) {
+    models_size = 0;
+    for (const auto& tree : models_) {
+      models_size += tree->SizesInByte();
+    }
+  }
+  sizes["models"] = models_size;
+  if (train_data_ != nullptr) {
+    sizes["dataset"] = train_data_->SizesInByte();
+    sizes["gradients"] = sizeof(score_t) * (gradients_.capacity() + hessians_.capacity());
+    size_t bagging_size = sizeof(data_size_t) * (bag_data_indices_.capacity() + tmp_indices_.capacity());
+    if (tmp_subset_ != nullptr) {
+      bagging_size += tmp_subset_->SizesInByte();
+    }
+    sizes["bagging"] = bagging_size;
+    size_t score_size = train_score_updater_ != nullptr ? train_score_updater_->SizesInByte() : 0;
+    for (const auto& score_updater : valid_score_updater_) {
+      score_size += score_updater->SizesInByte();
+    }
+    sizes["score_updaters"] = score_size;
+  }
+  if (tree_learner_ != nullptr) {
+    tree_learner_->AddSizesInByte(&sizes);
+  }
+  size_t total = 0;
+  for (const auto& pair : sizes) {
+    total += pair.second;
+  }
+  sizes["total"] = total;
+}
+
+void GBDT::UpdateMemoryUsage(bool log) {
+  // the map is reused, keys are short enough to not allocate once they exist
+  auto& sizes = memory_usage_;
+  GetMemoryUsage(&sizes);
+  // trees added by training are counted incrementally from here on
+  models_size_in_byte_ = sizes["models"];
+  models_size_version_ = model_version_;
+  if (config_ != nullptr && config_->memory_budget > 0.0f && tree_learner_ != nullptr) {
+    const size_t budget = static_cast<size_t>(config_->memory_budget * 1024 * 1024);
+    if (sizes["total"] > budget) {
+      const size_t others = sizes["total"] - sizes["histogram_pool"];
+      tree_learner_->LimitHistogramPool(budget > others ? budget - others : 0);
+      GetMemoryUsage(&sizes);
+      if (sizes["total"] > budget) {
+        Log::Warning("Memory usage %.3f MB exceeds memory_budget %.3f MB after shrinking the histogram pool",
+                     sizes["total"] / 1024.0 / 1024.0, config_->memory_budget);
+      }
+    }
+  }
+  for (const auto& pair : sizes) {
+    peak_memory_usage_[pair.first] = std::max(peak_memory_usage_[pair.first], pair.second);
+  }
+  if (log) {
+    std::stringstream str_buf;
+    str_buf << std::fixed << std::setprecision(3);
+    for (const auto& pair : sizes) {
+      if (pair.first != "total") {
+        str_buf << ", " << pair.first << " " << pair.second / 1024.0 / 1024.0;
+      }
+    }
+    Log::Info("Memory usage %.3f MB (peak %.3f MB)%s", sizes["total"] / 1024.0 / 1024.0,
+              peak_memory_usage_["total"] / 1024.0 / 1024.0, str_buf.str().c_str());
+  }
+}
+
+std::string GBDT::MemoryUsageToJSON() const {
+  std::map<std::string, size_t> sizes;
+  GetMemoryUsage(&sizes);
+  std::stringstream str_buf;
+  str_buf << "{";
+  bool first = true;
+  for (const auto& pair : sizes) {
+    size_t peak = pair.second;
+    auto it = peak_memory_usage_.find(pair.first);
+    if (it != peak_memory_usage_.end()) {
+      peak = std::max(peak, it->second);
+    }
+    if (!first) { str_buf << ","; }
+    first = false;
+    str_buf << "\"" << pair.first << "\":{\"current\":" << pair.second << ",\"peak\":" << peak << "}";
+  }
+  str_buf << "}";
+  return str_buf.str();
+}
+
+std::string GBDT::TrainingStatsToJSON() const {
+  std::map<std::string, int64_t> stats;
+  if (tree_learner_ != nullptr) {
+    tree_learner_->AddTrainingStats(&stats);
+  }
+  std::stringstream str_buf;
+  str_buf << "{";
+  bool first = true;
+  for (const auto& pair : stats) {
+    if (!first) { str_buf << ","; }
+    first = false;
+    str_buf << "\"" << pair.first << "\":" << pair.second;
+  }
+  str_buf << "}";
+  return str_buf.str();
 }
 
 /* If the custom "average" is implemented it will be used inplace of the label average (if enabled)
@@ -366,7 +564,8 @@ double GBDT::BoostFromAverage(int class_id, bool update_scorer) {
 }
 
 bool GBDT::TrainOneIter(const score_t* gradients, const score_t* hessians) {
-  std::vector<double> init_scores(num_tree_per_iteration_, 0.0);
+  auto& init_scores = init_scores_buf_;
+  init_scores.assign(num_tree_per_iteration_, 0.0);
   // boosting first
   if (gradients == nullptr || hessians == nullptr) {
     for (int cur_tree_id = 0; cur_tree_id < num_tree_per_iteration_; ++cur_tree_id) {
@@ -380,13 +579,15 @@ bool GBDT::TrainOneIter(const score_t* gradients, const score_t* hessians) {
   Bagging(iter_);
 
   bool should_continue = false;
+  int64_t added_size = 0;
   for (int cur_tree_id = 0; cur_tree_id < num_tree_per_iteration_; ++cur_tree_id) {
     const size_t offset = static_cast<size_t>(cur_tree_id) * num_data_;
-    std::unique_ptr<Tree> new_tree(new Tree(2));
+    std::unique_ptr<Tree> new_tree;
     if (class_need_train_[cur_tree_id] && train_data_->num_features() > 0) {
       auto grad = gradients + offset;
       auto hess = hessians + offset;
       // need to copy gradients for bagging subset.
+      // bagging indices are ascending, so this is also safe when grad points into gradients_
       if (is_use_subset_ && bag_data_cnt_ < num_data_) {
         for (int i = 0; i < bag_data_cnt_; ++i) {
           gradients_[offset + i] = grad[bag_data_indices_[i]];
@@ -395,7 +596,10 @@ bool GBDT::TrainOneIter(const score_t* gradients, const score_t* hessians) {
         grad = gradients_.data() + offset;
         hess = hessians_.data() + offset;
       }
+      tree_learner_->SetTreeClass(cur_tree_id);
       new_tree.reset(tree_learner_->Train(grad, hess, is_constant_hessian_, forced_splits_json_));
+    } else {
+      new_tree.reset(new Tree(2));
     }
 
     if (new_tree->num_leaves() > 1) {
@@ -431,8 +635,10 @@ bool GBDT::TrainOneIter(const score_t* gradients, const score_t* hessians) {
       }
     }
     // add model
+    added_size += new_tree->SizesInByte();
     models_.push_back(std::move(new_tree));
   }
+  OnModelsResized(added_size);
 
   if (!should_continue) {
     Log::Warning("Stopped training because there are no more leaves that meet the split requirements");
@@ -440,14 +646,28 @@ bool GBDT::TrainOneIter(const score_t* gradients, const score_t* hessians) {
       for (int cur_tree_id = 0; cur_tree_id < num_tree_per_iteration_; ++cur_tree_id) {
         models_.pop_back();
       }
+      OnModelsResized(-added_size);
     }
     return true;
   }
 
+  UpdateMemoryUsage(false);
   ++iter_;
   return false;
 }
 
+int64_t GBDT::GetGradientBuffers(score_t** out_gradients, score_t** out_hessians) {
+  // buffers are not allocated when training without objective function
+  size_t total_size = static_cast<size_t>(num_data_) * num_tree_per_iteration_;
+  if (gradients_.size() != total_size) {
+    gradients_.resize(total_size);
+    hessians_.resize(total_size);
+  }
+  *out_gradients = gradients_.data();
+  *out_hessians = hessians_.data();
+  return static_cast<int64_t>(total_size);
+}
+
 void GBDT::RollbackOneIter() {
   if (iter_ <= 0) { return; }
   // reset score
@@ -460,9 +680,12 @@ void GBDT::RollbackOneIter() {
     }
   }
   // remove model
+  int64_t removed_size = 0;
   for (int cur_tree_id = 0; cur_tree_id < num_tree_per_iteration_; ++cur_tree_id) {
+    removed_size += models_.back()->SizesInByte();
     models_.pop_back();
   }
+  OnModelsResized(-removed_size);
   --iter_;
 }
 
@@ -477,14 +700,22 @@ bool GBDT::EvalAndCheckEarlyStopping() {
     Log::Info("Early stopping at iteration %d, the best iteration round is %d",
               iter_, iter_ - early_stopping_round_);
     Log::Info("Output of best iteration round:\n%s", best_msg.c_str());
-    // pop last early_stopping_round_ models
-    for (int i = 0; i < early_stopping_round_ * num_tree_per_iteration_; ++i) {
-      models_.pop_back();
+    // roll back last early_stopping_round_ iterations, so scores stay consistent with the kept models
+    for (int i = 0; i < early_stopping_round_; ++i) {
+      RollbackOneIter();
     }
   }
   return is_met_early_stopping;
 }
 
+std::vector<const Tree*> GBDT::TrainedTrees() const {
+  std::vector<const Tree*> trees;
+  for (int i = num_init_iteration_ * num_tree_per_iteration_; i < (num_init_iteration_ + iter_) * num_tree_per_iteration_; ++i) {
+    trees.push_back(models_[i].get());
+  }
+  return trees;
+}
+
 void GBDT::UpdateScore(const Tree* tree, const int cur_tree_id) {
   // update training score
   if (!is_use_subset_) {
@@ -685,12 +916,7 @@ void GBDT::ResetTrainingData(const Dataset* train_data, const ObjectiveFunction*
     train_score_updater_.reset(new ScoreUpdater(train_data_, num_tree_per_iteration_));
 
     // update score
-    for (int i = 0; i < iter_; ++i) {
-      for (int cur_tree_id = 0; cur_tree_id < num_tree_per_iteration_; ++cur_tree_id) {
-        auto curr_tree = (i + num_init_iteration_) * num_tree_per_iteration_ + cur_tree_id;
-        train_score_updater_->AddScore(models_[curr_tree].get(), cur_tree_id);
-      }
-    }
+    train_score_updater_->AddScore(TrainedTrees(), num_tree_per_iteration_);
 
     num_data_ = train_data_->num_data();
 
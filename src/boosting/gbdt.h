@@ -12,6 +12,7 @@
 #include <string>
 #include <algorithm>
 #include <cstdio>
+#include <deque>
 #include <fstream>
 #include <map>
 #include <memory>
@@ -73,6 +74,7 @@ class GBDT : public GBDTBase {
       auto new_tree = std::unique_ptr<Tree>(new Tree(*(tree.get())));
       models_.push_back(std::move(new_tree));
     }
+    ++model_version_;
     num_iteration_for_pred_ = static_cast<int>(models_.size()) / num_tree_per_iteration_;
   }
 
@@ -101,6 +103,7 @@ class GBDT : public GBDTBase {
         models_.push_back(std::move(new_tree));
       }
     }
+    ++model_version_;
   }
 
   /*!
@@ -135,6 +138,12 @@ class GBDT : public GBDTBase {
 
   void RefitTree(const std::vector<std::vector<int>>& tree_leaf_prediction) override;
 
+  int CompactModel(const std::vector<std::vector<int>>& tree_leaf_prediction) override;
+
+  std::string MemoryUsageToJSON() const override;
+
+  std::string TrainingStatsToJSON() const override;
+
   /*!
   * \brief Training logic
   * \param gradients nullptr for using default objective, otherwise use self-defined boosting
@@ -143,11 +152,27 @@ class GBDT : public GBDTBase {
   */
   bool TrainOneIter(const score_t* gradients, const score_t* hessians) override;
 
+  /*!
+  * \brief Get the internal buffers of gradients and Hessians for training data.
+  *        They stay valid until the training data is reset
+  * \param out_gradients Pointer to the gradients buffer
+  * \param out_hessians Pointer to the Hessians buffer
+  * \return Length of each buffer
+  */
+  int64_t GetGradientBuffers(score_t** out_gradients, score_t** out_hessians) override;
+
   /*!
   * \brief Rollback one iteration
   */
   void RollbackOneIter() override;
 
+  /*!
+  * \brief Print eval result and check early stopping
+  */
+  bool EvalAndCheckEarlyStopping() override;
+
+  bool ResumeFromCheckpoint() override;
+
   /*!
   * \brief Get current iteration
   */
@@ -226,22 +251,44 @@ class GBDT : public GBDTBase {
   void PredictRaw(const double* features, double* output,
                   const PredictionEarlyStopInstance* earlyStop) const override;
 
+  void PredictRaw(const float* features, double* output,
+                  const PredictionEarlyStopInstance* early_stop) const override;
+
   void PredictRawByMap(const std::unordered_map<int, double>& features, double* output,
                        const PredictionEarlyStopInstance* early_stop) const override;
 
   void Predict(const double* features, double* output,
                const PredictionEarlyStopInstance* earlyStop) const override;
 
+  void Predict(const float* features, double* output,
+               const PredictionEarlyStopInstance* early_stop) const override;
+
   void PredictByMap(const std::unordered_map<int, double>& features, double* output,
                     const PredictionEarlyStopInstance* early_stop) const override;
 
   void PredictLeafIndex(const double* features, double* output) const override;
 
+  void PredictLeafIndex(const float* features, double* output) const override;
+
   void PredictLeafIndexByMap(const std::unordered_map<int, double>& features, double* output) const override;
 
   void PredictContrib(const double* features, double* output,
                       const PredictionEarlyStopInstance* earlyStop) const override;
 
+  void InitPredictByBins(int num_iteration) override;
+
+  bool GetFeatureBinUpperBounds(int feature_idx, std::vector<double>* out_bounds) const override;
+
+  void PredictRawByBins(const uint16_t* feature_bins, double* output) const override;
+
+  void PredictByBins(const uint16_t* feature_bins, double* output) const override;
+
+  void PredictLeafIndexByBins(const uint16_t* feature_bins, double* output) const override;
+
+  bool CanPredictOnDatasetBins(const Dataset* data) override;
+
+  void PredictRawOnDatasetBins(const Dataset* data, double* out_score) override;
+
   /*!
   * \brief Dump model to json format string
   * \param start_iteration The model will be saved start from
@@ -319,6 +366,12 @@ class GBDT : public GBDTBase {
   */
   inline int NumberOfTotalModel() const override { return static_cast<int>(models_.size()); }
 
+  /*!
+  * \brief Get version of the model, which changes whenever the trees are changed
+  * \return Version of the model
+  */
+  inline int64_t ModelVersion() const override { return model_version_; }
+
   /*!
   * \brief Get number of tree per iteration
   * \return number of tree per iteration
@@ -344,6 +397,10 @@ class GBDT : public GBDTBase {
     }
   }
 
+  void InitPredictByMap() override;
+
+  void InitPredictTreeParallel(int min_num_trees) override;
+
   inline double GetLeafValue(int tree_idx, int leaf_idx) const override {
     CHECK(tree_idx >= 0 && static_cast<size_t>(tree_idx) < models_.size());
     CHECK(leaf_idx >= 0 && leaf_idx < models_[tree_idx]->num_leaves());
@@ -354,6 +411,7 @@ class GBDT : public GBDTBase {
     CHECK(tree_idx >= 0 && static_cast<size_t>(tree_idx) < models_.size());
     CHECK(leaf_idx >= 0 && leaf_idx < models_[tree_idx]->num_leaves());
     models_[tree_idx]->SetLeafOutput(leaf_idx, val);
+    ++model_version_;
   }
 
   /*!
@@ -363,15 +421,71 @@ class GBDT : public GBDTBase {
 
  protected:
   /*!
-  * \brief Print eval result and check early stopping
+  * \brief Prediction for one record of double or float feature values, not sigmoid transform
   */
-  virtual bool EvalAndCheckEarlyStopping();
+  template<typename T>
+  void PredictRawFromValues(const T* features, double* output,
+                            const PredictionEarlyStopInstance* early_stop) const;
+
+  template<typename T>
+  void PredictFromValues(const T* features, double* output,
+                         const PredictionEarlyStopInstance* early_stop) const;
+
+  /*!
+  * \brief Raw prediction for one record with the used trees split over threads,
+  *        every thread sums its trees into its own slot and the slots are summed after
+  */
+  template<typename T>
+  void PredictRawTreeParallel(const T* features, double* output) const;
+
+  template<typename T>
+  void PredictLeafIndexFromValues(const T* features, double* output) const;
+
+  /*!
+  * \brief Whether prediction by map can skip the trees not using the features of a record
+  * \param early_stop Early stopping instance, tree skipping changes the order of accumulation so it needs none
+  */
+  bool CanSkipTreesByMap(const PredictionEarlyStopInstance* early_stop) const;
+
+  /*!
+  * \brief Get the used trees which split on the features of a record
+  * \param features Feature values of this record
+  * \return Sorted indices of trees
+  */
+  std::vector<int> TreesUsingFeatures(const std::unordered_map<int, double>& features) const;
 
   /*!
   * \brief reset config for bagging
   */
   void ResetBaggingConfig(const Config* config, bool is_change_dataset);
 
+  /*!
+  * \brief Get the current sizes in byte of each component, ``total`` is their sum
+  * \param out_sizes Output map, existing entries are reset to 0
+  */
+  void GetMemoryUsage(std::map<std::string, size_t>* out_sizes) const;
+
+  /*!
+  * \brief Sample the sizes in byte of each component to update their peaks, and shrink the histogram pool
+  *        if the total exceeds ``memory_budget``
+  * \param log True to log a summary of the memory usage
+  */
+  void UpdateMemoryUsage(bool log);
+
+  /*!
+  * \brief Increment the model version after trees were pushed to or popped from models_,
+  *        and keep the total size of the trees up to date without walking all of them
+  * \param size_delta Change of the total size in byte of the trees
+  */
+  void OnModelsResized(int64_t size_delta) {
+    const bool is_size_valid = models_size_version_ == model_version_;
+    ++model_version_;
+    if (is_size_valid) {
+      models_size_in_byte_ = static_cast<size_t>(static_cast<int64_t>(models_size_in_byte_) + size_delta);
+      models_size_version_ = model_version_;
+    }
+  }
+
   /*!
   * \brief Implement bagging logic
   * \param iter Current interation
@@ -402,6 +516,11 @@ class GBDT : public GBDTBase {
   */
   virtual void Boosting();
 
+  /*!
+  * \brief Get the trees trained in this booster, excluding the ones of the input model
+  */
+  std::vector<const Tree*> TrainedTrees() const;
+
   /*!
   * \brief updating score after tree was trained
   * \param tree Trained tree of this iteration
@@ -422,6 +541,21 @@ class GBDT : public GBDTBase {
   */
   std::string OutputMetric(int iter);
 
+  /*!
+  * \brief Save a checkpoint of the current iteration on all machines, the last two complete ones are kept
+  */
+  void SaveCheckpoint();
+
+  /*!
+  * \brief Serialize the state needed to resume training at the current iteration
+  */
+  std::string CheckpointToString() const;
+
+  /*!
+  * \brief Filename of the checkpoint of one iteration on this machine
+  */
+  std::string CheckpointFileName(int iter) const;
+
   double BoostFromAverage(int class_id, bool update_scorer);
 
   /*! \brief current iteration */
@@ -476,6 +610,32 @@ class GBDT : public GBDTBase {
   data_size_t label_idx_;
   /*! \brief number of used model */
   int num_iteration_for_pred_;
+  /*! \brief Minimal number of used trees to predict a single record by tree parallel, <= 0 means never */
+  int predict_tree_parallel_threshold_ = 0;
+  /*! \brief Leaf of each tree when all features are zero, used by prediction by map */
+  std::vector<int> default_leaf_by_map_;
+  /*! \brief Prefix sums of the outputs of default_leaf_by_map_ over iterations, for each tree of one iteration */
+  std::vector<double> default_output_sum_by_map_;
+  /*! \brief Ascending indices of trees splitting on each feature, used by prediction by map */
+  std::unordered_map<int, std::vector<int>> feature_to_trees_;
+  /*! \brief model_version_ the prediction by map tables were built for, -1 means never */
+  int64_t predict_by_map_version_ = -1;
+  /*! \brief Upper bounds of bins of each feature for pre-binned prediction */
+  std::vector<std::vector<double>> predict_bin_upper_bounds_;
+  /*! \brief Whether each feature is categorical, used by pre-binned prediction */
+  std::vector<int8_t> predict_bin_is_categorical_;
+  /*! \brief Numerical splits of each tree in bins, used by pre-binned prediction */
+  std::vector<std::vector<uint32_t>> predict_node_bins_;
+  /*! \brief model_version_ the pre-binned prediction tables were built for, -1 means never */
+  int64_t predict_bins_version_ = -1;
+  /*! \brief Copies of the trees mapped to the bins of dataset_bins_data_ by CanPredictOnDatasetBins */
+  std::vector<std::unique_ptr<Tree>> dataset_bins_trees_;
+  /*! \brief Dataset the trees in dataset_bins_trees_ were mapped to */
+  const Dataset* dataset_bins_data_ = nullptr;
+  /*! \brief model_version_ the trees in dataset_bins_trees_ were mapped for, -1 means never */
+  int64_t dataset_bins_version_ = -1;
+  /*! \brief Incremented on every change of the trees, keys the tables built for prediction */
+  int64_t model_version_ = 0;
   /*! \brief Shrinkage rate for one iteration */
   double shrinkage_rate_;
   /*! \brief Number of loaded initial models */
@@ -507,6 +667,18 @@ class GBDT : public GBDTBase {
   std::vector<int8_t> monotone_constraints_;
 
   Json forced_splits_json_;
+  /*! \brief Init scores of the current iteration, reused to avoid allocations */
+  std::vector<double> init_scores_buf_;
+  /*! \brief Peak sizes in byte of each component, sampled by UpdateMemoryUsage */
+  std::map<std::string, size_t> peak_memory_usage_;
+  /*! \brief Current sizes in byte of each component, reused by UpdateMemoryUsage */
+  std::map<std::string, size_t> memory_usage_;
+  /*! \brief Total size in byte of models_, valid if models_size_version_ is model_version_ */
+  size_t models_size_in_byte_ = 0;
+  /*! \brief model_version_ models_size_in_byte_ was computed for, -1 means never */
+  int64_t models_size_version_ = -1;
+  /*! \brief Iterations of the complete checkpoints kept on disk, oldest first */
+  std::deque<int> checkpoint_iters_;
 };
 
 }  // namespace LightGBM
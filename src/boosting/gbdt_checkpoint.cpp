@@ -0,0 +1,235 @@
+/*!
+ * Copyright (c) 2017 Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT License. See LICENSE file in the project root for license information.
+ */
+#include <LightGBM/network.h>
+#include <LightGBM/utils/common.h>
+
+#include <string>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <utility>
+#include <vector>
+
+#include "gbdt.h"
+
+namespace LightGBM {
+
+const char* kCheckpointToken = "______LightGBM_Checkpoint_v1______";
+
+namespace {
+
+/*! \brief Minimum of a value over all machines, the value itself without network */
+int SyncUpByMin(int local) {
+  if (Network::num_machines() > 1) {
+    return Network::GlobalSyncUpByMin(local);
+  }
+  return local;
+}
+
+/*! \brief Write content to a temporary file first, so a crash never leaves a partial file behind */
+bool WriteFileAtomically(const std::string& filename, const std::string& content) {
+  const std::string tmp_filename = filename + ".tmp";
+  {
+    std::ofstream output_file(tmp_filename, std::ios::out | std::ios::binary);
+    output_file.write(content.data(), content.size());
+    output_file.close();
+    if (!output_file) {
+      std::remove(tmp_filename.c_str());
+      return false;
+    }
+  }
+  // rename doesn't replace existing files on all platforms
+  std::remove(filename.c_str());
+  return std::rename(tmp_filename.c_str(), filename.c_str()) == 0;
+}
+
+bool ReadFile(const std::string& filename, std::string* content) {
+  std::ifstream input_file(filename, std::ios::in | std::ios::binary);
+  if (!input_file) { return false; }
+  std::stringstream str_buf;
+  str_buf << input_file.rdbuf();
+  *content = str_buf.str();
+  return static_cast<bool>(input_file);
+}
+
+void AppendStringToBinary(const std::string& str, std::string* buffer) {
+  Common::AppendToBinary(std::vector<char>(str.begin(), str.end()), buffer);
+}
+
+bool ReadStringFromBinary(const std::string& buffer, size_t* pos, std::string* str) {
+  std::vector<char> chars;
+  if (!Common::ReadFromBinary(buffer, pos, &chars)) { return false; }
+  str->assign(chars.begin(), chars.end());
+  return true;
+}
+
+}  // namespace
+
+std::string GBDT::CheckpointFileName(int iter) const {
+  return config_->checkpoint_prefix + ".rank_" + std::to_string(Network::rank()) + ".iter_" + std::to_string(iter);
+}
+
+std::string GBDT::CheckpointToString() const {
+  std::string buffer;
+  AppendStringToBinary(kCheckpointToken, &buffer);
+  Common::AppendToBinary(Network::num_machines(), &buffer);
+  Common::AppendToBinary(iter_, &buffer);
+  Common::AppendToBinary(num_init_iteration_, &buffer);
+  Common::AppendToBinary(num_tree_per_iteration_, &buffer);
+  // the trees of the input model are loaded again by the resumed run, only the trained ones are saved
+  const size_t num_init_models = static_cast<size_t>(num_init_iteration_) * num_tree_per_iteration_;
+  Common::AppendToBinary(static_cast<uint64_t>(models_.size() - num_init_models), &buffer);
+  for (size_t i = num_init_models; i < models_.size(); ++i) {
+    models_[i]->SaveBinaryToString(&buffer);
+  }
+  const size_t num_train_score = static_cast<size_t>(num_data_) * num_tree_per_iteration_;
+  Common::AppendToBinary(std::vector<double>(train_score_updater_->score(),
+                                             train_score_updater_->score() + num_train_score), &buffer);
+  Common::AppendToBinary(static_cast<uint64_t>(valid_score_updater_.size()), &buffer);
+  for (size_t i = 0; i < valid_score_updater_.size(); ++i) {
+    const size_t num_valid_score = static_cast<size_t>(valid_score_updater_[i]->num_data()) * num_tree_per_iteration_;
+    Common::AppendToBinary(std::vector<double>(valid_score_updater_[i]->score(),
+                                               valid_score_updater_[i]->score() + num_valid_score), &buffer);
+  }
+  // early stopping state only exists when early_stopping_round > 0
+  for (size_t i = 0; i < best_iter_.size(); ++i) {
+    Common::AppendToBinary(best_iter_[i], &buffer);
+    Common::AppendToBinary(best_score_[i], &buffer);
+    Common::AppendToBinary(static_cast<uint64_t>(best_msg_[i].size()), &buffer);
+    for (const auto& msg : best_msg_[i]) {
+      AppendStringToBinary(msg, &buffer);
+    }
+  }
+  AppendStringToBinary(tree_learner_->SaveState(), &buffer);
+  return buffer;
+}
+
+void GBDT::SaveCheckpoint() {
+  const std::string filename = CheckpointFileName(iter_);
+  const bool is_saved = WriteFileAtomically(filename, CheckpointToString());
+  // the checkpoint only counts when all machines saved it
+  if (!SyncUpByMin(is_saved ? 1 : 0)) {
+    Log::Warning("Failed to save checkpoint of iteration %d on all machines", iter_);
+    std::remove(filename.c_str());
+    return;
+  }
+  const std::string latest_filename = config_->checkpoint_prefix + ".rank_" + std::to_string(Network::rank()) + ".latest";
+  if (!WriteFileAtomically(latest_filename, std::to_string(iter_))) {
+    Log::Warning("Failed to update %s", latest_filename.c_str());
+    return;
+  }
+  Log::Info("Saved checkpoint of iteration %d to %s", iter_, filename.c_str());
+  // other machines may still point to the previous checkpoint, so keep it
+  checkpoint_iters_.push_back(iter_);
+  while (checkpoint_iters_.size() > 2) {
+    std::remove(CheckpointFileName(checkpoint_iters_.front()).c_str());
+    checkpoint_iters_.pop_front();
+  }
+}
+
+bool GBDT::ResumeFromCheckpoint() {
+  if (config_->checkpoint_freq <= 0) { return false; }
+  std::string content;
+  int latest_iter = 0;
+  const std::string latest_filename = config_->checkpoint_prefix + ".rank_" + std::to_string(Network::rank()) + ".latest";
+  if (ReadFile(latest_filename, &content)) {
+    Common::Atoi(content.c_str(), &latest_iter);
+  }
+  // the previous checkpoint is kept, so every machine has the oldest latest one
+  const int resume_iter = SyncUpByMin(latest_iter);
+  if (resume_iter <= 0) { return false; }
+  const std::string filename = CheckpointFileName(resume_iter);
+  const size_t num_init_models = static_cast<size_t>(num_init_iteration_) * num_tree_per_iteration_;
+
+  // parse everything first, the state is only changed when all machines can resume
+  std::string buffer;
+  std::string token;
+  size_t pos = 0;
+  int num_machines = 0;
+  int iter = 0;
+  int num_init_iteration = 0;
+  int num_tree_per_iteration = 0;
+  uint64_t num_models = 0;
+  std::vector<std::unique_ptr<Tree>> models;
+  std::vector<double> train_score;
+  uint64_t num_valid = 0;
+  std::vector<std::vector<double>> valid_scores(valid_score_updater_.size());
+  auto best_iter = best_iter_;
+  auto best_score = best_score_;
+  auto best_msg = best_msg_;
+  std::string learner_state;
+  bool is_valid = ReadFile(filename, &buffer)
+    && ReadStringFromBinary(buffer, &pos, &token) && token == kCheckpointToken
+    && Common::ReadFromBinary(buffer, &pos, &num_machines) && num_machines == Network::num_machines()
+    && Common::ReadFromBinary(buffer, &pos, &iter) && iter == resume_iter
+    && Common::ReadFromBinary(buffer, &pos, &num_init_iteration) && num_init_iteration == num_init_iteration_
+    && Common::ReadFromBinary(buffer, &pos, &num_tree_per_iteration) && num_tree_per_iteration == num_tree_per_iteration_
+    && Common::ReadFromBinary(buffer, &pos, &num_models)
+    && num_models == static_cast<uint64_t>(iter) * num_tree_per_iteration;
+  for (uint64_t i = 0; is_valid && i < num_models; ++i) {
+    // binary trees keep exact outputs and bin thresholds, so resumed training matches
+    models.emplace_back(new Tree(1));
+    is_valid = models.back()->LoadBinaryFromString(buffer, &pos);
+  }
+  is_valid = is_valid
+    && Common::ReadFromBinary(buffer, &pos, &train_score)
+    && train_score.size() == static_cast<size_t>(num_data_) * num_tree_per_iteration_
+    && Common::ReadFromBinary(buffer, &pos, &num_valid) && num_valid == valid_score_updater_.size();
+  for (size_t i = 0; is_valid && i < valid_score_updater_.size(); ++i) {
+    is_valid = Common::ReadFromBinary(buffer, &pos, &valid_scores[i])
+      && valid_scores[i].size() == static_cast<size_t>(valid_score_updater_[i]->num_data()) * num_tree_per_iteration_;
+  }
+  for (size_t i = 0; is_valid && i < best_iter_.size(); ++i) {
+    uint64_t num_msg = 0;
+    is_valid = Common::ReadFromBinary(buffer, &pos, &best_iter[i]) && best_iter[i].size() == best_iter_[i].size()
+      && Common::ReadFromBinary(buffer, &pos, &best_score[i]) && best_score[i].size() == best_score_[i].size()
+      && Common::ReadFromBinary(buffer, &pos, &num_msg) && num_msg == best_msg_[i].size();
+    for (uint64_t j = 0; is_valid && j < num_msg; ++j) {
+      is_valid = ReadStringFromBinary(buffer, &pos, &best_msg[i][j]);
+    }
+  }
+  is_valid = is_valid && ReadStringFromBinary(buffer, &pos, &learner_state) && pos == buffer.size();
+  // the learner checks its state itself, keep the current one in case other machines can't resume
+  const std::string current_learner_state = tree_learner_->SaveState();
+  is_valid = is_valid && tree_learner_->LoadState(learner_state);
+  if (!is_valid) {
+    Log::Warning("Checkpoint %s cannot be used for the current training data and parameters", filename.c_str());
+  }
+  if (!SyncUpByMin(is_valid ? 1 : 0)) {
+    Log::Warning("Not all machines can resume from checkpoint of iteration %d, training from scratch", resume_iter);
+    tree_learner_->LoadState(current_learner_state);
+    return false;
+  }
+  iter_ = iter;
+  models_.resize(num_init_models);
+  for (auto& tree : models) {
+    models_.push_back(std::move(tree));
+  }
+  ++model_version_;
+  train_score_updater_->SetScore(train_score);
+  for (size_t i = 0; i < valid_score_updater_.size(); ++i) {
+    valid_score_updater_[i]->SetScore(valid_scores[i]);
+  }
+  best_iter_ = std::move(best_iter);
+  best_score_ = std::move(best_score);
+  best_msg_ = std::move(best_msg);
+  // checkpoints of this machine newer than the resumed one are never used again
+  if (latest_iter > resume_iter) {
+    std::remove(CheckpointFileName(latest_iter).c_str());
+    if (!WriteFileAtomically(latest_filename, std::to_string(resume_iter))) {
+      Log::Warning("Failed to update %s", latest_filename.c_str());
+    }
+  }
+  // the checkpoint before the resumed one is removed by the next save
+  checkpoint_iters_.clear();
+  if (iter_ > config_->checkpoint_freq) {
+    checkpoint_iters_.push_back(iter_ - config_->checkpoint_freq);
+  }
+  checkpoint_iters_.push_back(iter_);
+  Log::Info("Resumed training from checkpoint %s at iteration %d", filename.c_str(), iter_);
+  return true;
+}
+
+}  // namespace LightGBM
@@ -238,6 +238,35 @@ std::string GBDT::ModelToIfElse(int num_iteration) const {
   str_buf << "\t" << "}" << '\n';
   str_buf << "}" << '\n';
 
+  // float32 features, hard-coded trees compare in double
+  str_buf << "void GBDT::PredictRaw(const float* features, double *output, const PredictionEarlyStopInstance* early_stop) const {" << '\n';
+  str_buf << "\t" << "std::vector<double> buf(features, features + max_feature_idx_ + 1);" << '\n';
+  str_buf << "\t" << "PredictRaw(buf.data(), output, early_stop);" << '\n';
+  str_buf << "}" << '\n';
+  str_buf << "void GBDT::Predict(const float* features, double *output, const PredictionEarlyStopInstance* early_stop) const {" << '\n';
+  str_buf << "\t" << "std::vector<double> buf(features, features + max_feature_idx_ + 1);" << '\n';
+  str_buf << "\t" << "Predict(buf.data(), output, early_stop);" << '\n';
+  str_buf << "}" << '\n';
+  str_buf << "void GBDT::PredictLeafIndex(const float* features, double *output) const {" << '\n';
+  str_buf << "\t" << "std::vector<double> buf(features, features + max_feature_idx_ + 1);" << '\n';
+  str_buf << "\t" << "PredictLeafIndex(buf.data(), output);" << '\n';
+  str_buf << "}" << '\n';
+
+  // hard-coded trees always traverse all trees by map
+  str_buf << "void GBDT::InitPredictByMap() {}" << '\n';
+
+  // hard-coded trees are always predicted serially
+  str_buf << "void GBDT::InitPredictTreeParallel(int) {}" << '\n';
+
+  // pre-binned prediction needs the split thresholds, which are not kept by hard-coded trees
+  str_buf << "void GBDT::InitPredictByBins(int) {" << '\n';
+  str_buf << "\t" << "Log::Fatal(\"Pre-binned prediction is not supported by hard-coded models\");" << '\n';
+  str_buf << "}" << '\n';
+  str_buf << "bool GBDT::GetFeatureBinUpperBounds(int, std::vector<double>*) const { return false; }" << '\n';
+  str_buf << "void GBDT::PredictRawByBins(const uint16_t*, double*) const {}" << '\n';
+  str_buf << "void GBDT::PredictByBins(const uint16_t*, double*) const {}" << '\n';
+  str_buf << "void GBDT::PredictLeafIndexByBins(const uint16_t*, double*) const {}" << '\n';
+
   str_buf << "}  // namespace LightGBM" << '\n';
 
   return str_buf.str();
@@ -524,6 +553,7 @@ bool GBDT::LoadModelFromString(const char* buffer, size_t len) {
     }
     OMP_THROW_EX();
   }
+  ++model_version_;
   num_iteration_for_pred_ = static_cast<int>(models_.size()) / num_tree_per_iteration_;
   num_init_iteration_ = num_iteration_for_pred_;
   iter_ = 0;
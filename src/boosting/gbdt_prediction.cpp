@@ -6,11 +6,49 @@
 #include <LightGBM/prediction_early_stop.h>
 #include <LightGBM/utils/openmp_wrapper.h>
 
+#include <algorithm>
+#include <limits>
+#include <vector>
+
 #include "gbdt.h"
 
 namespace LightGBM {
 
-void GBDT::PredictRaw(const double* features, double* output, const PredictionEarlyStopInstance* early_stop) const {
+void GBDT::InitPredictTreeParallel(int min_num_trees) {
+  predict_tree_parallel_threshold_ = min_num_trees;
+}
+
+template<typename T>
+void GBDT::PredictRawTreeParallel(const T* features, double* output) const {
+  std::vector<double> partial_output;
+  #pragma omp parallel
+  {
+    #pragma omp single
+    {
+      partial_output.resize(static_cast<size_t>(omp_get_num_threads()) * num_tree_per_iteration_, 0.0);
+    }
+    double* local_output = partial_output.data() + static_cast<size_t>(omp_get_thread_num()) * num_tree_per_iteration_;
+    #pragma omp for schedule(static)
+    for (int i = 0; i < num_iteration_for_pred_; ++i) {
+      for (int k = 0; k < num_tree_per_iteration_; ++k) {
+        local_output[k] += models_[i * num_tree_per_iteration_ + k]->Predict(features);
+      }
+    }
+  }
+  std::memset(output, 0, sizeof(double) * num_tree_per_iteration_);
+  for (size_t i = 0; i < partial_output.size(); ++i) {
+    output[i % num_tree_per_iteration_] += partial_output[i];
+  }
+}
+
+template<typename T>
+void GBDT::PredictRawFromValues(const T* features, double* output, const PredictionEarlyStopInstance* early_stop) const {
+  if (predict_tree_parallel_threshold_ > 0
+      && num_iteration_for_pred_ * num_tree_per_iteration_ >= predict_tree_parallel_threshold_
+      && early_stop->round_period == std::numeric_limits<int>::max() && !omp_in_parallel()) {
+    PredictRawTreeParallel(features, output);
+    return;
+  }
   int early_stop_round_counter = 0;
   // set zero
   std::memset(output, 0, sizeof(double) * num_tree_per_iteration_);
@@ -30,7 +68,25 @@ void GBDT::PredictRaw(const double* features, double* output, const PredictionEa
   }
 }
 
+void GBDT::PredictRaw(const double* features, double* output, const PredictionEarlyStopInstance* early_stop) const {
+  PredictRawFromValues(features, output, early_stop);
+}
+
+void GBDT::PredictRaw(const float* features, double* output, const PredictionEarlyStopInstance* early_stop) const {
+  PredictRawFromValues(features, output, early_stop);
+}
+
 void GBDT::PredictRawByMap(const std::unordered_map<int, double>& features, double* output, const PredictionEarlyStopInstance* early_stop) const {
+  if (CanSkipTreesByMap(early_stop)) {
+    // start from the outputs with all features zero, then correct the trees touched by this record
+    std::memcpy(output, default_output_sum_by_map_.data() + static_cast<size_t>(num_iteration_for_pred_) * num_tree_per_iteration_,
+                sizeof(double) * num_tree_per_iteration_);
+    for (int i : TreesUsingFeatures(features)) {
+      output[i % num_tree_per_iteration_] += models_[i]->PredictByMap(features)
+                                             - models_[i]->LeafOutput(default_leaf_by_map_[i]);
+    }
+    return;
+  }
   int early_stop_round_counter = 0;
   // set zero
   std::memset(output, 0, sizeof(double) * num_tree_per_iteration_);
@@ -50,8 +106,9 @@ void GBDT::PredictRawByMap(const std::unordered_map<int, double>& features, doub
   }
 }
 
-void GBDT::Predict(const double* features, double* output, const PredictionEarlyStopInstance* early_stop) const {
-  PredictRaw(features, output, early_stop);
+template<typename T>
+void GBDT::PredictFromValues(const T* features, double* output, const PredictionEarlyStopInstance* early_stop) const {
+  PredictRawFromValues(features, output, early_stop);
   if (average_output_) {
     for (int k = 0; k < num_tree_per_iteration_; ++k) {
       output[k] /= num_iteration_for_pred_;
@@ -62,6 +119,14 @@ void GBDT::Predict(const double* features, double* output, const PredictionEarly
   }
 }
 
+void GBDT::Predict(const double* features, double* output, const PredictionEarlyStopInstance* early_stop) const {
+  PredictFromValues(features, output, early_stop);
+}
+
+void GBDT::Predict(const float* features, double* output, const PredictionEarlyStopInstance* early_stop) const {
+  PredictFromValues(features, output, early_stop);
+}
+
 void GBDT::PredictByMap(const std::unordered_map<int, double>& features, double* output, const PredictionEarlyStopInstance* early_stop) const {
   PredictRawByMap(features, output, early_stop);
   if (average_output_) {
@@ -74,18 +139,207 @@ void GBDT::PredictByMap(const std::unordered_map<int, double>& features, double*
   }
 }
 
-void GBDT::PredictLeafIndex(const double* features, double* output) const {
+template<typename T>
+void GBDT::PredictLeafIndexFromValues(const T* features, double* output) const {
   int total_tree = num_iteration_for_pred_ * num_tree_per_iteration_;
   for (int i = 0; i < total_tree; ++i) {
     output[i] = models_[i]->PredictLeafIndex(features);
   }
 }
 
+void GBDT::PredictLeafIndex(const double* features, double* output) const {
+  PredictLeafIndexFromValues(features, output);
+}
+
+void GBDT::PredictLeafIndex(const float* features, double* output) const {
+  PredictLeafIndexFromValues(features, output);
+}
+
 void GBDT::PredictLeafIndexByMap(const std::unordered_map<int, double>& features, double* output) const {
   int total_tree = num_iteration_for_pred_ * num_tree_per_iteration_;
+  if (CanSkipTreesByMap(nullptr)) {
+    for (int i = 0; i < total_tree; ++i) {
+      output[i] = default_leaf_by_map_[i];
+    }
+    for (int i : TreesUsingFeatures(features)) {
+      output[i] = models_[i]->PredictLeafIndexByMap(features);
+    }
+    return;
+  }
   for (int i = 0; i < total_tree; ++i) {
     output[i] = models_[i]->PredictLeafIndexByMap(features);
   }
 }
 
+void GBDT::InitPredictByMap() {
+  if (predict_by_map_version_ == model_version_) {
+    return;
+  }
+  const int num_models = static_cast<int>(models_.size());
+  default_leaf_by_map_.resize(num_models);
+  default_output_sum_by_map_.assign(static_cast<size_t>(num_models) + num_tree_per_iteration_, 0.0);
+  feature_to_trees_.clear();
+  const std::unordered_map<int, double> all_zero;
+  std::vector<int> tree_features;
+  for (int i = 0; i < num_models; ++i) {
+    default_leaf_by_map_[i] = models_[i]->PredictLeafIndexByMap(all_zero);
+    default_output_sum_by_map_[i + num_tree_per_iteration_] =
+      default_output_sum_by_map_[i] + models_[i]->LeafOutput(default_leaf_by_map_[i]);
+    tree_features.clear();
+    for (int j = 0; j < models_[i]->num_leaves() - 1; ++j) {
+      tree_features.push_back(models_[i]->split_feature(j));
+    }
+    std::sort(tree_features.begin(), tree_features.end());
+    tree_features.erase(std::unique(tree_features.begin(), tree_features.end()), tree_features.end());
+    for (int feature : tree_features) {
+      feature_to_trees_[feature].push_back(i);
+    }
+  }
+  predict_by_map_version_ = model_version_;
+}
+
+bool GBDT::CanSkipTreesByMap(const PredictionEarlyStopInstance* early_stop) const {
+  return (early_stop == nullptr || early_stop->round_period == std::numeric_limits<int>::max())
+         && predict_by_map_version_ == model_version_;
+}
+
+std::vector<int> GBDT::TreesUsingFeatures(const std::unordered_map<int, double>& features) const {
+  const int total_tree = num_iteration_for_pred_ * num_tree_per_iteration_;
+  std::vector<int> trees;
+  for (const auto& pair : features) {
+    auto iter = feature_to_trees_.find(pair.first);
+    if (iter == feature_to_trees_.end()) {
+      continue;
+    }
+    for (int tree : iter->second) {
+      if (tree >= total_tree) {
+        break;
+      }
+      trees.push_back(tree);
+    }
+  }
+  std::sort(trees.begin(), trees.end());
+  trees.erase(std::unique(trees.begin(), trees.end()), trees.end());
+  return trees;
+}
+
+void GBDT::InitPredictByBins(int num_iteration) {
+  InitPredict(num_iteration, false);
+  // the tables cover all the trees, so they only depend on the model
+  if (predict_bins_version_ == model_version_) {
+    return;
+  }
+  const int num_features = max_feature_idx_ + 1;
+  predict_bin_upper_bounds_.assign(num_features, std::vector<double>());
+  predict_bin_is_categorical_.assign(num_features, 0);
+  for (const auto& tree : models_) {
+    tree->AddSplitThresholds(&predict_bin_upper_bounds_, &predict_bin_is_categorical_);
+  }
+  #pragma omp parallel for schedule(dynamic)
+  for (int i = 0; i < num_features; ++i) {
+    auto& bounds = predict_bin_upper_bounds_[i];
+    // bin of (-kZeroThreshold, kZeroThreshold] is the zero bin
+    bounds.push_back(-kZeroThreshold);
+    bounds.push_back(kZeroThreshold);
+    std::sort(bounds.begin(), bounds.end());
+    bounds.erase(std::unique(bounds.begin(), bounds.end()), bounds.end());
+  }
+  for (int i = 0; i < num_features; ++i) {
+    if (predict_bin_upper_bounds_[i].size() + 1 > std::numeric_limits<uint16_t>::max()) {
+      Log::Fatal("Feature %d has too many thresholds for pre-binned prediction", i);
+    }
+  }
+  predict_node_bins_.resize(models_.size());
+  #pragma omp parallel for schedule(dynamic)
+  for (int i = 0; i < static_cast<int>(models_.size()); ++i) {
+    predict_node_bins_[i] = models_[i]->NodeBins(predict_bin_upper_bounds_);
+  }
+  predict_bins_version_ = model_version_;
+}
+
+bool GBDT::GetFeatureBinUpperBounds(int feature_idx, std::vector<double>* out_bounds) const {
+  CHECK(feature_idx >= 0 && static_cast<size_t>(feature_idx) < predict_bin_upper_bounds_.size());
+  if (predict_bin_is_categorical_[feature_idx]) {
+    out_bounds->clear();
+    return false;
+  }
+  *out_bounds = predict_bin_upper_bounds_[feature_idx];
+  return true;
+}
+
+void GBDT::PredictRawByBins(const uint16_t* feature_bins, double* output) const {
+  std::memset(output, 0, sizeof(double) * num_tree_per_iteration_);
+  for (int i = 0; i < num_iteration_for_pred_; ++i) {
+    // predict all the trees for one iteration
+    for (int k = 0; k < num_tree_per_iteration_; ++k) {
+      const int tree_idx = i * num_tree_per_iteration_ + k;
+      output[k] += models_[tree_idx]->PredictByBins(feature_bins, predict_node_bins_[tree_idx].data());
+    }
+  }
+}
+
+void GBDT::PredictByBins(const uint16_t* feature_bins, double* output) const {
+  PredictRawByBins(feature_bins, output);
+  if (average_output_) {
+    for (int k = 0; k < num_tree_per_iteration_; ++k) {
+      output[k] /= num_iteration_for_pred_;
+    }
+  }
+  if (objective_function_ != nullptr) {
+    objective_function_->ConvertOutput(output, output);
+  }
+}
+
+void GBDT::PredictLeafIndexByBins(const uint16_t* feature_bins, double* output) const {
+  int total_tree = num_iteration_for_pred_ * num_tree_per_iteration_;
+  for (int i = 0; i < total_tree; ++i) {
+    output[i] = models_[i]->PredictLeafIndexByBins(feature_bins, predict_node_bins_[i].data());
+  }
+}
+
+bool GBDT::CanPredictOnDatasetBins(const Dataset* data) {
+  const int num_models = static_cast<int>(models_.size());
+  // map copies of the trees, the models themselves keep the bins of their own training data
+  dataset_bins_trees_.resize(num_models);
+  std::vector<int8_t> is_mapped(num_models, 0);
+  OMP_INIT_EX();
+  #pragma omp parallel for schedule(dynamic)
+  for (int i = 0; i < num_models; ++i) {
+    OMP_LOOP_EX_BEGIN();
+    dataset_bins_trees_[i].reset(new Tree(*models_[i]));
+    is_mapped[i] = dataset_bins_trees_[i]->MapThresholdsToBins(data);
+    OMP_LOOP_EX_END();
+  }
+  OMP_THROW_EX();
+  if (std::find(is_mapped.begin(), is_mapped.end(), 0) != is_mapped.end()) {
+    std::vector<std::unique_ptr<Tree>>().swap(dataset_bins_trees_);
+    dataset_bins_data_ = nullptr;
+    dataset_bins_version_ = -1;
+    return false;
+  }
+  dataset_bins_data_ = data;
+  dataset_bins_version_ = model_version_;
+  return true;
+}
+
+void GBDT::PredictRawOnDatasetBins(const Dataset* data, double* out_score) {
+  if (dataset_bins_data_ != data || dataset_bins_version_ != model_version_) {
+    CHECK(CanPredictOnDatasetBins(data));
+  }
+  const data_size_t num_data = data->num_data();
+  const int num_models = static_cast<int>(dataset_bins_trees_.size());
+  std::memset(out_score, 0, sizeof(double) * num_data * num_tree_per_iteration_);
+  std::vector<const Tree*> trees(num_models);
+  std::vector<double*> scores(num_models);
+  for (int i = 0; i < num_models; ++i) {
+    trees[i] = dataset_bins_trees_[i].get();
+    scores[i] = out_score + static_cast<size_t>(num_data) * (i % num_tree_per_iteration_);
+  }
+  // all trees are evaluated together in parallel over blocks of records
+  Tree::AddPredictionToScore(trees, data, num_data, scores);
+  std::vector<std::unique_ptr<Tree>>().swap(dataset_bins_trees_);
+  dataset_bins_data_ = nullptr;
+  dataset_bins_version_ = -1;
+}
+
 }  // namespace LightGBM
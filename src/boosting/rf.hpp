@@ -108,6 +108,7 @@ class RF : public GBDT {
 
     gradients = gradients_.data();
     hessians = hessians_.data();
+    int64_t added_size = 0;
     for (int cur_tree_id = 0; cur_tree_id < num_tree_per_iteration_; ++cur_tree_id) {
       std::unique_ptr<Tree> new_tree(new Tree(2));
       size_t offset = static_cast<size_t>(cur_tree_id)* num_data_;
@@ -125,6 +126,7 @@ class RF : public GBDT {
           hess = tmp_hess_.data();
         }
 
+        tree_learner_->SetTreeClass(cur_tree_id);
         new_tree.reset(tree_learner_->Train(grad, hess, is_constant_hessian_,
           forced_splits_json_));
       }
@@ -159,8 +161,11 @@ class RF : public GBDT {
         }
       }
       // add model
+      added_size += new_tree->SizesInByte();
       models_.push_back(std::move(new_tree));
     }
+    OnModelsResized(added_size);
+    UpdateMemoryUsage(false);
     ++iter_;
     return false;
   }
@@ -180,9 +185,12 @@ class RF : public GBDT {
       MultiplyScore(cur_tree_id, 1.0f / (iter_ + num_init_iteration_ - 1));
     }
     // remove model
+    int64_t removed_size = 0;
     for (int cur_tree_id = 0; cur_tree_id < num_tree_per_iteration_; ++cur_tree_id) {
+      removed_size += models_.back()->SizesInByte();
       models_.pop_back();
     }
+    OnModelsResized(-removed_size);
     --iter_;
   }
 
@@ -11,6 +11,7 @@
 #include <LightGBM/tree_learner.h>
 #include <LightGBM/utils/openmp_wrapper.h>
 
+#include <algorithm>
 #include <cstring>
 #include <vector>
 
@@ -80,6 +81,19 @@ class ScoreUpdater {
     tree->AddPredictionToScore(data_, num_data_, score_.data() + offset);
   }
   /*!
+  * \brief Using many tree models to get prediction numbers, then adding to scores for all data.
+  *        The trees are evaluated together, which is much faster than adding them one by one
+  * \param trees Tree models, trees[i] is for the tree id i % num_tree_per_iteration
+  * \param num_tree_per_iteration Number of trees per iteration
+  */
+  inline void AddScore(const std::vector<const Tree*>& trees, int num_tree_per_iteration) {
+    std::vector<double*> scores(trees.size());
+    for (size_t i = 0; i < trees.size(); ++i) {
+      scores[i] = score_.data() + static_cast<size_t>(num_data_) * (i % num_tree_per_iteration);
+    }
+    Tree::AddPredictionToScore(trees, data_, num_data_, scores);
+  }
+  /*!
   * \brief Adding prediction score, only used for training data.
   *        The training data is partitioned into tree leaves after training
   *        Based on which We can get prediction quickly.
@@ -108,6 +122,15 @@ class ScoreUpdater {
 
   inline data_size_t num_data() const { return num_data_; }
 
+  /*! \brief Overwrite all scores, e.g. when resuming from a checkpoint */
+  inline void SetScore(const std::vector<double>& score) {
+    CHECK(score.size() == score_.size());
+    std::copy(score.begin(), score.end(), score_.begin());
+  }
+
+  /*! \brief Get sizes in byte of this object */
+  inline size_t SizesInByte() const { return sizeof(double) * score_.size(); }
+
   /*! \brief Disable copy */
   ScoreUpdater& operator=(const ScoreUpdater&) = delete;
   /*! \brief Disable copy */
@@ -19,11 +19,20 @@
 #include <LightGBM/utils/threading.h>
 
 #include <string>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <cstdio>
 #include <functional>
+#include <limits>
+#include <list>
 #include <memory>
 #include <mutex>
 #include <stdexcept>
+#include <thread>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include "application/predictor.hpp"
@@ -52,6 +61,7 @@ const int PREDICTOR_TYPES = 4;
 class SingleRowPredictor {
  public:
   PredictFunction predict_function;
+  std::function<void(const float*, double*)> dense_float_predict_function;
   int64_t num_pred_in_one_row;
 
   SingleRowPredictor(int predict_type, Boosting* boosting, const Config& config, int iter) {
@@ -70,20 +80,30 @@ class SingleRowPredictor {
     early_stop_ = config.pred_early_stop;
     early_stop_freq_ = config.pred_early_stop_freq;
     early_stop_margin_ = config.pred_early_stop_margin;
+    tree_parallel_threshold_ = config.pred_tree_parallel_threshold;
     iter_ = iter;
     predictor_.reset(new Predictor(boosting, iter_, is_raw_score, is_predict_leaf, predict_contrib,
-                                   early_stop_, early_stop_freq_, early_stop_margin_));
+                                   early_stop_, early_stop_freq_, early_stop_margin_,
+                                   tree_parallel_threshold_));
     num_pred_in_one_row = boosting->NumPredictOneRow(iter_, is_predict_leaf, predict_contrib);
     predict_function = predictor_->GetPredictFunction();
-    num_total_model_ = boosting->NumberOfTotalModel();
+    dense_float_predict_function = predictor_->GetDenseFloatPredictFunction();
+    model_version_ = boosting->ModelVersion();
   }
   ~SingleRowPredictor() {}
   bool IsPredictorEqual(const Config& config, int iter, Boosting* boosting) {
-    return early_stop_ != config.pred_early_stop ||
-      early_stop_freq_ != config.pred_early_stop_freq ||
-      early_stop_margin_ != config.pred_early_stop_margin ||
-      iter_ != iter ||
-      num_total_model_ != boosting->NumberOfTotalModel();
+    return early_stop_ == config.pred_early_stop &&
+      early_stop_freq_ == config.pred_early_stop_freq &&
+      early_stop_margin_ == config.pred_early_stop_margin &&
+      tree_parallel_threshold_ == config.pred_tree_parallel_threshold &&
+      iter_ == iter &&
+      model_version_ == boosting->ModelVersion();
+  }
+
+  /*! \brief Restore the prediction settings of boosting, which other predictions of the booster may have changed */
+  void InitBoosting(Boosting* boosting) const {
+    boosting->InitPredict(iter_, false);
+    boosting->InitPredictTreeParallel(tree_parallel_threshold_);
   }
 
  private:
@@ -91,8 +111,140 @@ class SingleRowPredictor {
   bool early_stop_;
   int early_stop_freq_;
   double early_stop_margin_;
+  int tree_parallel_threshold_;
   int iter_;
-  int num_total_model_;
+  int64_t model_version_;
+};
+
+/*!
+* \brief Bounded cache of single row predictions, keyed by the row content.
+*        Entries are spread over shards with their own lock and LRU list, so lookups of concurrent callers rarely contend
+*/
+class PredictionCache {
+ public:
+  PredictionCache() : capacity_(0), hits_(0), misses_(0) {
+    for (int i = 0; i < kNumShards; ++i) {
+      shards_[i].capacity = 0;
+    }
+  }
+
+  /*! \brief Key of a row given by (feature index, value) pairs */
+  static std::string RowKey(int predict_type, int num_iteration, const Config& config,
+                            const std::vector<std::pair<int, double>>& row) {
+    std::string key;
+    key.reserve(kKeyHeaderSize + row.size() * (sizeof(int) + sizeof(double)));
+    AppendKeyHeader(kSparseRow, predict_type, num_iteration, config, &key);
+    for (const auto& pair : row) {
+      key.append(reinterpret_cast<const char*>(&pair.first), sizeof(pair.first));
+      key.append(reinterpret_cast<const char*>(&pair.second), sizeof(pair.second));
+    }
+    return key;
+  }
+
+  /*! \brief Key of a dense float32 row */
+  static std::string RowKey(int predict_type, int num_iteration, const Config& config, const float* row, int ncol) {
+    std::string key;
+    key.reserve(kKeyHeaderSize + sizeof(float) * ncol);
+    AppendKeyHeader(kDenseFloatRow, predict_type, num_iteration, config, &key);
+    key.append(reinterpret_cast<const char*>(row), sizeof(float) * ncol);
+    return key;
+  }
+
+  /*! \brief Change the maximal number of cached rows, drops all entries if it differs from the current one */
+  void SetCapacity(int capacity) {
+    if (capacity_.load(std::memory_order_relaxed) == capacity) { return; }
+    for (int i = 0; i < kNumShards; ++i) {
+      std::lock_guard<std::mutex> lock(shards_[i].mutex);
+      shards_[i].capacity = capacity / kNumShards + (i < capacity % kNumShards ? 1 : 0);
+      shards_[i].lru.clear();
+      shards_[i].index.clear();
+    }
+    capacity_.store(capacity, std::memory_order_relaxed);
+  }
+
+  /*! \brief Copy the cached prediction of key to out_result, return false if it is not cached */
+  bool Get(const std::string& key, double* out_result, int64_t* out_len) {
+    Shard& shard = shards_[std::hash<std::string>()(key) % kNumShards];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.index.find(key);
+    if (it == shard.index.end()) {
+      misses_.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+    shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+    const std::vector<double>& result = it->second->second;
+    std::copy(result.begin(), result.end(), out_result);
+    *out_len = static_cast<int64_t>(result.size());
+    hits_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+  }
+
+  /*! \brief Cache the prediction of key, evicting the least recently used entry of its shard if full */
+  void Put(const std::string& key, const double* result, int64_t len) {
+    Shard& shard = shards_[std::hash<std::string>()(key) % kNumShards];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    if (shard.capacity <= 0 || shard.index.count(key) > 0) { return; }
+    if (static_cast<int>(shard.lru.size()) >= shard.capacity) {
+      shard.index.erase(shard.lru.back().first);
+      shard.lru.pop_back();
+    }
+    shard.lru.emplace_front(key, std::vector<double>(result, result + len));
+    shard.index[key] = shard.lru.begin();
+  }
+
+  /*! \brief Drop all entries, the hit and miss counters are kept */
+  void Clear() {
+    for (int i = 0; i < kNumShards; ++i) {
+      std::lock_guard<std::mutex> lock(shards_[i].mutex);
+      shards_[i].lru.clear();
+      shards_[i].index.clear();
+    }
+  }
+
+  void GetStats(int64_t* out_hits, int64_t* out_misses, int64_t* out_num_entries) {
+    int64_t num_entries = 0;
+    for (int i = 0; i < kNumShards; ++i) {
+      std::lock_guard<std::mutex> lock(shards_[i].mutex);
+      num_entries += static_cast<int64_t>(shards_[i].lru.size());
+    }
+    *out_hits = hits_.load(std::memory_order_relaxed);
+    *out_misses = misses_.load(std::memory_order_relaxed);
+    *out_num_entries = num_entries;
+  }
+
+ private:
+  static const int kNumShards = 16;
+  static const int kSparseRow = 0;
+  static const int kDenseFloatRow = 1;
+  static const size_t kKeyHeaderSize = sizeof(int) * 5 + sizeof(double);
+
+  /*! \brief Append the settings that change the prediction of a row */
+  static void AppendKeyHeader(int row_format, int predict_type, int num_iteration, const Config& config,
+                              std::string* key) {
+    key->append(reinterpret_cast<const char*>(&row_format), sizeof(row_format));
+    key->append(reinterpret_cast<const char*>(&predict_type), sizeof(predict_type));
+    key->append(reinterpret_cast<const char*>(&num_iteration), sizeof(num_iteration));
+    // frequency and margin only matter with early stopping
+    const int early_stop = config.pred_early_stop ? 1 : 0;
+    const int early_stop_freq = config.pred_early_stop ? config.pred_early_stop_freq : 0;
+    const double early_stop_margin = config.pred_early_stop ? config.pred_early_stop_margin : 0.0f;
+    key->append(reinterpret_cast<const char*>(&early_stop), sizeof(early_stop));
+    key->append(reinterpret_cast<const char*>(&early_stop_freq), sizeof(early_stop_freq));
+    key->append(reinterpret_cast<const char*>(&early_stop_margin), sizeof(early_stop_margin));
+  }
+
+  struct Shard {
+    std::mutex mutex;
+    int capacity;
+    /*! \brief Entries from the most to the least recently used */
+    std::list<std::pair<std::string, std::vector<double>>> lru;
+    std::unordered_map<std::string, std::list<std::pair<std::string, std::vector<double>>>::iterator> index;
+  };
+
+  std::atomic<int> capacity_;
+  std::atomic<int64_t> hits_;
+  std::atomic<int64_t> misses_;
+  Shard shards_[kNumShards];
 };
 
 class Booster {
@@ -131,11 +283,16 @@ class Booster {
   }
 
   void MergeFrom(const Booster* other) {
-    std::lock_guard<std::mutex> lock(mutex_);
+    auto lock = LockNotTrainingInBackground();
     boosting_->MergeFrom(other->boosting_.get());
+    ResetSingleRowPredictors();
   }
 
   ~Booster() {
+    if (train_thread_.joinable()) {
+      train_cancel_requested_ = true;
+      train_thread_.join();
+    }
   }
 
   void CreateObjectiveAndMetrics() {
@@ -157,14 +314,15 @@ class Booster {
         Metric::CreateMetric(metric_type, config_));
       if (metric == nullptr) { continue; }
       metric->Init(train_data_->metadata(), train_data_->num_data());
+      metric->SetDistributed(config_.is_parallel_find_bin);
       train_metric_.push_back(std::move(metric));
     }
     train_metric_.shrink_to_fit();
   }
 
   void ResetTrainingData(const Dataset* train_data) {
+    auto lock = LockNotTrainingInBackground();
     if (train_data != train_data_) {
-      std::lock_guard<std::mutex> lock(mutex_);
       train_data_ = train_data;
       CreateObjectiveAndMetrics();
       // reset the boosting
@@ -174,7 +332,7 @@ class Booster {
   }
 
   void ResetConfig(const char* parameters) {
-    std::lock_guard<std::mutex> lock(mutex_);
+    auto lock = LockNotTrainingInBackground();
     auto param = Config::Str2Map(parameters);
     if (param.count("num_class")) {
       Log::Fatal("Cannot change num_class during training");
@@ -210,12 +368,13 @@ class Booster {
   }
 
   void AddValidData(const Dataset* valid_data) {
-    std::lock_guard<std::mutex> lock(mutex_);
+    auto lock = LockNotTrainingInBackground();
     valid_metrics_.emplace_back();
     for (auto metric_type : config_.metric) {
       auto metric = std::unique_ptr<Metric>(Metric::CreateMetric(metric_type, config_));
       if (metric == nullptr) { continue; }
       metric->Init(valid_data->metadata(), valid_data->num_data());
+      metric->SetDistributed(config_.is_parallel_find_bin && config_.pre_partition);
       valid_metrics_.back().push_back(std::move(metric));
     }
     valid_metrics_.back().shrink_to_fit();
@@ -224,12 +383,13 @@ class Booster {
   }
 
   bool TrainOneIter() {
-    std::lock_guard<std::mutex> lock(mutex_);
+    auto lock = LockNotTrainingInBackground();
+    predict_cache_.Clear();
     return boosting_->TrainOneIter(nullptr, nullptr);
   }
 
   void Refit(const int32_t* leaf_preds, int32_t nrow, int32_t ncol) {
-    std::lock_guard<std::mutex> lock(mutex_);
+    auto lock = LockNotTrainingInBackground();
     std::vector<std::vector<int32_t>> v_leaf_preds(nrow, std::vector<int32_t>(ncol, 0));
     for (int i = 0; i < nrow; ++i) {
       for (int j = 0; j < ncol; ++j) {
@@ -237,16 +397,131 @@ class Booster {
       }
     }
     boosting_->RefitTree(v_leaf_preds);
+    ResetSingleRowPredictors();
+  }
+
+  int CompactModel(const int32_t* leaf_preds, int32_t nrow, int32_t ncol) {
+    auto lock = LockNotTrainingInBackground();
+    std::vector<std::vector<int32_t>> v_leaf_preds(leaf_preds == nullptr ? 0 : nrow, std::vector<int32_t>(ncol, 0));
+    for (int i = 0; i < static_cast<int>(v_leaf_preds.size()); ++i) {
+      for (int j = 0; j < ncol; ++j) {
+        v_leaf_preds[i][j] = leaf_preds[static_cast<size_t>(i) * ncol + j];
+      }
+    }
+    int num_removed_iterations = boosting_->CompactModel(v_leaf_preds);
+    ResetSingleRowPredictors();
+    return num_removed_iterations;
   }
 
   bool TrainOneIter(const score_t* gradients, const score_t* hessians) {
-    std::lock_guard<std::mutex> lock(mutex_);
+    auto lock = LockNotTrainingInBackground();
+    predict_cache_.Clear();
+    return boosting_->TrainOneIter(gradients, hessians);
+  }
+
+  bool TrainOneIterInplace() {
+    auto lock = LockNotTrainingInBackground();
+    score_t* gradients = nullptr;
+    score_t* hessians = nullptr;
+    boosting_->GetGradientBuffers(&gradients, &hessians);
+    predict_cache_.Clear();
+    return boosting_->TrainOneIter(gradients, hessians);
+  }
+
+  bool TrainOneIterFromDouble(const double* gradients, const double* hessians) {
+    auto lock = LockNotTrainingInBackground();
+    predict_cache_.Clear();
+    #ifdef SCORE_T_USE_DOUBLE
     return boosting_->TrainOneIter(gradients, hessians);
+    #else
+    // convert straight into the boosting's own buffers, no temporary copy
+    score_t* grad_buffer = nullptr;
+    score_t* hess_buffer = nullptr;
+    const int64_t len = boosting_->GetGradientBuffers(&grad_buffer, &hess_buffer);
+    #pragma omp parallel for schedule(static)
+    for (int64_t i = 0; i < len; ++i) {
+      grad_buffer[i] = static_cast<score_t>(gradients[i]);
+      hess_buffer[i] = static_cast<score_t>(hessians[i]);
+    }
+    return boosting_->TrainOneIter(grad_buffer, hess_buffer);
+    #endif
+  }
+
+  int64_t GetGradientBuffers(score_t** out_gradients, score_t** out_hessians) {
+    // the buffers are written by the training thread
+    auto lock = LockNotTrainingInBackground();
+    return boosting_->GetGradientBuffers(out_gradients, out_hessians);
+  }
+
+  const double* GetTrainingScore(int64_t* out_len) {
+    // the scores are updated by the training thread
+    auto lock = LockNotTrainingInBackground();
+    return boosting_->GetTrainingScore(out_len);
   }
 
   void RollbackOneIter() {
-    std::lock_guard<std::mutex> lock(mutex_);
+    auto lock = LockNotTrainingInBackground();
     boosting_->RollbackOneIter();
+    predict_cache_.Clear();
+  }
+
+  void StartTraining(int num_iterations) {
+    if (num_iterations <= 0) {
+      Log::Fatal("Number of iterations for training should be greater than 0");
+    }
+    std::lock_guard<std::mutex> lock(train_status_mutex_);
+    if (train_status_ == C_API_TRAINING_RUNNING) {
+      Log::Fatal("Training is already running in background");
+    }
+    // the previous run has already ended, only release its thread
+    if (train_thread_.joinable()) {
+      train_thread_.join();
+    }
+    train_eval_.clear();
+    train_eval_iteration_ = 0;
+    train_error_.clear();
+    train_start_time_ = std::chrono::steady_clock::now();
+    train_elapsed_seconds_ = 0.0;
+    train_iteration_ = 0;
+    train_cancel_requested_ = false;
+    train_status_ = C_API_TRAINING_RUNNING;
+    train_thread_ = std::thread(&Booster::TrainInBackground, this, num_iterations, Log::CurrentLogLevel());
+  }
+
+  void GetTrainingProgress(int* out_status, int* out_iteration, double* out_elapsed_seconds) {
+    std::lock_guard<std::mutex> lock(train_status_mutex_);
+    *out_status = train_status_;
+    *out_iteration = train_iteration_;
+    if (train_status_ == C_API_TRAINING_RUNNING) {
+      *out_elapsed_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - train_start_time_).count();
+    } else {
+      *out_elapsed_seconds = train_elapsed_seconds_;
+    }
+  }
+
+  void GetTrainingEval(int data_idx, int* out_iteration, int* out_len, double* out_results) {
+    std::lock_guard<std::mutex> lock(train_status_mutex_);
+    *out_iteration = train_eval_iteration_;
+    *out_len = 0;
+    if (train_eval_.empty()) { return; }
+    if (data_idx < 0 || data_idx >= static_cast<int>(train_eval_.size())) {
+      Log::Fatal("Data index %d is out of range", data_idx);
+    }
+    *out_len = static_cast<int>(train_eval_[data_idx].size());
+    std::copy(train_eval_[data_idx].begin(), train_eval_[data_idx].end(), out_results);
+  }
+
+  void CancelTraining() {
+    train_cancel_requested_ = true;
+  }
+
+  int WaitTraining() {
+    std::unique_lock<std::mutex> lock(train_status_mutex_);
+    train_done_cv_.wait(lock, [this] { return train_status_ != C_API_TRAINING_RUNNING; });
+    if (train_status_ == C_API_TRAINING_FAILED) {
+      Log::Fatal("Training in background failed: %s", train_error_.c_str());
+    }
+    return train_status_;
   }
 
   void PredictSingleRow(int num_iteration, int predict_type, int ncol,
@@ -257,19 +532,92 @@ class Booster {
       Log::Fatal("The number of features in data (%d) is not the same as it was in training data (%d).\n"\
                  "You can set ``predict_disable_shape_check=true`` to discard this error, but please be aware what you are doing.", ncol, boosting_->MaxFeatureIdx() + 1);
     }
+    auto one_row = get_row_fun(0);
+    std::string cache_key;
+    if (config.pred_cache_size > 0) {
+      predict_cache_.SetCapacity(config.pred_cache_size);
+      cache_key = PredictionCache::RowKey(predict_type, num_iteration, config, one_row);
+      if (predict_cache_.Get(cache_key, out_result, out_len)) { return; }
+    }
     std::lock_guard<std::mutex> lock(mutex_);
     if (single_row_predictor_[predict_type].get() == nullptr ||
         !single_row_predictor_[predict_type]->IsPredictorEqual(config, num_iteration, boosting_.get())) {
       single_row_predictor_[predict_type].reset(new SingleRowPredictor(predict_type, boosting_.get(),
                                                                        config, num_iteration));
+      predict_cache_.Clear();
+    } else {
+      single_row_predictor_[predict_type]->InitBoosting(boosting_.get());
     }
-    auto one_row = get_row_fun(0);
     auto pred_wrt_ptr = out_result;
     single_row_predictor_[predict_type]->predict_function(one_row, pred_wrt_ptr);
 
     *out_len = single_row_predictor_[predict_type]->num_pred_in_one_row;
+    if (config.pred_cache_size > 0) {
+      predict_cache_.Put(cache_key, out_result, *out_len);
+    }
+  }
+
+
+  /*! \brief Whether the rows can be read in place by the float32 prediction path */
+  bool CanPredictDenseFloat(int data_type, int is_row_major, int predict_type, int ncol) const {
+    return data_type == C_API_DTYPE_FLOAT32 && is_row_major && predict_type != C_API_PREDICT_CONTRIB
+           && ncol == boosting_->MaxFeatureIdx() + 1;
+  }
+
+  void PredictSingleRowForDenseFloat(int num_iteration, int predict_type, const float* data,
+                                     const Config& config, double* out_result, int64_t* out_len) {
+    std::string cache_key;
+    if (config.pred_cache_size > 0) {
+      predict_cache_.SetCapacity(config.pred_cache_size);
+      cache_key = PredictionCache::RowKey(predict_type, num_iteration, config, data,
+                                          boosting_->MaxFeatureIdx() + 1);
+      if (predict_cache_.Get(cache_key, out_result, out_len)) { return; }
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (single_row_predictor_[predict_type].get() == nullptr ||
+        !single_row_predictor_[predict_type]->IsPredictorEqual(config, num_iteration, boosting_.get())) {
+      single_row_predictor_[predict_type].reset(new SingleRowPredictor(predict_type, boosting_.get(),
+                                                                       config, num_iteration));
+      predict_cache_.Clear();
+    } else {
+      single_row_predictor_[predict_type]->InitBoosting(boosting_.get());
+    }
+    single_row_predictor_[predict_type]->dense_float_predict_function(data, out_result);
+    *out_len = single_row_predictor_[predict_type]->num_pred_in_one_row;
+    if (config.pred_cache_size > 0) {
+      predict_cache_.Put(cache_key, out_result, *out_len);
+    }
   }
 
+  void GetPredictCacheStats(int64_t* out_hits, int64_t* out_misses, int64_t* out_num_entries) {
+    predict_cache_.GetStats(out_hits, out_misses, out_num_entries);
+  }
+
+  void PredictForDenseFloat(int num_iteration, int predict_type, const float* data, int nrow, int ncol,
+                            const Config& config, double* out_result, int64_t* out_len) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    bool is_predict_leaf = false;
+    bool is_raw_score = false;
+    if (predict_type == C_API_PREDICT_LEAF_INDEX) {
+      is_predict_leaf = true;
+    } else if (predict_type == C_API_PREDICT_RAW_SCORE) {
+      is_raw_score = true;
+    }
+    Predictor predictor(boosting_.get(), num_iteration, is_raw_score, is_predict_leaf, false,
+                        config.pred_early_stop, config.pred_early_stop_freq, config.pred_early_stop_margin,
+                        config.pred_tree_parallel_threshold);
+    int64_t num_pred_in_one_row = boosting_->NumPredictOneRow(num_iteration, is_predict_leaf, false);
+    const auto& pred_fun = predictor.GetDenseFloatPredictFunction();
+    OMP_INIT_EX();
+    #pragma omp parallel for schedule(static)
+    for (int i = 0; i < nrow; ++i) {
+      OMP_LOOP_EX_BEGIN();
+      pred_fun(data + static_cast<size_t>(ncol) * i, out_result + static_cast<size_t>(num_pred_in_one_row) * i);
+      OMP_LOOP_EX_END();
+    }
+    OMP_THROW_EX();
+    *out_len = num_pred_in_one_row * nrow;
+  }
 
   void Predict(int num_iteration, int predict_type, int nrow, int ncol,
                std::function<std::vector<std::pair<int, double>>(int row_idx)> get_row_fun,
@@ -294,7 +642,8 @@ class Booster {
     }
 
     Predictor predictor(boosting_.get(), num_iteration, is_raw_score, is_predict_leaf, predict_contrib,
-                        config.pred_early_stop, config.pred_early_stop_freq, config.pred_early_stop_margin);
+                        config.pred_early_stop, config.pred_early_stop_freq, config.pred_early_stop_margin,
+                        config.pred_tree_parallel_threshold);
     int64_t num_pred_in_one_row = boosting_->NumPredictOneRow(num_iteration, is_predict_leaf, predict_contrib);
     auto pred_fun = predictor.GetPredictFunction();
     OMP_INIT_EX();
@@ -310,6 +659,84 @@ class Booster {
     *out_len = num_pred_in_one_row * nrow;
   }
 
+  /*!
+  * \brief Predict one dense matrix with several boosters, the predictions of a row are stored model by model.
+  *        Rows are converted once and predicted in blocks, all models go over a block before the next one
+  */
+  static void PredictMulti(const std::vector<Booster*>& boosters, int num_iteration, int predict_type,
+                           const void* data, int data_type, int nrow, int ncol, int is_row_major,
+                           std::function<std::vector<std::pair<int, double>>(int row_idx)> get_row_fun,
+                           const Config& config, double* out_result, int64_t* out_len) {
+    // lock each booster once, in a fixed order
+    std::vector<Booster*> unique_boosters(boosters);
+    std::sort(unique_boosters.begin(), unique_boosters.end());
+    unique_boosters.erase(std::unique(unique_boosters.begin(), unique_boosters.end()), unique_boosters.end());
+    std::vector<std::unique_lock<std::mutex>> locks;
+    for (auto booster : unique_boosters) {
+      locks.emplace_back(booster->mutex_);
+    }
+    const bool is_predict_leaf = predict_type == C_API_PREDICT_LEAF_INDEX;
+    const bool is_raw_score = predict_type == C_API_PREDICT_RAW_SCORE;
+    const bool predict_contrib = predict_type == C_API_PREDICT_CONTRIB;
+    const int num_models = static_cast<int>(boosters.size());
+    std::vector<std::unique_ptr<Predictor>> predictors;
+    std::vector<int64_t> pred_offsets(num_models + 1, 0);
+    int num_features = ncol;
+    for (int m = 0; m < num_models; ++m) {
+      const Boosting* boosting = boosters[m]->boosting_.get();
+      if (!config.predict_disable_shape_check && ncol != boosting->MaxFeatureIdx() + 1) {
+        Log::Fatal("The number of features in data (%d) is not the same as it was in training data of booster %d (%d).\n" \
+                   "You can set ``predict_disable_shape_check=true`` to discard this error, but please be aware what you are doing.", ncol, m, boosting->MaxFeatureIdx() + 1);
+      }
+      predictors.emplace_back(new Predictor(boosters[m]->boosting_.get(), num_iteration, is_raw_score, is_predict_leaf, predict_contrib,
+                                            config.pred_early_stop, config.pred_early_stop_freq, config.pred_early_stop_margin,
+                                            config.pred_tree_parallel_threshold));
+      pred_offsets[m + 1] = pred_offsets[m] + boosting->NumPredictOneRow(num_iteration, is_predict_leaf, predict_contrib);
+      num_features = std::max(num_features, boosting->MaxFeatureIdx() + 1);
+    }
+    const int64_t num_pred_in_one_row = pred_offsets.back();
+    const int kRowBlockSize = 64;
+    const int num_blocks = (nrow + kRowBlockSize - 1) / kRowBlockSize;
+    OMP_INIT_EX();
+    #pragma omp parallel
+    {
+      // features absent from data are zero
+      std::vector<double> block_buf(predict_contrib ? 0 : static_cast<size_t>(kRowBlockSize) * num_features, 0.0f);
+      #pragma omp for schedule(static)
+      for (int block = 0; block < num_blocks; ++block) {
+        OMP_LOOP_EX_BEGIN();
+        const int start = block * kRowBlockSize;
+        const int end = std::min(nrow, start + kRowBlockSize);
+        if (predict_contrib) {
+          for (int i = start; i < end; ++i) {
+            auto one_row = get_row_fun(i);
+            for (int m = 0; m < num_models; ++m) {
+              predictors[m]->GetPredictFunction()(one_row, out_result + num_pred_in_one_row * i + pred_offsets[m]);
+            }
+          }
+        } else {
+          if (data_type == C_API_DTYPE_FLOAT32) {
+            CopyDenseRows(reinterpret_cast<const float*>(data), nrow, ncol, is_row_major, start, end, num_features, block_buf.data());
+          } else if (data_type == C_API_DTYPE_FLOAT64) {
+            CopyDenseRows(reinterpret_cast<const double*>(data), nrow, ncol, is_row_major, start, end, num_features, block_buf.data());
+          } else {
+            Log::Fatal("Unknown data type in PredictForMatMulti");
+          }
+          for (int m = 0; m < num_models; ++m) {
+            const auto& pred_fun = predictors[m]->GetDensePredictFunction();
+            for (int i = start; i < end; ++i) {
+              pred_fun(block_buf.data() + static_cast<size_t>(num_features) * (i - start),
+                       out_result + num_pred_in_one_row * i + pred_offsets[m]);
+            }
+          }
+        }
+        OMP_LOOP_EX_END();
+      }
+    }
+    OMP_THROW_EX();
+    *out_len = num_pred_in_one_row * nrow;
+  }
+
   void Predict(int num_iteration, int predict_type, const char* data_filename,
                int data_has_header, const Config& config,
                const char* result_filename) {
@@ -327,48 +754,128 @@ class Booster {
       is_raw_score = false;
     }
     Predictor predictor(boosting_.get(), num_iteration, is_raw_score, is_predict_leaf, predict_contrib,
-                        config.pred_early_stop, config.pred_early_stop_freq, config.pred_early_stop_margin);
+                        config.pred_early_stop, config.pred_early_stop_freq, config.pred_early_stop_margin,
+                        config.pred_tree_parallel_threshold);
     bool bool_data_has_header = data_has_header > 0 ? true : false;
     predictor.Predict(data_filename, result_filename, bool_data_has_header, config.predict_disable_shape_check);
   }
 
+  void PredictForBins(int num_iteration, int predict_type, const void* data, int data_type,
+                      int nrow, int ncol, int is_row_major, const Config& config,
+                      double* out_result, int64_t* out_len) {
+    if (!config.predict_disable_shape_check && ncol != boosting_->MaxFeatureIdx() + 1) {
+      Log::Fatal("The number of features in data (%d) is not the same as it was in training data (%d).\n" \
+                 "You can set ``predict_disable_shape_check=true`` to discard this error, but please be aware what you are doing.", ncol, boosting_->MaxFeatureIdx() + 1);
+    }
+    if (predict_type == C_API_PREDICT_CONTRIB) {
+      Log::Fatal("Feature contributions are not supported for pre-binned data");
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    boosting_->InitPredictByBins(num_iteration);
+    const int num_features = boosting_->MaxFeatureIdx() + 1;
+    // features absent from data are zero
+    std::vector<uint16_t> zero_bins(num_features, 0);
+    std::vector<double> bounds;
+    for (int i = 0; i < num_features; ++i) {
+      if (boosting_->GetFeatureBinUpperBounds(i, &bounds)) {
+        zero_bins[i] = static_cast<uint16_t>(std::lower_bound(bounds.begin(), bounds.end(), kZeroThreshold) - bounds.begin());
+        if (data_type == C_API_DTYPE_UINT8 && bounds.size() + 1 > std::numeric_limits<uint8_t>::max()) {
+          Log::Fatal("Feature %d needs %d bins, which cannot be stored in uint8, please use uint16", i, static_cast<int>(bounds.size()) + 2);
+        }
+      }
+    }
+    int64_t num_pred_in_one_row = boosting_->NumPredictOneRow(num_iteration, predict_type == C_API_PREDICT_LEAF_INDEX, false);
+    if (data_type == C_API_DTYPE_UINT8) {
+      PredictForBins(reinterpret_cast<const uint8_t*>(data), predict_type, nrow, ncol, is_row_major,
+                     zero_bins, num_pred_in_one_row, out_result);
+    } else if (data_type == C_API_DTYPE_UINT16) {
+      PredictForBins(reinterpret_cast<const uint16_t*>(data), predict_type, nrow, ncol, is_row_major,
+                     zero_bins, num_pred_in_one_row, out_result);
+    } else {
+      Log::Fatal("Unknown data type in PredictForBins");
+    }
+    *out_len = num_pred_in_one_row * nrow;
+  }
+
+  void GetFeatureBinUpperBounds(int feature_idx, int64_t buffer_len, int64_t* out_len, double* out_bounds) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (feature_idx < 0 || feature_idx > boosting_->MaxFeatureIdx()) {
+      Log::Fatal("Feature index %d is out of range", feature_idx);
+    }
+    boosting_->InitPredictByBins(-1);
+    std::vector<double> bounds;
+    if (!boosting_->GetFeatureBinUpperBounds(feature_idx, &bounds)) {
+      *out_len = -1;
+      return;
+    }
+    *out_len = static_cast<int64_t>(bounds.size());
+    if (buffer_len >= *out_len) {
+      std::copy(bounds.begin(), bounds.end(), out_bounds);
+    }
+  }
+
+  std::vector<double> GetEvalAt(int data_idx) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return boosting_->GetEvalAt(data_idx);
+  }
+
   void GetPredictAt(int data_idx, double* out_result, int64_t* out_len) {
+    std::lock_guard<std::mutex> lock(mutex_);
     boosting_->GetPredictAt(data_idx, out_result, out_len);
   }
 
   void SaveModelToFile(int start_iteration, int num_iteration, const char* filename) {
+    std::lock_guard<std::mutex> lock(mutex_);
     boosting_->SaveModelToFile(start_iteration, num_iteration, filename);
   }
 
   void LoadModelFromString(const char* model_str) {
+    auto lock = LockNotTrainingInBackground();
     size_t len = std::strlen(model_str);
     boosting_->LoadModelFromString(model_str, len);
+    ResetSingleRowPredictors();
   }
 
   std::string SaveModelToString(int start_iteration, int num_iteration) {
+    std::lock_guard<std::mutex> lock(mutex_);
     return boosting_->SaveModelToString(start_iteration, num_iteration);
   }
 
   std::string DumpModel(int start_iteration, int num_iteration) {
+    std::lock_guard<std::mutex> lock(mutex_);
     return boosting_->DumpModel(start_iteration, num_iteration);
   }
 
+  std::string MemoryUsageToJSON() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return boosting_->MemoryUsageToJSON();
+  }
+
+  std::string TrainingStatsToJSON() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return boosting_->TrainingStatsToJSON();
+  }
+
   std::vector<double> FeatureImportance(int num_iteration, int importance_type) {
+    std::lock_guard<std::mutex> lock(mutex_);
     return boosting_->FeatureImportance(num_iteration, importance_type);
   }
 
-  double GetLeafValue(int tree_idx, int leaf_idx) const {
+  double GetLeafValue(int tree_idx, int leaf_idx) {
+    std::lock_guard<std::mutex> lock(mutex_);
     return dynamic_cast<GBDTBase*>(boosting_.get())->GetLeafValue(tree_idx, leaf_idx);
   }
 
   void SetLeafValue(int tree_idx, int leaf_idx, double val) {
-    std::lock_guard<std::mutex> lock(mutex_);
+    auto lock = LockNotTrainingInBackground();
     dynamic_cast<GBDTBase*>(boosting_.get())->SetLeafValue(tree_idx, leaf_idx, val);
+    ResetSingleRowPredictors();
   }
 
   void ShuffleModels(int start_iter, int end_iter) {
-    std::lock_guard<std::mutex> lock(mutex_);
+    auto lock = LockNotTrainingInBackground();
     boosting_->ShuffleModels(start_iter, end_iter);
+    ResetSingleRowPredictors();
   }
 
   int GetEvalCounts() const {
@@ -402,9 +909,140 @@ class Booster {
   const Boosting* GetBoosting() const { return boosting_.get(); }
 
  private:
+  /*!
+  * \brief Lock mutex_ for a call that changes the model or the training state, which is not allowed while
+  *        StartTraining runs. The status is checked under the lock, so a run started afterwards waits for the call
+  */
+  std::unique_lock<std::mutex> LockNotTrainingInBackground() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (train_status_ == C_API_TRAINING_RUNNING) {
+      Log::Fatal("Cannot modify the booster while training in background, call LGBM_BoosterWaitTraining first");
+    }
+    return lock;
+  }
+
+  /*! \brief Body of the thread started by StartTraining, mutex_ is held only within one iteration */
+  void TrainInBackground(int num_iterations, LogLevel log_level) {
+    // log level and number of threads are per thread settings
+    Log::ResetLogLevel(log_level);
+    if (config_.num_threads > 0) {
+      omp_set_num_threads(config_.num_threads);
+    }
+    int status = C_API_TRAINING_FINISHED;
+    std::string error;
+    try {
+      for (int iter = 0; iter < num_iterations; ++iter) {
+        if (train_cancel_requested_) {
+          status = C_API_TRAINING_CANCELLED;
+          break;
+        }
+        bool is_finished = false;
+        bool is_early_stopped = false;
+        {
+          std::lock_guard<std::mutex> lock(mutex_);
+          predict_cache_.Clear();
+          is_finished = boosting_->TrainOneIter(nullptr, nullptr);
+          if (!is_finished) {
+            is_early_stopped = boosting_->EvalAndCheckEarlyStopping();
+          }
+          ++train_iteration_;
+          bool is_last = is_finished || is_early_stopped || iter + 1 == num_iterations;
+          if (is_last || (config_.metric_freq > 0 && (iter + 1) % config_.metric_freq == 0)) {
+            std::vector<std::vector<double>> eval(valid_metrics_.size() + 1);
+            for (size_t i = 0; i < eval.size(); ++i) {
+              eval[i] = boosting_->GetEvalAt(static_cast<int>(i));
+            }
+            std::lock_guard<std::mutex> status_lock(train_status_mutex_);
+            train_eval_ = std::move(eval);
+            train_eval_iteration_ = iter + 1;
+          }
+        }
+        Log::Info("%f seconds elapsed, finished iteration %d",
+                  std::chrono::duration<double>(std::chrono::steady_clock::now() - train_start_time_).count(), iter + 1);
+        if (is_early_stopped) {
+          status = C_API_TRAINING_EARLY_STOPPED;
+          break;
+        }
+        if (is_finished) { break; }
+      }
+    } catch (std::exception& ex) {
+      status = C_API_TRAINING_FAILED;
+      error = ex.what();
+    }
+    {
+      std::lock_guard<std::mutex> lock(train_status_mutex_);
+      train_elapsed_seconds_ = std::chrono::duration<double>(std::chrono::steady_clock::now() - train_start_time_).count();
+      train_error_ = error;
+      train_status_ = status;
+    }
+    train_done_cv_.notify_all();
+  }
+
+  /*! \brief Single row predictors and the prediction cache keep model outputs, reset them when trees are changed */
+  void ResetSingleRowPredictors() {
+    for (int i = 0; i < PREDICTOR_TYPES; ++i) {
+      single_row_predictor_[i].reset(nullptr);
+    }
+    predict_cache_.Clear();
+  }
+
+  /*! \brief Copy rows [start, end) of a dense matrix into row-major buffer out, with stride columns per row */
+  template<typename T>
+  static void CopyDenseRows(const T* data, int nrow, int ncol, int is_row_major, int start, int end, int stride, double* out) {
+    for (int i = start; i < end; ++i) {
+      double* row = out + static_cast<size_t>(stride) * (i - start);
+      if (is_row_major) {
+        const T* row_data = data + static_cast<size_t>(ncol) * i;
+        for (int j = 0; j < ncol; ++j) {
+          row[j] = static_cast<double>(row_data[j]);
+        }
+      } else {
+        for (int j = 0; j < ncol; ++j) {
+          row[j] = static_cast<double>(data[static_cast<size_t>(nrow) * j + i]);
+        }
+      }
+    }
+  }
+
+  template<typename BIN_T>
+  void PredictForBins(const BIN_T* data, int predict_type, int nrow, int ncol, int is_row_major,
+                      const std::vector<uint16_t>& zero_bins, int64_t num_pred_in_one_row, double* out_result) {
+    const int num_features = static_cast<int>(zero_bins.size());
+    const int num_used_col = std::min(ncol, num_features);
+    OMP_INIT_EX();
+    #pragma omp parallel
+    {
+      std::vector<uint16_t> row(zero_bins);
+      #pragma omp for schedule(static)
+      for (int i = 0; i < nrow; ++i) {
+        OMP_LOOP_EX_BEGIN();
+        if (is_row_major) {
+          const BIN_T* row_data = data + static_cast<size_t>(ncol) * i;
+          std::copy(row_data, row_data + num_used_col, row.begin());
+        } else {
+          for (int j = 0; j < num_used_col; ++j) {
+            row[j] = data[static_cast<size_t>(nrow) * j + i];
+          }
+        }
+        auto pred_wrt_ptr = out_result + static_cast<size_t>(num_pred_in_one_row) * i;
+        if (predict_type == C_API_PREDICT_LEAF_INDEX) {
+          boosting_->PredictLeafIndexByBins(row.data(), pred_wrt_ptr);
+        } else if (predict_type == C_API_PREDICT_RAW_SCORE) {
+          boosting_->PredictRawByBins(row.data(), pred_wrt_ptr);
+        } else {
+          boosting_->PredictByBins(row.data(), pred_wrt_ptr);
+        }
+        OMP_LOOP_EX_END();
+      }
+    }
+    OMP_THROW_EX();
+  }
+
   const Dataset* train_data_;
   std::unique_ptr<Boosting> boosting_;
   std::unique_ptr<SingleRowPredictor> single_row_predictor_[PREDICTOR_TYPES];
+  /*! \brief Recent single row predictions, used when pred_cache_size > 0 */
+  PredictionCache predict_cache_;
 
   /*! \brief All configs */
   Config config_;
@@ -416,6 +1054,23 @@ class Booster {
   std::unique_ptr<ObjectiveFunction> objective_fun_;
   /*! \brief mutex for threading safe call */
   std::mutex mutex_;
+
+  /*! \brief Thread of StartTraining, joined when the next run starts or the booster is freed */
+  std::thread train_thread_;
+  /*! \brief One of C_API_TRAINING_*, written under train_status_mutex_ */
+  std::atomic<int> train_status_{C_API_TRAINING_IDLE};
+  std::atomic<bool> train_cancel_requested_{false};
+  /*! \brief Iterations finished since StartTraining */
+  std::atomic<int> train_iteration_{0};
+  /*! \brief Guards the progress below, it is never held while an iteration is trained */
+  std::mutex train_status_mutex_;
+  std::condition_variable train_done_cv_;
+  std::chrono::steady_clock::time_point train_start_time_;
+  double train_elapsed_seconds_ = 0.0;
+  /*! \brief Latest evaluation results per dataset and the iteration they were taken at */
+  std::vector<std::vector<double>> train_eval_;
+  int train_eval_iteration_ = 0;
+  std::string train_error_;
 };
 
 }  // namespace LightGBM
@@ -430,6 +1085,9 @@ RowFunctionFromDenseMatric(const void* data, int num_row, int num_col, int data_
 std::function<std::vector<std::pair<int, double>>(int row_idx)>
 RowPairFunctionFromDenseMatric(const void* data, int num_row, int num_col, int data_type, int is_row_major);
 
+std::function<double(int row_idx, int col_idx)>
+ValueFunctionFromDenseMatric(const void* data, int num_row, int num_col, int data_type, int is_row_major);
+
 std::function<std::vector<std::pair<int, double>>(int row_idx)>
 RowPairFunctionFromDenseRows(const void** data, int num_col, int data_type);
 
@@ -631,32 +1289,36 @@ int LGBM_DatasetCreateFromMats(int32_t nmat,
     int sample_cnt = static_cast<int>(total_nrow < config.bin_construct_sample_cnt ? total_nrow : config.bin_construct_sample_cnt);
     auto sample_indices = rand.Sample(total_nrow, sample_cnt);
     sample_cnt = static_cast<int>(sample_indices.size());
-    std::vector<std::vector<double>> sample_values(ncol);
-    std::vector<std::vector<int>> sample_idx(ncol);
-
+    // locate the matrix and local row of each sampled row
+    std::vector<int> sample_mat(sample_cnt);
+    std::vector<int> sample_row(sample_cnt);
     int offset = 0;
     int j = 0;
-    for (size_t i = 0; i < sample_indices.size(); ++i) {
+    for (int i = 0; i < sample_cnt; ++i) {
       auto idx = sample_indices[i];
       while ((idx - offset) >= nrow[j]) {
         offset += nrow[j];
         ++j;
       }
-
-      auto row = get_row_fun[j](static_cast<int>(idx - offset));
-      for (size_t k = 0; k < row.size(); ++k) {
-        if (std::fabs(row[k]) > kZeroThreshold || std::isnan(row[k])) {
-          sample_values[k].emplace_back(row[k]);
-          sample_idx[k].emplace_back(static_cast<int>(i));
+      sample_mat[i] = j;
+      sample_row[i] = static_cast<int>(idx - offset);
+    }
+    std::vector<std::function<double(int row_idx, int col_idx)>> get_value_fun;
+    for (int k = 0; k < nmat; ++k) {
+      get_value_fun.push_back(ValueFunctionFromDenseMatric(data[k], nrow[k], ncol, data_type, is_row_major));
+    }
+    // sample one column at a time, so only the columns being binned are alive
+    auto get_sample_column = [&] (int col_idx, std::vector<double>* out_values, std::vector<int>* out_indices) {
+      for (int i = 0; i < sample_cnt; ++i) {
+        const double val = get_value_fun[sample_mat[i]](sample_row[i], col_idx);
+        if (std::fabs(val) > kZeroThreshold || std::isnan(val)) {
+          out_values->emplace_back(val);
+          out_indices->emplace_back(i);
         }
       }
-    }
+    };
     DatasetLoader loader(config, nullptr, 1, nullptr);
-    ret.reset(loader.CostructFromSampleData(Common::Vector2Ptr<double>(&sample_values).data(),
-                                            Common::Vector2Ptr<int>(&sample_idx).data(),
-                                            ncol,
-                                            Common::VectorSize<double>(sample_values).data(),
-                                            sample_cnt, total_nrow));
+    ret.reset(loader.CostructFromSampleColumns(ncol, get_sample_column, sample_cnt, total_nrow));
   } else {
     ret.reset(new Dataset(total_nrow));
     ret->CreateValid(
@@ -728,11 +1390,7 @@ int LGBM_DatasetCreateFromCSR(const void* indptr,
       }
     }
     DatasetLoader loader(config, nullptr, 1, nullptr);
-    ret.reset(loader.CostructFromSampleData(Common::Vector2Ptr<double>(&sample_values).data(),
-                                            Common::Vector2Ptr<int>(&sample_idx).data(),
-                                            static_cast<int>(num_col),
-                                            Common::VectorSize<double>(sample_values).data(),
-                                            sample_cnt, nrow));
+    ret.reset(loader.CostructFromSampleData(&sample_values, &sample_idx, sample_cnt, nrow));
   } else {
     ret.reset(new Dataset(nrow));
     ret->CreateValid(
@@ -796,11 +1454,7 @@ int LGBM_DatasetCreateFromCSRFunc(void* get_row_funptr,
       }
     }
     DatasetLoader loader(config, nullptr, 1, nullptr);
-    ret.reset(loader.CostructFromSampleData(Common::Vector2Ptr<double>(&sample_values).data(),
-                                            Common::Vector2Ptr<int>(&sample_idx).data(),
-                                            static_cast<int>(num_col),
-                                            Common::VectorSize<double>(sample_values).data(),
-                                            sample_cnt, nrow));
+    ret.reset(loader.CostructFromSampleData(&sample_values, &sample_idx, sample_cnt, nrow));
   } else {
     ret.reset(new Dataset(nrow));
     ret->CreateValid(
@@ -851,29 +1505,19 @@ int LGBM_DatasetCreateFromCSC(const void* col_ptr,
     int sample_cnt = static_cast<int>(nrow < config.bin_construct_sample_cnt ? nrow : config.bin_construct_sample_cnt);
     auto sample_indices = rand.Sample(nrow, sample_cnt);
     sample_cnt = static_cast<int>(sample_indices.size());
-    std::vector<std::vector<double>> sample_values(ncol_ptr - 1);
-    std::vector<std::vector<int>> sample_idx(ncol_ptr - 1);
-    OMP_INIT_EX();
-    #pragma omp parallel for schedule(static)
-    for (int i = 0; i < static_cast<int>(sample_values.size()); ++i) {
-      OMP_LOOP_EX_BEGIN();
-      CSC_RowIterator col_it(col_ptr, col_ptr_type, indices, data, data_type, ncol_ptr, nelem, i);
+    // sample one column at a time, so only the columns being binned are alive
+    auto get_sample_column = [&] (int col_idx, std::vector<double>* out_values, std::vector<int>* out_indices) {
+      CSC_RowIterator col_it(col_ptr, col_ptr_type, indices, data, data_type, ncol_ptr, nelem, col_idx);
       for (int j = 0; j < sample_cnt; j++) {
         auto val = col_it.Get(sample_indices[j]);
         if (std::fabs(val) > kZeroThreshold || std::isnan(val)) {
-          sample_values[i].emplace_back(val);
-          sample_idx[i].emplace_back(j);
+          out_values->emplace_back(val);
+          out_indices->emplace_back(j);
         }
       }
-      OMP_LOOP_EX_END();
-    }
-    OMP_THROW_EX();
+    };
     DatasetLoader loader(config, nullptr, 1, nullptr);
-    ret.reset(loader.CostructFromSampleData(Common::Vector2Ptr<double>(&sample_values).data(),
-                                            Common::Vector2Ptr<int>(&sample_idx).data(),
-                                            static_cast<int>(sample_values.size()),
-                                            Common::VectorSize<double>(sample_values).data(),
-                                            sample_cnt, nrow));
+    ret.reset(loader.CostructFromSampleColumns(static_cast<int>(ncol_ptr - 1), get_sample_column, sample_cnt, nrow));
   } else {
     ret.reset(new Dataset(nrow));
     ret->CreateValid(
@@ -1166,6 +1810,14 @@ int LGBM_BoosterRefit(BoosterHandle handle, const int32_t* leaf_preds, int32_t n
   API_END();
 }
 
+int LGBM_BoosterCompactModel(BoosterHandle handle, const int32_t* leaf_preds, int32_t nrow, int32_t ncol,
+                             int* out_num_removed_iterations) {
+  API_BEGIN();
+  Booster* ref_booster = reinterpret_cast<Booster*>(handle);
+  *out_num_removed_iterations = ref_booster->CompactModel(leaf_preds, nrow, ncol);
+  API_END();
+}
+
 int LGBM_BoosterUpdateOneIter(BoosterHandle handle, int* is_finished) {
   API_BEGIN();
   Booster* ref_booster = reinterpret_cast<Booster*>(handle);
@@ -1195,6 +1847,90 @@ int LGBM_BoosterUpdateOneIterCustom(BoosterHandle handle,
   API_END();
 }
 
+int LGBM_BoosterUpdateOneIterCustomFloat64(BoosterHandle handle,
+                                           const double* grad,
+                                           const double* hess,
+                                           int* is_finished) {
+  API_BEGIN();
+  Booster* ref_booster = reinterpret_cast<Booster*>(handle);
+  if (ref_booster->TrainOneIterFromDouble(grad, hess)) {
+    *is_finished = 1;
+  } else {
+    *is_finished = 0;
+  }
+  API_END();
+}
+
+int LGBM_BoosterGetGradientBuffers(BoosterHandle handle,
+                                   int64_t* out_len,
+                                   float** out_grad,
+                                   float** out_hess) {
+  API_BEGIN();
+  Booster* ref_booster = reinterpret_cast<Booster*>(handle);
+  #ifdef SCORE_T_USE_DOUBLE
+  Log::Fatal("Don't support custom loss function when SCORE_T_USE_DOUBLE is enabled");
+  #else
+  *out_len = ref_booster->GetGradientBuffers(out_grad, out_hess);
+  #endif
+  API_END();
+}
+
+int LGBM_BoosterUpdateOneIterInplace(BoosterHandle handle,
+                                     int* is_finished) {
+  API_BEGIN();
+  Booster* ref_booster = reinterpret_cast<Booster*>(handle);
+  if (ref_booster->TrainOneIterInplace()) {
+    *is_finished = 1;
+  } else {
+    *is_finished = 0;
+  }
+  API_END();
+}
+
+int LGBM_BoosterStartTraining(BoosterHandle handle,
+                              int num_iterations) {
+  API_BEGIN();
+  Booster* ref_booster = reinterpret_cast<Booster*>(handle);
+  ref_booster->StartTraining(num_iterations);
+  API_END();
+}
+
+int LGBM_BoosterGetTrainingProgress(BoosterHandle handle,
+                                    int* out_status,
+                                    int* out_iteration,
+                                    double* out_elapsed_seconds) {
+  API_BEGIN();
+  Booster* ref_booster = reinterpret_cast<Booster*>(handle);
+  ref_booster->GetTrainingProgress(out_status, out_iteration, out_elapsed_seconds);
+  API_END();
+}
+
+int LGBM_BoosterGetTrainingEval(BoosterHandle handle,
+                                int data_idx,
+                                int* out_iteration,
+                                int* out_len,
+                                double* out_results) {
+  API_BEGIN();
+  Booster* ref_booster = reinterpret_cast<Booster*>(handle);
+  ref_booster->GetTrainingEval(data_idx, out_iteration, out_len, out_results);
+  API_END();
+}
+
+int LGBM_BoosterCancelTraining(BoosterHandle handle) {
+  API_BEGIN();
+  Booster* ref_booster = reinterpret_cast<Booster*>(handle);
+  ref_booster->CancelTraining();
+  API_END();
+}
+
+int LGBM_BoosterWaitTraining(BoosterHandle handle,
+                             int* out_status) {
+  API_BEGIN();
+  Booster* ref_booster = reinterpret_cast<Booster*>(handle);
+  *out_status = ref_booster->WaitTraining();
+  API_END();
+}
+
 int LGBM_BoosterRollbackOneIter(BoosterHandle handle) {
   API_BEGIN();
   Booster* ref_booster = reinterpret_cast<Booster*>(handle);
@@ -1257,8 +1993,7 @@ int LGBM_BoosterGetEval(BoosterHandle handle,
                         double* out_results) {
   API_BEGIN();
   Booster* ref_booster = reinterpret_cast<Booster*>(handle);
-  auto boosting = ref_booster->GetBoosting();
-  auto result_buf = boosting->GetEvalAt(data_idx);
+  auto result_buf = ref_booster->GetEvalAt(data_idx);
   *out_len = static_cast<int>(result_buf.size());
   for (size_t i = 0; i < result_buf.size(); ++i) {
     (out_results)[i] = static_cast<double>(result_buf[i]);
@@ -1285,6 +2020,15 @@ int LGBM_BoosterGetPredict(BoosterHandle handle,
   API_END();
 }
 
+int LGBM_BoosterGetTrainingScore(BoosterHandle handle,
+                                 int64_t* out_len,
+                                 const double** out_result) {
+  API_BEGIN();
+  Booster* ref_booster = reinterpret_cast<Booster*>(handle);
+  *out_result = ref_booster->GetTrainingScore(out_len);
+  API_END();
+}
+
 int LGBM_BoosterPredictForFile(BoosterHandle handle,
                                const char* data_filename,
                                int data_has_header,
@@ -1455,9 +2199,81 @@ int LGBM_BoosterPredictForMat(BoosterHandle handle,
     omp_set_num_threads(config.num_threads);
   }
   Booster* ref_booster = reinterpret_cast<Booster*>(handle);
+  if (ref_booster->CanPredictDenseFloat(data_type, is_row_major, predict_type, ncol)) {
+    ref_booster->PredictForDenseFloat(num_iteration, predict_type, reinterpret_cast<const float*>(data),
+                                      nrow, ncol, config, out_result, out_len);
+  } else {
+    auto get_row_fun = RowPairFunctionFromDenseMatric(data, nrow, ncol, data_type, is_row_major);
+    ref_booster->Predict(num_iteration, predict_type, nrow, ncol, get_row_fun,
+                         config, out_result, out_len);
+  }
+  API_END();
+}
+
+int LGBM_BoosterPredictForMatMulti(const BoosterHandle* handles,
+                                   int num_boosters,
+                                   const void* data,
+                                   int data_type,
+                                   int32_t nrow,
+                                   int32_t ncol,
+                                   int is_row_major,
+                                   int predict_type,
+                                   int num_iteration,
+                                   const char* parameter,
+                                   int64_t* out_len,
+                                   double* out_result) {
+  API_BEGIN();
+  if (num_boosters <= 0) {
+    Log::Fatal("Need at least one booster for prediction");
+  }
+  auto param = Config::Str2Map(parameter);
+  Config config;
+  config.Set(param);
+  if (config.num_threads > 0) {
+    omp_set_num_threads(config.num_threads);
+  }
+  std::vector<Booster*> boosters(num_boosters);
+  for (int i = 0; i < num_boosters; ++i) {
+    boosters[i] = reinterpret_cast<Booster*>(handles[i]);
+  }
   auto get_row_fun = RowPairFunctionFromDenseMatric(data, nrow, ncol, data_type, is_row_major);
-  ref_booster->Predict(num_iteration, predict_type, nrow, ncol, get_row_fun,
-                       config, out_result, out_len);
+  Booster::PredictMulti(boosters, num_iteration, predict_type, data, data_type, nrow, ncol, is_row_major,
+                        get_row_fun, config, out_result, out_len);
+  API_END();
+}
+
+int LGBM_BoosterPredictForBins(BoosterHandle handle,
+                               const void* data,
+                               int data_type,
+                               int32_t nrow,
+                               int32_t ncol,
+                               int is_row_major,
+                               int predict_type,
+                               int num_iteration,
+                               const char* parameter,
+                               int64_t* out_len,
+                               double* out_result) {
+  API_BEGIN();
+  auto param = Config::Str2Map(parameter);
+  Config config;
+  config.Set(param);
+  if (config.num_threads > 0) {
+    omp_set_num_threads(config.num_threads);
+  }
+  Booster* ref_booster = reinterpret_cast<Booster*>(handle);
+  ref_booster->PredictForBins(num_iteration, predict_type, data, data_type, nrow, ncol, is_row_major,
+                              config, out_result, out_len);
+  API_END();
+}
+
+int LGBM_BoosterGetFeatureBinUpperBounds(BoosterHandle handle,
+                                         int feature_idx,
+                                         int64_t buffer_len,
+                                         int64_t* out_len,
+                                         double* out_bounds) {
+  API_BEGIN();
+  Booster* ref_booster = reinterpret_cast<Booster*>(handle);
+  ref_booster->GetFeatureBinUpperBounds(feature_idx, buffer_len, out_len, out_bounds);
   API_END();
 }
 
@@ -1479,8 +2295,24 @@ int LGBM_BoosterPredictForMatSingleRow(BoosterHandle handle,
     omp_set_num_threads(config.num_threads);
   }
   Booster* ref_booster = reinterpret_cast<Booster*>(handle);
-  auto get_row_fun = RowPairFunctionFromDenseMatric(data, 1, ncol, data_type, is_row_major);
-  ref_booster->PredictSingleRow(num_iteration, predict_type, ncol, get_row_fun, config, out_result, out_len);
+  // a single row is row-major either way
+  if (ref_booster->CanPredictDenseFloat(data_type, 1, predict_type, ncol)) {
+    ref_booster->PredictSingleRowForDenseFloat(num_iteration, predict_type, reinterpret_cast<const float*>(data),
+                                               config, out_result, out_len);
+  } else {
+    auto get_row_fun = RowPairFunctionFromDenseMatric(data, 1, ncol, data_type, is_row_major);
+    ref_booster->PredictSingleRow(num_iteration, predict_type, ncol, get_row_fun, config, out_result, out_len);
+  }
+  API_END();
+}
+
+int LGBM_BoosterGetPredictCacheStats(BoosterHandle handle,
+                                     int64_t* out_hits,
+                                     int64_t* out_misses,
+                                     int64_t* out_num_entries) {
+  API_BEGIN();
+  Booster* ref_booster = reinterpret_cast<Booster*>(handle);
+  ref_booster->GetPredictCacheStats(out_hits, out_misses, out_num_entries);
   API_END();
 }
 
@@ -1550,6 +2382,34 @@ int LGBM_BoosterDumpModel(BoosterHandle handle,
   API_END();
 }
 
+int LGBM_BoosterGetMemoryUsage(BoosterHandle handle,
+                               int64_t buffer_len,
+                               int64_t* out_len,
+                               char* out_str) {
+  API_BEGIN();
+  Booster* ref_booster = reinterpret_cast<Booster*>(handle);
+  std::string usage = ref_booster->MemoryUsageToJSON();
+  *out_len = static_cast<int64_t>(usage.size()) + 1;
+  if (*out_len <= buffer_len) {
+    std::memcpy(out_str, usage.c_str(), *out_len);
+  }
+  API_END();
+}
+
+int LGBM_BoosterGetTrainingStats(BoosterHandle handle,
+                                 int64_t buffer_len,
+                                 int64_t* out_len,
+                                 char* out_str) {
+  API_BEGIN();
+  Booster* ref_booster = reinterpret_cast<Booster*>(handle);
+  std::string stats = ref_booster->TrainingStatsToJSON();
+  *out_len = static_cast<int64_t>(stats.size()) + 1;
+  if (*out_len <= buffer_len) {
+    std::memcpy(out_str, stats.c_str(), *out_len);
+  }
+  API_END();
+}
+
 int LGBM_BoosterGetLeafValue(BoosterHandle handle,
                              int tree_idx,
                              int leaf_idx,
@@ -1663,6 +2523,34 @@ RowFunctionFromDenseMatric(const void* data, int num_row, int num_col, int data_
   throw std::runtime_error("Unknown data type in RowFunctionFromDenseMatric");
 }
 
+std::function<double(int row_idx, int col_idx)>
+ValueFunctionFromDenseMatric(const void* data, int num_row, int num_col, int data_type, int is_row_major) {
+  if (data_type == C_API_DTYPE_FLOAT32) {
+    const float* data_ptr = reinterpret_cast<const float*>(data);
+    if (is_row_major) {
+      return [=] (int row_idx, int col_idx) {
+        return static_cast<double>(*(data_ptr + static_cast<size_t>(num_col) * row_idx + col_idx));
+      };
+    } else {
+      return [=] (int row_idx, int col_idx) {
+        return static_cast<double>(*(data_ptr + static_cast<size_t>(num_row) * col_idx + row_idx));
+      };
+    }
+  } else if (data_type == C_API_DTYPE_FLOAT64) {
+    const double* data_ptr = reinterpret_cast<const double*>(data);
+    if (is_row_major) {
+      return [=] (int row_idx, int col_idx) {
+        return *(data_ptr + static_cast<size_t>(num_col) * row_idx + col_idx);
+      };
+    } else {
+      return [=] (int row_idx, int col_idx) {
+        return *(data_ptr + static_cast<size_t>(num_row) * col_idx + row_idx);
+      };
+    }
+  }
+  throw std::runtime_error("Unknown data type in ValueFunctionFromDenseMatric");
+}
+
 std::function<std::vector<std::pair<int, double>>(int row_idx)>
 RowPairFunctionFromDenseMatric(const void* data, int num_row, int num_col, int data_type, int is_row_major) {
   auto inner_function = RowFunctionFromDenseMatric(data, num_row, num_col, data_type, is_row_major);
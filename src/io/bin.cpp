@@ -14,6 +14,7 @@
 #include <cstring>
 
 #include "dense_bin.hpp"
+#include "dense_bitmap_bin.hpp"
 #include "dense_nbits_bin.hpp"
 #include "ordered_sparse_bin.hpp"
 #include "sparse_bin.hpp"
@@ -632,6 +633,8 @@ namespace LightGBM {
   template class DenseBin<uint16_t>;
   template class DenseBin<uint32_t>;
 
+  template class DenseBitmapBin<1>;
+
   template class SparseBin<uint8_t>;
   template class SparseBin<uint16_t>;
   template class SparseBin<uint32_t>;
@@ -641,19 +644,21 @@ namespace LightGBM {
   template class OrderedSparseBin<uint32_t>;
 
   Bin* Bin::CreateBin(data_size_t num_data, int num_bin, double sparse_rate,
-    bool is_enable_sparse, double sparse_threshold, bool* is_sparse) {
+    bool is_enable_sparse, double sparse_threshold, bool is_enable_bitmap, bool* is_sparse) {
     // sparse threshold
     if (sparse_rate >= sparse_threshold && is_enable_sparse) {
       *is_sparse = true;
       return CreateSparseBin(num_data, num_bin);
     } else {
       *is_sparse = false;
-      return CreateDenseBin(num_data, num_bin);
+      return CreateDenseBin(num_data, num_bin, is_enable_bitmap);
     }
   }
 
-  Bin* Bin::CreateDenseBin(data_size_t num_data, int num_bin) {
-    if (num_bin <= 16) {
+  Bin* Bin::CreateDenseBin(data_size_t num_data, int num_bin, bool is_enable_bitmap) {
+    if (is_enable_bitmap && num_bin <= 2) {
+      return new DenseBitmapBin<1>(num_data, num_bin);
+    } else if (num_bin <= 16) {
       return new Dense4bitsBin(num_data);
     } else if (num_bin <= 256) {
       return new DenseBin<uint8_t>(num_data);
@@ -115,6 +115,8 @@ void GetTaskType(const std::unordered_map<std::string, std::string>& params, Tas
       *task = TaskType::kConvertModel;
     } else if (value == std::string("refit") || value == std::string("refit_tree")) {
       *task = TaskType::KRefitTree;
+    } else if (value == std::string("compact_model")) {
+      *task = TaskType::kCompactModel;
     } else {
       Log::Fatal("Unknown task type %s", value.c_str());
     }
@@ -298,6 +300,35 @@ void Config::CheckParamConflict() {
       histogram_pool_size = -1;
     }
   }
+  if (feature_pruning_rounds > 0 && !is_single_tree_learner) {
+    Log::Warning("Feature pruning is only supported by the serial tree learner, will disable it");
+    feature_pruning_rounds = 0;
+  }
+  if (leaf_batch_size > 1 && (!is_single_tree_learner || device_type != std::string("cpu"))) {
+    Log::Warning("leaf_batch_size is only supported by the serial tree learner on cpu, will grow trees leaf-wise");
+    leaf_batch_size = 1;
+  }
+  if (leaf_id_partition_fraction > 0.0 && (!is_single_tree_learner || device_type != std::string("cpu"))) {
+    Log::Warning("leaf_id_partition_fraction is only supported by the serial tree learner on cpu, will disable it");
+    leaf_id_partition_fraction = 0.0;
+  }
+  if (enable_bitmap_bin && device_type == std::string("gpu")) {
+    Log::Warning("enable_bitmap_bin is not supported by the gpu device, will disable it");
+    enable_bitmap_bin = false;
+  }
+  if (checkpoint_freq > 0) {
+    if (boosting != std::string("gbdt") && boosting != std::string("goss")) {
+      Log::Warning("Checkpoints are only supported by gbdt and goss boosting, will disable them");
+      checkpoint_freq = -1;
+    } else if (bagging_freq > 0 && checkpoint_freq % bagging_freq != 0) {
+      // bags are not saved, so resume only at iterations where they are redrawn
+      checkpoint_freq += bagging_freq - checkpoint_freq % bagging_freq;
+      Log::Warning("checkpoint_freq is rounded up to %d, a multiple of bagging_freq", checkpoint_freq);
+    }
+    if (checkpoint_prefix.empty()) {
+      checkpoint_prefix = output_model + ".checkpoint";
+    }
+  }
   // Check max_depth and num_leaves
   if (max_depth > 0) {
     double full_num_leaves = std::pow(2, max_depth);
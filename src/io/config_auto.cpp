@@ -119,6 +119,7 @@ std::unordered_map<std::string, std::string> Config::alias_table({
   {"is_sparse", "is_enable_sparse"},
   {"enable_sparse", "is_enable_sparse"},
   {"sparse", "is_enable_sparse"},
+  {"bitmap_bin", "enable_bitmap_bin"},
   {"two_round_loading", "two_round"},
   {"use_two_round_loading", "two_round"},
   {"is_save_binary", "save_binary"},
@@ -182,6 +183,8 @@ std::unordered_set<std::string> Config::parameter_set({
   "device_type",
   "seed",
   "max_depth",
+  "leaf_batch_size",
+  "leaf_id_partition_fraction",
   "min_data_in_leaf",
   "min_sum_hessian_in_leaf",
   "bagging_fraction",
@@ -192,6 +195,9 @@ std::unordered_set<std::string> Config::parameter_set({
   "feature_fraction",
   "feature_fraction_bynode",
   "feature_fraction_seed",
+  "feature_pruning_rounds",
+  "feature_pruning_gain_ratio",
+  "feature_pruning_recheck_freq",
   "early_stopping_round",
   "first_metric_only",
   "max_delta_step",
@@ -227,18 +233,23 @@ std::unordered_set<std::string> Config::parameter_set({
   "min_data_in_bin",
   "bin_construct_sample_cnt",
   "histogram_pool_size",
+  "memory_budget",
   "data_random_seed",
   "output_model",
   "snapshot_freq",
+  "checkpoint_freq",
+  "checkpoint_prefix",
   "input_model",
   "output_result",
   "initscore_filename",
   "valid_data_initscores",
+  "init_score_cache",
   "pre_partition",
   "enable_bundle",
   "max_conflict_rate",
   "is_enable_sparse",
   "sparse_threshold",
+  "enable_bitmap_bin",
   "use_missing",
   "zero_as_missing",
   "two_round",
@@ -256,6 +267,8 @@ std::unordered_set<std::string> Config::parameter_set({
   "pred_early_stop",
   "pred_early_stop_freq",
   "pred_early_stop_margin",
+  "pred_tree_parallel_threshold",
+  "pred_cache_size",
   "predict_disable_shape_check",
   "convert_model_language",
   "convert_model",
@@ -310,6 +323,13 @@ void Config::GetMembersFromString(const std::unordered_map<std::string, std::str
 
   GetInt(params, "max_depth", &max_depth);
 
+  GetInt(params, "leaf_batch_size", &leaf_batch_size);
+  CHECK(leaf_batch_size >0);
+
+  GetDouble(params, "leaf_id_partition_fraction", &leaf_id_partition_fraction);
+  CHECK(leaf_id_partition_fraction >=0.0);
+  CHECK(leaf_id_partition_fraction <=1.0);
+
   GetInt(params, "min_data_in_leaf", &min_data_in_leaf);
   CHECK(min_data_in_leaf >=0);
 
@@ -342,6 +362,15 @@ void Config::GetMembersFromString(const std::unordered_map<std::string, std::str
 
   GetInt(params, "feature_fraction_seed", &feature_fraction_seed);
 
+  GetInt(params, "feature_pruning_rounds", &feature_pruning_rounds);
+
+  GetDouble(params, "feature_pruning_gain_ratio", &feature_pruning_gain_ratio);
+  CHECK(feature_pruning_gain_ratio >=0.0);
+  CHECK(feature_pruning_gain_ratio <1.0);
+
+  GetInt(params, "feature_pruning_recheck_freq", &feature_pruning_recheck_freq);
+  CHECK(feature_pruning_recheck_freq >0);
+
   GetInt(params, "early_stopping_round", &early_stopping_round);
 
   GetBool(params, "first_metric_only", &first_metric_only);
@@ -446,12 +475,18 @@ void Config::GetMembersFromString(const std::unordered_map<std::string, std::str
 
   GetDouble(params, "histogram_pool_size", &histogram_pool_size);
 
+  GetDouble(params, "memory_budget", &memory_budget);
+
   GetInt(params, "data_random_seed", &data_random_seed);
 
   GetString(params, "output_model", &output_model);
 
   GetInt(params, "snapshot_freq", &snapshot_freq);
 
+  GetInt(params, "checkpoint_freq", &checkpoint_freq);
+
+  GetString(params, "checkpoint_prefix", &checkpoint_prefix);
+
   GetString(params, "input_model", &input_model);
 
   GetString(params, "output_result", &output_result);
@@ -462,6 +497,8 @@ void Config::GetMembersFromString(const std::unordered_map<std::string, std::str
     valid_data_initscores = Common::Split(tmp_str.c_str(), ',');
   }
 
+  GetBool(params, "init_score_cache", &init_score_cache);
+
   GetBool(params, "pre_partition", &pre_partition);
 
   GetBool(params, "enable_bundle", &enable_bundle);
@@ -476,6 +513,8 @@ void Config::GetMembersFromString(const std::unordered_map<std::string, std::str
   CHECK(sparse_threshold >0.0);
   CHECK(sparse_threshold <=1.0);
 
+  GetBool(params, "enable_bitmap_bin", &enable_bitmap_bin);
+
   GetBool(params, "use_missing", &use_missing);
 
   GetBool(params, "zero_as_missing", &zero_as_missing);
@@ -510,6 +549,11 @@ void Config::GetMembersFromString(const std::unordered_map<std::string, std::str
 
   GetDouble(params, "pred_early_stop_margin", &pred_early_stop_margin);
 
+  GetInt(params, "pred_tree_parallel_threshold", &pred_tree_parallel_threshold);
+
+  GetInt(params, "pred_cache_size", &pred_cache_size);
+  CHECK(pred_cache_size >=0);
+
   GetBool(params, "predict_disable_shape_check", &predict_disable_shape_check);
 
   GetString(params, "convert_model_language", &convert_model_language);
@@ -598,6 +642,8 @@ std::string Config::SaveMembersToString() const {
   str_buf << "[num_leaves: " << num_leaves << "]\n";
   str_buf << "[num_threads: " << num_threads << "]\n";
   str_buf << "[max_depth: " << max_depth << "]\n";
+  str_buf << "[leaf_batch_size: " << leaf_batch_size << "]\n";
+  str_buf << "[leaf_id_partition_fraction: " << leaf_id_partition_fraction << "]\n";
   str_buf << "[min_data_in_leaf: " << min_data_in_leaf << "]\n";
   str_buf << "[min_sum_hessian_in_leaf: " << min_sum_hessian_in_leaf << "]\n";
   str_buf << "[bagging_fraction: " << bagging_fraction << "]\n";
@@ -608,6 +654,9 @@ std::string Config::SaveMembersToString() const {
   str_buf << "[feature_fraction: " << feature_fraction << "]\n";
   str_buf << "[feature_fraction_bynode: " << feature_fraction_bynode << "]\n";
   str_buf << "[feature_fraction_seed: " << feature_fraction_seed << "]\n";
+  str_buf << "[feature_pruning_rounds: " << feature_pruning_rounds << "]\n";
+  str_buf << "[feature_pruning_gain_ratio: " << feature_pruning_gain_ratio << "]\n";
+  str_buf << "[feature_pruning_recheck_freq: " << feature_pruning_recheck_freq << "]\n";
   str_buf << "[early_stopping_round: " << early_stopping_round << "]\n";
   str_buf << "[first_metric_only: " << first_metric_only << "]\n";
   str_buf << "[max_delta_step: " << max_delta_step << "]\n";
@@ -643,18 +692,23 @@ std::string Config::SaveMembersToString() const {
   str_buf << "[min_data_in_bin: " << min_data_in_bin << "]\n";
   str_buf << "[bin_construct_sample_cnt: " << bin_construct_sample_cnt << "]\n";
   str_buf << "[histogram_pool_size: " << histogram_pool_size << "]\n";
+  str_buf << "[memory_budget: " << memory_budget << "]\n";
   str_buf << "[data_random_seed: " << data_random_seed << "]\n";
   str_buf << "[output_model: " << output_model << "]\n";
   str_buf << "[snapshot_freq: " << snapshot_freq << "]\n";
+  str_buf << "[checkpoint_freq: " << checkpoint_freq << "]\n";
+  str_buf << "[checkpoint_prefix: " << checkpoint_prefix << "]\n";
   str_buf << "[input_model: " << input_model << "]\n";
   str_buf << "[output_result: " << output_result << "]\n";
   str_buf << "[initscore_filename: " << initscore_filename << "]\n";
   str_buf << "[valid_data_initscores: " << Common::Join(valid_data_initscores, ",") << "]\n";
+  str_buf << "[init_score_cache: " << init_score_cache << "]\n";
   str_buf << "[pre_partition: " << pre_partition << "]\n";
   str_buf << "[enable_bundle: " << enable_bundle << "]\n";
   str_buf << "[max_conflict_rate: " << max_conflict_rate << "]\n";
   str_buf << "[is_enable_sparse: " << is_enable_sparse << "]\n";
   str_buf << "[sparse_threshold: " << sparse_threshold << "]\n";
+  str_buf << "[enable_bitmap_bin: " << enable_bitmap_bin << "]\n";
   str_buf << "[use_missing: " << use_missing << "]\n";
   str_buf << "[zero_as_missing: " << zero_as_missing << "]\n";
   str_buf << "[two_round: " << two_round << "]\n";
@@ -672,6 +726,8 @@ std::string Config::SaveMembersToString() const {
   str_buf << "[pred_early_stop: " << pred_early_stop << "]\n";
   str_buf << "[pred_early_stop_freq: " << pred_early_stop_freq << "]\n";
   str_buf << "[pred_early_stop_margin: " << pred_early_stop_margin << "]\n";
+  str_buf << "[pred_tree_parallel_threshold: " << pred_tree_parallel_threshold << "]\n";
+  str_buf << "[pred_cache_size: " << pred_cache_size << "]\n";
   str_buf << "[predict_disable_shape_check: " << predict_disable_shape_check << "]\n";
   str_buf << "[convert_model_language: " << convert_model_language << "]\n";
   str_buf << "[convert_model: " << convert_model << "]\n";
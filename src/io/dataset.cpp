@@ -9,9 +9,11 @@
 #include <LightGBM/utils/openmp_wrapper.h>
 #include <LightGBM/utils/threading.h>
 
+#include <algorithm>
 #include <limits>
 #include <chrono>
 #include <cstdio>
+#include <functional>
 #include <sstream>
 #include <unordered_map>
 
@@ -170,6 +172,7 @@ std::vector<std::vector<int>> FastFeatureBundling(const std::vector<std::unique_
                                                   int** sample_indices,
                                                   double** sample_values,
                                                   const int* num_per_col,
+                                                  const int* num_sample_values,
                                                   int num_sample_col,
                                                   size_t total_sample_cnt,
                                                   const std::vector<int>& used_features,
@@ -184,10 +187,10 @@ std::vector<std::vector<int>> FastFeatureBundling(const std::vector<std::unique_
   const data_size_t max_error_cnt = static_cast<data_size_t>(total_sample_cnt * max_conflict_rate);
   std::vector<size_t> feature_non_zero_cnt;
   feature_non_zero_cnt.reserve(used_features.size());
-  // put dense feature first
+  // put dense feature first, counted before the sampled indices were fixed
   for (auto fidx : used_features) {
     if (fidx < num_sample_col) {
-      feature_non_zero_cnt.emplace_back(num_per_col[fidx]);
+      feature_non_zero_cnt.emplace_back(num_sample_values != nullptr ? num_sample_values[fidx] : num_per_col[fidx]);
     } else {
       feature_non_zero_cnt.emplace_back(0);
     }
@@ -215,6 +218,11 @@ std::vector<std::vector<int>> FastFeatureBundling(const std::vector<std::unique_
     if (fidx >= num_sample_col) {
       continue;
     }
+    // already fixed when the sampled values were released
+    if (sample_values == nullptr) {
+      tmp_num_per_col[fidx] = num_per_col[fidx];
+      continue;
+    }
     auto ret = FixSampleIndices(bin_mappers[fidx].get(), static_cast<int>(total_sample_cnt), num_per_col[fidx], sample_indices[fidx], sample_values[fidx]);
     if (!ret.empty()) {
       tmp_indices.push_back(ret);
@@ -262,6 +270,22 @@ std::vector<std::vector<int>> FastFeatureBundling(const std::vector<std::unique_
   return ret;
 }
 
+void Dataset::ReleaseSampleValues(const BinMapper* bin_mapper, int total_sample_cnt, bool keep_indices,
+                                  std::vector<double>* sample_values, std::vector<int>* sample_indices,
+                                  int* num_sample_values) {
+  *num_sample_values = static_cast<int>(sample_values->size());
+  if (keep_indices && bin_mapper != nullptr && !bin_mapper->is_trivial()) {
+    auto fixed_indices = FixSampleIndices(bin_mapper, total_sample_cnt, static_cast<int>(sample_indices->size()),
+                                          sample_indices->data(), sample_values->data());
+    if (!fixed_indices.empty()) {
+      sample_indices->swap(fixed_indices);
+    }
+  } else {
+    std::vector<int>().swap(*sample_indices);
+  }
+  std::vector<double>().swap(*sample_values);
+}
+
 void Dataset::Construct(
   std::vector<std::unique_ptr<BinMapper>>* bin_mappers,
   int num_total_features,
@@ -269,6 +293,7 @@ void Dataset::Construct(
   int** sample_non_zero_indices,
   double** sample_values,
   const int* num_per_col,
+  const int* num_sample_values,
   int num_sample_col,
   size_t total_sample_cnt,
   const Config& io_config) {
@@ -290,7 +315,8 @@ void Dataset::Construct(
 
   if (io_config.enable_bundle && !used_features.empty()) {
     features_in_group = FastFeatureBundling(*bin_mappers,
-                                            sample_non_zero_indices, sample_values, num_per_col, num_sample_col, total_sample_cnt,
+                                            sample_non_zero_indices, sample_values, num_per_col, num_sample_values,
+                                            num_sample_col, total_sample_cnt,
                                             used_features, io_config.max_conflict_rate,
                                             num_data_, io_config.min_data_in_leaf,
                                             sparse_threshold_, io_config.is_enable_sparse, io_config.device_type == std::string("gpu"));
@@ -326,7 +352,7 @@ void Dataset::Construct(
     }
     feature_groups_.emplace_back(std::unique_ptr<FeatureGroup>(
       new FeatureGroup(cur_cnt_features, &cur_bin_mappers, num_data_, sparse_threshold_,
-                       io_config.is_enable_sparse)));
+                       io_config.is_enable_sparse, io_config.enable_bitmap_bin)));
   }
   feature_groups_.shrink_to_fit();
   group_bin_boundaries_.clear();
@@ -479,7 +505,8 @@ void Dataset::CopyFeatureMapperFrom(const Dataset* dataset) {
       dataset->feature_groups_[i]->num_feature_,
       &bin_mappers,
       num_data_,
-      dataset->feature_groups_[i]->is_sparse_));
+      dataset->feature_groups_[i]->is_sparse_,
+      dataset->feature_groups_[i]->is_enable_bitmap_));
   }
   feature_groups_.shrink_to_fit();
   used_feature_map_ = dataset->used_feature_map_;
@@ -519,7 +546,8 @@ void Dataset::CreateValid(const Dataset* dataset) {
       &bin_mappers,
       num_data_,
       sparse_threshold_,
-      is_enable_sparse));
+      is_enable_sparse,
+      false));
     feature2group_.push_back(i);
     feature2subfeature_.push_back(0);
   }
@@ -613,6 +641,10 @@ bool Dataset::SetDoubleField(const char* field_name, const double* field_data, d
   name = Common::Trim(name);
   if (name == std::string("init_score")) {
     metadata_.SetInitScore(field_data, num_element);
+  } else if (name == std::string("label") || name == std::string("target")) {
+    metadata_.SetLabel(field_data, num_element);
+  } else if (name == std::string("weight") || name == std::string("weights")) {
+    metadata_.SetWeights(field_data, num_element);
   } else {
     return false;
   }
@@ -807,6 +839,46 @@ void Dataset::SaveBinaryFile(const char* bin_filename) {
   }
 }
 
+size_t Dataset::SizesInByte() const {
+  size_t ret = metadata_.SizesInByte();
+  for (int i = 0; i < num_groups_; ++i) {
+    ret += feature_groups_[i]->MemorySizesInByte();
+  }
+  return ret;
+}
+
+size_t Dataset::BinHash() const {
+  std::vector<size_t> feature_hashes(num_features_);
+  OMP_INIT_EX();
+  #pragma omp parallel for schedule(dynamic)
+  for (int i = 0; i < num_features_; ++i) {
+    OMP_LOOP_EX_BEGIN();
+    size_t seed = std::hash<int>()(RealFeatureIndex(i));
+    auto combine = [&seed](size_t hash) {
+      seed ^= hash + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+    };
+    const BinMapper* bin_mapper = FeatureBinMapper(i);
+    combine(std::hash<int>()(static_cast<int>(bin_mapper->bin_type())));
+    combine(std::hash<int>()(static_cast<int>(bin_mapper->missing_type())));
+    for (int bin = 0; bin < bin_mapper->num_bin(); ++bin) {
+      combine(std::hash<double>()(bin_mapper->BinToValue(bin)));
+    }
+    std::unique_ptr<BinIterator> iter(FeatureIterator(i));
+    iter->Reset(0);
+    for (data_size_t j = 0; j < num_data_; ++j) {
+      combine(std::hash<uint32_t>()(iter->Get(j)));
+    }
+    feature_hashes[i] = seed;
+    OMP_LOOP_EX_END();
+  }
+  OMP_THROW_EX();
+  size_t seed = std::hash<data_size_t>()(num_data_);
+  for (size_t hash : feature_hashes) {
+    seed ^= hash + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+  }
+  return seed;
+}
+
 void Dataset::DumpTextFile(const char* text_filename) {
   FILE* file = NULL;
 #if _MSC_VER
@@ -866,12 +938,31 @@ void Dataset::DumpTextFile(const char* text_filename) {
   fclose(file);
 }
 
+size_t Dataset::NumRowBlockHistogramEntries() const {
+  // the partial histograms only hold the used groups, so the most entries are needed
+  // when the groups with the most bins are used
+  std::vector<int> group_num_bin(num_groups_);
+  for (int group = 0; group < num_groups_; ++group) {
+    group_num_bin[group] = feature_groups_[group]->num_total_bin_;
+  }
+  std::sort(group_num_bin.begin(), group_num_bin.end(), std::greater<int>());
+  size_t num_used_bin = 0;
+  size_t ret = 0;
+  for (int num_used_group = 1; num_used_group <= num_groups_; ++num_used_group) {
+    num_used_bin += group_num_bin[num_used_group - 1];
+    const int num_blocks = NumHistogramRowBlocks(num_data_, num_used_group);
+    ret = std::max(ret, num_used_bin * (num_blocks - 1));
+  }
+  return ret;
+}
+
 void Dataset::ConstructHistograms(const std::vector<int8_t>& is_feature_used,
                                   const data_size_t* data_indices, data_size_t num_data,
                                   int leaf_idx,
                                   std::vector<std::unique_ptr<OrderedBin>>* ordered_bins,
                                   const score_t* gradients, const score_t* hessians,
                                   score_t* ordered_gradients, score_t* ordered_hessians,
+                                  HistogramBinEntry* row_block_histograms,
                                   bool is_constant_hessian,
                                   HistogramBinEntry* hist_data) const {
   if (leaf_idx < 0 || num_data < 0 || hist_data == nullptr) {
@@ -895,6 +986,7 @@ void Dataset::ConstructHistograms(const std::vector<int8_t>& is_feature_used,
     }
   }
   int num_used_group = static_cast<int>(used_group.size());
+  const int num_blocks = row_block_histograms == nullptr ? 1 : NumHistogramRowBlocks(num_data, num_used_group);
   auto ptr_ordered_grad = gradients;
   auto ptr_ordered_hess = hessians;
   auto& ref_ordered_bins = *ordered_bins;
@@ -913,6 +1005,13 @@ void Dataset::ConstructHistograms(const std::vector<int8_t>& is_feature_used,
     }
     ptr_ordered_grad = ordered_gradients;
     ptr_ordered_hess = ordered_hessians;
+    if (num_blocks > 1) {
+      ConstructHistogramsByRowBlocks(used_group, num_blocks, data_indices, num_data, nullptr, 0, leaf_idx,
+                                     ref_ordered_bins, gradients, hessians,
+                                     ptr_ordered_grad, ptr_ordered_hess, row_block_histograms,
+                                     is_constant_hessian, hist_data);
+      return;
+    }
     if (!is_constant_hessian) {
       OMP_INIT_EX();
       #pragma omp parallel for schedule(static)
@@ -977,6 +1076,13 @@ void Dataset::ConstructHistograms(const std::vector<int8_t>& is_feature_used,
       OMP_THROW_EX();
     }
   } else {
+    if (num_blocks > 1) {
+      ConstructHistogramsByRowBlocks(used_group, num_blocks, nullptr, num_data, nullptr, 0, leaf_idx,
+                                     ref_ordered_bins, gradients, hessians,
+                                     ptr_ordered_grad, ptr_ordered_hess, row_block_histograms,
+                                     is_constant_hessian, hist_data);
+      return;
+    }
     if (!is_constant_hessian) {
       OMP_INIT_EX();
       #pragma omp parallel for schedule(static)
@@ -1041,6 +1147,245 @@ void Dataset::ConstructHistograms(const std::vector<int8_t>& is_feature_used,
   }
 }
 
+void Dataset::ConstructHistogramsOfLeafId(const std::vector<int8_t>& is_feature_used,
+                                          const uint8_t* leaf_ids, uint8_t leaf_id, data_size_t num_data_in_leaf,
+                                          const std::vector<std::unique_ptr<OrderedBin>>& ordered_bins,
+                                          const score_t* gradients, const score_t* hessians,
+                                          HistogramBinEntry* row_block_histograms,
+                                          bool is_constant_hessian,
+                                          HistogramBinEntry* hist_data) const {
+  std::vector<int> used_group;
+  used_group.reserve(num_groups_);
+  for (int group = 0; group < num_groups_; ++group) {
+    const int f_cnt = group_feature_cnt_[group];
+    for (int j = 0; j < f_cnt; ++j) {
+      if (is_feature_used[group_feature_start_[group] + j]) {
+        used_group.push_back(group);
+        break;
+      }
+    }
+  }
+  if (used_group.empty()) { return; }
+  // blocks hold the same rows of the leaf as with its index list, so the sums are added in the same order
+  const int num_blocks = row_block_histograms == nullptr ? 1
+                       : NumHistogramRowBlocks(num_data_in_leaf, static_cast<int>(used_group.size()));
+  // the masked scan reads the gradients in place
+  ConstructHistogramsByRowBlocks(used_group, num_blocks, nullptr, num_data_in_leaf, leaf_ids, leaf_id, 0,
+                                 ordered_bins, gradients, hessians, gradients, hessians, row_block_histograms,
+                                 is_constant_hessian, hist_data);
+}
+
+void Dataset::ConstructHistogramsOfLeaves(const std::vector<LeafHistogramTask>& tasks,
+                                          std::vector<std::unique_ptr<OrderedBin>>* ordered_bins,
+                                          const score_t* gradients, const score_t* hessians,
+                                          bool is_constant_hessian) const {
+  std::vector<std::pair<int, int>> leaf_group;
+  for (int ti = 0; ti < static_cast<int>(tasks.size()); ++ti) {
+    const auto& task = tasks[ti];
+    if (task.leaf_idx < 0 || task.num_data < 0 || task.histogram_data == nullptr) { continue; }
+    for (int group = 0; group < num_groups_; ++group) {
+      const int f_cnt = group_feature_cnt_[group];
+      for (int j = 0; j < f_cnt; ++j) {
+        if ((*task.is_feature_used)[group_feature_start_[group] + j]) {
+          leaf_group.emplace_back(ti, group);
+          break;
+        }
+      }
+    }
+  }
+  if (leaf_group.empty()) { return; }
+  // gather the gradients of all leaves in one parallel region
+  #pragma omp parallel
+  for (const auto& task : tasks) {
+    if (task.leaf_ids != nullptr || task.data_indices == nullptr || task.num_data >= num_data_
+        || task.histogram_data == nullptr) {
+      continue;
+    }
+    if (!is_constant_hessian) {
+      #pragma omp for schedule(static) nowait
+      for (data_size_t i = 0; i < task.num_data; ++i) {
+        task.ordered_gradients[i] = gradients[task.data_indices[i]];
+        task.ordered_hessians[i] = hessians[task.data_indices[i]];
+      }
+    } else {
+      #pragma omp for schedule(static) nowait
+      for (data_size_t i = 0; i < task.num_data; ++i) {
+        task.ordered_gradients[i] = gradients[task.data_indices[i]];
+      }
+    }
+  }
+  auto& ref_ordered_bins = *ordered_bins;
+  OMP_INIT_EX();
+  // leaves have very different sizes, so the pairs are scheduled dynamically
+  #pragma omp parallel for schedule(dynamic)
+  for (int i = 0; i < static_cast<int>(leaf_group.size()); ++i) {
+    OMP_LOOP_EX_BEGIN();
+    const auto& task = tasks[leaf_group[i].first];
+    const int group = leaf_group[i].second;
+    const bool is_gathered = task.leaf_ids == nullptr && task.data_indices != nullptr && task.num_data < num_data_;
+    const score_t* ptr_ordered_grad = is_gathered ? task.ordered_gradients : gradients;
+    const score_t* ptr_ordered_hess = is_gathered ? task.ordered_hessians : hessians;
+    auto data_ptr = task.histogram_data + group_bin_boundaries_[group];
+    const int num_bin = feature_groups_[group]->num_total_bin_;
+    std::memset(reinterpret_cast<void*>(data_ptr + 1), 0, (num_bin - 1) * sizeof(HistogramBinEntry));
+    const Bin* bin_data = feature_groups_[group]->bin_data_.get();
+    if (ref_ordered_bins[group] != nullptr) {
+      if (is_constant_hessian) {
+        ref_ordered_bins[group]->ConstructHistogram(task.leaf_idx, gradients, data_ptr);
+      } else {
+        ref_ordered_bins[group]->ConstructHistogram(task.leaf_idx, gradients, hessians, data_ptr);
+      }
+    } else if (task.leaf_ids != nullptr) {
+      if (is_constant_hessian) {
+        bin_data->ConstructHistogramOfLeafId(task.leaf_ids, task.leaf_id, 0, num_data_, gradients, data_ptr);
+      } else {
+        bin_data->ConstructHistogramOfLeafId(task.leaf_ids, task.leaf_id, 0, num_data_, gradients, hessians, data_ptr);
+      }
+    } else if (is_gathered) {
+      if (is_constant_hessian) {
+        bin_data->ConstructHistogram(task.data_indices, 0, task.num_data, ptr_ordered_grad, data_ptr);
+      } else {
+        bin_data->ConstructHistogram(task.data_indices, 0, task.num_data, ptr_ordered_grad, ptr_ordered_hess, data_ptr);
+      }
+    } else {
+      if (is_constant_hessian) {
+        bin_data->ConstructHistogram(0, task.num_data, ptr_ordered_grad, data_ptr);
+      } else {
+        bin_data->ConstructHistogram(0, task.num_data, ptr_ordered_grad, ptr_ordered_hess, data_ptr);
+      }
+    }
+    if (is_constant_hessian) {
+      // fixed hessian.
+      for (int j = 0; j < num_bin; ++j) {
+        data_ptr[j].sum_hessians = data_ptr[j].cnt * hessians[0];
+      }
+    }
+    OMP_LOOP_EX_END();
+  }
+  OMP_THROW_EX();
+}
+
+int Dataset::NumHistogramRowBlocks(data_size_t num_data, int num_used_group) {
+  // gradients and hessians of a block should stay in L2 cache, and the number of partial histograms is bounded.
+  // Leaves with enough feature groups to share among the threads are not tiled, this budget of tiles
+  // stands in for the number of threads, so the sums are added in the same order with any number of threads
+  const data_size_t kRowsPerBlock = 1 << 14;
+  const int kMaxBlocks = 16;
+  const int kMaxTiles = 32;
+  const int max_blocks = std::min(kMaxBlocks, kMaxTiles / std::max(1, num_used_group));
+  return std::max(1, static_cast<int>(std::min<data_size_t>(max_blocks, num_data / kRowsPerBlock)));
+}
+
+void Dataset::ConstructHistogramsByRowBlocks(const std::vector<int>& used_group, int num_blocks,
+                                             const data_size_t* data_indices, data_size_t num_data,
+                                             const uint8_t* leaf_ids, uint8_t leaf_id,
+                                             int leaf_idx,
+                                             const std::vector<std::unique_ptr<OrderedBin>>& ordered_bins,
+                                             const score_t* gradients, const score_t* hessians,
+                                             const score_t* ordered_gradients, const score_t* ordered_hessians,
+                                             HistogramBinEntry* row_block_histograms,
+                                             bool is_constant_hessian,
+                                             HistogramBinEntry* hist_data) const {
+  const int num_used_group = static_cast<int>(used_group.size());
+  // the partial histograms of a block only hold the used groups
+  std::vector<size_t> used_group_offset(num_used_group);
+  size_t num_used_bin = 0;
+  for (int gi = 0; gi < num_used_group; ++gi) {
+    used_group_offset[gi] = num_used_bin;
+    num_used_bin += feature_groups_[used_group[gi]]->num_total_bin_;
+  }
+  const data_size_t block_size = (num_data + num_blocks - 1) / num_blocks;
+  // block b starts at the (b * block_size)-th row of the leaf, masked scans look up its position in the whole data
+  std::vector<data_size_t> block_start(num_blocks + 1);
+  if (leaf_ids == nullptr) {
+    for (int block = 0; block <= num_blocks; ++block) {
+      block_start[block] = std::min(num_data, block * block_size);
+    }
+  } else {
+    std::fill(block_start.begin() + 1, block_start.end(), num_data_);
+    data_size_t cnt = 0;
+    for (data_size_t i = 0, block = 1; i < num_data_ && block < num_blocks; ++i) {
+      if (leaf_ids[i] != leaf_id) { continue; }
+      if (cnt == block * block_size) {
+        block_start[block++] = i;
+      }
+      ++cnt;
+    }
+  }
+  const int num_tiles = num_blocks * num_used_group;
+  OMP_INIT_EX();
+  #pragma omp parallel for schedule(static, 1)
+  for (int tile = 0; tile < num_tiles; ++tile) {
+    OMP_LOOP_EX_BEGIN();
+    const int block = tile / num_used_group;
+    const int gi = tile % num_used_group;
+    const int group = used_group[gi];
+    // ordered bins can only construct a whole leaf, leave them to the first block
+    if (ordered_bins[group] != nullptr && block > 0) {
+      continue;
+    }
+    auto data_ptr = block == 0 ? hist_data + group_bin_boundaries_[group]
+                               : row_block_histograms + num_used_bin * (block - 1) + used_group_offset[gi];
+    const int num_bin = feature_groups_[group]->num_total_bin_;
+    std::memset(reinterpret_cast<void*>(data_ptr + 1), 0, (num_bin - 1) * sizeof(HistogramBinEntry));
+    if (ordered_bins[group] != nullptr) {
+      if (is_constant_hessian) {
+        ordered_bins[group]->ConstructHistogram(leaf_idx, gradients, data_ptr);
+      } else {
+        ordered_bins[group]->ConstructHistogram(leaf_idx, gradients, hessians, data_ptr);
+      }
+    } else {
+      const data_size_t start = block_start[block];
+      const data_size_t end = block_start[block + 1];
+      const Bin* bin_data = feature_groups_[group]->bin_data_.get();
+      if (leaf_ids != nullptr) {
+        if (is_constant_hessian) {
+          bin_data->ConstructHistogramOfLeafId(leaf_ids, leaf_id, start, end, ordered_gradients, data_ptr);
+        } else {
+          bin_data->ConstructHistogramOfLeafId(leaf_ids, leaf_id, start, end, ordered_gradients, ordered_hessians, data_ptr);
+        }
+      } else if (data_indices != nullptr) {
+        if (is_constant_hessian) {
+          bin_data->ConstructHistogram(data_indices, start, end, ordered_gradients, data_ptr);
+        } else {
+          bin_data->ConstructHistogram(data_indices, start, end, ordered_gradients, ordered_hessians, data_ptr);
+        }
+      } else {
+        if (is_constant_hessian) {
+          bin_data->ConstructHistogram(start, end, ordered_gradients, data_ptr);
+        } else {
+          bin_data->ConstructHistogram(start, end, ordered_gradients, ordered_hessians, data_ptr);
+        }
+      }
+    }
+    OMP_LOOP_EX_END();
+  }
+  OMP_THROW_EX();
+  // reduce partial histograms of the other blocks
+  #pragma omp parallel for schedule(static)
+  for (int gi = 0; gi < num_used_group; ++gi) {
+    const int group = used_group[gi];
+    auto data_ptr = hist_data + group_bin_boundaries_[group];
+    const int num_bin = feature_groups_[group]->num_total_bin_;
+    if (ordered_bins[group] == nullptr) {
+      for (int block = 1; block < num_blocks; ++block) {
+        auto buf_ptr = row_block_histograms + num_used_bin * (block - 1) + used_group_offset[gi];
+        for (int i = 1; i < num_bin; ++i) {
+          data_ptr[i].sum_gradients += buf_ptr[i].sum_gradients;
+          data_ptr[i].sum_hessians += buf_ptr[i].sum_hessians;
+          data_ptr[i].cnt += buf_ptr[i].cnt;
+        }
+      }
+    }
+    if (is_constant_hessian) {
+      // fixed hessian.
+      for (int i = 0; i < num_bin; ++i) {
+        data_ptr[i].sum_hessians = data_ptr[i].cnt * hessians[0];
+      }
+    }
+  }
+}
+
 void Dataset::FixHistogram(int feature_idx, double sum_gradient, double sum_hessian, data_size_t num_data,
                            HistogramBinEntry* data) const {
   const int group = feature2group_[feature_idx];
@@ -191,13 +191,20 @@ Dataset* DatasetLoader::LoadFromFile(const char* filename, const char* initscore
       dataset->num_data_ = static_cast<data_size_t>(text_data.size());
       // sample data
       auto sample_data = SampleTextDataFromMemory(text_data);
+      data_size_t num_sampled_from = dataset->num_data_;
+      if (IsShardedTextLoad(dataset->metadata_, num_machines)) {
+        sample_data = GatherShardedSample(sample_data, dataset->num_data_, num_global_data);
+        num_sampled_from = num_global_data;
+      }
       // construct feature bin mappers
-      ConstructBinMappersFromTextData(rank, num_machines, sample_data, parser.get(), dataset.get());
+      ConstructBinMappersFromTextData(rank, num_machines, sample_data, num_sampled_from, parser.get(), dataset.get());
+      CheckPredictOnBins(dataset.get());
       // initialize label
       dataset->metadata_.Init(dataset->num_data_, weight_idx_, group_idx_);
       // extract features
       ExtractFeaturesFromMemory(&text_data, parser.get(), dataset.get());
       text_data.clear();
+      PredictOnBins(dataset.get());
     } else {
       // sample data from file
       auto sample_data = SampleTextDataFromFile(filename, dataset->metadata_, rank, num_machines, &num_global_data, &used_data_indices);
@@ -206,13 +213,17 @@ Dataset* DatasetLoader::LoadFromFile(const char* filename, const char* initscore
       } else {
         dataset->num_data_ = num_global_data;
       }
+      // sharded sample is already merged over all machines
+      const data_size_t num_sampled_from = IsShardedTextLoad(dataset->metadata_, num_machines) ? num_global_data : dataset->num_data_;
       // construct feature bin mappers
-      ConstructBinMappersFromTextData(rank, num_machines, sample_data, parser.get(), dataset.get());
+      ConstructBinMappersFromTextData(rank, num_machines, sample_data, num_sampled_from, parser.get(), dataset.get());
+      CheckPredictOnBins(dataset.get());
       // initialize label
       dataset->metadata_.Init(dataset->num_data_, weight_idx_, group_idx_);
       Log::Debug("Making second pass...");
       // extract features
-      ExtractFeaturesFromFile(filename, parser.get(), used_data_indices, dataset.get());
+      ExtractFeaturesFromFile(filename, parser.get(), used_data_indices, rank, num_machines, dataset.get());
+      PredictOnBins(dataset.get());
     }
   } else {
     // load data from binary file
@@ -247,9 +258,11 @@ Dataset* DatasetLoader::LoadFromFileAlignWithOtherDataset(const char* filename,
       // initialize label
       dataset->metadata_.Init(dataset->num_data_, weight_idx_, group_idx_);
       dataset->CreateValid(train_data);
+      CheckPredictOnBins(dataset.get());
       // extract features
       ExtractFeaturesFromMemory(&text_data, parser.get(), dataset.get());
       text_data.clear();
+      PredictOnBins(dataset.get());
     } else {
       TextReader<data_size_t> text_reader(filename, config_.header);
       // Get number of lines of data file
@@ -258,8 +271,10 @@ Dataset* DatasetLoader::LoadFromFileAlignWithOtherDataset(const char* filename,
       // initialize label
       dataset->metadata_.Init(dataset->num_data_, weight_idx_, group_idx_);
       dataset->CreateValid(train_data);
+      CheckPredictOnBins(dataset.get());
       // extract features
-      ExtractFeaturesFromFile(filename, parser.get(), used_data_indices, dataset.get());
+      ExtractFeaturesFromFile(filename, parser.get(), used_data_indices, 0, 1, dataset.get());
+      PredictOnBins(dataset.get());
     }
   } else {
     // load data from binary file
@@ -563,7 +578,8 @@ Dataset* DatasetLoader::LoadFromBinFile(const char* data_filename, const char* b
     dataset->feature_groups_.emplace_back(std::unique_ptr<FeatureGroup>(
       new FeatureGroup(buffer.data(),
                        *num_global_data,
-                       *used_data_indices)));
+                       *used_data_indices,
+                       config_.enable_bitmap_bin)));
   }
   dataset->feature_groups_.shrink_to_fit();
   dataset->is_finish_load_ = true;
@@ -574,6 +590,51 @@ Dataset* DatasetLoader::LoadFromBinFile(const char* data_filename, const char* b
 Dataset* DatasetLoader::CostructFromSampleData(double** sample_values,
                                                int** sample_indices, int num_col, const int* num_per_col,
                                                size_t total_sample_size, data_size_t num_data) {
+  return CostructFromSampleData(sample_values, sample_indices, num_col, num_per_col, total_sample_size, num_data,
+                                nullptr, nullptr, nullptr);
+}
+
+Dataset* DatasetLoader::CostructFromSampleData(std::vector<std::vector<double>>* sample_values,
+                                               std::vector<std::vector<int>>* sample_indices,
+                                               size_t total_sample_size, data_size_t num_data) {
+  CHECK(sample_values->size() == sample_indices->size());
+  return CostructFromSampleData(nullptr, nullptr, static_cast<int>(sample_values->size()), nullptr,
+                                total_sample_size, num_data, sample_values, sample_indices, nullptr);
+}
+
+Dataset* DatasetLoader::CostructFromSampleColumns(int num_col, const SampleColumnFunction& get_sample_column,
+                                                  size_t total_sample_size, data_size_t num_data) {
+  std::vector<std::vector<double>> sample_values(num_col);
+  std::vector<std::vector<int>> sample_indices(num_col);
+  return CostructFromSampleData(nullptr, nullptr, num_col, nullptr, total_sample_size, num_data,
+                                &sample_values, &sample_indices, get_sample_column);
+}
+
+Dataset* DatasetLoader::CostructFromSampleData(double** sample_values,
+                                               int** sample_indices, int num_col, const int* num_per_col,
+                                               size_t total_sample_size, data_size_t num_data,
+                                               std::vector<std::vector<double>>* owned_values,
+                                               std::vector<std::vector<int>>* owned_indices,
+                                               const SampleColumnFunction& get_sample_column) {
+  auto column_values = [&] (int i) {
+    return owned_values != nullptr ? (*owned_values)[i].data() : sample_values[i];
+  };
+  auto column_size = [&] (int i) {
+    return owned_values != nullptr ? static_cast<int>((*owned_values)[i].size()) : num_per_col[i];
+  };
+  auto load_sample = [&] (int i) {
+    if (get_sample_column) {
+      get_sample_column(i, &(*owned_values)[i], &(*owned_indices)[i]);
+    }
+  };
+  // release the sampled values of a column once its bin mapper is found
+  std::vector<int> num_sample_values(owned_values != nullptr ? num_col : 0, 0);
+  auto release_sample = [&] (int i, const BinMapper* bin_mapper) {
+    if (owned_values != nullptr) {
+      Dataset::ReleaseSampleValues(bin_mapper, static_cast<int>(total_sample_size), config_.enable_bundle,
+                                   &(*owned_values)[i], &(*owned_indices)[i], &num_sample_values[i]);
+    }
+  };
   int num_total_features = num_col;
   if (Network::num_machines() > 1) {
     num_total_features = Network::GlobalSyncUpByMax(num_total_features);
@@ -606,6 +667,7 @@ Dataset* DatasetLoader::CostructFromSampleData(double** sample_values,
       OMP_LOOP_EX_BEGIN();
       if (ignore_features_.count(i) > 0) {
         bin_mappers[i] = nullptr;
+        release_sample(i, nullptr);
         continue;
       }
       BinType bin_type = BinType::NumericalBin;
@@ -617,17 +679,19 @@ Dataset* DatasetLoader::CostructFromSampleData(double** sample_values,
         }
       }
       bin_mappers[i].reset(new BinMapper());
+      load_sample(i);
       if (config_.max_bin_by_feature.empty()) {
-        bin_mappers[i]->FindBin(sample_values[i], num_per_col[i], total_sample_size,
+        bin_mappers[i]->FindBin(column_values(i), column_size(i), total_sample_size,
                                 config_.max_bin, config_.min_data_in_bin, filter_cnt,
                                 bin_type, config_.use_missing, config_.zero_as_missing,
                                 forced_bin_bounds[i]);
       } else {
-        bin_mappers[i]->FindBin(sample_values[i], num_per_col[i], total_sample_size,
+        bin_mappers[i]->FindBin(column_values(i), column_size(i), total_sample_size,
                                 config_.max_bin_by_feature[i], config_.min_data_in_bin,
                                 filter_cnt, bin_type, config_.use_missing,
                                 config_.zero_as_missing, forced_bin_bounds[i]);
       }
+      release_sample(i, bin_mappers[i].get());
       OMP_LOOP_EX_END();
     }
     OMP_THROW_EX();
@@ -640,6 +704,10 @@ Dataset* DatasetLoader::CostructFromSampleData(double** sample_values,
     // machine i will find bins for features in [ start[i], start[i] + len[i] )
     std::vector<int> start(num_machines);
     std::vector<int> len(num_machines);
+    // all machines need the sampled indices of all columns for feature bundling
+    for (int i = 0; i < num_col; ++i) {
+      load_sample(i);
+    }
     int step = (num_total_features + num_machines - 1) / num_machines;
     if (step < 1) { step = 1; }
 
@@ -665,12 +733,12 @@ Dataset* DatasetLoader::CostructFromSampleData(double** sample_values,
         continue;
       }
       if (config_.max_bin_by_feature.empty()) {
-        bin_mappers[i]->FindBin(sample_values[start[rank] + i], num_per_col[start[rank] + i],
+        bin_mappers[i]->FindBin(column_values(start[rank] + i), column_size(start[rank] + i),
                                 total_sample_size, config_.max_bin, config_.min_data_in_bin,
                                 filter_cnt, bin_type, config_.use_missing, config_.zero_as_missing,
                                 forced_bin_bounds[i]);
       } else {
-        bin_mappers[i]->FindBin(sample_values[start[rank] + i], num_per_col[start[rank] + i],
+        bin_mappers[i]->FindBin(column_values(start[rank] + i), column_size(start[rank] + i),
                                 total_sample_size, config_.max_bin_by_feature[start[rank] + i],
                                 config_.min_data_in_bin, filter_cnt, bin_type, config_.use_missing,
                                 config_.zero_as_missing, forced_bin_bounds[i]);
@@ -715,9 +783,19 @@ Dataset* DatasetLoader::CostructFromSampleData(double** sample_values,
       bin_mappers[i]->CopyFrom(cp_ptr);
       cp_ptr += bin_mappers[i]->SizesInByte();
     }
+    for (int i = 0; i < num_col; ++i) {
+      release_sample(i, bin_mappers[i].get());
+    }
   }
   auto dataset = std::unique_ptr<Dataset>(new Dataset(num_data));
-  dataset->Construct(&bin_mappers, num_total_features, forced_bin_bounds, sample_indices, sample_values, num_per_col, num_col, total_sample_size, config_);
+  if (owned_values != nullptr) {
+    dataset->Construct(&bin_mappers, num_total_features, forced_bin_bounds, Common::Vector2Ptr<int>(owned_indices).data(),
+                       nullptr, Common::VectorSize<int>(*owned_indices).data(), num_sample_values.data(), num_col,
+                       total_sample_size, config_);
+  } else {
+    dataset->Construct(&bin_mappers, num_total_features, forced_bin_bounds, sample_indices, sample_values, num_per_col,
+                       nullptr, num_col, total_sample_size, config_);
+  }
   dataset->set_feature_names(feature_names_);
   return dataset.release();
 }
@@ -769,14 +847,11 @@ std::vector<std::string> DatasetLoader::LoadTextDataToMemory(const char* filenam
     const data_size_t* query_boundaries = metadata.query_boundaries();
 
     if (query_boundaries == nullptr) {
-      // if not contain query data, minimal sample unit is one record
-      *num_global_data = text_reader.ReadAndFilterLines([this, rank, num_machines](data_size_t) {
-        if (random_.NextShort(0, num_machines) == rank) {
-          return true;
-        } else {
-          return false;
-        }
-      }, used_data_indices);
+      // if not contain query data, each machine only reads the lines in its own byte range
+      size_t range_begin = 0, range_end = 0;
+      GetShardByteRange(text_reader.DataSize(), rank, num_machines, &range_begin, &range_end);
+      const data_size_t num_local_data = text_reader.ReadByteRangeLines(range_begin, range_end);
+      *num_global_data = SyncUpShardedData(num_local_data, rank, num_machines, used_data_indices);
     } else {
       // if contain query data, minimal sample unit is one query
       data_size_t num_queries = metadata.num_queries();
@@ -830,15 +905,12 @@ std::vector<std::string> DatasetLoader::SampleTextDataFromFile(const char* filen
             // get query data
     const data_size_t* query_boundaries = metadata.query_boundaries();
     if (query_boundaries == nullptr) {
-      // if not contain query file, minimal sample unit is one record
-      *num_global_data = text_reader.SampleAndFilterFromFile([this, rank, num_machines]
-      (data_size_t) {
-        if (random_.NextShort(0, num_machines) == rank) {
-          return true;
-        } else {
-          return false;
-        }
-      }, used_data_indices, &random_, sample_cnt, &out_data);
+      // if not contain query file, each machine only reads the lines in its own byte range
+      size_t range_begin = 0, range_end = 0;
+      GetShardByteRange(text_reader.DataSize(), rank, num_machines, &range_begin, &range_end);
+      const data_size_t num_local_data = text_reader.SampleFromByteRange(range_begin, range_end, &random_, sample_cnt, &out_data);
+      *num_global_data = SyncUpShardedData(num_local_data, rank, num_machines, used_data_indices);
+      out_data = GatherShardedSample(out_data, num_local_data, *num_global_data);
     } else {
       // if contain query file, minimal sample unit is one query
       data_size_t num_queries = metadata.num_queries();
@@ -866,8 +938,73 @@ std::vector<std::string> DatasetLoader::SampleTextDataFromFile(const char* filen
   return out_data;
 }
 
+void DatasetLoader::GetShardByteRange(size_t data_size, int rank, int num_machines,
+                                      size_t* range_begin, size_t* range_end) {
+  *range_begin = data_size / num_machines * rank;
+  *range_end = rank + 1 < num_machines ? data_size / num_machines * (rank + 1) : data_size;
+}
+
+bool DatasetLoader::IsShardedTextLoad(const Metadata& metadata, int num_machines) const {
+  return num_machines > 1 && !config_.pre_partition && metadata.query_boundaries() == nullptr;
+}
+
+data_size_t DatasetLoader::SyncUpShardedData(data_size_t num_local_data, int rank, int num_machines,
+                                             std::vector<data_size_t>* used_data_indices) {
+  auto num_data_by_rank = Network::GlobalArray(num_local_data);
+  data_size_t offset = 0;
+  int64_t num_global_data = 0;
+  for (int i = 0; i < num_machines; ++i) {
+    if (i < rank) {
+      offset += num_data_by_rank[i];
+    }
+    num_global_data += num_data_by_rank[i];
+  }
+  if (num_global_data > std::numeric_limits<data_size_t>::max()) {
+    Log::Fatal("Number of data is too large: %lld", static_cast<long long>(num_global_data));
+  }
+  used_data_indices->resize(num_local_data);
+  for (data_size_t i = 0; i < num_local_data; ++i) {
+    (*used_data_indices)[i] = offset + i;
+  }
+  Log::Info("Local data of machine %d is [%d, %d) of %d data", rank, offset, offset + num_local_data,
+            static_cast<data_size_t>(num_global_data));
+  return static_cast<data_size_t>(num_global_data);
+}
+
+std::vector<std::string> DatasetLoader::GatherShardedSample(const std::vector<std::string>& local_sample,
+                                                            data_size_t num_local_data, data_size_t num_global_data) {
+  // the merged sample is uniform over the whole file, since the file is cut into contiguous ranges
+  const double ratio = num_global_data > 0 ? static_cast<double>(num_local_data) / num_global_data : 0.0;
+  const int local_sample_cnt = std::min(static_cast<int>(local_sample.size()),
+                                        static_cast<int>(config_.bin_construct_sample_cnt * ratio + 0.5));
+  auto sample_indices = random_.Sample(static_cast<int>(local_sample.size()), local_sample_cnt);
+  std::vector<char> local_buf;
+  for (auto idx : sample_indices) {
+    local_buf.insert(local_buf.end(), local_sample[idx].begin(), local_sample[idx].end());
+    local_buf.push_back('\n');
+  }
+  auto block_len = Network::GlobalArray(static_cast<comm_size_t>(local_buf.size()));
+  std::vector<comm_size_t> block_start(block_len.size(), 0);
+  for (size_t i = 1; i < block_len.size(); ++i) {
+    block_start[i] = block_start[i - 1] + block_len[i - 1];
+  }
+  const comm_size_t all_size = block_start.back() + block_len.back();
+  std::vector<char> global_buf(all_size);
+  Network::Allgather(local_buf.data(), block_start.data(), block_len.data(), global_buf.data(), all_size);
+  std::vector<std::string> out;
+  comm_size_t line_start = 0;
+  for (comm_size_t i = 0; i < all_size; ++i) {
+    if (global_buf[i] == '\n') {
+      out.emplace_back(global_buf.data() + line_start, i - line_start);
+      line_start = i + 1;
+    }
+  }
+  return out;
+}
+
 void DatasetLoader::ConstructBinMappersFromTextData(int rank, int num_machines,
                                                     const std::vector<std::string>& sample_data,
+                                                    data_size_t num_sampled_from,
                                                     const Parser* parser, Dataset* dataset) {
   std::vector<std::vector<double>> sample_values;
   std::vector<std::vector<int>> sample_indices;
@@ -925,7 +1062,8 @@ void DatasetLoader::ConstructBinMappersFromTextData(int rank, int num_machines,
   dataset->set_feature_names(feature_names_);
   std::vector<std::unique_ptr<BinMapper>> bin_mappers(dataset->num_total_features_);
   const data_size_t filter_cnt = static_cast<data_size_t>(
-    static_cast<double>(config_.min_data_in_leaf* sample_data.size()) / dataset->num_data_);
+    static_cast<double>(config_.min_data_in_leaf* sample_data.size()) / num_sampled_from);
+  std::vector<int> num_sample_values(sample_values.size(), 0);
   // start find bins
   if (num_machines == 1) {
     // if only one machine, find bin locally
@@ -935,6 +1073,8 @@ void DatasetLoader::ConstructBinMappersFromTextData(int rank, int num_machines,
       OMP_LOOP_EX_BEGIN();
       if (ignore_features_.count(i) > 0) {
         bin_mappers[i] = nullptr;
+        Dataset::ReleaseSampleValues(nullptr, static_cast<int>(sample_data.size()), config_.enable_bundle,
+                                     &sample_values[i], &sample_indices[i], &num_sample_values[i]);
         continue;
       }
       BinType bin_type = BinType::NumericalBin;
@@ -953,6 +1093,8 @@ void DatasetLoader::ConstructBinMappersFromTextData(int rank, int num_machines,
                                 config_.min_data_in_bin, filter_cnt, bin_type, config_.use_missing,
                                 config_.zero_as_missing, forced_bin_bounds[i]);
       }
+      Dataset::ReleaseSampleValues(bin_mappers[i].get(), static_cast<int>(sample_data.size()), config_.enable_bundle,
+                                   &sample_values[i], &sample_indices[i], &num_sample_values[i]);
       OMP_LOOP_EX_END();
     }
     OMP_THROW_EX();
@@ -1039,10 +1181,15 @@ void DatasetLoader::ConstructBinMappersFromTextData(int rank, int num_machines,
       bin_mappers[i]->CopyFrom(cp_ptr);
       cp_ptr += bin_mappers[i]->SizesInByte();
     }
+    for (int i = 0; i < static_cast<int>(sample_values.size()); ++i) {
+      Dataset::ReleaseSampleValues(bin_mappers[i].get(), static_cast<int>(sample_data.size()), config_.enable_bundle,
+                                   &sample_values[i], &sample_indices[i], &num_sample_values[i]);
+    }
   }
+  // the sampled values are released, the sampled indices are the ones used by feature bundling
   dataset->Construct(&bin_mappers, dataset->num_total_features_, forced_bin_bounds, Common::Vector2Ptr<int>(&sample_indices).data(),
-                     Common::Vector2Ptr<double>(&sample_values).data(),
-                     Common::VectorSize<int>(sample_indices).data(), static_cast<int>(sample_indices.size()), sample_data.size(), config_);
+                     nullptr, Common::VectorSize<int>(sample_indices).data(), num_sample_values.data(),
+                     static_cast<int>(sample_indices.size()), sample_data.size(), config_);
 }
 
 /*! \brief Extract local features from memory */
@@ -1050,7 +1197,7 @@ void DatasetLoader::ExtractFeaturesFromMemory(std::vector<std::string>* text_dat
   std::vector<std::pair<int, double>> oneline_features;
   double tmp_label = 0.0f;
   auto& ref_text_data = *text_data;
-  if (predict_fun_ == nullptr) {
+  if (!PredictWhileParsing()) {
     OMP_INIT_EX();
     // if doesn't need to prediction with initial model
     #pragma omp parallel for schedule(static) private(oneline_features) firstprivate(tmp_label)
@@ -1109,7 +1256,7 @@ void DatasetLoader::ExtractFeaturesFromMemory(std::vector<std::string>* text_dat
       // set label
       dataset->metadata_.SetLabelAt(i, static_cast<label_t>(tmp_label));
       // free processed line:
-      text_data[i].clear();
+      ref_text_data[i].clear();
       // shrink_to_fit will be very slow in linux, and seems not free memory, disable for now
       // text_reader_->Lines()[i].shrink_to_fit();
       // push data
@@ -1145,9 +1292,10 @@ void DatasetLoader::ExtractFeaturesFromMemory(std::vector<std::string>* text_dat
 
 /*! \brief Extract local features from file */
 void DatasetLoader::ExtractFeaturesFromFile(const char* filename, const Parser* parser,
-                                            const std::vector<data_size_t>& used_data_indices, Dataset* dataset) {
+                                            const std::vector<data_size_t>& used_data_indices,
+                                            int rank, int num_machines, Dataset* dataset) {
   std::vector<double> init_score;
-  if (predict_fun_ != nullptr) {
+  if (PredictWhileParsing()) {
     init_score = std::vector<double>(dataset->num_data_ * num_class_);
   }
   std::function<void(data_size_t, const std::vector<std::string>&)> process_fun =
@@ -1198,7 +1346,12 @@ void DatasetLoader::ExtractFeaturesFromFile(const char* filename, const Parser*
     OMP_THROW_EX();
   };
   TextReader<data_size_t> text_reader(filename, config_.header, config_.file_load_progress_interval_bytes);
-  if (!used_data_indices.empty()) {
+  if (IsShardedTextLoad(dataset->metadata_, num_machines)) {
+    // only need the lines in own byte range
+    size_t range_begin = 0, range_end = 0;
+    GetShardByteRange(text_reader.DataSize(), rank, num_machines, &range_begin, &range_end);
+    text_reader.ReadByteRangeAndProcessParallel(range_begin, range_end, process_fun);
+  } else if (!used_data_indices.empty()) {
     // only need part of data
     text_reader.ReadPartAndProcessParallel(used_data_indices, process_fun);
   } else {
@@ -1213,6 +1366,35 @@ void DatasetLoader::ExtractFeaturesFromFile(const char* filename, const Parser*
   dataset->FinishLoad();
 }
 
+void DatasetLoader::SetBinnedPredictFunction(const CheckBinnedPredictFunction& check_fun,
+                                             const BinnedPredictFunction& predict_fun) {
+  check_binned_predict_fun_ = check_fun;
+  binned_predict_fun_ = predict_fun;
+}
+
+void DatasetLoader::CheckPredictOnBins(const Dataset* dataset) {
+  predict_on_bins_ = predict_fun_ != nullptr && check_binned_predict_fun_ && binned_predict_fun_
+                     && check_binned_predict_fun_(dataset);
+  if (predict_fun_ != nullptr) {
+    if (predict_on_bins_) {
+      Log::Info("Computing initial scores of the input model from the bins of %s", dataset->data_filename_.c_str());
+    } else {
+      Log::Debug("Computing initial scores of the input model from the raw features of %s", dataset->data_filename_.c_str());
+    }
+  }
+}
+
+void DatasetLoader::PredictOnBins(Dataset* dataset) {
+  if (!predict_on_bins_) {
+    return;
+  }
+  std::vector<double> init_score(static_cast<size_t>(dataset->num_data_) * num_class_);
+  binned_predict_fun_(dataset, init_score.data());
+  // metadata_ will manage space of init_score
+  dataset->metadata_.SetInitScore(init_score.data(), dataset->num_data_ * num_class_);
+  predict_on_bins_ = false;
+}
+
 /*! \brief Check can load from binary file */
 std::string DatasetLoader::CheckCanLoadFromBin(const char* filename) {
   std::string bin_filename(filename);
@@ -148,6 +148,30 @@ class DenseBin: public Bin {
     }
   }
 
+  void ConstructHistogramOfLeafId(const uint8_t* leaf_ids, uint8_t leaf_id, data_size_t start, data_size_t end,
+    const score_t* gradients, const score_t* hessians,
+    HistogramBinEntry* out) const override {
+    // masked instead of branched, the data of a leaf are interleaved with the others
+    for (data_size_t i = start; i < end; i++) {
+      const score_t mask = static_cast<score_t>(leaf_ids[i] == leaf_id);
+      const VAL_T bin = data_[i];
+      out[bin].sum_gradients += mask * gradients[i];
+      out[bin].sum_hessians += mask * hessians[i];
+      out[bin].cnt += leaf_ids[i] == leaf_id;
+    }
+  }
+
+  void ConstructHistogramOfLeafId(const uint8_t* leaf_ids, uint8_t leaf_id, data_size_t start, data_size_t end,
+    const score_t* gradients,
+    HistogramBinEntry* out) const override {
+    for (data_size_t i = start; i < end; i++) {
+      const score_t mask = static_cast<score_t>(leaf_ids[i] == leaf_id);
+      const VAL_T bin = data_[i];
+      out[bin].sum_gradients += mask * gradients[i];
+      out[bin].cnt += leaf_ids[i] == leaf_id;
+    }
+  }
+
   data_size_t Split(
     uint32_t min_bin, uint32_t max_bin, uint32_t default_bin, uint32_t most_freq_bin, MissingType missing_type, bool default_left,
     uint32_t threshold, data_size_t* data_indices, data_size_t num_data,
@@ -0,0 +1,457 @@
+/*!
+ * Copyright (c) 2017 Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT License. See LICENSE file in the project root for license information.
+ */
+#ifndef LIGHTGBM_IO_DENSE_BITMAP_BIN_HPP_
+#define LIGHTGBM_IO_DENSE_BITMAP_BIN_HPP_
+
+#include <LightGBM/bin.h>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace LightGBM {
+
+template <int NUM_BITS>
+class DenseBitmapBin;
+
+template <int NUM_BITS>
+class DenseBitmapBinIterator : public BinIterator {
+ public:
+  explicit DenseBitmapBinIterator(const DenseBitmapBin<NUM_BITS>* bin_data, uint32_t min_bin, uint32_t max_bin, uint32_t most_freq_bin)
+    : bin_data_(bin_data), min_bin_(static_cast<uint8_t>(min_bin)),
+    max_bin_(static_cast<uint8_t>(max_bin)),
+    most_freq_bin_(static_cast<uint8_t>(most_freq_bin)) {
+    if (most_freq_bin_ == 0) {
+      offset_ = 1;
+    } else {
+      offset_ = 0;
+    }
+  }
+  inline uint32_t RawGet(data_size_t idx) override;
+  inline uint32_t Get(data_size_t idx) override;
+  inline void Reset(data_size_t) override {}
+
+ private:
+  const DenseBitmapBin<NUM_BITS>* bin_data_;
+  uint8_t min_bin_;
+  uint8_t max_bin_;
+  uint8_t most_freq_bin_;
+  uint8_t offset_;
+};
+
+/*!
+* \brief Dense bin for groups with at most 1 << NUM_BITS bins, stored as NUM_BITS bitmaps over the data.
+*        Every 64 data use one word per bitmap, and the bin of a data is made of its bit in each bitmap.
+*        Histograms are built per block of 64 data: all gradients are summed, only the set bits of the other bins
+*        are visited, and bin 0 gets the rest, instead of updating the histogram per data.
+*        Only groups with 2 bins use it, with more bitmaps gathering the bits of a leaf is slower than Dense4bitsBin.
+*/
+template <int NUM_BITS>
+class DenseBitmapBin : public Bin {
+ public:
+  friend DenseBitmapBinIterator<NUM_BITS>;
+  DenseBitmapBin(data_size_t num_data, int num_bin)
+    : num_data_(num_data), num_bin_(num_bin) {
+    data_ = std::vector<uint64_t>(NumWords(num_data_), 0);
+  }
+
+  ~DenseBitmapBin() {
+  }
+
+  void Push(int, data_size_t idx, uint32_t value) override {
+    // data of the same word are pushed by different threads, so the bits are set atomically instead of
+    // keeping a buffer of all data until FinishLoad
+    uint64_t* words = data_.data() + static_cast<size_t>(idx >> 6) * NUM_BITS;
+    const int shift = idx & 63;
+    for (int k = 0; k < NUM_BITS; ++k) {
+      if ((value >> k) & 1) {
+        const uint64_t bit = static_cast<uint64_t>(1) << shift;
+        #pragma omp atomic
+        words[k] |= bit;
+      }
+    }
+  }
+
+  void ReSize(data_size_t num_data) override {
+    if (num_data_ != num_data) {
+      num_data_ = num_data;
+      data_.resize(NumWords(num_data_));
+    }
+  }
+
+  inline BinIterator* GetIterator(uint32_t min_bin, uint32_t max_bin, uint32_t most_freq_bin) const override;
+
+  void ConstructHistogram(const data_size_t* data_indices, data_size_t start, data_size_t end,
+    const score_t* ordered_gradients, const score_t* ordered_hessians,
+    HistogramBinEntry* out) const override {
+    ConstructHistogramInner<true, true, false>(data_indices, nullptr, 0, start, end,
+                                               ordered_gradients, ordered_hessians, out);
+  }
+
+  void ConstructHistogram(data_size_t start, data_size_t end,
+    const score_t* ordered_gradients, const score_t* ordered_hessians,
+    HistogramBinEntry* out) const override {
+    ConstructHistogramInner<false, true, false>(nullptr, nullptr, 0, start, end,
+                                                ordered_gradients, ordered_hessians, out);
+  }
+
+  void ConstructHistogram(const data_size_t* data_indices, data_size_t start, data_size_t end,
+    const score_t* ordered_gradients,
+    HistogramBinEntry* out) const override {
+    ConstructHistogramInner<true, false, false>(data_indices, nullptr, 0, start, end,
+                                                ordered_gradients, nullptr, out);
+  }
+
+  void ConstructHistogram(data_size_t start, data_size_t end,
+    const score_t* ordered_gradients,
+    HistogramBinEntry* out) const override {
+    ConstructHistogramInner<false, false, false>(nullptr, nullptr, 0, start, end,
+                                                 ordered_gradients, nullptr, out);
+  }
+
+  void ConstructHistogramOfLeafId(const uint8_t* leaf_ids, uint8_t leaf_id, data_size_t start, data_size_t end,
+    const score_t* gradients, const score_t* hessians,
+    HistogramBinEntry* out) const override {
+    ConstructHistogramInner<false, true, true>(nullptr, leaf_ids, leaf_id, start, end, gradients, hessians, out);
+  }
+
+  void ConstructHistogramOfLeafId(const uint8_t* leaf_ids, uint8_t leaf_id, data_size_t start, data_size_t end,
+    const score_t* gradients,
+    HistogramBinEntry* out) const override {
+    ConstructHistogramInner<false, false, true>(nullptr, leaf_ids, leaf_id, start, end, gradients, nullptr, out);
+  }
+
+  data_size_t Split(
+    uint32_t min_bin, uint32_t max_bin, uint32_t default_bin, uint32_t most_freq_bin, MissingType missing_type, bool default_left,
+    uint32_t threshold, data_size_t* data_indices, data_size_t num_data,
+    data_size_t* lte_indices, data_size_t* gt_indices) const override {
+    if (num_data <= 0) { return 0; }
+    uint32_t th = threshold + min_bin;
+    uint32_t t_default_bin = min_bin + default_bin;
+    uint32_t t_most_freq_bin = min_bin + most_freq_bin;
+    if (most_freq_bin == 0) {
+      th -= 1;
+      t_default_bin -= 1;
+      t_most_freq_bin -= 1;
+    }
+    data_size_t lte_count = 0;
+    data_size_t gt_count = 0;
+    data_size_t* default_indices = gt_indices;
+    data_size_t* default_count = &gt_count;
+    data_size_t* missing_default_indices = gt_indices;
+    data_size_t* missing_default_count = &gt_count;
+    if (most_freq_bin <= threshold) {
+      default_indices = lte_indices;
+      default_count = &lte_count;
+    }
+    if (missing_type == MissingType::NaN) {
+      if (default_left) {
+        missing_default_indices = lte_indices;
+        missing_default_count = &lte_count;
+      }
+      for (data_size_t i = 0; i < num_data; ++i) {
+        const data_size_t idx = data_indices[i];
+        const uint32_t bin = BinAt(idx);
+        if (bin == max_bin) {
+          missing_default_indices[(*missing_default_count)++] = idx;
+        } else if (bin < min_bin || bin > max_bin || t_most_freq_bin == bin) {
+          default_indices[(*default_count)++] = idx;
+        } else if (bin > th) {
+          gt_indices[gt_count++] = idx;
+        } else {
+          lte_indices[lte_count++] = idx;
+        }
+      }
+    } else {
+      if ((default_left && missing_type == MissingType::Zero)
+          || (default_bin <= threshold && missing_type != MissingType::Zero)) {
+        missing_default_indices = lte_indices;
+        missing_default_count = &lte_count;
+      }
+      if (default_bin == most_freq_bin) {
+        for (data_size_t i = 0; i < num_data; ++i) {
+          const data_size_t idx = data_indices[i];
+          const uint32_t bin = BinAt(idx);
+          if (bin < min_bin || bin > max_bin || t_most_freq_bin == bin) {
+            missing_default_indices[(*missing_default_count)++] = idx;
+          } else if (bin > th) {
+            gt_indices[gt_count++] = idx;
+          } else {
+            lte_indices[lte_count++] = idx;
+          }
+        }
+      } else {
+        for (data_size_t i = 0; i < num_data; ++i) {
+          const data_size_t idx = data_indices[i];
+          const uint32_t bin = BinAt(idx);
+          if (bin == t_default_bin) {
+            missing_default_indices[(*missing_default_count)++] = idx;
+          } else if (bin < min_bin || bin > max_bin || t_most_freq_bin == bin) {
+            default_indices[(*default_count)++] = idx;
+          } else if (bin > th) {
+            gt_indices[gt_count++] = idx;
+          } else {
+            lte_indices[lte_count++] = idx;
+          }
+        }
+      }
+    }
+    return lte_count;
+  }
+
+  data_size_t SplitCategorical(
+    uint32_t min_bin, uint32_t max_bin, uint32_t most_freq_bin,
+    const uint32_t* threshold, int num_threahold, data_size_t* data_indices, data_size_t num_data,
+    data_size_t* lte_indices, data_size_t* gt_indices) const override {
+    if (num_data <= 0) { return 0; }
+    data_size_t lte_count = 0;
+    data_size_t gt_count = 0;
+    data_size_t* default_indices = gt_indices;
+    data_size_t* default_count = &gt_count;
+    if (Common::FindInBitset(threshold, num_threahold, most_freq_bin)) {
+      default_indices = lte_indices;
+      default_count = &lte_count;
+    }
+    for (data_size_t i = 0; i < num_data; ++i) {
+      const data_size_t idx = data_indices[i];
+      const uint32_t bin = BinAt(idx);
+      if (bin < min_bin || bin > max_bin) {
+        default_indices[(*default_count)++] = idx;
+      } else if (Common::FindInBitset(threshold, num_threahold, bin - min_bin)) {
+        lte_indices[lte_count++] = idx;
+      } else {
+        gt_indices[gt_count++] = idx;
+      }
+    }
+    return lte_count;
+  }
+
+  data_size_t num_data() const override { return num_data_; }
+
+  /*! \brief not ordered bin for dense feature */
+  OrderedBin* CreateOrderedBin() const override { return nullptr; }
+
+  void FinishLoad() override {}
+
+  void LoadFromMemory(const void* memory, const std::vector<data_size_t>& local_used_indices) override {
+    // binary files use the layout of Dense4bitsBin
+    const uint8_t* mem_data = reinterpret_cast<const uint8_t*>(memory);
+    std::fill(data_.begin(), data_.end(), 0);
+    for (data_size_t i = 0; i < num_data_; ++i) {
+      const data_size_t idx = local_used_indices.empty() ? i : local_used_indices[i];
+      SetBinAt(i, (mem_data[idx >> 1] >> ((idx & 1) << 2)) & 0xf);
+    }
+  }
+
+  void CopySubset(const Bin* full_bin, const data_size_t* used_indices, data_size_t num_used_indices) override {
+    auto other_bin = dynamic_cast<const DenseBitmapBin<NUM_BITS>*>(full_bin);
+    std::fill(data_.begin(), data_.end(), 0);
+    for (data_size_t i = 0; i < num_used_indices; ++i) {
+      SetBinAt(i, other_bin->BinAt(used_indices[i]));
+    }
+  }
+
+  void SaveBinaryToFile(const VirtualFileWriter* writer) const override {
+    // use the layout of Dense4bitsBin, so binary files don't depend on enable_bitmap_bin
+    std::vector<uint8_t> mem_data((num_data_ + 1) / 2, 0);
+    for (data_size_t i = 0; i < num_data_; ++i) {
+      mem_data[i >> 1] |= static_cast<uint8_t>(BinAt(i) << ((i & 1) << 2));
+    }
+    writer->Write(mem_data.data(), sizeof(uint8_t) * mem_data.size());
+  }
+
+  size_t SizesInByte() const override {
+    // size in binary files
+    return sizeof(uint8_t) * ((num_data_ + 1) / 2);
+  }
+
+  size_t MemorySizesInByte() const override {
+    return sizeof(uint64_t) * data_.capacity();
+  }
+
+  DenseBitmapBin<NUM_BITS>* Clone() override {
+    return new DenseBitmapBin<NUM_BITS>(*this);
+  }
+
+ protected:
+  DenseBitmapBin(const DenseBitmapBin<NUM_BITS>& other)
+    : num_data_(other.num_data_), num_bin_(other.num_bin_), data_(other.data_) {}
+
+  static size_t NumWords(data_size_t num_data) {
+    return static_cast<size_t>((num_data + 63) / 64) * NUM_BITS;
+  }
+
+  inline uint32_t BinAt(data_size_t idx) const {
+    const uint64_t* words = data_.data() + static_cast<size_t>(idx >> 6) * NUM_BITS;
+    const int shift = idx & 63;
+    uint32_t bin = 0;
+    for (int k = 0; k < NUM_BITS; ++k) {
+      bin |= static_cast<uint32_t>((words[k] >> shift) & 1) << k;
+    }
+    return bin;
+  }
+
+  inline void SetBinAt(data_size_t idx, uint32_t bin) {
+    uint64_t* words = data_.data() + static_cast<size_t>(idx >> 6) * NUM_BITS;
+    const int shift = idx & 63;
+    for (int k = 0; k < NUM_BITS; ++k) {
+      words[k] |= static_cast<uint64_t>((bin >> k) & 1) << shift;
+    }
+  }
+
+  static inline int CountTrailingZeros(uint64_t x) {
+    #if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward64(&index, x);
+    return static_cast<int>(index);
+    #else
+    return __builtin_ctzll(x);
+    #endif
+  }
+
+  template <bool USE_INDICES, bool USE_HESSIANS, bool USE_LEAF_ID>
+  inline void ConstructHistogramInner(const data_size_t* data_indices, const uint8_t* leaf_ids, uint8_t leaf_id,
+                                      data_size_t start, data_size_t end,
+                                      const score_t* ordered_gradients, const score_t* ordered_hessians,
+                                      HistogramBinEntry* out) const {
+    const int kMaxBin = 1 << NUM_BITS;
+    const int kNumLane = 4;
+    // sums of all used data and of the bins except bin 0, whose sums are the rest
+    double total_gradients[kNumLane] = {};
+    double total_hessians[kNumLane] = {};
+    data_size_t total_cnt = 0;
+    double sum_gradients[kMaxBin] = {};
+    double sum_hessians[kMaxBin] = {};
+    data_size_t cnt[kMaxBin] = {};
+    data_size_t block_start = start;
+    while (block_start < end) {
+      // a block has at most 64 used data, without indices it is within one word of the bitmaps
+      data_size_t block_end = std::min(end, USE_INDICES ? block_start + 64 : ((block_start >> 6) + 1) << 6);
+      const int block_size = static_cast<int>(block_end - block_start);
+      const score_t* gradients = ordered_gradients + block_start;
+      const score_t* hessians = ordered_hessians + block_start;
+      // bit k of the masks is for the (block_start + k)-th used data
+      uint64_t bits[NUM_BITS];
+      if (USE_INDICES) {
+        for (int p = 0; p < NUM_BITS; ++p) {
+          bits[p] = 0;
+        }
+        // shifted in from the top, so bit k ends at position k after block_size data
+        const uint64_t kTopBit = static_cast<uint64_t>(1) << 63;
+        const data_size_t* indices = data_indices + block_start;
+        for (int k = 0; k < block_size; ++k) {
+          const data_size_t idx = indices[k];
+          const uint64_t* words = data_.data() + static_cast<size_t>(idx >> 6) * NUM_BITS;
+          for (int p = 0; p < NUM_BITS; ++p) {
+            bits[p] = (bits[p] >> 1) | ((words[p] << (63 - (idx & 63))) & kTopBit);
+          }
+        }
+        for (int p = 0; p < NUM_BITS; ++p) {
+          bits[p] >>= 64 - block_size;
+        }
+      } else {
+        const uint64_t* words = data_.data() + static_cast<size_t>(block_start >> 6) * NUM_BITS;
+        for (int p = 0; p < NUM_BITS; ++p) {
+          bits[p] = words[p] >> (block_start & 63);
+        }
+      }
+      uint64_t used_mask = block_size == 64 ? ~static_cast<uint64_t>(0) : (static_cast<uint64_t>(1) << block_size) - 1;
+      if (USE_LEAF_ID) {
+        uint64_t leaf_mask = 0;
+        for (int k = 0; k < block_size; ++k) {
+          leaf_mask |= static_cast<uint64_t>(leaf_ids[block_start + k] == leaf_id) << k;
+        }
+        used_mask &= leaf_mask;
+        for (uint64_t mask = used_mask; mask != 0; mask &= mask - 1) {
+          const int k = CountTrailingZeros(mask);
+          total_gradients[0] += gradients[k];
+          if (USE_HESSIANS) {
+            total_hessians[0] += hessians[k];
+          }
+          ++total_cnt;
+        }
+      } else {
+        int k = 0;
+        for (; k + kNumLane <= block_size; k += kNumLane) {
+          for (int l = 0; l < kNumLane; ++l) {
+            total_gradients[l] += gradients[k + l];
+            if (USE_HESSIANS) {
+              total_hessians[l] += hessians[k + l];
+            }
+          }
+        }
+        for (; k < block_size; ++k) {
+          total_gradients[0] += gradients[k];
+          if (USE_HESSIANS) {
+            total_hessians[0] += hessians[k];
+          }
+        }
+        total_cnt += block_size;
+      }
+      for (int j = 1; j < kMaxBin; ++j) {
+        uint64_t bin_mask = used_mask;
+        for (int p = 0; p < NUM_BITS; ++p) {
+          bin_mask &= ((j >> p) & 1) ? bits[p] : ~bits[p];
+        }
+        for (; bin_mask != 0; bin_mask &= bin_mask - 1) {
+          const int k = CountTrailingZeros(bin_mask);
+          sum_gradients[j] += gradients[k];
+          if (USE_HESSIANS) {
+            sum_hessians[j] += hessians[k];
+          }
+          ++cnt[j];
+        }
+      }
+      block_start = block_end;
+    }
+    sum_gradients[0] = (total_gradients[0] + total_gradients[1]) + (total_gradients[2] + total_gradients[3]);
+    sum_hessians[0] = (total_hessians[0] + total_hessians[1]) + (total_hessians[2] + total_hessians[3]);
+    cnt[0] = total_cnt;
+    for (int j = 1; j < kMaxBin; ++j) {
+      sum_gradients[0] -= sum_gradients[j];
+      sum_hessians[0] -= sum_hessians[j];
+      cnt[0] -= cnt[j];
+    }
+    for (int j = 0; j < num_bin_; ++j) {
+      out[j].sum_gradients += sum_gradients[j];
+      if (USE_HESSIANS) {
+        out[j].sum_hessians += sum_hessians[j];
+      }
+      out[j].cnt += cnt[j];
+    }
+  }
+
+  data_size_t num_data_;
+  int num_bin_;
+  std::vector<uint64_t> data_;
+};
+
+template <int NUM_BITS>
+uint32_t DenseBitmapBinIterator<NUM_BITS>::Get(data_size_t idx) {
+  const auto bin = bin_data_->BinAt(idx);
+  if (bin >= min_bin_ && bin <= max_bin_) {
+    return bin - min_bin_ + offset_;
+  } else {
+    return most_freq_bin_;
+  }
+}
+
+template <int NUM_BITS>
+uint32_t DenseBitmapBinIterator<NUM_BITS>::RawGet(data_size_t idx) {
+  return bin_data_->BinAt(idx);
+}
+
+template <int NUM_BITS>
+inline BinIterator* DenseBitmapBin<NUM_BITS>::GetIterator(uint32_t min_bin, uint32_t max_bin, uint32_t most_freq_bin) const {
+  return new DenseBitmapBinIterator<NUM_BITS>(this, min_bin, max_bin, most_freq_bin);
+}
+
+}  // namespace LightGBM
+#endif   // LIGHTGBM_IO_DENSE_BITMAP_BIN_HPP_
@@ -44,6 +44,29 @@ struct LocalFile : VirtualFileReader, VirtualFileWriter {
     return fread(buffer, 1, bytes, file_);
   }
 
+  bool Seek(size_t offset) const {
+#if _MSC_VER
+    return _fseeki64(file_, static_cast<int64_t>(offset), SEEK_SET) == 0;
+#else
+    return fseeko(file_, static_cast<off_t>(offset), SEEK_SET) == 0;
+#endif
+  }
+
+  size_t Size() const {
+#if _MSC_VER
+    const int64_t cur = _ftelli64(file_);
+    _fseeki64(file_, 0, SEEK_END);
+    const int64_t size = _ftelli64(file_);
+    _fseeki64(file_, cur, SEEK_SET);
+#else
+    const off_t cur = ftello(file_);
+    fseeko(file_, 0, SEEK_END);
+    const off_t size = ftello(file_);
+    fseeko(file_, cur, SEEK_SET);
+#endif
+    return size > 0 ? static_cast<size_t>(size) : 0;
+  }
+
   size_t Write(const void* buffer, size_t bytes) const {
     return fwrite(buffer, bytes, 1, file_) == 1 ? bytes : 0;
   }
@@ -90,6 +113,20 @@ struct HDFSFile : VirtualFileReader, VirtualFileWriter {
     return FileOperation<void*>(data, bytes, &hdfsRead);
   }
 
+  bool Seek(size_t offset) const {
+    return hdfsSeek(fs_, file_, static_cast<tOffset>(offset)) == 0;
+  }
+
+  size_t Size() const {
+    hdfsFileInfo* info = hdfsGetPathInfo(fs_, filename_.c_str());
+    if (info == NULL) {
+      return 0;
+    }
+    const size_t size = static_cast<size_t>(info->mSize);
+    hdfsFreeFileInfo(info, 1);
+    return size;
+  }
+
   size_t Write(const void* data, size_t bytes) const {
     return FileOperation<const void*>(data, bytes, &hdfsWrite);
   }
@@ -300,7 +300,8 @@ void Metadata::SetInitScore(const double* init_score, data_size_t len) {
   init_score_load_from_file_ = false;
 }
 
-void Metadata::SetLabel(const label_t* label, data_size_t len) {
+template <typename T>
+void Metadata::SetLabelInner(const T* label, data_size_t len) {
   std::lock_guard<std::mutex> lock(mutex_);
   if (label == nullptr) {
     Log::Fatal("label cannot be nullptr");
@@ -312,11 +313,22 @@ void Metadata::SetLabel(const label_t* label, data_size_t len) {
  
   #pragma omp parallel for schedule(static)
   for (data_size_t i = 0; i < num_data_; ++i) {
-    label_[i] = Common::AvoidInf(label[i]);
+    label_[i] = Common::AvoidInf(static_cast<label_t>(label[i]));
   }
 }
 
-void Metadata::SetWeights(const label_t* weights, data_size_t len) {
+void Metadata::SetLabel(const label_t* label, data_size_t len) {
+  SetLabelInner(label, len);
+}
+
+#ifndef LABEL_T_USE_DOUBLE
+void Metadata::SetLabel(const double* label, data_size_t len) {
+  SetLabelInner(label, len);
+}
+#endif
+
+template <typename T>
+void Metadata::SetWeightsInner(const T* weights, data_size_t len) {
   std::lock_guard<std::mutex> lock(mutex_);
   // save to nullptr
   if (weights == nullptr || len == 0) {
@@ -332,12 +344,22 @@ void Metadata::SetWeights(const label_t* weights, data_size_t len) {
  
   #pragma omp parallel for schedule(static)
   for (data_size_t i = 0; i < num_weights_; ++i) {
-    weights_[i] = Common::AvoidInf(weights[i]);
+    weights_[i] = Common::AvoidInf(static_cast<label_t>(weights[i]));
   }
   LoadQueryWeights();
   weight_load_from_file_ = false;
 }
 
+void Metadata::SetWeights(const label_t* weights, data_size_t len) {
+  SetWeightsInner(weights, len);
+}
+
+#ifndef LABEL_T_USE_DOUBLE
+void Metadata::SetWeights(const double* weights, data_size_t len) {
+  SetWeightsInner(weights, len);
+}
+#endif
+
 void Metadata::SetQuery(const data_size_t* query, data_size_t len) {
   std::lock_guard<std::mutex> lock(mutex_);
   // save to nullptr
@@ -126,6 +126,18 @@ class SparseBin: public Bin {
     Log::Fatal("Using OrderedSparseBin->ConstructHistogram() instead");
   }
 
+  void ConstructHistogramOfLeafId(const uint8_t*, uint8_t, data_size_t, data_size_t, const score_t*,
+                                  const score_t*, HistogramBinEntry*) const override {
+    // Will use OrderedSparseBin->ConstructHistogram() instead
+    Log::Fatal("Using OrderedSparseBin->ConstructHistogram() instead");
+  }
+
+  void ConstructHistogramOfLeafId(const uint8_t*, uint8_t, data_size_t, data_size_t, const score_t*,
+                                  HistogramBinEntry*) const override {
+    // Will use OrderedSparseBin->ConstructHistogram() instead
+    Log::Fatal("Using OrderedSparseBin->ConstructHistogram() instead");
+  }
+
   inline bool NextNonzero(data_size_t* i_delta,
                           data_size_t* cur_pos) const {
     ++(*i_delta);
@@ -8,9 +8,11 @@
 #include <LightGBM/utils/common.h>
 #include <LightGBM/utils/threading.h>
 
+#include <algorithm>
 #include <functional>
 #include <iomanip>
 #include <sstream>
+#include <tuple>
 
 namespace LightGBM {
 
@@ -22,6 +24,7 @@ Tree::Tree(int max_leaves)
   split_feature_.resize(max_leaves_ - 1);
   threshold_in_bin_.resize(max_leaves_ - 1);
   threshold_.resize(max_leaves_ - 1);
+  threshold_float_.resize(max_leaves_ - 1);
   decision_type_.resize(max_leaves_ - 1, 0);
   split_gain_.resize(max_leaves_ - 1);
   leaf_parent_.resize(max_leaves_);
@@ -65,6 +68,7 @@ int Tree::Split(int leaf, int feature, int real_feature, uint32_t threshold_bin,
   }
   threshold_in_bin_[new_node_idx] = threshold_bin;
   threshold_[new_node_idx] = threshold_double;
+  threshold_float_[new_node_idx] = MaxFloatNotAbove(threshold_double);
   ++num_leaves_;
   return num_leaves_ - 1;
 }
@@ -85,6 +89,7 @@ int Tree::SplitCategorical(int leaf, int feature, int real_feature, const uint32
   }
   threshold_in_bin_[new_node_idx] = num_cat_;
   threshold_[new_node_idx] = num_cat_;
+  threshold_float_[new_node_idx] = static_cast<float>(num_cat_);
   ++num_cat_;
   cat_boundaries_.push_back(cat_boundaries_.back() + num_threshold);
   for (int i = 0; i < num_threshold; ++i) {
@@ -206,6 +211,197 @@ void Tree::AddPredictionToScore(const Dataset* data,
 
 #undef PredictionFun
 
+void Tree::AddPredictionToScore(const std::vector<const Tree*>& trees, const Dataset* data,
+                                data_size_t num_data, const std::vector<double*>& scores) {
+  CHECK(trees.size() == scores.size());
+  const int num_trees = static_cast<int>(trees.size());
+  if (num_trees == 0 || num_data <= 0) { return; }
+  // columns of the features used by any tree in the decoded bins of a block
+  std::vector<int> used_features;
+  std::vector<int> feature_column(data->num_features(), -1);
+  std::vector<std::vector<int>> node_columns(num_trees);
+  std::vector<std::vector<uint32_t>> default_bins(num_trees);
+  std::vector<std::vector<uint32_t>> max_bins(num_trees);
+  for (int t = 0; t < num_trees; ++t) {
+    const Tree* tree = trees[t];
+    for (int i = 0; i < tree->num_leaves_ - 1; ++i) {
+      const int fidx = tree->split_feature_inner_[i];
+      if (feature_column[fidx] < 0) {
+        feature_column[fidx] = static_cast<int>(used_features.size());
+        used_features.push_back(fidx);
+      }
+      auto bin_mapper = data->FeatureBinMapper(fidx);
+      node_columns[t].push_back(feature_column[fidx]);
+      default_bins[t].push_back(bin_mapper->GetDefaultBin());
+      max_bins[t].push_back(bin_mapper->num_bin() - 1);
+    }
+  }
+  const int num_columns = static_cast<int>(used_features.size());
+  // bins of a block are decoded once for all trees, the block is kept small enough to stay in cache
+  const data_size_t block_size = std::max<data_size_t>(64, (1 << 16) / std::max(num_columns, 1));
+  Threading::For<data_size_t>(0, num_data, [&]
+  (int, data_size_t start, data_size_t end) {
+    std::vector<std::unique_ptr<BinIterator>> iter(num_columns);
+    for (int j = 0; j < num_columns; ++j) {
+      iter[j].reset(data->FeatureIterator(used_features[j]));
+      iter[j]->Reset(start);
+    }
+    std::vector<uint32_t> block_bins(static_cast<size_t>(block_size) * num_columns);
+    for (data_size_t block_start = start; block_start < end; block_start += block_size) {
+      const data_size_t block_end = std::min(end, block_start + block_size);
+      for (int j = 0; j < num_columns; ++j) {
+        for (data_size_t i = block_start; i < block_end; ++i) {
+          block_bins[static_cast<size_t>(i - block_start) * num_columns + j] = iter[j]->Get(i);
+        }
+      }
+      for (int t = 0; t < num_trees; ++t) {
+        const Tree* tree = trees[t];
+        double* score = scores[t];
+        if (tree->num_leaves_ <= 1) {
+          if (tree->leaf_value_[0] != 0.0f) {
+            for (data_size_t i = block_start; i < block_end; ++i) {
+              score[i] += tree->leaf_value_[0];
+            }
+          }
+          continue;
+        }
+        const int* columns = node_columns[t].data();
+        const uint32_t* tree_default_bins = default_bins[t].data();
+        const uint32_t* tree_max_bins = max_bins[t].data();
+        const uint32_t* row_bins = block_bins.data();
+        if (tree->num_cat_ > 0) {
+          for (data_size_t i = block_start; i < block_end; ++i, row_bins += num_columns) {
+            int node = 0;
+            while (node >= 0) {
+              node = tree->DecisionInner(row_bins[columns[node]], node, tree_default_bins[node], tree_max_bins[node]);
+            }
+            score[i] += static_cast<double>(tree->leaf_value_[~node]);
+          }
+        } else {
+          for (data_size_t i = block_start; i < block_end; ++i, row_bins += num_columns) {
+            int node = 0;
+            while (node >= 0) {
+              node = tree->NumericalDecisionInner(row_bins[columns[node]], node, tree_default_bins[node], tree_max_bins[node]);
+            }
+            score[i] += static_cast<double>(tree->leaf_value_[~node]);
+          }
+        }
+      }
+    }
+  });
+}
+
+bool Tree::MapThresholdsToBins(const Dataset* data) {
+  const int num_nodes = num_leaves_ - 1;
+  std::vector<int> split_feature_inner(num_nodes);
+  std::vector<uint32_t> threshold_in_bin(num_nodes);
+  std::vector<std::vector<uint32_t>> cat_bins(num_cat_);
+  for (int i = 0; i < num_nodes; ++i) {
+    if (split_feature_[i] >= data->num_total_features()) {
+      return false;
+    }
+    const int inner_feature = data->InnerFeatureIndex(split_feature_[i]);
+    if (inner_feature < 0) {
+      return false;
+    }
+    const BinMapper* bin_mapper = data->FeatureBinMapper(inner_feature);
+    // missing values must fall in the bins the decision expects
+    int8_t missing_type = 0;
+    if (bin_mapper->missing_type() == MissingType::Zero) {
+      missing_type = 1;
+    } else if (bin_mapper->missing_type() == MissingType::NaN) {
+      missing_type = 2;
+    }
+    if (GetMissingType(decision_type_[i]) != missing_type) {
+      return false;
+    }
+    split_feature_inner[i] = inner_feature;
+    if (GetDecisionType(decision_type_[i], kCategoricalMask)) {
+      if (bin_mapper->bin_type() != BinType::CategoricalBin) {
+        return false;
+      }
+      const int cat_idx = static_cast<int>(threshold_[i]);
+      for (int j = cat_boundaries_[cat_idx]; j < cat_boundaries_[cat_idx + 1]; ++j) {
+        for (int k = 0; k < 32; ++k) {
+          if (((cat_threshold_[j] >> k) & 1) == 0) {
+            continue;
+          }
+          const int category = (j - cat_boundaries_[cat_idx]) * 32 + k;
+          const uint32_t bin = bin_mapper->ValueToBin(category);
+          // the last bin also holds the unseen and negative categories
+          if (bin + 1 == static_cast<uint32_t>(bin_mapper->num_bin())
+              || static_cast<int>(bin_mapper->BinToValue(bin)) != category) {
+            return false;
+          }
+          cat_bins[cat_idx].push_back(bin);
+        }
+      }
+      threshold_in_bin[i] = static_cast<uint32_t>(cat_idx);
+    } else {
+      if (bin_mapper->bin_type() != BinType::NumericalBin) {
+        return false;
+      }
+      const uint32_t bin = bin_mapper->ValueToBin(threshold_[i]);
+      if (bin_mapper->BinToValue(bin) != threshold_[i]) {
+        return false;
+      }
+      threshold_in_bin[i] = bin;
+    }
+  }
+  split_feature_inner_ = std::move(split_feature_inner);
+  threshold_in_bin_ = std::move(threshold_in_bin);
+  cat_boundaries_inner_.assign(1, 0);
+  cat_threshold_inner_.clear();
+  for (int i = 0; i < num_cat_; ++i) {
+    auto bitset = Common::ConstructBitset(cat_bins[i].data(), static_cast<int>(cat_bins[i].size()));
+    cat_threshold_inner_.insert(cat_threshold_inner_.end(), bitset.begin(), bitset.end());
+    cat_boundaries_inner_.push_back(static_cast<int>(cat_threshold_inner_.size()));
+  }
+  return true;
+}
+
+void Tree::AddSplitThresholds(std::vector<std::vector<double>>* feature_thresholds,
+                              std::vector<int8_t>* is_categorical) const {
+  for (int i = 0; i < num_leaves_ - 1; ++i) {
+    const int feature = split_feature_[i];
+    if (GetDecisionType(decision_type_[i], kCategoricalMask)) {
+      (*is_categorical)[feature] = 1;
+    } else {
+      (*feature_thresholds)[feature].push_back(threshold_[i]);
+    }
+  }
+}
+
+std::vector<uint32_t> Tree::NodeBins(const std::vector<std::vector<double>>& bin_upper_bounds) const {
+  std::vector<uint32_t> node_bins(3 * std::max(num_leaves_ - 1, 0), 0);
+  for (int i = 0; i < num_leaves_ - 1; ++i) {
+    if (GetDecisionType(decision_type_[i], kCategoricalMask)) {
+      continue;
+    }
+    const auto& bounds = bin_upper_bounds[split_feature_[i]];
+    auto threshold_pos = std::lower_bound(bounds.begin(), bounds.end(), threshold_[i]);
+    auto zero_pos = std::lower_bound(bounds.begin(), bounds.end(), kZeroThreshold);
+    CHECK(threshold_pos != bounds.end() && *threshold_pos == threshold_[i]);
+    CHECK(zero_pos != bounds.end());
+    node_bins[3 * i] = static_cast<uint32_t>(threshold_pos - bounds.begin());
+    node_bins[3 * i + 1] = static_cast<uint32_t>(zero_pos - bounds.begin());
+    // the last bin is for values larger than all upper bounds, NaN follows it
+    node_bins[3 * i + 2] = static_cast<uint32_t>(bounds.size() + 1);
+  }
+  return node_bins;
+}
+
+size_t Tree::SizesInByte() const {
+  return sizeof(int) * (left_child_.size() + right_child_.size() + split_feature_inner_.size() + split_feature_.size()
+                        + cat_boundaries_inner_.size() + cat_boundaries_.size() + leaf_parent_.size()
+                        + leaf_count_.size() + internal_count_.size() + leaf_depth_.size())
+    + sizeof(uint32_t) * (threshold_in_bin_.size() + cat_threshold_inner_.size() + cat_threshold_.size())
+    + sizeof(double) * (threshold_.size() + leaf_value_.size() + leaf_weight_.size()
+                        + internal_value_.size() + internal_weight_.size())
+    + sizeof(float) * (threshold_float_.size() + split_gain_.size())
+    + sizeof(int8_t) * decision_type_.size() + sizeof(Tree);
+}
+
 std::string Tree::ToString() const {
   std::stringstream str_buf;
   str_buf << "num_leaves=" << num_leaves_ << '\n';
@@ -245,6 +441,80 @@ std::string Tree::ToString() const {
   return str_buf.str();
 }
 
+void Tree::SaveBinaryToString(std::string* buffer) const {
+  Common::AppendToBinary(max_leaves_, buffer);
+  Common::AppendToBinary(num_leaves_, buffer);
+  Common::AppendToBinary(left_child_, buffer);
+  Common::AppendToBinary(right_child_, buffer);
+  Common::AppendToBinary(split_feature_inner_, buffer);
+  Common::AppendToBinary(split_feature_, buffer);
+  Common::AppendToBinary(threshold_in_bin_, buffer);
+  Common::AppendToBinary(threshold_, buffer);
+  Common::AppendToBinary(threshold_float_, buffer);
+  Common::AppendToBinary(num_cat_, buffer);
+  Common::AppendToBinary(cat_boundaries_inner_, buffer);
+  Common::AppendToBinary(cat_threshold_inner_, buffer);
+  Common::AppendToBinary(cat_boundaries_, buffer);
+  Common::AppendToBinary(cat_threshold_, buffer);
+  Common::AppendToBinary(decision_type_, buffer);
+  Common::AppendToBinary(split_gain_, buffer);
+  Common::AppendToBinary(leaf_parent_, buffer);
+  Common::AppendToBinary(leaf_value_, buffer);
+  Common::AppendToBinary(leaf_weight_, buffer);
+  Common::AppendToBinary(leaf_count_, buffer);
+  Common::AppendToBinary(internal_value_, buffer);
+  Common::AppendToBinary(internal_weight_, buffer);
+  Common::AppendToBinary(internal_count_, buffer);
+  Common::AppendToBinary(leaf_depth_, buffer);
+  Common::AppendToBinary(shrinkage_, buffer);
+  Common::AppendToBinary(max_depth_, buffer);
+}
+
+bool Tree::LoadBinaryFromString(const std::string& buffer, size_t* pos) {
+  bool is_valid = Common::ReadFromBinary(buffer, pos, &max_leaves_)
+    && Common::ReadFromBinary(buffer, pos, &num_leaves_)
+    && Common::ReadFromBinary(buffer, pos, &left_child_)
+    && Common::ReadFromBinary(buffer, pos, &right_child_)
+    && Common::ReadFromBinary(buffer, pos, &split_feature_inner_)
+    && Common::ReadFromBinary(buffer, pos, &split_feature_)
+    && Common::ReadFromBinary(buffer, pos, &threshold_in_bin_)
+    && Common::ReadFromBinary(buffer, pos, &threshold_)
+    && Common::ReadFromBinary(buffer, pos, &threshold_float_)
+    && Common::ReadFromBinary(buffer, pos, &num_cat_)
+    && Common::ReadFromBinary(buffer, pos, &cat_boundaries_inner_)
+    && Common::ReadFromBinary(buffer, pos, &cat_threshold_inner_)
+    && Common::ReadFromBinary(buffer, pos, &cat_boundaries_)
+    && Common::ReadFromBinary(buffer, pos, &cat_threshold_)
+    && Common::ReadFromBinary(buffer, pos, &decision_type_)
+    && Common::ReadFromBinary(buffer, pos, &split_gain_)
+    && Common::ReadFromBinary(buffer, pos, &leaf_parent_)
+    && Common::ReadFromBinary(buffer, pos, &leaf_value_)
+    && Common::ReadFromBinary(buffer, pos, &leaf_weight_)
+    && Common::ReadFromBinary(buffer, pos, &leaf_count_)
+    && Common::ReadFromBinary(buffer, pos, &internal_value_)
+    && Common::ReadFromBinary(buffer, pos, &internal_weight_)
+    && Common::ReadFromBinary(buffer, pos, &internal_count_)
+    && Common::ReadFromBinary(buffer, pos, &leaf_depth_)
+    && Common::ReadFromBinary(buffer, pos, &shrinkage_)
+    && Common::ReadFromBinary(buffer, pos, &max_depth_);
+  // node arrays are indexed up to max_leaves_, check them before any traversal
+  const size_t num_nodes = static_cast<size_t>(std::max(max_leaves_ - 1, 0));
+  return is_valid && max_leaves_ >= 1 && num_leaves_ >= 1 && num_leaves_ <= max_leaves_ && num_cat_ >= 0
+    && left_child_.size() == num_nodes && right_child_.size() == num_nodes
+    && split_feature_inner_.size() == num_nodes && split_feature_.size() == num_nodes
+    && threshold_in_bin_.size() == num_nodes && threshold_.size() == num_nodes
+    && threshold_float_.size() == num_nodes && decision_type_.size() == num_nodes
+    && split_gain_.size() == num_nodes && internal_value_.size() == num_nodes
+    && internal_weight_.size() == num_nodes && internal_count_.size() == num_nodes
+    && leaf_parent_.size() == static_cast<size_t>(max_leaves_)
+    && leaf_value_.size() == static_cast<size_t>(max_leaves_)
+    && leaf_weight_.size() == static_cast<size_t>(max_leaves_)
+    && leaf_count_.size() == static_cast<size_t>(max_leaves_)
+    && leaf_depth_.size() == static_cast<size_t>(max_leaves_)
+    && cat_boundaries_.size() == static_cast<size_t>(num_cat_) + 1
+    && cat_boundaries_inner_.size() == static_cast<size_t>(num_cat_) + 1;
+}
+
 std::string Tree::ToJSON() const {
   std::stringstream str_buf;
   str_buf << std::setprecision(std::numeric_limits<double>::digits10 + 2);
@@ -503,6 +773,7 @@ Tree::Tree(const char* str, size_t* used_len) {
   }
 
   Common::Atoi(key_vals["num_leaves"].c_str(), &num_leaves_);
+  max_leaves_ = num_leaves_;
 
   if (key_vals.count("num_cat") <= 0) {
     Log::Fatal("Tree model should contain num_cat field");
@@ -544,6 +815,10 @@ Tree::Tree(const char* str, size_t* used_len) {
 
   if (key_vals.count("threshold")) {
     threshold_ = Common::StringToArray<double>(key_vals["threshold"], num_leaves_ - 1);
+    threshold_float_.resize(num_leaves_ - 1);
+    for (int i = 0; i < num_leaves_ - 1; ++i) {
+      threshold_float_[i] = MaxFloatNotAbove(threshold_[i]);
+    }
   } else {
     Log::Fatal("Tree model string format error, should contain threshold field");
   }
@@ -725,6 +1000,199 @@ double Tree::ExpectedValue() const {
   return exp_value;
 }
 
+/*! \brief Keep values[index[i]] at position i, for the node arrays that are present */
+template<typename T>
+static void GatherByIndex(const std::vector<int>& index, std::vector<T>* values) {
+  if (values->empty()) { return; }
+  std::vector<T> gathered(index.size());
+  for (size_t i = 0; i < index.size(); ++i) {
+    gathered[i] = (*values)[index[i]];
+  }
+  values->swap(gathered);
+}
+
+int Tree::Compact(const std::vector<int>& leaf_visits) {
+  if (num_leaves_ <= 1) { return 0; }
+  const int num_nodes = num_leaves_ - 1;
+  // nodes in pre-order, each node before all of its descendants
+  std::vector<int> order;
+  order.reserve(num_nodes);
+  std::vector<int> stack(1, 0);
+  while (!stack.empty()) {
+    int node = stack.back();
+    stack.pop_back();
+    order.push_back(node);
+    if (right_child_[node] >= 0) { stack.push_back(right_child_[node]); }
+    if (left_child_[node] >= 0) { stack.push_back(left_child_[node]); }
+  }
+  // bottom-up: visits of nodes, and nodes whose children are (collapsed) leaves with equal outputs
+  std::vector<int64_t> visits(num_nodes, 0);
+  std::vector<int8_t> collapsed(num_nodes, 0);
+  std::vector<double> collapsed_output(num_nodes, 0.0f);
+  auto child_visits = [&](int child) -> int64_t {
+    if (child >= 0) { return visits[child]; }
+    return leaf_visits.empty() ? leaf_count_[~child] : leaf_visits[~child];
+  };
+  for (auto it = order.rbegin(); it != order.rend(); ++it) {
+    const int node = *it;
+    const int left = left_child_[node];
+    const int right = right_child_[node];
+    visits[node] = child_visits(left) + child_visits(right);
+    if ((left < 0 || collapsed[left]) && (right < 0 || collapsed[right])) {
+      const double left_output = left < 0 ? leaf_value_[~left] : collapsed_output[left];
+      const double right_output = right < 0 ? leaf_value_[~right] : collapsed_output[right];
+      if (left_output == right_output) {
+        collapsed[node] = 1;
+        collapsed_output[node] = left_output;
+      }
+    }
+  }
+  // top-down: number the kept nodes and the leaves in pre-order, the more visited child first
+  std::vector<int> node_source;
+  std::vector<int> leaf_source;
+  std::vector<int> new_left_child, new_right_child, new_leaf_parent;
+  // old child, new parent and whether it is the left child of the parent
+  std::vector<std::tuple<int, int, bool>> pending(1, std::make_tuple(0, -1, true));
+  while (!pending.empty()) {
+    int old_index = std::get<0>(pending.back());
+    int parent = std::get<1>(pending.back());
+    bool is_left = std::get<2>(pending.back());
+    pending.pop_back();
+    int new_ref;
+    if (old_index < 0 || collapsed[old_index]) {
+      new_ref = ~static_cast<int>(leaf_source.size());
+      leaf_source.push_back(old_index);
+      new_leaf_parent.push_back(parent);
+    } else {
+      new_ref = static_cast<int>(node_source.size());
+      node_source.push_back(old_index);
+      new_left_child.push_back(0);
+      new_right_child.push_back(0);
+      const int left = left_child_[old_index];
+      const int right = right_child_[old_index];
+      if (child_visits(left) >= child_visits(right)) {
+        pending.emplace_back(right, new_ref, false);
+        pending.emplace_back(left, new_ref, true);
+      } else {
+        pending.emplace_back(left, new_ref, true);
+        pending.emplace_back(right, new_ref, false);
+      }
+    }
+    if (parent >= 0) {
+      (is_left ? new_left_child : new_right_child)[parent] = new_ref;
+    }
+  }
+  const int removed_leaves = num_leaves_ - static_cast<int>(leaf_source.size());
+  // leaves, a collapsed node takes the output of its children and the data of the node
+  std::vector<double> new_leaf_value(leaf_source.size());
+  std::vector<double> new_leaf_weight(leaf_source.size());
+  std::vector<int> new_leaf_count(leaf_source.size());
+  for (size_t i = 0; i < leaf_source.size(); ++i) {
+    const int old_index = leaf_source[i];
+    if (old_index < 0) {
+      new_leaf_value[i] = leaf_value_[~old_index];
+      new_leaf_weight[i] = leaf_weight_[~old_index];
+      new_leaf_count[i] = leaf_count_[~old_index];
+    } else {
+      new_leaf_value[i] = collapsed_output[old_index];
+      new_leaf_weight[i] = internal_weight_[old_index];
+      new_leaf_count[i] = internal_count_[old_index];
+    }
+  }
+  leaf_value_.swap(new_leaf_value);
+  leaf_weight_.swap(new_leaf_weight);
+  leaf_count_.swap(new_leaf_count);
+  leaf_parent_.swap(new_leaf_parent);
+  left_child_.swap(new_left_child);
+  right_child_.swap(new_right_child);
+  GatherByIndex(node_source, &split_feature_inner_);
+  GatherByIndex(node_source, &split_feature_);
+  GatherByIndex(node_source, &threshold_in_bin_);
+  GatherByIndex(node_source, &threshold_);
+  GatherByIndex(node_source, &threshold_float_);
+  GatherByIndex(node_source, &decision_type_);
+  GatherByIndex(node_source, &split_gain_);
+  GatherByIndex(node_source, &internal_value_);
+  GatherByIndex(node_source, &internal_weight_);
+  GatherByIndex(node_source, &internal_count_);
+  num_leaves_ = static_cast<int>(leaf_source.size());
+  max_leaves_ = num_leaves_;
+  if (num_leaves_ > 1) {
+    RecomputeLeafDepths(0, 0);
+  } else {
+    leaf_depth_.assign(1, 0);
+  }
+  if (max_depth_ >= 0) {
+    RecomputeMaxDepth();
+  }
+  return removed_leaves;
+}
+
+bool Tree::HasSameStructure(const Tree& other) const {
+  if (num_leaves_ != other.num_leaves_) { return false; }
+  for (int i = 0; i < num_leaves_ - 1; ++i) {
+    if (left_child_[i] != other.left_child_[i] || right_child_[i] != other.right_child_[i]
+        || split_feature_[i] != other.split_feature_[i] || decision_type_[i] != other.decision_type_[i]) {
+      return false;
+    }
+    if (GetDecisionType(decision_type_[i], kCategoricalMask)) {
+      const int cat_idx = static_cast<int>(threshold_[i]);
+      const int other_cat_idx = static_cast<int>(other.threshold_[i]);
+      const int num_words = cat_boundaries_[cat_idx + 1] - cat_boundaries_[cat_idx];
+      if (num_words != other.cat_boundaries_[other_cat_idx + 1] - other.cat_boundaries_[other_cat_idx]
+          || !std::equal(cat_threshold_.begin() + cat_boundaries_[cat_idx],
+                         cat_threshold_.begin() + cat_boundaries_[cat_idx + 1],
+                         other.cat_threshold_.begin() + other.cat_boundaries_[other_cat_idx])) {
+        return false;
+      }
+    } else if (threshold_[i] != other.threshold_[i]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+size_t Tree::StructureHash() const {
+  size_t seed = std::hash<int>()(num_leaves_);
+  auto combine = [&seed](size_t hash) {
+    seed ^= hash + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+  };
+  for (int i = 0; i < num_leaves_ - 1; ++i) {
+    combine(std::hash<int>()(left_child_[i]));
+    combine(std::hash<int>()(right_child_[i]));
+    combine(std::hash<int>()(split_feature_[i]));
+    combine(std::hash<int>()(decision_type_[i]));
+    if (GetDecisionType(decision_type_[i], kCategoricalMask)) {
+      const int cat_idx = static_cast<int>(threshold_[i]);
+      for (int j = cat_boundaries_[cat_idx]; j < cat_boundaries_[cat_idx + 1]; ++j) {
+        combine(std::hash<uint32_t>()(cat_threshold_[j]));
+      }
+    } else {
+      combine(std::hash<double>()(threshold_[i]));
+    }
+  }
+  return seed;
+}
+
+void Tree::AddLeafOutputs(const Tree& other) {
+  if (other.num_leaves_ == 1) {
+    for (int i = 0; i < num_leaves_; ++i) {
+      leaf_value_[i] += other.leaf_value_[0];
+    }
+    for (int i = 0; i < num_leaves_ - 1; ++i) {
+      internal_value_[i] += other.leaf_value_[0];
+    }
+    return;
+  }
+  CHECK(HasSameStructure(other));
+  for (int i = 0; i < num_leaves_; ++i) {
+    leaf_value_[i] += other.leaf_value_[i];
+  }
+  for (int i = 0; i < num_leaves_ - 1; ++i) {
+    internal_value_[i] += other.internal_value_[i];
+  }
+}
+
 void Tree::RecomputeMaxDepth() {
   if (num_leaves_ == 1) {
     max_depth_ = 0;
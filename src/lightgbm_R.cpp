@@ -195,21 +195,11 @@ LGBM_SE LGBM_DatasetSetField_R(LGBM_SE handle,
   int len = static_cast<int>(R_AS_INT(num_element));
   const char* name = R_CHAR_PTR(field_name);
   if (!strcmp("group", name) || !strcmp("query", name)) {
-    std::vector<int32_t> vec(len);
-#pragma omp parallel for schedule(static)
-    for (int i = 0; i < len; ++i) {
-      vec[i] = static_cast<int32_t>(R_INT_PTR(field_data)[i]);
-    }
-    CHECK_CALL(LGBM_DatasetSetField(R_GET_PTR(handle), name, vec.data(), len, C_API_DTYPE_INT32));
-  } else if (!strcmp("init_score", name)) {
-    CHECK_CALL(LGBM_DatasetSetField(R_GET_PTR(handle), name, R_REAL_PTR(field_data), len, C_API_DTYPE_FLOAT64));
+    // R integers are already 32-bit, pass them through without a copy
+    CHECK_CALL(LGBM_DatasetSetField(R_GET_PTR(handle), name, R_INT_PTR(field_data), len, C_API_DTYPE_INT32));
   } else {
-    std::vector<float> vec(len);
-#pragma omp parallel for schedule(static)
-    for (int i = 0; i < len; ++i) {
-      vec[i] = static_cast<float>(R_REAL_PTR(field_data)[i]);
-    }
-    CHECK_CALL(LGBM_DatasetSetField(R_GET_PTR(handle), name, vec.data(), len, C_API_DTYPE_FLOAT32));
+    // label and weight are converted from double directly into the dataset
+    CHECK_CALL(LGBM_DatasetSetField(R_GET_PTR(handle), name, R_REAL_PTR(field_data), len, C_API_DTYPE_FLOAT64));
   }
   R_API_END();
 }
@@ -233,11 +223,7 @@ LGBM_SE LGBM_DatasetGetField_R(LGBM_SE handle,
       R_INT_PTR(field_data)[i] = p_data[i + 1] - p_data[i];
     }
   } else if (!strcmp("init_score", name)) {
-    auto p_data = reinterpret_cast<const double*>(res);
-#pragma omp parallel for schedule(static)
-    for (int i = 0; i < out_len; ++i) {
-      R_REAL_PTR(field_data)[i] = p_data[i];
-    }
+    std::memcpy(R_REAL_PTR(field_data), res, sizeof(double) * out_len);
   } else {
     auto p_data = reinterpret_cast<const float*>(res);
 #pragma omp parallel for schedule(static)
@@ -394,14 +380,13 @@ LGBM_SE LGBM_BoosterUpdateOneIterCustom_R(LGBM_SE handle,
   LGBM_SE call_state) {
   int is_finished = 0;
   R_API_BEGIN();
-  int int_len = R_AS_INT(len);
-  std::vector<float> tgrad(int_len), thess(int_len);
-#pragma omp parallel for schedule(static)
-  for (int j = 0; j < int_len; ++j) {
-    tgrad[j] = static_cast<float>(R_REAL_PTR(grad)[j]);
-    thess[j] = static_cast<float>(R_REAL_PTR(hess)[j]);
+  // the R vectors are read in place, so make sure they cover the whole training data
+  int64_t num_score = 0;
+  CHECK_CALL(LGBM_BoosterGetNumPredict(R_GET_PTR(handle), 0, &num_score));
+  if (static_cast<int64_t>(R_AS_INT(len)) != num_score) {
+    Log::Fatal("Length of custom gradients and Hessians is not same with #data * #class");
   }
-  CHECK_CALL(LGBM_BoosterUpdateOneIterCustom(R_GET_PTR(handle), tgrad.data(), thess.data(), &is_finished));
+  CHECK_CALL(LGBM_BoosterUpdateOneIterCustomFloat64(R_GET_PTR(handle), R_REAL_PTR(grad), R_REAL_PTR(hess), &is_finished));
   R_API_END();
 }
 
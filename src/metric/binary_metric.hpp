@@ -9,8 +9,10 @@
 #include <LightGBM/utils/common.h>
 #include <LightGBM/utils/log.h>
 
+#include <cmath>
 #include <string>
 #include <algorithm>
+#include <limits>
 #include <sstream>
 #include <vector>
 
@@ -92,7 +94,9 @@ class BinaryMetric: public Metric {
         }
       }
     }
-    double loss = sum_loss / sum_weights_;
+    double sum_weights = sum_weights_;
+    GlobalSumIfDistributed(&sum_loss, &sum_weights);
+    double loss = sum_loss / sum_weights;
     return std::vector<double>(1, loss);
   }
 
@@ -192,6 +196,9 @@ class AUCMetric: public Metric {
   }
 
   std::vector<double> Eval(const double* score, const ObjectiveFunction*) const override {
+    if (is_distributed_) {
+      return std::vector<double>(1, DistributedAUC(score));
+    }
     // get indices sorted by score, descent order
     std::vector<data_size_t> sorted_idx;
     for (data_size_t i = 0; i < num_data_; ++i) {
@@ -251,6 +258,62 @@ class AUCMetric: public Metric {
   }
 
  private:
+  /*!
+  * \brief AUC over data partitioned on machines. Sorted scores cannot be merged, so scores are
+  *        bucketed into kNumDistributedBins equal-width bins over the global range of log-squashed scores, and
+  *        the per-bin positive/negative weights are summed over machines. Ties within a bin count 0.5
+  * \param score Local prediction score
+  * \return Global AUC
+  */
+  double DistributedAUC(const double* score) const {
+    // bin on a monotone squash of the score, so that a few huge scores do not collapse the range
+    auto squash = [](double x) { return x >= 0.0f ? std::log1p(x) : -std::log1p(-x); };
+    double min_score = std::numeric_limits<double>::infinity();
+    double max_score = -std::numeric_limits<double>::infinity();
+    for (data_size_t i = 0; i < num_data_; ++i) {
+      if (std::isfinite(score[i])) {
+        min_score = std::min(min_score, squash(score[i]));
+        max_score = std::max(max_score, squash(score[i]));
+      }
+    }
+    min_score = Network::GlobalSyncUpByMin(min_score);
+    max_score = Network::GlobalSyncUpByMax(max_score);
+    const double scale = max_score > min_score ? (kNumDistributedBins - 1) / (max_score - min_score) : 0.0f;
+    // [0, kNumDistributedBins) are positive weights, [kNumDistributedBins, 2 * kNumDistributedBins) are negative ones
+    std::vector<double> hist(2 * kNumDistributedBins, 0.0f);
+    for (data_size_t i = 0; i < num_data_; ++i) {
+      // infinite scores go to the end bins, NaN ones to the lowest bin
+      const double cur_score = std::isnan(score[i]) ? min_score : squash(score[i]);
+      int bin = 0;
+      if (cur_score >= max_score) {
+        bin = kNumDistributedBins - 1;
+      } else if (cur_score > min_score) {
+        bin = std::min(static_cast<int>((cur_score - min_score) * scale), kNumDistributedBins - 1);
+      }
+      const double weight = weights_ == nullptr ? 1.0f : weights_[i];
+      hist[bin + (label_[i] > 0 ? 0 : kNumDistributedBins)] += weight;
+    }
+    GlobalSumIfDistributed(&hist);
+    double sum_pos = 0.0f;
+    double sum_neg = 0.0f;
+    double accum = 0.0f;
+    // from highest score to lowest
+    for (int bin = kNumDistributedBins - 1; bin >= 0; --bin) {
+      const double cur_pos = hist[bin];
+      const double cur_neg = hist[bin + kNumDistributedBins];
+      accum += cur_neg * (cur_pos * 0.5f + sum_pos);
+      sum_pos += cur_pos;
+      sum_neg += cur_neg;
+    }
+    double auc = 1.0f;
+    if (sum_pos > 0.0f && sum_neg > 0.0f) {
+      auc = accum / (sum_pos * sum_neg);
+    }
+    return auc;
+  }
+
+  /*! \brief Number of score bins used by distributed AUC */
+  static const int kNumDistributedBins = 1 << 16;
   /*! \brief Number of data */
   data_size_t num_data_;
   /*! \brief Pointer of label */
@@ -136,13 +136,19 @@ class MapMetric:public Metric {
         }
       }
     }
-    // Get final average MAP
-    std::vector<double> result(eval_at_.size(), 0.0f);
-    for (size_t j = 0; j < result.size(); ++j) {
+    // Get final average MAP, the last element is the sum weights of queries
+    std::vector<double> result(eval_at_.size() + 1, 0.0f);
+    for (size_t j = 0; j < eval_at_.size(); ++j) {
       for (int i = 0; i < num_threads_; ++i) {
         result[j] += result_buffer_[i][j];
       }
-      result[j] /= sum_query_weights_;
+    }
+    result.back() = sum_query_weights_;
+    GlobalSumIfDistributed(&result);
+    const double sum_query_weights = result.back();
+    result.pop_back();
+    for (size_t j = 0; j < result.size(); ++j) {
+      result[j] /= sum_query_weights;
     }
     return result;
   }
@@ -114,7 +114,9 @@ class MulticlassMetric: public Metric {
         }
       }
     }
-    double loss = sum_loss / sum_weights_;
+    double sum_weights = sum_weights_;
+    GlobalSumIfDistributed(&sum_loss, &sum_weights);
+    double loss = sum_loss / sum_weights;
     return std::vector<double>(1, loss);
   }
 
@@ -208,6 +210,12 @@ class AucMuMetric : public Metric {
       [this](data_size_t a, data_size_t b) { return label_[a] < label_[b]; });
   }
 
+  void SetDistributed(bool is_distributed) override {
+    if (is_distributed && Network::num_machines() > 1) {
+      Log::Warning("auc_mu cannot be merged over machines, it is evaluated on the local data only");
+    }
+  }
+
   std::vector<double> Eval(const double* score, const ObjectiveFunction*) const override {
     // the notation follows that used in the paper introducing the auc-mu metric:
     // http://proceedings.mlr.press/v97/kleiman19a/kleiman19a.pdf
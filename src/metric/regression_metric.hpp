@@ -90,7 +90,9 @@ class RegressionMetric: public Metric {
         }
       }
     }
-    double loss = PointWiseLossCalculator::AverageLoss(sum_loss, sum_weights_);
+    double sum_weights = sum_weights_;
+    GlobalSumIfDistributed(&sum_loss, &sum_weights);
+    double loss = PointWiseLossCalculator::AverageLoss(sum_loss, sum_weights);
     return std::vector<double>(1, loss);
   }
 
@@ -134,7 +134,9 @@ class CrossEntropyMetric : public Metric {
         }
       }
     }
-    double loss = sum_loss / sum_weights_;
+    double sum_weights = sum_weights_;
+    GlobalSumIfDistributed(&sum_loss, &sum_weights);
+    double loss = sum_loss / sum_weights;
     return std::vector<double>(1, loss);
   }
 
@@ -221,7 +223,9 @@ class CrossEntropyLambdaMetric : public Metric {
         }
       }
     }
-    return std::vector<double>(1, sum_loss / static_cast<double>(num_data_));
+    double num_data = static_cast<double>(num_data_);
+    GlobalSumIfDistributed(&sum_loss, &num_data);
+    return std::vector<double>(1, sum_loss / num_data);
   }
 
   const std::vector<std::string>& GetName() const override {
@@ -328,7 +332,11 @@ class KullbackLeiblerDivergence : public Metric {
         }
       }
     }
-    double loss = presum_label_entropy_ + sum_loss / sum_weights_;
+    // the offset term is averaged locally, so merge it by its sum
+    sum_loss += presum_label_entropy_ * sum_weights_;
+    double sum_weights = sum_weights_;
+    GlobalSumIfDistributed(&sum_loss, &sum_weights);
+    double loss = sum_loss / sum_weights;
     return std::vector<double>(1, loss);
   }
 
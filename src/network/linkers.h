@@ -155,6 +155,38 @@ class Linkers {
   */
   static void MpiAbortIfIsParallel();
 
+  /*!
+  * \brief Allgather by MPI_Allgatherv
+  * \param input Input data
+  * \param block_start Start position of the block of every rank in output
+  * \param block_len Length of the block of every rank
+  * \param output Output result, input can be a part of it
+  * \param all_size Size of output data
+  */
+  void Allgather(char* input, const comm_size_t* block_start, const comm_size_t* block_len, char* output, comm_size_t all_size);
+
+  /*!
+  * \brief Reduce scatter by MPI_Reduce_scatter, blocks should be contiguous, ordered by rank and in whole elements
+  * \param input Input data
+  * \param input_size Size of input data
+  * \param type_size Size of one element
+  * \param block_len Length of the block of every rank
+  * \param output Output result
+  * \param reducer Reduce function
+  */
+  void ReduceScatter(char* input, comm_size_t input_size, int type_size,
+                     const comm_size_t* block_len, char* output, const ReduceFunction& reducer);
+
+  /*!
+  * \brief Allreduce by MPI_Allreduce
+  * \param input Input data
+  * \param input_size Size of input data
+  * \param type_size Size of one element
+  * \param output Output result, can be the same as input
+  * \param reducer Reduce function
+  */
+  void Allreduce(char* input, comm_size_t input_size, int type_size, char* output, const ReduceFunction& reducer);
+
   #endif
   private:
   /*! \brief Rank of local machine */
@@ -184,6 +216,15 @@ class Linkers {
   /*! \brief Local socket listener */
   std::unique_ptr<TcpSocket> listener_;
   #endif  // USE_SOCKET
+
+  #ifdef USE_MPI
+  /*! \brief MPI operation calling the reducer of the running collective */
+  static void MpiReduce(void* input, void* output, int* len, MPI_Datatype* datatype);
+  /*! \brief Reducer of the running collective, since MPI operations cannot carry state */
+  static ReduceFunction mpi_reducer_;
+  /*! \brief MPI operation of MpiReduce */
+  MPI_Op reduce_op_;
+  #endif  // USE_MPI
 };
 
 
@@ -4,10 +4,15 @@
  */
 #ifdef USE_MPI
 
+#include <cstring>
+#include <vector>
+
 #include "linkers.h"
 
 namespace LightGBM {
 
+ReduceFunction Linkers::mpi_reducer_ = nullptr;
+
 Linkers::Linkers(Config) {
   is_init_ = false;
   int argc = 0;
@@ -23,12 +28,67 @@ Linkers::Linkers(Config) {
   MPI_SAFE_CALL(MPI_Barrier(MPI_COMM_WORLD));
   bruck_map_ = BruckMap::Construct(rank_, num_machines_);
   recursive_halving_map_ = RecursiveHalvingMap::Construct(rank_, num_machines_);
+  // reducers are commutative
+  MPI_SAFE_CALL(MPI_Op_create(&Linkers::MpiReduce, 1, &reduce_op_));
   is_init_ = true;
 }
 
 Linkers::~Linkers() {
   // Don't call MPI_Finalize() here: If the destructor was called because only this node had an exception, calling MPI_Finalize() will cause all nodes to hang.
   // Instead we will handle finalize/abort for MPI in main().
+  if (is_init_) {
+    int is_finalized = 0;
+    MPI_Finalized(&is_finalized);
+    if (!is_finalized) {
+      MPI_Op_free(&reduce_op_);
+    }
+  }
+}
+
+void Linkers::MpiReduce(void* input, void* output, int* len, MPI_Datatype* datatype) {
+  int type_size = 0;
+  MPI_SAFE_CALL(MPI_Type_size(*datatype, &type_size));
+  mpi_reducer_(reinterpret_cast<const char*>(input), reinterpret_cast<char*>(output),
+               type_size, static_cast<comm_size_t>(*len) * type_size);
+}
+
+void Linkers::Allgather(char* input, const comm_size_t* block_start, const comm_size_t* block_len,
+                        char* output, comm_size_t) {
+  auto start_time = std::chrono::high_resolution_clock::now();
+  // input may overlap with output, gather in place
+  std::memmove(output + block_start[rank_], input, block_len[rank_]);
+  MPI_SAFE_CALL(MPI_Allgatherv(MPI_IN_PLACE, 0, MPI_DATATYPE_NULL,
+                               output, const_cast<comm_size_t*>(block_len), const_cast<comm_size_t*>(block_start),
+                               MPI_BYTE, MPI_COMM_WORLD));
+  network_time_ += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start_time);
+}
+
+void Linkers::ReduceScatter(char* input, comm_size_t, int type_size,
+                            const comm_size_t* block_len, char* output, const ReduceFunction& reducer) {
+  auto start_time = std::chrono::high_resolution_clock::now();
+  std::vector<int> recv_counts(num_machines_);
+  for (int i = 0; i < num_machines_; ++i) {
+    recv_counts[i] = block_len[i] / type_size;
+  }
+  MPI_Datatype datatype;
+  MPI_SAFE_CALL(MPI_Type_contiguous(type_size, MPI_BYTE, &datatype));
+  MPI_SAFE_CALL(MPI_Type_commit(&datatype));
+  mpi_reducer_ = reducer;
+  MPI_SAFE_CALL(MPI_Reduce_scatter(input, output, recv_counts.data(), datatype, reduce_op_, MPI_COMM_WORLD));
+  MPI_SAFE_CALL(MPI_Type_free(&datatype));
+  network_time_ += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start_time);
+}
+
+void Linkers::Allreduce(char* input, comm_size_t input_size, int type_size, char* output, const ReduceFunction& reducer) {
+  auto start_time = std::chrono::high_resolution_clock::now();
+  MPI_Datatype datatype;
+  MPI_SAFE_CALL(MPI_Type_contiguous(type_size, MPI_BYTE, &datatype));
+  MPI_SAFE_CALL(MPI_Type_commit(&datatype));
+  mpi_reducer_ = reducer;
+  MPI_SAFE_CALL(MPI_Allreduce(input == output ? MPI_IN_PLACE : input, output, input_size / type_size,
+                              datatype, reduce_op_, MPI_COMM_WORLD));
+  MPI_SAFE_CALL(MPI_Type_free(&datatype));
+  network_time_ += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start_time);
 }
 
 bool Linkers::IsMpiInitialized() {
@@ -69,6 +69,11 @@ void Network::Allreduce(char* input, comm_size_t input_size, int type_size, char
   if (num_machines_ <= 1) {
     Log::Fatal("Please initilize the network interface first");
   }
+#ifdef USE_MPI
+  if (reduce_scatter_ext_fun_ == nullptr && allgather_ext_fun_ == nullptr) {
+    return linkers_->Allreduce(input, input_size, type_size, output, reducer);
+  }
+#endif  // USE_MPI
   comm_size_t count = input_size / type_size;
   // if small package or small count , do it by all gather.(reduce the communication times.)
   if (count < num_machines_ || input_size < 4096) {
@@ -141,6 +146,9 @@ void Network::Allgather(char* input, const comm_size_t* block_start, const comm_
   if (allgather_ext_fun_ != nullptr) {
     return allgather_ext_fun_(input, block_len[rank_], block_start, block_len, num_machines_, output, all_size);
   }
+#ifdef USE_MPI
+  return linkers_->Allgather(input, block_start, block_len, output, all_size);
+#endif  // USE_MPI
   const comm_size_t kRingThreshold = 10 * 1024 * 1024;  // 10MB
   const int kRingNodeThreshold = 64;
   if (all_size > kRingThreshold && num_machines_ < kRingNodeThreshold) {
@@ -238,6 +246,18 @@ void Network::ReduceScatter(char* input, comm_size_t input_size, int type_size,
   if (reduce_scatter_ext_fun_ != nullptr) {
     return reduce_scatter_ext_fun_(input, input_size, type_size, block_start, block_len, num_machines_, output, output_size, reducer);
   }
+#ifdef USE_MPI
+  // MPI_Reduce_scatter needs contiguous blocks ordered by rank, in whole elements
+  bool is_mpi_layout = true;
+  comm_size_t cur_start = 0;
+  for (int i = 0; i < num_machines_ && is_mpi_layout; ++i) {
+    is_mpi_layout = block_start[i] == cur_start && block_len[i] % type_size == 0;
+    cur_start += block_len[i];
+  }
+  if (is_mpi_layout && cur_start == input_size) {
+    return linkers_->ReduceScatter(input, input_size, type_size, block_len, output, reducer);
+  }
+#endif  // USE_MPI
   const comm_size_t kRingThreshold = 10 * 1024 * 1024;  // 10MB
   if (recursive_halving_map_.is_power_of_2 || input_size < kRingThreshold) {
     ReduceScatterRecursiveHalving(input, input_size, type_size, block_start, block_len, output, output_size, reducer);
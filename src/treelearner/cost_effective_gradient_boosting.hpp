@@ -10,6 +10,8 @@
 #include <LightGBM/utils/common.h>
 #include <LightGBM/utils/log.h>
 
+#include <string>
+#include <utility>
 #include <vector>
 
 #include "data_partition.hpp"
@@ -84,6 +86,25 @@ class CostEfficientGradientBoosting {
     }
   }
 
+  /*! \brief Append the features and data already paid for to state */
+  void SaveState(std::string* state) const {
+    std::vector<int8_t> is_used(is_feature_used_in_split_.begin(), is_feature_used_in_split_.end());
+    Common::AppendToBinary(is_used, state);
+    Common::AppendToBinary(feature_used_in_data_, state);
+  }
+
+  bool LoadState(const std::string& state, size_t* pos) {
+    std::vector<int8_t> is_used;
+    std::vector<uint32_t> used_in_data;
+    if (!Common::ReadFromBinary(state, pos, &is_used) || !Common::ReadFromBinary(state, pos, &used_in_data)
+        || is_used.size() != is_feature_used_in_split_.size() || used_in_data.size() != feature_used_in_data_.size()) {
+      return false;
+    }
+    is_feature_used_in_split_.assign(is_used.begin(), is_used.end());
+    feature_used_in_data_ = std::move(used_in_data);
+    return true;
+  }
+
  private:
   double CalculateOndemandCosts(int feature_index, int real_fidx, int leaf_index) const {
     if (tree_learner_->config_->cegb_penalty_feature_lazy.empty()) {
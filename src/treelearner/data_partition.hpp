@@ -14,6 +14,10 @@
 #include <vector>
 
 namespace LightGBM {
+
+/*! \brief Leaf id of the data that are in no leaf kept as leaf ids */
+const uint8_t kNoLeafId = 255;
+
 /*!
 * \brief DataPartition is used to store the the partition of data on tree.
 */
@@ -23,6 +27,7 @@ class DataPartition {
     :num_data_(num_data), num_leaves_(num_leaves) {
     leaf_begin_.resize(num_leaves_);
     leaf_count_.resize(num_leaves_);
+    leaf_id_of_leaf_.resize(num_leaves_, -1);
     indices_.resize(num_data_);
     temp_left_indices_.resize(num_data_);
     temp_right_indices_.resize(num_data_);
@@ -43,12 +48,32 @@ class DataPartition {
     num_leaves_ = num_leaves;
     leaf_begin_.resize(num_leaves_);
     leaf_count_.resize(num_leaves_);
+    leaf_id_of_leaf_.assign(num_leaves_, -1);
   }
   void ResetNumData(int num_data) {
     num_data_ = num_data;
     indices_.resize(num_data_);
     temp_left_indices_.resize(num_data_);
     temp_right_indices_.resize(num_data_);
+    if (leaf_id_min_count_ > 0) {
+      leaf_ids_.resize(num_data_);
+    }
+  }
+
+  /*!
+  * \brief Keep the leaves with many data as a leaf id per data instead of an index list,
+  *        so their splits and histograms scan the data sequentially instead of moving and gathering indices
+  * \param min_count Minimal number of data of such leaves, <= 0 to use index lists only
+  */
+  void SetLeafIdMinCount(data_size_t min_count) {
+    leaf_id_min_count_ = min_count;
+    if (leaf_id_min_count_ > 0) {
+      leaf_ids_.resize(num_data_);
+    } else {
+      leaf_ids_.clear();
+      leaf_ids_.shrink_to_fit();
+    }
+    std::fill(leaf_id_of_leaf_.begin(), leaf_id_of_leaf_.end(), -1);
   }
   ~DataPartition() {
   }
@@ -59,6 +84,8 @@ class DataPartition {
   void Init() {
     std::fill(leaf_begin_.begin(), leaf_begin_.end(), 0);
     std::fill(leaf_count_.begin(), leaf_count_.end(), 0);
+    std::fill(leaf_id_of_leaf_.begin(), leaf_id_of_leaf_.end(), -1);
+    num_used_leaf_ids_ = 0;
     if (used_data_indices_ == nullptr) {
       // if using all data
       leaf_count_[0] = num_data_;
@@ -71,10 +98,15 @@ class DataPartition {
       leaf_count_[0] = used_data_count_;
       std::memcpy(indices_.data(), used_data_indices_, used_data_count_ * sizeof(data_size_t));
     }
+    // the root keeps its index list, leaf ids are given to its descendants with many data
+    if (leaf_id_min_count_ > 0) {
+      std::memset(leaf_ids_.data(), kNoLeafId, num_data_ * sizeof(uint8_t));
+    }
   }
 
   void ResetByLeafPred(const std::vector<int>& leaf_pred, int num_leaves) {
     ResetLeaves(num_leaves);
+    num_used_leaf_ids_ = 0;
     std::vector<std::vector<data_size_t>> indices_per_leaf(num_leaves_);
     for (data_size_t i = 0; i < static_cast<data_size_t>(leaf_pred.size()); ++i) {
       indices_per_leaf[leaf_pred[i]].push_back(i);
@@ -89,7 +121,7 @@ class DataPartition {
   }
 
   /*!
-  * \brief Get the data indices of one leaf
+  * \brief Get the data indices of one leaf, the leaves kept as leaf ids need FillIndexLists first
   * \param leaf index of leaf
   * \param indices output data indices
   * \return number of data on this leaf
@@ -113,8 +145,11 @@ class DataPartition {
     // get leaf boundary
     const data_size_t begin = leaf_begin_[leaf];
     const data_size_t cnt = leaf_count_[leaf];
+    // a leaf kept as leaf ids has no index list, its data are collected from all data
+    const bool is_by_id = leaf_id_of_leaf_[leaf] >= 0;
+    const data_size_t num_scanned = is_by_id ? num_data_ : cnt;
 
-    data_size_t inner_size = (cnt + num_threads_ - 1) / num_threads_;
+    data_size_t inner_size = (num_scanned + num_threads_ - 1) / num_threads_;
     if (inner_size < min_inner_size) { inner_size = min_inner_size; }
     // split data multi-threading
     OMP_INIT_EX();
@@ -124,11 +159,24 @@ class DataPartition {
       left_cnts_buf_[i] = 0;
       right_cnts_buf_[i] = 0;
       data_size_t cur_start = i * inner_size;
-      if (cur_start > cnt) { continue; }
+      if (cur_start > num_scanned) { continue; }
       data_size_t cur_cnt = inner_size;
-      if (cur_start + cur_cnt > cnt) { cur_cnt = cnt - cur_start; }
+      if (cur_start + cur_cnt > num_scanned) { cur_cnt = num_scanned - cur_start; }
+      data_size_t* cur_indices = indices_.data() + begin + cur_start;
+      if (is_by_id) {
+        const uint8_t leaf_id = static_cast<uint8_t>(leaf_id_of_leaf_[leaf]);
+        const data_size_t cur_end = cur_start + cur_cnt;
+        // branch free, the next index overwrites the ones not in the leaf.
+        // The less or equal indices are stored on the collected ones, as the bins read each index before writing it
+        cur_indices = temp_left_indices_.data() + cur_start;
+        cur_cnt = 0;
+        for (data_size_t j = cur_start; j < cur_end; ++j) {
+          cur_indices[cur_cnt] = j;
+          cur_cnt += leaf_ids_[j] == leaf_id;
+        }
+      }
       // split data inner, reduce the times of function called
-      data_size_t cur_left_count = dataset->Split(feature, threshold, num_threshold, default_left, indices_.data() + begin + cur_start, cur_cnt,
+      data_size_t cur_left_count = dataset->Split(feature, threshold, num_threshold, default_left, cur_indices, cur_cnt,
                                                   temp_left_indices_.data() + cur_start, temp_right_indices_.data() + cur_start);
       offsets_buf_[i] = cur_start;
       left_cnts_buf_[i] = cur_left_count;
@@ -144,22 +192,87 @@ class DataPartition {
       right_write_pos_buf_[i] = right_write_pos_buf_[i - 1] + right_cnts_buf_[i - 1];
     }
     left_cnt = left_write_pos_buf_[num_threads_ - 1] + left_cnts_buf_[num_threads_ - 1];
+    // children with many data are kept as leaf ids, the left one keeps the leaf id of a parent kept as leaf ids.
+    // Leaf ids are not reused within a tree, so the data of the other leaves never have the id of a live one
+    const bool is_left_by_id = leaf_id_min_count_ > 0 && left_cnt >= leaf_id_min_count_
+      && (is_by_id || num_used_leaf_ids_ < kNoLeafId);
+    const int left_leaf_id = !is_left_by_id ? -1 : (is_by_id ? leaf_id_of_leaf_[leaf] : num_used_leaf_ids_++);
+    const bool is_right_by_id = leaf_id_min_count_ > 0 && cnt - left_cnt >= leaf_id_min_count_
+      && num_used_leaf_ids_ < kNoLeafId;
+    const int right_leaf_id = is_right_by_id ? num_used_leaf_ids_++ : -1;
+    const bool is_left_labeled = is_left_by_id && !is_by_id;
+    const bool is_right_labeled = is_right_by_id || (is_left_by_id && is_by_id);
+    const uint8_t right_label = is_right_by_id ? static_cast<uint8_t>(right_leaf_id) : kNoLeafId;
     // copy back indices of right leaf to indices_
     #pragma omp parallel for schedule(static, 1)
     for (int i = 0; i < num_threads_; ++i) {
       if (left_cnts_buf_[i] > 0) {
-        std::memcpy(indices_.data() + begin + left_write_pos_buf_[i],
-                    temp_left_indices_.data() + offsets_buf_[i], left_cnts_buf_[i] * sizeof(data_size_t));
+        const data_size_t* left_indices = temp_left_indices_.data() + offsets_buf_[i];
+        if (!is_left_by_id) {
+          std::memcpy(indices_.data() + begin + left_write_pos_buf_[i], left_indices, left_cnts_buf_[i] * sizeof(data_size_t));
+        } else if (is_left_labeled) {
+          for (data_size_t j = 0; j < left_cnts_buf_[i]; ++j) {
+            leaf_ids_[left_indices[j]] = static_cast<uint8_t>(left_leaf_id);
+          }
+        }
       }
       if (right_cnts_buf_[i] > 0) {
-        std::memcpy(indices_.data() + begin + left_cnt + right_write_pos_buf_[i],
-                    temp_right_indices_.data() + offsets_buf_[i], right_cnts_buf_[i] * sizeof(data_size_t));
+        const data_size_t* right_indices = temp_right_indices_.data() + offsets_buf_[i];
+        if (!is_right_by_id) {
+          std::memcpy(indices_.data() + begin + left_cnt + right_write_pos_buf_[i], right_indices,
+                      right_cnts_buf_[i] * sizeof(data_size_t));
+        }
+        if (is_right_labeled) {
+          for (data_size_t j = 0; j < right_cnts_buf_[i]; ++j) {
+            leaf_ids_[right_indices[j]] = right_label;
+          }
+        }
       }
     }
     // update leaf boundary
     leaf_count_[leaf] = left_cnt;
     leaf_begin_[right_leaf] = left_cnt + begin;
     leaf_count_[right_leaf] = cnt - left_cnt;
+    leaf_id_of_leaf_[leaf] = left_leaf_id;
+    leaf_id_of_leaf_[right_leaf] = right_leaf_id;
+  }
+
+  /*!
+  * \brief Fill the index lists of the leaves kept as leaf ids, afterwards all leaves use index lists
+  */
+  void FillIndexLists() {
+    const data_size_t min_inner_size = 512;
+    data_size_t inner_size = (num_data_ + num_threads_ - 1) / num_threads_;
+    if (inner_size < min_inner_size) { inner_size = min_inner_size; }
+    for (int leaf = 0; leaf < num_leaves_; ++leaf) {
+      if (leaf_id_of_leaf_[leaf] < 0) { continue; }
+      const uint8_t leaf_id = static_cast<uint8_t>(leaf_id_of_leaf_[leaf]);
+      #pragma omp parallel for schedule(static, 1)
+      for (int i = 0; i < num_threads_; ++i) {
+        left_cnts_buf_[i] = 0;
+        const data_size_t cur_start = i * inner_size;
+        const data_size_t cur_end = std::min(num_data_, cur_start + inner_size);
+        for (data_size_t j = cur_start; j < cur_end; ++j) {
+          left_cnts_buf_[i] += leaf_ids_[j] == leaf_id;
+        }
+      }
+      left_write_pos_buf_[0] = 0;
+      for (int i = 1; i < num_threads_; ++i) {
+        left_write_pos_buf_[i] = left_write_pos_buf_[i - 1] + left_cnts_buf_[i - 1];
+      }
+      #pragma omp parallel for schedule(static, 1)
+      for (int i = 0; i < num_threads_; ++i) {
+        data_size_t* out = indices_.data() + leaf_begin_[leaf] + left_write_pos_buf_[i];
+        const data_size_t cur_start = i * inner_size;
+        const data_size_t cur_end = std::min(num_data_, cur_start + inner_size);
+        for (data_size_t j = cur_start; j < cur_end; ++j) {
+          if (leaf_ids_[j] == leaf_id) {
+            *out++ = j;
+          }
+        }
+      }
+      leaf_id_of_leaf_[leaf] = -1;
+    }
   }
 
   /*!
@@ -188,9 +301,28 @@ class DataPartition {
 
   const data_size_t* indices() const { return indices_.data(); }
 
+  /*!
+  * \brief Get the leaf id of the data of one leaf
+  * \param leaf index of leaf
+  * \return leaf id, or -1 if the leaf uses an index list
+  */
+  int leaf_id(int leaf) const { return leaf_id_of_leaf_[leaf]; }
+
+  /*! \brief Leaf id of each data, only valid for the data of the leaves with leaf_id(leaf) >= 0 */
+  const uint8_t* leaf_ids() const { return leaf_ids_.data(); }
+
   /*! \brief Get number of leaves */
   int num_leaves() const { return num_leaves_; }
 
+  /*! \brief Get sizes in byte of this object */
+  size_t SizesInByte() const {
+    return sizeof(data_size_t) * (leaf_begin_.size() + leaf_count_.size() + indices_.size()
+                                  + temp_left_indices_.size() + temp_right_indices_.size()
+                                  + offsets_buf_.size() + left_cnts_buf_.size() + right_cnts_buf_.size()
+                                  + left_write_pos_buf_.size() + right_write_pos_buf_.size())
+      + sizeof(uint8_t) * leaf_ids_.size() + sizeof(int) * leaf_id_of_leaf_.size();
+  }
+
  private:
   /*! \brief Number of all data */
   data_size_t num_data_;
@@ -222,6 +354,14 @@ class DataPartition {
   std::vector<data_size_t> left_write_pos_buf_;
   /*! \brief Buffer for multi-threading data partition, used to store write position of right leaf for different threads */
   std::vector<data_size_t> right_write_pos_buf_;
+  /*! \brief Leaf id of each data, for the leaves with at least leaf_id_min_count_ data */
+  std::vector<uint8_t> leaf_ids_;
+  /*! \brief Leaf id of each leaf, -1 for the leaves using index lists */
+  std::vector<int> leaf_id_of_leaf_;
+  /*! \brief Number of leaf ids given out in the current tree, they are not reused within a tree */
+  int num_used_leaf_ids_ = 0;
+  /*! \brief Minimal number of data of the leaves kept as leaf ids, <= 0 means index lists only */
+  data_size_t leaf_id_min_count_ = 0;
 };
 
 }  // namespace LightGBM
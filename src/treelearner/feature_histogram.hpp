@@ -727,6 +727,12 @@ class HistogramPool {
     if (cache_size > old_cache_size) {
       pool_.resize(cache_size);
       data_.resize(cache_size);
+    } else if (cache_size < old_cache_size) {
+      // release the slots that are no longer used
+      pool_.resize(cache_size);
+      pool_.shrink_to_fit();
+      data_.resize(cache_size);
+      data_.shrink_to_fit();
     }
 
     OMP_INIT_EX();
@@ -761,6 +767,24 @@ class HistogramPool {
       feature_metas_[i].penalty = train_data_->FeaturePenalte(i);
     }
   }
+  /*! \brief Number of histograms that can be cached */
+  int cache_size() const { return cache_size_; }
+
+  /*!
+  * \brief Get sizes in byte of this object
+  */
+  size_t SizesInByte() const {
+    size_t ret = sizeof(FeatureMetainfo) * feature_metas_.size()
+      + sizeof(int) * (mapper_.size() + inverse_mapper_.size() + last_used_time_.size());
+    for (size_t i = 0; i < data_.size(); ++i) {
+      ret += sizeof(HistogramBinEntry) * data_[i].capacity();
+    }
+    if (train_data_ != nullptr) {
+      ret += sizeof(FeatureHistogram) * pool_.size() * train_data_->num_features();
+    }
+    return ret;
+  }
+
   /*!
   * \brief Get data for the specific index
   * \param idx which index want to get
@@ -827,7 +851,7 @@ class HistogramPool {
   std::vector<int> inverse_mapper_;
   std::vector<int> last_used_time_;
   int cur_time_ = 0;
-  const Dataset* train_data_;
+  const Dataset* train_data_ = nullptr;
 };
 
 }  // namespace LightGBM
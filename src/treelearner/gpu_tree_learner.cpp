@@ -953,6 +953,11 @@ bool GPUTreeLearner::ConstructGPUHistogramsAsync(
   return true;
 }
 
+void GPUTreeLearner::ChooseHistogramSources(const std::vector<int8_t>& is_feature_used, bool use_subtract) {
+  // the dense feature groups are built on the GPU for all used features
+  SetDefaultHistogramSources(is_feature_used, use_subtract);
+}
+
 void GPUTreeLearner::ConstructHistograms(const std::vector<int8_t>& is_feature_used, bool use_subtract) {
   std::vector<int8_t> is_sparse_feature_used(num_features_, 0);
   std::vector<int8_t> is_dense_feature_used(num_features_, 0);
@@ -979,7 +984,8 @@ void GPUTreeLearner::ConstructHistograms(const std::vector<int8_t>& is_feature_u
     nullptr, smaller_leaf_splits_->num_data_in_leaf(),
     smaller_leaf_splits_->LeafIndex(),
     &ordered_bins_, gradients_, hessians_,
-    ordered_gradients_.data(), ordered_hessians_.data(), is_constant_hessian_,
+    ordered_gradients_.data(), ordered_hessians_.data(),
+    row_block_histograms_.data(), is_constant_hessian_,
     ptr_smaller_leaf_hist_data);
   // wait for GPU to finish, only if GPU is actually used
   if (is_gpu_used) {
@@ -1032,7 +1038,8 @@ void GPUTreeLearner::ConstructHistograms(const std::vector<int8_t>& is_feature_u
       nullptr, larger_leaf_splits_->num_data_in_leaf(),
       larger_leaf_splits_->LeafIndex(),
       &ordered_bins_, gradients_, hessians_,
-      ordered_gradients_.data(), ordered_hessians_.data(), is_constant_hessian_,
+      ordered_gradients_.data(), ordered_hessians_.data(),
+      row_block_histograms_.data(), is_constant_hessian_,
       ptr_larger_leaf_hist_data);
     // wait for GPU to finish, only if GPU is actually used
     if (is_gpu_used) {
@@ -68,6 +68,7 @@ class GPUTreeLearner: public SerialTreeLearner {
   bool BeforeFindBestSplit(const Tree* tree, int left_leaf, int right_leaf) override;
   void FindBestSplits() override;
   void Split(Tree* tree, int best_Leaf, int* left_leaf, int* right_leaf) override;
+  void ChooseHistogramSources(const std::vector<int8_t>& is_feature_used, bool use_subtract) override;
   void ConstructHistograms(const std::vector<int8_t>& is_feature_used, bool use_subtract) override;
 
  private:
@@ -10,6 +10,7 @@
 #include <LightGBM/utils/common.h>
 
 #include <algorithm>
+#include <limits>
 #include <queue>
 #include <unordered_map>
 #include <utility>
@@ -88,10 +89,18 @@ void SerialTreeLearner::Init(const Dataset* train_data, bool is_constant_hessian
   // initialize data partition
   data_partition_.reset(new DataPartition(num_data_, config_->num_leaves));
   is_feature_used_.resize(num_features_);
+  is_feature_used_in_split_.resize(num_features_);
+  smaller_node_used_features_.resize(num_features_);
+  larger_node_used_features_.resize(num_features_);
+  smaller_best_per_thread_.resize(num_threads_);
+  larger_best_per_thread_.resize(num_threads_);
+  feature_best_gain_.assign(num_features_, kMinScore);
+  ResetFeaturePruning();
   valid_feature_indices_ = train_data_->ValidFeatureIndices();
   // initialize ordered gradients and hessians
   ordered_gradients_.resize(num_data_);
   ordered_hessians_.resize(num_data_);
+  row_block_histograms_.resize(train_data_->NumRowBlockHistogramEntries());
   // if has ordered bin, need to allocate a buffer to fast split
   if (has_ordered_bin_) {
     is_data_in_leaf_.resize(num_data_);
@@ -103,14 +112,20 @@ void SerialTreeLearner::Init(const Dataset* train_data, bool is_constant_hessian
       }
     }
   }
+  InitHistogramCostModel();
   Log::Info("Number of data points in the train set: %d, number of used features: %d", num_data_, num_features_);
   if (CostEfficientGradientBoosting::IsEnable(config_)) {
     cegb_.reset(new CostEfficientGradientBoosting(this));
     cegb_->Init();
   }
+  ResetLeafIdPartition();
 }
 
 void SerialTreeLearner::ResetTrainingData(const Dataset* train_data) {
+  // a new training set, bagging passes the same subset every time
+  if (train_data != train_data_) {
+    ResetFeaturePruning();
+  }
   train_data_ = train_data;
   num_data_ = train_data_->num_data();
   CHECK(num_features_ == train_data_->num_features());
@@ -128,17 +143,24 @@ void SerialTreeLearner::ResetTrainingData(const Dataset* train_data) {
   // initialize ordered gradients and hessians
   ordered_gradients_.resize(num_data_);
   ordered_hessians_.resize(num_data_);
+  row_block_histograms_.resize(train_data_->NumRowBlockHistogramEntries());
   // if has ordered bin, need to allocate a buffer to fast split
   if (has_ordered_bin_) {
     is_data_in_leaf_.resize(num_data_);
     std::fill(is_data_in_leaf_.begin(), is_data_in_leaf_.end(), static_cast<char>(0));
   }
+  InitHistogramCostModel();
   if (cegb_ != nullptr) {
     cegb_->Init();
   }
+  ResetLeafIdPartition();
 }
 
 void SerialTreeLearner::ResetConfig(const Config* config) {
+  const bool is_pruning_changed = config_->feature_pruning_rounds != config->feature_pruning_rounds
+                                  || config_->feature_pruning_gain_ratio != config->feature_pruning_gain_ratio
+                                  || config_->feature_pruning_recheck_freq != config->feature_pruning_recheck_freq
+                                  || config_->num_class != config->num_class;
   if (config_->num_leaves != config->num_leaves) {
     config_ = config;
     int max_cache_size = 0;
@@ -168,6 +190,19 @@ void SerialTreeLearner::ResetConfig(const Config* config) {
     cegb_.reset(new CostEfficientGradientBoosting(this));
     cegb_->Init();
   }
+  if (is_pruning_changed) {
+    ResetFeaturePruning();
+  }
+  ResetLeafIdPartition();
+}
+
+void SerialTreeLearner::ResetLeafIdPartition() {
+  data_size_t min_count = 0;
+  // ordered bins and the lazy feature penalty of CEGB need the index lists of all leaves
+  if (config_->leaf_id_partition_fraction > 0.0 && !has_ordered_bin_ && config_->cegb_penalty_feature_lazy.empty()) {
+    min_count = std::max<data_size_t>(1, static_cast<data_size_t>(std::ceil(config_->leaf_id_partition_fraction * num_data_)));
+  }
+  data_partition_->SetLeafIdMinCount(min_count);
 }
 
 Tree* SerialTreeLearner::Train(const score_t* gradients, const score_t *hessians, bool is_constant_hessian, const Json& forced_split_json) {
@@ -193,46 +228,67 @@ Tree* SerialTreeLearner::Train(const score_t* gradients, const score_t *hessians
 
   int init_splits = 0;
   bool aborted_last_force_split = false;
+  num_constructed_histograms_ = 0;
+  num_subtracted_histograms_ = 0;
+  num_skipped_histograms_ = 0;
+  num_leaf_id_histograms_ = 0;
   if (!forced_split_json.is_null()) {
+    is_forcing_splits_ = true;
     init_splits = ForceSplits(tree.get(), forced_split_json, &left_leaf,
                               &right_leaf, &cur_depth, &aborted_last_force_split);
+    is_forcing_splits_ = false;
   }
 
-  for (int split = init_splits; split < config_->num_leaves - 1; ++split) {
-    #ifdef TIMETAG
-    start_time = std::chrono::steady_clock::now();
-    #endif
-    // some initial works before finding best split
-    if (!aborted_last_force_split && BeforeFindBestSplit(tree.get(), left_leaf, right_leaf)) {
+  if (config_->leaf_batch_size > 1) {
+    GrowLeafBatches(tree.get(), left_leaf, right_leaf, aborted_last_force_split, &cur_depth);
+  } else {
+    for (int split = init_splits; split < config_->num_leaves - 1; ++split) {
       #ifdef TIMETAG
-      init_split_time += std::chrono::steady_clock::now() - start_time;
+      start_time = std::chrono::steady_clock::now();
       #endif
-      // find best threshold for every feature
-      FindBestSplits();
-    } else if (aborted_last_force_split) {
-      aborted_last_force_split = false;
-    }
+      // some initial works before finding best split
+      if (!aborted_last_force_split && BeforeFindBestSplit(tree.get(), left_leaf, right_leaf)) {
+        #ifdef TIMETAG
+        init_split_time += std::chrono::steady_clock::now() - start_time;
+        #endif
+        // find best threshold for every feature
+        FindBestSplits();
+      } else if (aborted_last_force_split) {
+        aborted_last_force_split = false;
+      }
 
-    // Get a leaf with max split gain
-    int best_leaf = static_cast<int>(ArrayArgs<SplitInfo>::ArgMax(best_split_per_leaf_));
-    // Get split information for best leaf
-    const SplitInfo& best_leaf_SplitInfo = best_split_per_leaf_[best_leaf];
-    // cannot split, quit
-    if (best_leaf_SplitInfo.gain <= 0.0) {
-      Log::Warning("No further splits with positive gain, best gain: %f", best_leaf_SplitInfo.gain);
-      break;
+      // Get a leaf with max split gain
+      int best_leaf = static_cast<int>(ArrayArgs<SplitInfo>::ArgMax(best_split_per_leaf_));
+      // Get split information for best leaf
+      const SplitInfo& best_leaf_SplitInfo = best_split_per_leaf_[best_leaf];
+      // cannot split, quit
+      if (best_leaf_SplitInfo.gain <= 0.0) {
+        Log::Warning("No further splits with positive gain, best gain: %f", best_leaf_SplitInfo.gain);
+        break;
+      }
+      #ifdef TIMETAG
+      start_time = std::chrono::steady_clock::now();
+      #endif
+      // split tree with best leaf
+      Split(tree.get(), best_leaf, &left_leaf, &right_leaf);
+      #ifdef TIMETAG
+      split_time += std::chrono::steady_clock::now() - start_time;
+      #endif
+      cur_depth = std::max(cur_depth, tree->leaf_depth(left_leaf));
     }
-    #ifdef TIMETAG
-    start_time = std::chrono::steady_clock::now();
-    #endif
-    // split tree with best leaf
-    Split(tree.get(), best_leaf, &left_leaf, &right_leaf);
-    #ifdef TIMETAG
-    split_time += std::chrono::steady_clock::now() - start_time;
-    #endif
-    cur_depth = std::max(cur_depth, tree->leaf_depth(left_leaf));
+  }
+  // scores and tree outputs are updated by the index lists of the leaves
+  data_partition_->FillIndexLists();
+  if (config_->feature_pruning_rounds > 0) {
+    UpdateFeaturePruning();
   }
   Log::Debug("Trained a tree with leaves = %d and max_depth = %d", tree->num_leaves(), cur_depth);
+  Log::Debug("Feature group histograms of the tree: %d constructed (%d by leaf ids), %d subtracted, %d skipped",
+             num_constructed_histograms_, num_leaf_id_histograms_, num_subtracted_histograms_, num_skipped_histograms_);
+  total_constructed_histograms_ += num_constructed_histograms_;
+  total_subtracted_histograms_ += num_subtracted_histograms_;
+  total_skipped_histograms_ += num_skipped_histograms_;
+  total_leaf_id_histograms_ += num_leaf_id_histograms_;
   return tree.release();
 }
 
@@ -268,20 +324,19 @@ Tree* SerialTreeLearner::FitByExistingTree(const Tree* old_tree, const std::vect
   return FitByExistingTree(old_tree, gradients, hessians);
 }
 
-std::vector<int8_t> SerialTreeLearner::GetUsedFeatures(bool is_tree_level) {
-  std::vector<int8_t> ret(num_features_, 1);
-  if (config_->feature_fraction >= 1.0f && is_tree_level) {
-    return ret;
-  }
-  if (config_->feature_fraction_bynode >= 1.0f && !is_tree_level) {
-    return ret;
+void SerialTreeLearner::GetUsedFeatures(bool is_tree_level, std::vector<int8_t>* is_feature_used) {
+  int8_t* ret = is_feature_used->data();
+  if ((config_->feature_fraction >= 1.0f && is_tree_level)
+      || (config_->feature_fraction_bynode >= 1.0f && !is_tree_level)) {
+    std::memset(ret, 1, sizeof(int8_t) * num_features_);
+    return;
   }
-  std::memset(ret.data(), 0, sizeof(int8_t) * num_features_);
+  std::memset(ret, 0, sizeof(int8_t) * num_features_);
   const int min_used_features = std::min(2, static_cast<int>(valid_feature_indices_.size()));
   if (is_tree_level) {
     int used_feature_cnt = static_cast<int>(std::round(valid_feature_indices_.size() * config_->feature_fraction));
     used_feature_cnt = std::max(used_feature_cnt, min_used_features);
-    used_feature_indices_ = random_.Sample(static_cast<int>(valid_feature_indices_.size()), used_feature_cnt);
+    random_.Sample(static_cast<int>(valid_feature_indices_.size()), used_feature_cnt, &used_feature_indices_);
     int omp_loop_size = static_cast<int>(used_feature_indices_.size());
     #pragma omp parallel for schedule(static, 512) if (omp_loop_size >= 1024)
     for (int i = 0; i < omp_loop_size; ++i) {
@@ -293,7 +348,8 @@ std::vector<int8_t> SerialTreeLearner::GetUsedFeatures(bool is_tree_level) {
   } else if (used_feature_indices_.size() <= 0) {
     int used_feature_cnt = static_cast<int>(std::round(valid_feature_indices_.size() * config_->feature_fraction_bynode));
     used_feature_cnt = std::max(used_feature_cnt, min_used_features);
-    auto sampled_indices = random_.Sample(static_cast<int>(valid_feature_indices_.size()), used_feature_cnt);
+    auto& sampled_indices = sampled_feature_indices_;
+    random_.Sample(static_cast<int>(valid_feature_indices_.size()), used_feature_cnt, &sampled_indices);
     int omp_loop_size = static_cast<int>(sampled_indices.size());
     #pragma omp parallel for schedule(static, 512) if (omp_loop_size >= 1024)
     for (int i = 0; i < omp_loop_size; ++i) {
@@ -305,7 +361,8 @@ std::vector<int8_t> SerialTreeLearner::GetUsedFeatures(bool is_tree_level) {
   } else {
     int used_feature_cnt = static_cast<int>(std::round(used_feature_indices_.size() * config_->feature_fraction_bynode));
     used_feature_cnt = std::max(used_feature_cnt, min_used_features);
-    auto sampled_indices = random_.Sample(static_cast<int>(used_feature_indices_.size()), used_feature_cnt);
+    auto& sampled_indices = sampled_feature_indices_;
+    random_.Sample(static_cast<int>(used_feature_indices_.size()), used_feature_cnt, &sampled_indices);
     int omp_loop_size = static_cast<int>(sampled_indices.size());
     #pragma omp parallel for schedule(static, 512) if (omp_loop_size >= 1024)
     for (int i = 0; i < omp_loop_size; ++i) {
@@ -315,7 +372,6 @@ std::vector<int8_t> SerialTreeLearner::GetUsedFeatures(bool is_tree_level) {
       ret[inner_feature_index] = 1;
     }
   }
-  return ret;
 }
 
 void SerialTreeLearner::BeforeTrain() {
@@ -323,13 +379,16 @@ void SerialTreeLearner::BeforeTrain() {
   histogram_pool_.ResetMap();
 
   if (config_->feature_fraction < 1.0f) {
-    is_feature_used_ = GetUsedFeatures(true);
+    GetUsedFeatures(true, &is_feature_used_);
   } else {
     #pragma omp parallel for schedule(static, 512) if (num_features_ >= 1024)
     for (int i = 0; i < num_features_; ++i) {
       is_feature_used_[i] = 1;
     }
   }
+  if (config_->feature_pruning_rounds > 0) {
+    ApplyFeaturePruning();
+  }
 
   // initialize data partition
   data_partition_->Init();
@@ -476,63 +535,435 @@ bool SerialTreeLearner::BeforeFindBestSplit(const Tree* tree, int left_leaf, int
   return true;
 }
 
-void SerialTreeLearner::FindBestSplits() {
-  std::vector<int8_t> is_feature_used(num_features_, 0);
+void SerialTreeLearner::GetFeaturesOfSplit(std::vector<int8_t>* is_feature_used) {
+  auto& ref_is_feature_used = *is_feature_used;
   #pragma omp parallel for schedule(static, 1024) if (num_features_ >= 2048)
   for (int feature_index = 0; feature_index < num_features_; ++feature_index) {
+    ref_is_feature_used[feature_index] = 0;
     if (!is_feature_used_[feature_index]) continue;
     if (parent_leaf_histogram_array_ != nullptr
         && !parent_leaf_histogram_array_[feature_index].is_splittable()) {
       smaller_leaf_histogram_array_[feature_index].set_is_splittable(false);
       continue;
     }
-    is_feature_used[feature_index] = 1;
+    ref_is_feature_used[feature_index] = 1;
   }
+}
+
+void SerialTreeLearner::FindBestSplits() {
+  auto& is_feature_used = is_feature_used_in_split_;
+  GetFeaturesOfSplit(&is_feature_used);
   bool use_subtract = parent_leaf_histogram_array_ != nullptr;
+  ChooseHistogramSources(is_feature_used, use_subtract);
+  is_histogram_source_chosen_ = true;
   ConstructHistograms(is_feature_used, use_subtract);
   FindBestSplitsFromHistograms(is_feature_used, use_subtract);
+  is_histogram_source_chosen_ = false;
+}
+
+void SerialTreeLearner::SwapLeafPairSearch(LeafPairSearch* search) {
+  std::swap(smaller_leaf_splits_, search->smaller_leaf_splits);
+  std::swap(larger_leaf_splits_, search->larger_leaf_splits);
+  std::swap(parent_leaf_histogram_array_, search->parent_histogram_array);
+  std::swap(smaller_leaf_histogram_array_, search->smaller_histogram_array);
+  std::swap(larger_leaf_histogram_array_, search->larger_histogram_array);
+  std::swap(is_feature_used_in_split_, search->is_feature_used);
+  std::swap(smaller_histogram_source_, search->smaller_histogram_source);
+  std::swap(larger_histogram_source_, search->larger_histogram_source);
+  std::swap(smaller_constructed_features_, search->smaller_constructed_features);
+  std::swap(larger_constructed_features_, search->larger_constructed_features);
+}
+
+void SerialTreeLearner::FindBestSplitsOfLeaves(const Tree* tree, const std::vector<std::pair<int, int>>& leaf_pairs) {
+  const int num_pairs = static_cast<int>(leaf_pairs.size());
+  // an LRU pool may evict the histograms of a split while the others are constructed, so search them one by one
+  if (histogram_pool_.cache_size() < config_->num_leaves) {
+    for (int i = 0; i < num_pairs; ++i) {
+      SwapLeafPairSearch(&leaf_pair_searches_[i]);
+      if (BeforeFindBestSplit(tree, leaf_pairs[i].first, leaf_pairs[i].second)) {
+        FindBestSplits();
+      }
+      SwapLeafPairSearch(&leaf_pair_searches_[i]);
+    }
+    return;
+  }
+  for (int i = 0; i < num_pairs; ++i) {
+    auto& search = leaf_pair_searches_[i];
+    SwapLeafPairSearch(&search);
+    search.is_searched = BeforeFindBestSplit(tree, leaf_pairs[i].first, leaf_pairs[i].second);
+    if (search.is_searched) {
+      GetFeaturesOfSplit(&is_feature_used_in_split_);
+      const bool use_subtract = parent_leaf_histogram_array_ != nullptr;
+      ChooseHistogramSources(is_feature_used_in_split_, use_subtract);
+      is_histogram_source_chosen_ = true;
+      PrepareHistogramConstruction(is_feature_used_in_split_, use_subtract,
+                                   &search.is_smaller_constructed, &search.is_larger_constructed);
+      is_histogram_source_chosen_ = false;
+    }
+    SwapLeafPairSearch(&search);
+  }
+  #ifdef TIMETAG
+  auto start_time = std::chrono::steady_clock::now();
+  #endif
+  auto& tasks = leaf_histogram_tasks_;
+  tasks.clear();
+  const data_size_t* indices = data_partition_->indices();
+  auto add_task = [this, &tasks, indices](const LeafSplits* leaf_splits, const std::vector<int8_t>* is_feature_used,
+                                          FeatureHistogram* histogram_array) {
+    // leaves are disjoint ranges of the partition, so gathering to the same offsets doesn't overlap
+    const data_size_t offset = leaf_splits->data_indices() == nullptr ? 0
+      : static_cast<data_size_t>(leaf_splits->data_indices() - indices);
+    const int leaf_id = LeafIdOfLeafSplits(leaf_splits);
+    tasks.push_back({is_feature_used, leaf_splits->data_indices(), leaf_splits->num_data_in_leaf(),
+                     leaf_splits->LeafIndex(), leaf_id >= 0 ? data_partition_->leaf_ids() : nullptr,
+                     static_cast<uint8_t>(std::max(leaf_id, 0)),
+                     ordered_gradients_.data() + offset, ordered_hessians_.data() + offset,
+                     histogram_array[0].RawData() - 1});
+  };
+  for (int i = 0; i < num_pairs; ++i) {
+    const auto& search = leaf_pair_searches_[i];
+    if (!search.is_searched) { continue; }
+    if (search.is_smaller_constructed) {
+      add_task(search.smaller_leaf_splits.get(), &search.smaller_constructed_features, search.smaller_histogram_array);
+    }
+    if (search.larger_histogram_array != nullptr && search.is_larger_constructed) {
+      add_task(search.larger_leaf_splits.get(), &search.larger_constructed_features, search.larger_histogram_array);
+    }
+  }
+  train_data_->ConstructHistogramsOfLeaves(tasks, &ordered_bins_, gradients_, hessians_, is_constant_hessian_);
+  #ifdef TIMETAG
+  hist_time += std::chrono::steady_clock::now() - start_time;
+  #endif
+  for (int i = 0; i < num_pairs; ++i) {
+    auto& search = leaf_pair_searches_[i];
+    if (!search.is_searched) { continue; }
+    SwapLeafPairSearch(&search);
+    FindBestSplitsFromHistograms(is_feature_used_in_split_, parent_leaf_histogram_array_ != nullptr);
+    SwapLeafPairSearch(&search);
+  }
+}
+
+void SerialTreeLearner::GrowLeafBatches(Tree* tree, int left_leaf, int right_leaf, bool aborted_last_force_split,
+                                        int* cur_depth) {
+  const int max_num_pairs = std::min(config_->leaf_batch_size, config_->num_leaves);
+  while (static_cast<int>(leaf_pair_searches_.size()) < max_num_pairs) {
+    leaf_pair_searches_.emplace_back();
+    auto& search = leaf_pair_searches_.back();
+    search.smaller_leaf_splits.reset(new LeafSplits(num_data_));
+    search.larger_leaf_splits.reset(new LeafSplits(num_data_));
+    search.is_feature_used.resize(num_features_);
+    search.smaller_histogram_source.resize(num_features_);
+    search.larger_histogram_source.resize(num_features_);
+    search.smaller_constructed_features.resize(num_features_);
+    search.larger_constructed_features.resize(num_features_);
+  }
+  auto& leaf_pairs = leaf_pairs_;
+  leaf_pairs.clear();
+  if (!aborted_last_force_split) {
+    // the leaves of the root, or of the last forced split
+    *leaf_pair_searches_[0].smaller_leaf_splits = *smaller_leaf_splits_;
+    *leaf_pair_searches_[0].larger_leaf_splits = *larger_leaf_splits_;
+    leaf_pairs.emplace_back(left_leaf, right_leaf);
+  }
+  auto& leaves = batch_leaves_;
+  while (tree->num_leaves() < config_->num_leaves) {
+    FindBestSplitsOfLeaves(tree, leaf_pairs);
+    leaves.clear();
+    for (int i = 0; i < tree->num_leaves(); ++i) {
+      if (best_split_per_leaf_[i].gain > 0.0) {
+        leaves.push_back(i);
+      }
+    }
+    if (leaves.empty()) {
+      const int best_leaf = static_cast<int>(ArrayArgs<SplitInfo>::ArgMax(best_split_per_leaf_));
+      Log::Warning("No further splits with positive gain, best gain: %f", best_split_per_leaf_[best_leaf].gain);
+      break;
+    }
+    const int num_splits = std::min(static_cast<int>(leaves.size()),
+                                    std::min(config_->leaf_batch_size, config_->num_leaves - tree->num_leaves()));
+    // in the order of the leaf-wise growth, ties go to the smaller leaf index
+    std::partial_sort(leaves.begin(), leaves.begin() + num_splits, leaves.end(), [this](int a, int b) {
+      if (best_split_per_leaf_[a] > best_split_per_leaf_[b]) { return true; }
+      if (best_split_per_leaf_[b] > best_split_per_leaf_[a]) { return false; }
+      return a < b;
+    });
+    #ifdef TIMETAG
+    auto start_time = std::chrono::steady_clock::now();
+    #endif
+    leaf_pairs.clear();
+    for (int i = 0; i < num_splits; ++i) {
+      // CEGB updates the gains of the other leaves on each split
+      if (best_split_per_leaf_[leaves[i]].gain <= 0.0) { continue; }
+      Split(tree, leaves[i], &left_leaf, &right_leaf);
+      auto& search = leaf_pair_searches_[leaf_pairs.size()];
+      *search.smaller_leaf_splits = *smaller_leaf_splits_;
+      *search.larger_leaf_splits = *larger_leaf_splits_;
+      leaf_pairs.emplace_back(left_leaf, right_leaf);
+      *cur_depth = std::max(*cur_depth, tree->leaf_depth(left_leaf));
+    }
+    #ifdef TIMETAG
+    split_time += std::chrono::steady_clock::now() - start_time;
+    #endif
+  }
+}
+
+void SerialTreeLearner::InitHistogramCostModel() {
+  const int num_groups = train_data_->num_feature_groups();
+  group_nonzero_rate_.assign(num_groups, 0.0);
+  for (int i = 0; i < num_features_; ++i) {
+    group_nonzero_rate_[train_data_->Feature2Group(i)] += 1.0 - train_data_->FeatureBinMapper(i)->sparse_rate();
+  }
+  for (auto& rate : group_nonzero_rate_) {
+    rate = std::min(rate, 1.0);
+  }
+  group_used_bins_.resize(num_groups);
+  group_smaller_source_.resize(num_groups);
+  group_larger_source_.resize(num_groups);
+  smaller_histogram_source_.resize(num_features_);
+  larger_histogram_source_.resize(num_features_);
+  smaller_constructed_features_.resize(num_features_);
+  larger_constructed_features_.resize(num_features_);
+}
+
+// rows of a small leaf are scattered over the data, then each of their values loads a whole cache line
+static double RandomAccessBytes(double value_bytes, double fraction_of_data) {
+  const double kCacheLineBytes = 64.0;
+  return std::min(kCacheLineBytes, value_bytes / std::max(fraction_of_data, 1e-9));
+}
+
+double SerialTreeLearner::HistogramConstructionCost(int group, data_size_t num_data_in_leaf, bool is_leaf_id) const {
+  const int num_bin = train_data_->FeatureGroupNumBin(group);
+  const double fraction = static_cast<double>(num_data_in_leaf) / num_data_;
+  // the histogram is cleared and then accumulated
+  const double histogram_bytes = 2.0 * sizeof(HistogramBinEntry) * num_bin;
+  if (ordered_bins_[group] != nullptr || train_data_->FeatureGroupIsSparse(group)) {
+    // only the non-zero bins are visited, each reads its row index, bin and the gradients of the row
+    return histogram_bytes + num_data_in_leaf * group_nonzero_rate_[group]
+      * (sizeof(data_size_t) + sizeof(uint32_t) + 2 * RandomAccessBytes(sizeof(score_t), fraction));
+  }
+  double bin_bytes = 4.0;
+  if (num_bin <= 16) {
+    bin_bytes = 0.5;
+  } else if (num_bin <= 256) {
+    bin_bytes = 1.0;
+  } else if (num_bin <= 65536) {
+    bin_bytes = 2.0;
+  }
+  if (is_leaf_id) {
+    // masked scans read the leaf id, the bin and the gradients of all data in order
+    return histogram_bytes + static_cast<double>(num_data_) * (sizeof(uint8_t) + bin_bytes + 2 * sizeof(score_t));
+  }
+  return histogram_bytes + num_data_in_leaf
+    * (sizeof(data_size_t) + 2 * sizeof(score_t) + RandomAccessBytes(bin_bytes, fraction));
+}
+
+double SerialTreeLearner::GradientGatherCost(data_size_t num_data_in_leaf, bool is_leaf_id) const {
+  // leaves kept as leaf ids read the gradients in place
+  if (is_leaf_id || num_data_in_leaf >= num_data_) { return 0.0; }
+  const double fraction = static_cast<double>(num_data_in_leaf) / num_data_;
+  return num_data_in_leaf * (sizeof(data_size_t) + 2 * sizeof(score_t) + 2 * RandomAccessBytes(sizeof(score_t), fraction));
+}
+
+void SerialTreeLearner::SetDefaultHistogramSources(const std::vector<int8_t>& is_feature_used, bool use_subtract) {
+  const bool has_larger_leaf = larger_leaf_histogram_array_ != nullptr
+    && larger_leaf_splits_ != nullptr && larger_leaf_splits_->LeafIndex() >= 0;
+  for (int feature_index = 0; feature_index < num_features_; ++feature_index) {
+    if (!is_feature_used[feature_index]) {
+      smaller_histogram_source_[feature_index] = SkippedHistogram;
+      larger_histogram_source_[feature_index] = SkippedHistogram;
+    } else {
+      smaller_histogram_source_[feature_index] = ConstructedHistogram;
+      if (!has_larger_leaf) {
+        larger_histogram_source_[feature_index] = SkippedHistogram;
+      } else {
+        larger_histogram_source_[feature_index] = use_subtract ? SubtractedHistogram : ConstructedHistogram;
+      }
+    }
+  }
+}
+
+void SerialTreeLearner::ChooseHistogramSources(const std::vector<int8_t>& is_feature_used, bool use_subtract) {
+  SetDefaultHistogramSources(is_feature_used, use_subtract);
+  if (larger_leaf_histogram_array_ == nullptr || larger_leaf_splits_->LeafIndex() < 0) {
+    return;
+  }
+  const data_size_t smaller_cnt = smaller_leaf_splits_->num_data_in_leaf();
+  const data_size_t larger_cnt = larger_leaf_splits_->num_data_in_leaf();
+  const bool is_smaller_leaf_id = LeafIdOfLeafSplits(smaller_leaf_splits_.get()) >= 0;
+  const bool is_larger_leaf_id = LeafIdOfLeafSplits(larger_leaf_splits_.get()) >= 0;
+  // a leaf with less data can't have two children with min_data_in_leaf, so it is never split
+  // and its histograms are neither searched nor used as a parent. Forced splits ignore the data,
+  // and CEGB keeps the splits of all leaves, so nothing is skipped with them
+  const bool can_skip = !is_forcing_splits_ && cegb_ == nullptr;
+  const data_size_t min_split_cnt = std::max<data_size_t>(2, 2 * config_->min_data_in_leaf);
+  const bool is_smaller_splittable = !can_skip || smaller_cnt >= min_split_cnt;
+  const bool is_larger_splittable = !can_skip || larger_cnt >= min_split_cnt;
+  if (is_smaller_splittable && is_larger_splittable && !use_subtract) {
+    return;
+  }
+  std::fill(group_used_bins_.begin(), group_used_bins_.end(), 0);
+  for (int feature_index = 0; feature_index < num_features_; ++feature_index) {
+    if (is_feature_used[feature_index]) {
+      group_used_bins_[train_data_->Feature2Group(feature_index)] += train_data_->FeatureNumBin(feature_index);
+    }
+  }
+  double default_cost = GradientGatherCost(smaller_cnt, is_smaller_leaf_id)
+    + (use_subtract ? 0.0 : GradientGatherCost(larger_cnt, is_larger_leaf_id));
+  double chosen_cost = 0.0;
+  bool is_smaller_constructed = false;
+  bool is_larger_constructed = false;
+  const double kInf = std::numeric_limits<double>::infinity();
+  for (int group = 0; group < static_cast<int>(group_used_bins_.size()); ++group) {
+    if (group_used_bins_[group] <= 0) { continue; }
+    const double smaller_cost = HistogramConstructionCost(group, smaller_cnt, is_smaller_leaf_id);
+    const double larger_cost = HistogramConstructionCost(group, larger_cnt, is_larger_leaf_id);
+    // subtraction reads both histograms and writes one
+    const double subtract_cost = use_subtract ? 3.0 * sizeof(HistogramBinEntry) * group_used_bins_[group] : kInf;
+    default_cost += smaller_cost + (use_subtract ? subtract_cost : larger_cost);
+    group_smaller_source_[group] = ConstructedHistogram;
+    group_larger_source_[group] = SkippedHistogram;
+    double cost = smaller_cost;
+    if (is_larger_splittable) {
+      if (subtract_cost <= larger_cost) {
+        group_larger_source_[group] = SubtractedHistogram;
+        cost += subtract_cost;
+      } else {
+        group_larger_source_[group] = ConstructedHistogram;
+        cost += larger_cost;
+      }
+      // the smaller leaf is only needed for subtraction
+      if (!is_smaller_splittable && larger_cost <= cost) {
+        group_smaller_source_[group] = SkippedHistogram;
+        group_larger_source_[group] = ConstructedHistogram;
+        cost = larger_cost;
+      }
+    }
+    chosen_cost += cost;
+    is_smaller_constructed = is_smaller_constructed || group_smaller_source_[group] == ConstructedHistogram;
+    is_larger_constructed = is_larger_constructed || group_larger_source_[group] == ConstructedHistogram;
+  }
+  chosen_cost += (is_smaller_constructed ? GradientGatherCost(smaller_cnt, is_smaller_leaf_id) : 0.0)
+    + (is_larger_constructed ? GradientGatherCost(larger_cnt, is_larger_leaf_id) : 0.0);
+  if (chosen_cost >= default_cost) {
+    return;
+  }
+  for (int feature_index = 0; feature_index < num_features_; ++feature_index) {
+    if (!is_feature_used[feature_index]) { continue; }
+    const int group = train_data_->Feature2Group(feature_index);
+    smaller_histogram_source_[feature_index] = group_smaller_source_[group];
+    larger_histogram_source_[feature_index] = group_larger_source_[group];
+  }
+}
+
+void SerialTreeLearner::PrepareHistogramConstruction(const std::vector<int8_t>& is_feature_used, bool use_subtract,
+                                                     bool* is_smaller_constructed, bool* is_larger_constructed) {
+  // parallel learners construct histograms without choosing their sources
+  if (!is_histogram_source_chosen_) {
+    SetDefaultHistogramSources(is_feature_used, use_subtract);
+  }
+  *is_smaller_constructed = false;
+  *is_larger_constructed = false;
+  std::fill(group_smaller_source_.begin(), group_smaller_source_.end(), SkippedHistogram);
+  std::fill(group_larger_source_.begin(), group_larger_source_.end(), SkippedHistogram);
+  std::fill(group_used_bins_.begin(), group_used_bins_.end(), 0);
+  for (int feature_index = 0; feature_index < num_features_; ++feature_index) {
+    smaller_constructed_features_[feature_index] = smaller_histogram_source_[feature_index] == ConstructedHistogram;
+    larger_constructed_features_[feature_index] = larger_histogram_source_[feature_index] == ConstructedHistogram;
+    *is_smaller_constructed = *is_smaller_constructed || smaller_constructed_features_[feature_index];
+    *is_larger_constructed = *is_larger_constructed || larger_constructed_features_[feature_index];
+    if (is_feature_used[feature_index]) {
+      const int group = train_data_->Feature2Group(feature_index);
+      group_used_bins_[group] = 1;
+      // the features of a group share its source
+      group_smaller_source_[group] = smaller_histogram_source_[feature_index];
+      group_larger_source_[group] = larger_histogram_source_[feature_index];
+    }
+  }
+  const bool has_larger_leaf = larger_leaf_splits_ != nullptr && larger_leaf_splits_->LeafIndex() >= 0;
+  const bool is_leaf_id[2] = {LeafIdOfLeafSplits(smaller_leaf_splits_.get()) >= 0,
+                              has_larger_leaf && LeafIdOfLeafSplits(larger_leaf_splits_.get()) >= 0};
+  for (int group = 0; group < static_cast<int>(group_used_bins_.size()); ++group) {
+    if (!group_used_bins_[group]) { continue; }
+    for (int i = 0; i < (has_larger_leaf ? 2 : 1); ++i) {
+      const HistogramSource source = (i == 0) ? group_smaller_source_[group] : group_larger_source_[group];
+      if (source == ConstructedHistogram) {
+        ++num_constructed_histograms_;
+        if (is_leaf_id[i]) {
+          ++num_leaf_id_histograms_;
+        }
+      } else if (source == SubtractedHistogram) {
+        ++num_subtracted_histograms_;
+      } else {
+        ++num_skipped_histograms_;
+      }
+    }
+  }
 }
 
 void SerialTreeLearner::ConstructHistograms(const std::vector<int8_t>& is_feature_used, bool use_subtract) {
   #ifdef TIMETAG
   auto start_time = std::chrono::steady_clock::now();
   #endif
+  bool is_smaller_constructed = false;
+  bool is_larger_constructed = false;
+  PrepareHistogramConstruction(is_feature_used, use_subtract, &is_smaller_constructed, &is_larger_constructed);
   // construct smaller leaf
-  HistogramBinEntry* ptr_smaller_leaf_hist_data = smaller_leaf_histogram_array_[0].RawData() - 1;
-  train_data_->ConstructHistograms(is_feature_used,
-                                   smaller_leaf_splits_->data_indices(), smaller_leaf_splits_->num_data_in_leaf(),
-                                   smaller_leaf_splits_->LeafIndex(),
-                                   &ordered_bins_, gradients_, hessians_,
-                                   ordered_gradients_.data(), ordered_hessians_.data(), is_constant_hessian_,
-                                   ptr_smaller_leaf_hist_data);
-
-  if (larger_leaf_histogram_array_ != nullptr && !use_subtract) {
+  if (is_smaller_constructed) {
+    HistogramBinEntry* ptr_smaller_leaf_hist_data = smaller_leaf_histogram_array_[0].RawData() - 1;
+    ConstructLeafHistograms(smaller_constructed_features_, smaller_leaf_splits_.get(), ptr_smaller_leaf_hist_data);
+  }
+  if (larger_leaf_histogram_array_ != nullptr && is_larger_constructed) {
     // construct larger leaf
     HistogramBinEntry* ptr_larger_leaf_hist_data = larger_leaf_histogram_array_[0].RawData() - 1;
-    train_data_->ConstructHistograms(is_feature_used,
-                                     larger_leaf_splits_->data_indices(), larger_leaf_splits_->num_data_in_leaf(),
-                                     larger_leaf_splits_->LeafIndex(),
-                                     &ordered_bins_, gradients_, hessians_,
-                                     ordered_gradients_.data(), ordered_hessians_.data(), is_constant_hessian_,
-                                     ptr_larger_leaf_hist_data);
+    ConstructLeafHistograms(larger_constructed_features_, larger_leaf_splits_.get(), ptr_larger_leaf_hist_data);
   }
   #ifdef TIMETAG
   hist_time += std::chrono::steady_clock::now() - start_time;
   #endif
 }
 
-void SerialTreeLearner::FindBestSplitsFromHistograms(const std::vector<int8_t>& is_feature_used, bool use_subtract) {
+int SerialTreeLearner::LeafIdOfLeafSplits(const LeafSplits* leaf_splits) const {
+  if (leaf_splits->LeafIndex() < 0) {
+    return -1;
+  }
+  return data_partition_->leaf_id(leaf_splits->LeafIndex());
+}
+
+void SerialTreeLearner::ConstructLeafHistograms(const std::vector<int8_t>& is_feature_used, const LeafSplits* leaf_splits,
+                                                HistogramBinEntry* histogram_data) {
+  const int leaf_id = LeafIdOfLeafSplits(leaf_splits);
+  if (leaf_id >= 0) {
+    train_data_->ConstructHistogramsOfLeafId(is_feature_used, data_partition_->leaf_ids(), static_cast<uint8_t>(leaf_id),
+                                             leaf_splits->num_data_in_leaf(), ordered_bins_, gradients_, hessians_, row_block_histograms_.data(),
+                                             is_constant_hessian_, histogram_data);
+  } else {
+    train_data_->ConstructHistograms(is_feature_used,
+                                     leaf_splits->data_indices(), leaf_splits->num_data_in_leaf(),
+                                     leaf_splits->LeafIndex(),
+                                     &ordered_bins_, gradients_, hessians_,
+                                     ordered_gradients_.data(), ordered_hessians_.data(),
+                                     row_block_histograms_.data(), is_constant_hessian_,
+                                     histogram_data);
+  }
+}
+
+void SerialTreeLearner::FindBestSplitsFromHistograms(const std::vector<int8_t>& is_feature_used, bool) {
   #ifdef TIMETAG
   auto start_time = std::chrono::steady_clock::now();
   #endif
-  std::vector<SplitInfo> smaller_best(num_threads_);
-  std::vector<SplitInfo> larger_best(num_threads_);
-  std::vector<int8_t> smaller_node_used_features(num_features_, 1);
-  std::vector<int8_t> larger_node_used_features(num_features_, 1);
-  if (config_->feature_fraction_bynode < 1.0f) {
-    smaller_node_used_features = GetUsedFeatures(false);
-    larger_node_used_features = GetUsedFeatures(false);
+  auto& smaller_best = smaller_best_per_thread_;
+  auto& larger_best = larger_best_per_thread_;
+  for (int i = 0; i < num_threads_; ++i) {
+    smaller_best[i] = SplitInfo();
+    larger_best[i] = SplitInfo();
   }
+  const auto& smaller_node_used_features = smaller_node_used_features_;
+  const auto& larger_node_used_features = larger_node_used_features_;
+  GetUsedFeatures(false, &smaller_node_used_features_);
+  GetUsedFeatures(false, &larger_node_used_features_);
+  // gains of all evaluated features are tracked, not only of the ones sampled for this node
+  const bool is_feature_gain_tracked = config_->feature_pruning_rounds > 0;
+  is_feature_gain_updated_ = is_feature_gain_updated_ || is_feature_gain_tracked;
   OMP_INIT_EX();
   // find splits
   #pragma omp parallel for schedule(static)
@@ -540,30 +971,35 @@ void SerialTreeLearner::FindBestSplitsFromHistograms(const std::vector<int8_t>&
     OMP_LOOP_EX_BEGIN();
     if (!is_feature_used[feature_index]) { continue; }
     const int tid = omp_get_thread_num();
-    SplitInfo smaller_split;
-    train_data_->FixHistogram(feature_index,
-                              smaller_leaf_splits_->sum_gradients(), smaller_leaf_splits_->sum_hessians(),
-                              smaller_leaf_splits_->num_data_in_leaf(),
-                              smaller_leaf_histogram_array_[feature_index].RawData());
     int real_fidx = train_data_->RealFeatureIndex(feature_index);
-    smaller_leaf_histogram_array_[feature_index].FindBestThreshold(
-      smaller_leaf_splits_->sum_gradients(),
-      smaller_leaf_splits_->sum_hessians(),
-      smaller_leaf_splits_->num_data_in_leaf(),
-      smaller_leaf_splits_->min_constraint(),
-      smaller_leaf_splits_->max_constraint(),
-      &smaller_split);
-    smaller_split.feature = real_fidx;
-    if (cegb_ != nullptr) {
-      smaller_split.gain -= cegb_->DetlaGain(feature_index, real_fidx, smaller_leaf_splits_->LeafIndex(), smaller_leaf_splits_->num_data_in_leaf(), smaller_split);
-    }
-    if (smaller_split > smaller_best[tid] && smaller_node_used_features[feature_index]) {
-      smaller_best[tid] = smaller_split;
+    if (smaller_histogram_source_[feature_index] != SkippedHistogram) {
+      SplitInfo smaller_split;
+      train_data_->FixHistogram(feature_index,
+                                smaller_leaf_splits_->sum_gradients(), smaller_leaf_splits_->sum_hessians(),
+                                smaller_leaf_splits_->num_data_in_leaf(),
+                                smaller_leaf_histogram_array_[feature_index].RawData());
+      smaller_leaf_histogram_array_[feature_index].FindBestThreshold(
+        smaller_leaf_splits_->sum_gradients(),
+        smaller_leaf_splits_->sum_hessians(),
+        smaller_leaf_splits_->num_data_in_leaf(),
+        smaller_leaf_splits_->min_constraint(),
+        smaller_leaf_splits_->max_constraint(),
+        &smaller_split);
+      smaller_split.feature = real_fidx;
+      if (cegb_ != nullptr) {
+        smaller_split.gain -= cegb_->DetlaGain(feature_index, real_fidx, smaller_leaf_splits_->LeafIndex(), smaller_leaf_splits_->num_data_in_leaf(), smaller_split);
+      }
+      if (is_feature_gain_tracked) {
+        feature_best_gain_[feature_index] = std::max(feature_best_gain_[feature_index], smaller_split.gain);
+      }
+      if (smaller_split > smaller_best[tid] && smaller_node_used_features[feature_index]) {
+        smaller_best[tid] = smaller_split;
+      }
     }
-    // only has root leaf
-    if (larger_leaf_splits_ == nullptr || larger_leaf_splits_->LeafIndex() < 0) { continue; }
+    // only has root leaf, or the larger leaf can't be split
+    if (larger_histogram_source_[feature_index] == SkippedHistogram) { continue; }
 
-    if (use_subtract) {
+    if (larger_histogram_source_[feature_index] == SubtractedHistogram) {
       larger_leaf_histogram_array_[feature_index].Subtract(smaller_leaf_histogram_array_[feature_index]);
     } else {
       train_data_->FixHistogram(feature_index, larger_leaf_splits_->sum_gradients(), larger_leaf_splits_->sum_hessians(),
@@ -583,6 +1019,9 @@ void SerialTreeLearner::FindBestSplitsFromHistograms(const std::vector<int8_t>&
     if (cegb_ != nullptr) {
       larger_split.gain -= cegb_->DetlaGain(feature_index, real_fidx, larger_leaf_splits_->LeafIndex(), larger_leaf_splits_->num_data_in_leaf(), larger_split);
     }
+    if (is_feature_gain_tracked) {
+      feature_best_gain_[feature_index] = std::max(feature_best_gain_[feature_index], larger_split.gain);
+    }
     if (larger_split > larger_best[tid] && larger_node_used_features[feature_index]) {
       larger_best[tid] = larger_split;
     }
@@ -604,6 +1043,78 @@ void SerialTreeLearner::FindBestSplitsFromHistograms(const std::vector<int8_t>&
   #endif
 }
 
+void SerialTreeLearner::ResetFeaturePruning() {
+  const int num_class = std::max(1, config_->num_class);
+  feature_useless_trees_.assign(static_cast<size_t>(num_class) * num_features_, 0);
+  is_feature_pruned_.assign(static_cast<size_t>(num_class) * num_features_, 0);
+  num_pruning_trees_.assign(num_class, 0);
+  tree_class_ = 0;
+}
+
+void SerialTreeLearner::ApplyFeaturePruning() {
+  // each class prunes and rechecks its own features
+  const bool is_recheck_tree = num_pruning_trees_[tree_class_] % config_->feature_pruning_recheck_freq == 0;
+  const int8_t* is_feature_pruned = is_feature_pruned_.data() + static_cast<size_t>(tree_class_) * num_features_;
+  is_feature_gain_updated_ = false;
+  #pragma omp parallel for schedule(static, 512) if (num_features_ >= 1024)
+  for (int i = 0; i < num_features_; ++i) {
+    feature_best_gain_[i] = kMinScore;
+    if (is_feature_pruned[i] && !is_recheck_tree) {
+      is_feature_used_[i] = 0;
+    }
+  }
+}
+
+void SerialTreeLearner::UpdateFeaturePruning() {
+  ++num_pruning_trees_[tree_class_];
+  // no split was searched, e.g. the root has too few data
+  if (!is_feature_gain_updated_) {
+    return;
+  }
+  double max_gain = 0.0;
+  for (int i = 0; i < num_features_; ++i) {
+    if (is_feature_used_[i]) {
+      max_gain = std::max(max_gain, feature_best_gain_[i]);
+    }
+  }
+  // no split with positive gain, nothing to compare with
+  if (max_gain <= 0.0) {
+    return;
+  }
+  const double min_gain = max_gain * config_->feature_pruning_gain_ratio;
+  int* feature_useless_trees = feature_useless_trees_.data() + static_cast<size_t>(tree_class_) * num_features_;
+  int8_t* is_feature_pruned = is_feature_pruned_.data() + static_cast<size_t>(tree_class_) * num_features_;
+  std::vector<std::string> pruned_features;
+  std::vector<std::string> restored_features;
+  int num_pruned = 0;
+  for (int i = 0; i < num_features_; ++i) {
+    if (is_feature_used_[i]) {
+      if (feature_best_gain_[i] > min_gain) {
+        feature_useless_trees[i] = 0;
+        if (is_feature_pruned[i]) {
+          is_feature_pruned[i] = 0;
+          restored_features.push_back(train_data_->feature_names()[train_data_->RealFeatureIndex(i)]);
+        }
+      } else if (!is_feature_pruned[i] && ++feature_useless_trees[i] >= config_->feature_pruning_rounds) {
+        is_feature_pruned[i] = 1;
+        pruned_features.push_back(train_data_->feature_names()[train_data_->RealFeatureIndex(i)]);
+      }
+    }
+    num_pruned += is_feature_pruned[i];
+  }
+  if (!pruned_features.empty() || !restored_features.empty()) {
+    Log::Info("Feature pruning after %d trees of class %d: pruned %d and restored %d features, %d of %d features are pruned",
+              num_pruning_trees_[tree_class_], tree_class_, static_cast<int>(pruned_features.size()),
+              static_cast<int>(restored_features.size()), num_pruned, num_features_);
+    if (!pruned_features.empty()) {
+      Log::Debug("Pruned features: %s", Common::Join(pruned_features, ",").c_str());
+    }
+    if (!restored_features.empty()) {
+      Log::Debug("Restored features: %s", Common::Join(restored_features, ",").c_str());
+    }
+  }
+}
+
 int32_t SerialTreeLearner::ForceSplits(Tree* tree, const Json& forced_split_json, int* left_leaf,
                                        int* right_leaf, int *cur_depth,
                                        bool *aborted_last_force_split) {
@@ -797,12 +1308,15 @@ void SerialTreeLearner::Split(Tree* tree, int best_leaf, int* left_leaf, int* ri
     data_partition_->Split(best_leaf, train_data_, inner_feature_index,
                            &best_split_info.threshold, 1, best_split_info.default_left, *right_leaf);
   } else {
-    std::vector<uint32_t> cat_bitset_inner = Common::ConstructBitset(best_split_info.cat_threshold.data(), best_split_info.num_cat_threshold);
-    std::vector<int> threshold_int(best_split_info.num_cat_threshold);
+    auto& cat_bitset_inner = cat_bitset_inner_;
+    Common::ConstructBitset(best_split_info.cat_threshold.data(), best_split_info.num_cat_threshold, &cat_bitset_inner);
+    auto& threshold_int = cat_threshold_int_;
+    threshold_int.resize(best_split_info.num_cat_threshold);
     for (int i = 0; i < best_split_info.num_cat_threshold; ++i) {
       threshold_int[i] = static_cast<int>(train_data_->RealThreshold(inner_feature_index, best_split_info.cat_threshold[i]));
     }
-    std::vector<uint32_t> cat_bitset = Common::ConstructBitset(threshold_int.data(), best_split_info.num_cat_threshold);
+    auto& cat_bitset = cat_bitset_;
+    Common::ConstructBitset(threshold_int.data(), best_split_info.num_cat_threshold, &cat_bitset);
     *right_leaf = tree->SplitCategorical(best_leaf,
                                          inner_feature_index,
                                          best_split_info.feature,
@@ -892,4 +1406,79 @@ void SerialTreeLearner::RenewTreeOutput(Tree* tree, const ObjectiveFunction* obj
   }
 }
 
+void SerialTreeLearner::AddSizesInByte(std::map<std::string, size_t>* sizes) const {
+  (*sizes)["histogram_pool"] += histogram_pool_.SizesInByte();
+  if (data_partition_ != nullptr) {
+    (*sizes)["data_partition"] += data_partition_->SizesInByte();
+  }
+  (*sizes)["learner_buffers"] += sizeof(score_t) * (ordered_gradients_.capacity() + ordered_hessians_.capacity())
+    + sizeof(HistogramBinEntry) * row_block_histograms_.capacity()
+    + sizeof(char) * is_data_in_leaf_.capacity()
+    + sizeof(SplitInfo) * (best_split_per_leaf_.capacity() + splits_per_leaf_.capacity());
+}
+
+void SerialTreeLearner::AddTrainingStats(std::map<std::string, int64_t>* stats) const {
+  (*stats)["constructed_histograms"] += total_constructed_histograms_;
+  (*stats)["subtracted_histograms"] += total_subtracted_histograms_;
+  (*stats)["skipped_histograms"] += total_skipped_histograms_;
+  (*stats)["leaf_id_histograms"] += total_leaf_id_histograms_;
+}
+
+void SerialTreeLearner::LimitHistogramPool(size_t max_bytes) {
+  size_t total_histogram_size = 0;
+  for (int i = 0; i < train_data_->num_features(); ++i) {
+    total_histogram_size += sizeof(HistogramBinEntry) * train_data_->FeatureNumBin(i);
+  }
+  int max_cache_size = static_cast<int>(std::min<size_t>(max_bytes / std::max<size_t>(total_histogram_size, 1),
+                                                         static_cast<size_t>(config_->num_leaves)));
+  max_cache_size = std::max(2, max_cache_size);
+  // only shrink, growing back is done by ResetConfig
+  if (max_cache_size < histogram_pool_.cache_size()) {
+    Log::Warning("Shrinking histogram pool from %d to %d histograms to fit into the memory budget",
+                 histogram_pool_.cache_size(), max_cache_size);
+    histogram_pool_.DynamicChangeSize(train_data_, config_, max_cache_size, config_->num_leaves);
+  }
+}
+
+std::string SerialTreeLearner::SaveState() const {
+  std::string state;
+  Common::AppendToBinary(random_.State(), &state);
+  Common::AppendToBinary(num_pruning_trees_, &state);
+  Common::AppendToBinary(feature_useless_trees_, &state);
+  Common::AppendToBinary(is_feature_pruned_, &state);
+  Common::AppendToBinary(static_cast<int8_t>(cegb_ != nullptr), &state);
+  if (cegb_ != nullptr) {
+    cegb_->SaveState(&state);
+  }
+  return state;
+}
+
+bool SerialTreeLearner::LoadState(const std::string& state) {
+  size_t pos = 0;
+  unsigned int random_state = 0;
+  std::vector<int> num_pruning_trees;
+  std::vector<int> feature_useless_trees;
+  std::vector<int8_t> is_feature_pruned;
+  int8_t has_cegb = 0;
+  if (!Common::ReadFromBinary(state, &pos, &random_state)
+      || !Common::ReadFromBinary(state, &pos, &num_pruning_trees)
+      || !Common::ReadFromBinary(state, &pos, &feature_useless_trees)
+      || !Common::ReadFromBinary(state, &pos, &is_feature_pruned)
+      || !Common::ReadFromBinary(state, &pos, &has_cegb)
+      || num_pruning_trees.size() != num_pruning_trees_.size()
+      || feature_useless_trees.size() != feature_useless_trees_.size()
+      || is_feature_pruned.size() != is_feature_pruned_.size()
+      || (has_cegb != 0) != (cegb_ != nullptr)) {
+    return false;
+  }
+  if (cegb_ != nullptr && !cegb_->LoadState(state, &pos)) {
+    return false;
+  }
+  random_.SetState(random_state);
+  num_pruning_trees_ = std::move(num_pruning_trees);
+  feature_useless_trees_ = std::move(feature_useless_trees);
+  is_feature_pruned_ = std::move(is_feature_pruned);
+  return pos == state.size();
+}
+
 }  // namespace LightGBM
@@ -14,8 +14,10 @@
 #include <string>
 #include <cmath>
 #include <cstdio>
+#include <map>
 #include <memory>
 #include <random>
+#include <utility>
 #include <vector>
 
 #include "data_partition.hpp"
@@ -34,6 +36,14 @@ using namespace json11;
 namespace LightGBM {
 /*! \brief forward declaration */
 class CostEfficientGradientBoosting;
+
+/*! \brief How the histogram of a feature is obtained for a leaf */
+enum HistogramSource {
+  SkippedHistogram,
+  ConstructedHistogram,
+  SubtractedHistogram
+};
+
 /*!
 * \brief Used for learning a tree by single machine
 */
@@ -62,6 +72,11 @@ class SerialTreeLearner: public TreeLearner {
     data_partition_->SetUsedDataIndices(used_indices, num_data);
   }
 
+  void SetTreeClass(int tree_class) override {
+    CHECK(tree_class >= 0 && tree_class < static_cast<int>(num_pruning_trees_.size()));
+    tree_class_ = tree_class;
+  }
+
   void AddPredictionToScore(const Tree* tree, double* out_score) const override {
     if (tree->num_leaves() <= 1) { return; }
     CHECK(tree->num_leaves() <= data_partition_->num_leaves());
@@ -79,8 +94,23 @@ class SerialTreeLearner: public TreeLearner {
   void RenewTreeOutput(Tree* tree, const ObjectiveFunction* obj, std::function<double(const label_t*, int)> residual_getter,
                        data_size_t total_num_data, const data_size_t* bag_indices, data_size_t bag_cnt) const override;
 
+  void AddSizesInByte(std::map<std::string, size_t>* sizes) const override;
+
+  void AddTrainingStats(std::map<std::string, int64_t>* stats) const override;
+
+  void LimitHistogramPool(size_t max_bytes) override;
+
+  std::string SaveState() const override;
+
+  bool LoadState(const std::string& state) override;
+
  protected:
-  virtual std::vector<int8_t> GetUsedFeatures(bool is_tree_level);
+  /*!
+  * \brief Sample the used features of a tree or a node
+  * \param is_tree_level True to sample from all valid features, otherwise from the features used by the current tree
+  * \param is_feature_used Output, is_feature_used[i] != 0 means the i-th inner feature is used, must have num_features_ elements
+  */
+  virtual void GetUsedFeatures(bool is_tree_level, std::vector<int8_t>* is_feature_used);
   /*!
   * \brief Some initial works before training
   */
@@ -91,12 +121,71 @@ class SerialTreeLearner: public TreeLearner {
   */
   virtual bool BeforeFindBestSplit(const Tree* tree, int left_leaf, int right_leaf);
 
+  /*! \brief Mark the features whose splits are searched for the current leaves */
+  void GetFeaturesOfSplit(std::vector<int8_t>* is_feature_used);
+
   virtual void FindBestSplits();
 
+  /*!
+  * \brief Find the best splits of the new leaves of several splits, constructing all their histograms in one pass
+  * \param tree Current tree
+  * \param leaf_pairs (left leaf, right leaf) of each split of the current round
+  */
+  void FindBestSplitsOfLeaves(const Tree* tree, const std::vector<std::pair<int, int>>& leaf_pairs);
+
+  /*! \brief Grow the tree by splitting the leaf_batch_size leaves with the largest gains in each round */
+  void GrowLeafBatches(Tree* tree, int left_leaf, int right_leaf, bool aborted_last_force_split, int* cur_depth);
+
+  /*!
+  * \brief Choose for each feature group whether the histograms of the current leaves are constructed from data,
+  *        subtracted from the parent, or skipped, by the estimated bytes touched
+  * \param is_feature_used The features evaluated in this split search
+  * \param use_subtract True if the histograms of the parent are available
+  */
+  virtual void ChooseHistogramSources(const std::vector<int8_t>& is_feature_used, bool use_subtract);
+
+  /*! \brief Construct the smaller leaf's histograms and subtract the larger leaf's ones, the fixed policy */
+  void SetDefaultHistogramSources(const std::vector<int8_t>& is_feature_used, bool use_subtract);
+
+  /*! \brief Mark the features whose histograms are constructed from data for the current leaves, and count the sources */
+  void PrepareHistogramConstruction(const std::vector<int8_t>& is_feature_used, bool use_subtract,
+                                    bool* is_smaller_constructed, bool* is_larger_constructed);
+
   virtual void ConstructHistograms(const std::vector<int8_t>& is_feature_used, bool use_subtract);
 
+  /*! \brief Leaf id of the data of a leaf whose histograms are constructed by masked scans, or -1 to use its index list */
+  int LeafIdOfLeafSplits(const LeafSplits* leaf_splits) const;
+
+  /*! \brief Construct the histograms of one leaf by its leaf id or its index list */
+  void ConstructLeafHistograms(const std::vector<int8_t>& is_feature_used, const LeafSplits* leaf_splits,
+                               HistogramBinEntry* histogram_data);
+
   virtual void FindBestSplitsFromHistograms(const std::vector<int8_t>& is_feature_used, bool use_subtract);
 
+  /*!
+  * \brief Estimated bytes touched to construct the histogram of a feature group for a leaf from data
+  * \param is_leaf_id True if the leaf is kept as leaf ids, so its histograms scan all data
+  */
+  double HistogramConstructionCost(int group, data_size_t num_data_in_leaf, bool is_leaf_id) const;
+
+  /*! \brief Estimated bytes touched to gather the gradients of a leaf before constructing its histograms */
+  double GradientGatherCost(data_size_t num_data_in_leaf, bool is_leaf_id) const;
+
+  /*! \brief Reset the per feature group statistics used by ChooseHistogramSources */
+  void InitHistogramCostModel();
+
+  /*! \brief Set the leaves of the data partition kept as leaf ids, from leaf_id_partition_fraction */
+  void ResetLeafIdPartition();
+
+  /*! \brief Forget the pruned features and the counters of all classes */
+  void ResetFeaturePruning();
+
+  /*! \brief Skip the pruned features in the current tree, unless it rechecks them */
+  void ApplyFeaturePruning();
+
+  /*! \brief Prune or restore the features evaluated in the current tree, by their best split gains */
+  void UpdateFeaturePruning();
+
   /*!
   * \brief Partition tree and data according best split.
   * \param tree Current tree, will be splitted on this function.
@@ -165,6 +254,8 @@ class SerialTreeLearner: public TreeLearner {
   /*! \brief hessians of current iteration, ordered for cache optimized */
   std::vector<score_t> ordered_hessians_;
 #endif
+  /*! \brief Partial histograms of the row blocks of one leaf, used by Dataset::ConstructHistograms */
+  std::vector<HistogramBinEntry> row_block_histograms_;
 
   /*! \brief Store ordered bin */
   std::vector<std::unique_ptr<OrderedBin>> ordered_bins_;
@@ -180,6 +271,84 @@ class SerialTreeLearner: public TreeLearner {
   std::vector<int> ordered_bin_indices_;
   bool is_constant_hessian_;
   std::unique_ptr<CostEfficientGradientBoosting> cegb_;
+  /*! \brief Buffers reused by every split search, so that steady-state iterations don't allocate */
+  std::vector<int8_t> is_feature_used_in_split_;
+  std::vector<int8_t> smaller_node_used_features_;
+  std::vector<int8_t> larger_node_used_features_;
+  std::vector<int> sampled_feature_indices_;
+  std::vector<SplitInfo> smaller_best_per_thread_;
+  std::vector<SplitInfo> larger_best_per_thread_;
+  /*! \brief Buffers reused by categorical splits */
+  std::vector<uint32_t> cat_bitset_inner_;
+  std::vector<uint32_t> cat_bitset_;
+  std::vector<int> cat_threshold_int_;
+  /*! \brief Best split gain of each feature in the current tree, for feature pruning */
+  std::vector<double> feature_best_gain_;
+  /*! \brief Whether split gains were found in the current tree, for feature pruning */
+  bool is_feature_gain_updated_ = false;
+  /*!
+  * \brief Number of trees in a row without enough split gain on each feature, for feature pruning,
+  *        num_features_ entries for each class
+  */
+  std::vector<int> feature_useless_trees_;
+  /*!
+  * \brief is_feature_pruned_[k * num_features_ + i] = 1 means feature i is skipped in the trees of class k,
+  *        except in the trees rechecking it
+  */
+  std::vector<int8_t> is_feature_pruned_;
+  /*! \brief Number of trees of each class trained with feature pruning */
+  std::vector<int> num_pruning_trees_;
+  /*! \brief Class of the current tree, set by SetTreeClass */
+  int tree_class_ = 0;
+  /*! \brief Source of the histogram of each feature for the smaller and the larger leaf */
+  std::vector<HistogramSource> smaller_histogram_source_;
+  std::vector<HistogramSource> larger_histogram_source_;
+  /*! \brief Whether ChooseHistogramSources was called for the current split search */
+  bool is_histogram_source_chosen_ = false;
+  /*! \brief Leaves can be split regardless of their data while forcing splits, so no histogram is skipped */
+  bool is_forcing_splits_ = false;
+  /*! \brief Expected fraction of non-zero bins of each feature group */
+  std::vector<double> group_nonzero_rate_;
+  /*! \brief Buffers of ChooseHistogramSources and ConstructHistograms */
+  std::vector<int> group_used_bins_;
+  std::vector<HistogramSource> group_smaller_source_;
+  std::vector<HistogramSource> group_larger_source_;
+  std::vector<int8_t> smaller_constructed_features_;
+  std::vector<int8_t> larger_constructed_features_;
+  /*! \brief Number of feature group histograms of the current tree by source, for the debug log */
+  int num_constructed_histograms_ = 0;
+  int num_subtracted_histograms_ = 0;
+  int num_skipped_histograms_ = 0;
+  /*! \brief Constructed ones of them by scans of the leaf ids */
+  int num_leaf_id_histograms_ = 0;
+  /*! \brief Number of feature group histograms of all trees by source, reported by AddTrainingStats */
+  int64_t total_constructed_histograms_ = 0;
+  int64_t total_subtracted_histograms_ = 0;
+  int64_t total_skipped_histograms_ = 0;
+  int64_t total_leaf_id_histograms_ = 0;
+  /*! \brief Split search state of the new leaves of one split, kept while the other splits of a round are searched */
+  struct LeafPairSearch {
+    std::unique_ptr<LeafSplits> smaller_leaf_splits;
+    std::unique_ptr<LeafSplits> larger_leaf_splits;
+    FeatureHistogram* parent_histogram_array = nullptr;
+    FeatureHistogram* smaller_histogram_array = nullptr;
+    FeatureHistogram* larger_histogram_array = nullptr;
+    std::vector<int8_t> is_feature_used;
+    std::vector<HistogramSource> smaller_histogram_source;
+    std::vector<HistogramSource> larger_histogram_source;
+    std::vector<int8_t> smaller_constructed_features;
+    std::vector<int8_t> larger_constructed_features;
+    bool is_searched = false;
+    bool is_smaller_constructed = false;
+    bool is_larger_constructed = false;
+  };
+  /*! \brief Exchange the split search state of the learner with the one of a split, calling it twice restores both */
+  void SwapLeafPairSearch(LeafPairSearch* search);
+  /*! \brief Split search states of the current round, only used when leaf_batch_size > 1 */
+  std::vector<LeafPairSearch> leaf_pair_searches_;
+  std::vector<Dataset::LeafHistogramTask> leaf_histogram_tasks_;
+  std::vector<std::pair<int, int>> leaf_pairs_;
+  std::vector<int> batch_leaves_;
 };
 
 inline data_size_t SerialTreeLearner::GetGlobalDataCountInLeaf(int leaf_idx) const {
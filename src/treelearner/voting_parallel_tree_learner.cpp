@@ -380,8 +380,8 @@ void VotingParallelTreeLearner<TREELEARNER_T>::FindBestSplitsFromHistograms(cons
   std::vector<int8_t> smaller_node_used_features(this->num_features_, 1);
   std::vector<int8_t> larger_node_used_features(this->num_features_, 1);
   if (this->config_->feature_fraction_bynode < 1.0f) {
-    smaller_node_used_features = this->GetUsedFeatures(false);
-    larger_node_used_features = this->GetUsedFeatures(false);
+    this->GetUsedFeatures(false, &smaller_node_used_features);
+    this->GetUsedFeatures(false, &larger_node_used_features);
   }
   // find best split from local aggregated histograms
 
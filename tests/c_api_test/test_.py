@@ -1,7 +1,10 @@
 # coding: utf-8
 import ctypes
+import json
 import os
+import subprocess
 import sys
+import time
 
 from platform import system
 
@@ -35,6 +38,13 @@ def find_lib_path():
     return lib_path
 
 
+def find_cli_path():
+    # the command line application is built next to the library
+    cli_name = 'lightgbm.exe' if system() in ('Windows', 'Microsoft') else 'lightgbm'
+    cli_path = [os.path.join(os.path.dirname(p), cli_name) for p in find_lib_path()]
+    return [p for p in cli_path if os.path.isfile(p)]
+
+
 def LoadDll():
     lib_path = find_lib_path()
     if len(lib_path) == 0:
@@ -51,6 +61,8 @@ dtype_float32 = 0
 dtype_float64 = 1
 dtype_int32 = 2
 dtype_int64 = 3
+dtype_uint8 = 5
+dtype_uint16 = 6
 
 
 def c_array(ctype, values):
@@ -196,6 +208,64 @@ def free_dataset(handle):
     LIB.LGBM_DatasetFree(handle)
 
 
+def train_booster(train, params, num_iterations=20):
+    booster = ctypes.c_void_p()
+    LIB.LGBM_BoosterCreate(
+        train,
+        c_str(params),
+        ctypes.byref(booster))
+    is_finished = ctypes.c_int(0)
+    for _ in range(num_iterations):
+        LIB.LGBM_BoosterUpdateOneIter(booster, ctypes.byref(is_finished))
+        assert is_finished.value == 0
+    return booster
+
+
+def get_train_metric(booster):
+    result = np.array([0.0], dtype=np.float64)
+    out_len = ctypes.c_int(0)
+    LIB.LGBM_BoosterGetEval(
+        booster,
+        0,
+        ctypes.byref(out_len),
+        result.ctypes.data_as(ctypes.POINTER(ctypes.c_double)))
+    return result[0]
+
+
+def get_trees(booster):
+    # the trees of the model string, without the parameters
+    model_str = ctypes.create_string_buffer(1 << 22)
+    out_len = ctypes.c_int64(0)
+    LIB.LGBM_BoosterSaveModelToString(booster, 0, -1, ctypes.c_int64(len(model_str)), ctypes.byref(out_len),
+                                      model_str)
+    model_str = model_str.value.decode('ascii')
+    return model_str[model_str.index('Tree=0'):model_str.index('end of trees')]
+
+
+def get_memory_usage(booster):
+    buffer_len = 1 << 16
+    tmp_out_len = ctypes.c_int64(0)
+    string_buffer = ctypes.create_string_buffer(buffer_len)
+    LIB.LGBM_BoosterGetMemoryUsage(
+        booster,
+        ctypes.c_int64(buffer_len),
+        ctypes.byref(tmp_out_len),
+        string_buffer)
+    return json.loads(string_buffer.value.decode())
+
+
+def get_training_stats(booster):
+    buffer_len = 1 << 16
+    tmp_out_len = ctypes.c_int64(0)
+    string_buffer = ctypes.create_string_buffer(buffer_len)
+    LIB.LGBM_BoosterGetTrainingStats(
+        booster,
+        ctypes.c_int64(buffer_len),
+        ctypes.byref(tmp_out_len),
+        string_buffer)
+    return json.loads(string_buffer.value.decode())
+
+
 def test_dataset():
     train = load_from_file(os.path.join(os.path.dirname(os.path.realpath(__file__)),
                                         '../../examples/binary_classification/binary.train'), None)
@@ -214,6 +284,66 @@ def test_dataset():
     free_dataset(train)
 
 
+def test_dataset_bundling_order():
+    # mostly non-zero columns are bundled by their sampled value counts,
+    # as when the sampled values are kept by LGBM_DatasetCreateFromSampledColumn
+    num_data, num_feature = 1000, 60
+    params = 'verbose=-1 min_data_in_leaf=5 max_conflict_rate=0.1'
+    for seed in range(3):
+        rng = np.random.RandomState(seed)
+        mat = np.zeros((num_data, num_feature))
+        for j in range(num_feature):
+            hit = rng.rand(num_data) < rng.choice([0.02, 0.05, 0.1, 0.2])
+            if rng.rand() < 0.4:
+                mat[:, j] = np.where(hit, 0.0, 1.0)
+            else:
+                mat[:, j] = np.where(hit, rng.rand(num_data) + 0.5, 0.0)
+        label = (mat.sum(axis=1) + 3 * rng.rand(num_data) > 0.45 * num_feature).astype(np.float32)
+        from_mat = ctypes.c_void_p()
+        LIB.LGBM_DatasetCreateFromMat(
+            mat.ctypes.data_as(ctypes.POINTER(ctypes.c_void_p)),
+            dtype_float64,
+            num_data,
+            num_feature,
+            1,
+            c_str(params),
+            None,
+            ctypes.byref(from_mat))
+        indices = [np.nonzero(mat[:, j])[0].astype(np.int32) for j in range(num_feature)]
+        values = [np.ascontiguousarray(mat[idx, j]) for j, idx in enumerate(indices)]
+        from_sample = ctypes.c_void_p()
+        LIB.LGBM_DatasetCreateFromSampledColumn(
+            c_array(ctypes.POINTER(ctypes.c_double), [v.ctypes.data_as(ctypes.POINTER(ctypes.c_double)) for v in values]),
+            c_array(ctypes.POINTER(ctypes.c_int), [i.ctypes.data_as(ctypes.POINTER(ctypes.c_int)) for i in indices]),
+            num_feature,
+            c_array(ctypes.c_int, [len(i) for i in indices]),
+            num_data,
+            num_data,
+            c_str(params),
+            ctypes.byref(from_sample))
+        LIB.LGBM_DatasetPushRows(from_sample, mat.ctypes.data_as(ctypes.POINTER(ctypes.c_void_p)), dtype_float64,
+                                 num_data, num_feature, 0)
+        models = []
+        for train in (from_mat, from_sample):
+            LIB.LGBM_DatasetSetField(train, c_str('label'), label.ctypes.data_as(ctypes.c_void_p), num_data,
+                                     dtype_float32)
+            booster = ctypes.c_void_p()
+            LIB.LGBM_BoosterCreate(train, c_str("app=binary num_leaves=15 min_data_in_leaf=5 verbose=-1"),
+                                   ctypes.byref(booster))
+            is_finished = ctypes.c_int(0)
+            for _ in range(5):
+                LIB.LGBM_BoosterUpdateOneIter(booster, ctypes.byref(is_finished))
+            model_str = ctypes.create_string_buffer(1 << 22)
+            out_len = ctypes.c_int64(0)
+            LIB.LGBM_BoosterSaveModelToString(booster, 0, -1, ctypes.c_int64(len(model_str)), ctypes.byref(out_len),
+                                              model_str)
+            trees = model_str.value.decode('ascii')
+            models.append(trees[trees.index('Tree=0'):trees.index('end of trees')])
+            LIB.LGBM_BoosterFree(booster)
+            free_dataset(train)
+        assert models[0] == models[1]
+
+
 def test_booster():
     train = load_from_mat(os.path.join(os.path.dirname(os.path.realpath(__file__)),
                                        '../../examples/binary_classification/binary.train'), None)
@@ -278,3 +408,1052 @@ def test_booster():
         c_str(''),
         c_str('preb.txt'))
     LIB.LGBM_BoosterFree(booster2)
+
+
+def test_booster_inplace_custom_objective():
+    train = load_from_mat(os.path.join(os.path.dirname(os.path.realpath(__file__)),
+                                       '../../examples/binary_classification/binary.train'), None)
+    label_len = ctypes.c_int(0)
+    label_ptr = ctypes.c_void_p()
+    label_type = ctypes.c_int(0)
+    LIB.LGBM_DatasetGetField(train, c_str('label'), ctypes.byref(label_len),
+                             ctypes.byref(label_ptr), ctypes.byref(label_type))
+    label = np.ctypeslib.as_array(ctypes.cast(label_ptr, ctypes.POINTER(ctypes.c_float)),
+                                  shape=(label_len.value,))
+    booster = ctypes.c_void_p()
+    LIB.LGBM_BoosterCreate(
+        train,
+        c_str("objective=none num_leaves=31 verbose=-1"),
+        ctypes.byref(booster))
+    out_len = ctypes.c_int64(0)
+    grad_ptr = ctypes.POINTER(ctypes.c_float)()
+    hess_ptr = ctypes.POINTER(ctypes.c_float)()
+    assert LIB.LGBM_BoosterGetGradientBuffers(booster, ctypes.byref(out_len),
+                                              ctypes.byref(grad_ptr), ctypes.byref(hess_ptr)) == 0
+    assert out_len.value == label_len.value
+    grad = np.ctypeslib.as_array(grad_ptr, shape=(out_len.value,))
+    hess = np.ctypeslib.as_array(hess_ptr, shape=(out_len.value,))
+    score_ptr = ctypes.POINTER(ctypes.c_double)()
+    is_finished = ctypes.c_int(0)
+    for _ in range(10):
+        assert LIB.LGBM_BoosterGetTrainingScore(booster, ctypes.byref(out_len), ctypes.byref(score_ptr)) == 0
+        score = np.ctypeslib.as_array(score_ptr, shape=(out_len.value,))
+        prob = 1.0 / (1.0 + np.exp(-score))
+        grad[:] = prob - label
+        hess[:] = prob * (1.0 - prob)
+        assert LIB.LGBM_BoosterUpdateOneIterInplace(booster, ctypes.byref(is_finished)) == 0
+    score = np.ctypeslib.as_array(score_ptr, shape=(out_len.value,))
+    assert np.mean((score > 0) == (label > 0)) > 0.6
+    LIB.LGBM_BoosterFree(booster)
+    free_dataset(train)
+
+
+def test_booster_float64_custom_objective():
+    data_path = os.path.join(os.path.dirname(os.path.realpath(__file__)),
+                             '../../examples/binary_classification/binary.train')
+    label = np.loadtxt(data_path, dtype=np.float64)[:, 0]
+    models = []
+    for use_float64 in (False, True):
+        train = load_from_mat(data_path, None)
+        # label as double goes straight into the dataset without an intermediate float array
+        assert LIB.LGBM_DatasetSetField(train, c_str('label'), c_array(ctypes.c_double, label),
+                                        len(label), dtype_float64) == 0
+        booster = ctypes.c_void_p()
+        LIB.LGBM_BoosterCreate(
+            train,
+            c_str("objective=none num_leaves=31 verbose=-1"),
+            ctypes.byref(booster))
+        out_len = ctypes.c_int64(0)
+        score_ptr = ctypes.POINTER(ctypes.c_double)()
+        is_finished = ctypes.c_int(0)
+        for _ in range(10):
+            assert LIB.LGBM_BoosterGetTrainingScore(booster, ctypes.byref(out_len), ctypes.byref(score_ptr)) == 0
+            score = np.ctypeslib.as_array(score_ptr, shape=(out_len.value,))
+            prob = 1.0 / (1.0 + np.exp(-score))
+            grad = prob - label
+            hess = prob * (1.0 - prob)
+            if use_float64:
+                assert LIB.LGBM_BoosterUpdateOneIterCustomFloat64(
+                    booster, c_array(ctypes.c_double, grad), c_array(ctypes.c_double, hess),
+                    ctypes.byref(is_finished)) == 0
+            else:
+                assert LIB.LGBM_BoosterUpdateOneIterCustom(
+                    booster, c_array(ctypes.c_float, grad), c_array(ctypes.c_float, hess),
+                    ctypes.byref(is_finished)) == 0
+        buf_len = 1 << 22
+        tmp_out_len = ctypes.c_int64(0)
+        buf = ctypes.create_string_buffer(buf_len)
+        LIB.LGBM_BoosterSaveModelToString(booster, 0, -1, buf_len, ctypes.byref(tmp_out_len), buf)
+        models.append(buf.value.decode().split('parameters:')[0])
+        LIB.LGBM_BoosterFree(booster)
+        free_dataset(train)
+    assert models[0] == models[1]
+
+
+def test_booster_async_training():
+    train = load_from_mat(os.path.join(os.path.dirname(os.path.realpath(__file__)),
+                                       '../../examples/binary_classification/binary.train'), None)
+    test = load_from_mat(os.path.join(os.path.dirname(os.path.realpath(__file__)),
+                                      '../../examples/binary_classification/binary.test'), train)
+    booster = ctypes.c_void_p()
+    LIB.LGBM_BoosterCreate(
+        train,
+        c_str("objective=binary metric=auc num_leaves=31 verbose=-1"),
+        ctypes.byref(booster))
+    LIB.LGBM_BoosterAddValidData(booster, test)
+    status = ctypes.c_int(0)
+    iteration = ctypes.c_int(0)
+    elapsed = ctypes.c_double(0)
+    assert LIB.LGBM_BoosterStartTraining(booster, 20) == 0
+    # the booster cannot be changed by other calls while training in background
+    is_finished = ctypes.c_int(0)
+    assert LIB.LGBM_BoosterUpdateOneIter(booster, ctypes.byref(is_finished)) != 0
+    while True:
+        assert LIB.LGBM_BoosterGetTrainingProgress(booster, ctypes.byref(status),
+                                                   ctypes.byref(iteration), ctypes.byref(elapsed)) == 0
+        if status.value != 1:
+            break
+        time.sleep(0.01)
+    assert LIB.LGBM_BoosterWaitTraining(booster, ctypes.byref(status)) == 0
+    assert status.value == 2
+    assert iteration.value == 20
+    result = np.zeros(1, dtype=np.float64)
+    out_len = ctypes.c_int(0)
+    assert LIB.LGBM_BoosterGetTrainingEval(booster, 1, ctypes.byref(iteration), ctypes.byref(out_len),
+                                           result.ctypes.data_as(ctypes.POINTER(ctypes.c_double))) == 0
+    assert iteration.value == 20
+    assert out_len.value == 1
+    assert result[0] > 0.75
+    # cancellation stops at an iteration boundary, and the booster can be used again afterwards
+    assert LIB.LGBM_BoosterStartTraining(booster, 100000) == 0
+    assert LIB.LGBM_BoosterCancelTraining(booster) == 0
+    assert LIB.LGBM_BoosterWaitTraining(booster, ctypes.byref(status)) == 0
+    assert status.value == 4
+    assert LIB.LGBM_BoosterUpdateOneIter(booster, ctypes.byref(is_finished)) == 0
+    LIB.LGBM_BoosterFree(booster)
+    free_dataset(train)
+    free_dataset(test)
+
+
+def test_booster_async_training_calls():
+    train = load_from_mat(os.path.join(os.path.dirname(os.path.realpath(__file__)),
+                                       '../../examples/binary_classification/binary.train'), None)
+    num_data = ctypes.c_int(0)
+    LIB.LGBM_DatasetGetNumData(train, ctypes.byref(num_data))
+    num_feature = ctypes.c_int(0)
+    LIB.LGBM_DatasetGetNumFeature(train, ctypes.byref(num_feature))
+    booster = ctypes.c_void_p()
+    LIB.LGBM_BoosterCreate(train, c_str("objective=binary metric=auc num_leaves=31 verbose=-1"), ctypes.byref(booster))
+    other = ctypes.c_void_p()
+    LIB.LGBM_BoosterCreate(train, c_str("objective=binary num_leaves=31 verbose=-1"), ctypes.byref(other))
+    is_finished = ctypes.c_int(0)
+    LIB.LGBM_BoosterUpdateOneIter(other, ctypes.byref(is_finished))
+    status = ctypes.c_int(0)
+    iteration = ctypes.c_int(0)
+    elapsed = ctypes.c_double(0)
+    assert LIB.LGBM_BoosterStartTraining(booster, 100000) == 0
+    while iteration.value < 1:
+        time.sleep(0.01)
+        LIB.LGBM_BoosterGetTrainingProgress(booster, ctypes.byref(status), ctypes.byref(iteration),
+                                            ctypes.byref(elapsed))
+    # calls changing the model or the training state are rejected
+    out_len = ctypes.c_int64(0)
+    grad = ctypes.POINTER(ctypes.c_float)()
+    hess = ctypes.POINTER(ctypes.c_float)()
+    score = ctypes.POINTER(ctypes.c_double)()
+    assert LIB.LGBM_BoosterUpdateOneIter(booster, ctypes.byref(is_finished)) != 0
+    assert LIB.LGBM_BoosterRollbackOneIter(booster) != 0
+    assert LIB.LGBM_BoosterResetParameter(booster, c_str('learning_rate=0.05')) != 0
+    assert LIB.LGBM_BoosterShuffleModels(booster, 0, -1) != 0
+    assert LIB.LGBM_BoosterSetLeafValue(booster, 0, 0, ctypes.c_double(1.0)) != 0
+    assert LIB.LGBM_BoosterMerge(booster, other) != 0
+    assert LIB.LGBM_BoosterGetGradientBuffers(booster, ctypes.byref(out_len), ctypes.byref(grad),
+                                              ctypes.byref(hess)) != 0
+    assert LIB.LGBM_BoosterGetTrainingScore(booster, ctypes.byref(out_len), ctypes.byref(score)) != 0
+    # calls reading the model wait for the current iteration
+    pred = np.zeros(num_data.value, dtype=np.float64)
+    assert LIB.LGBM_BoosterGetPredict(booster, 0, ctypes.byref(out_len),
+                                      pred.ctypes.data_as(ctypes.POINTER(ctypes.c_double))) == 0
+    eval_len = ctypes.c_int(0)
+    result = np.zeros(1, dtype=np.float64)
+    assert LIB.LGBM_BoosterGetEval(booster, 0, ctypes.byref(eval_len),
+                                   result.ctypes.data_as(ctypes.POINTER(ctypes.c_double))) == 0
+    assert LIB.LGBM_BoosterSaveModel(booster, 0, -1, c_str('async_model.txt')) == 0
+    model_str = ctypes.create_string_buffer(1 << 25)
+    assert LIB.LGBM_BoosterDumpModel(booster, 0, -1, ctypes.c_int64(len(model_str)), ctypes.byref(out_len),
+                                     model_str) == 0
+    importance = np.zeros(num_feature.value, dtype=np.float64)
+    assert LIB.LGBM_BoosterFeatureImportance(booster, 0, 0,
+                                             importance.ctypes.data_as(ctypes.POINTER(ctypes.c_double))) == 0
+    leaf_value = ctypes.c_double(0)
+    assert LIB.LGBM_BoosterGetLeafValue(booster, 0, 0, ctypes.byref(leaf_value)) == 0
+    assert LIB.LGBM_BoosterSaveModelToString(booster, 0, -1, ctypes.c_int64(len(model_str)), ctypes.byref(out_len),
+                                             model_str) == 0
+    # the saved model is complete
+    loaded = ctypes.c_void_p()
+    num_iterations = ctypes.c_int(0)
+    assert LIB.LGBM_BoosterLoadModelFromString(model_str, ctypes.byref(num_iterations), ctypes.byref(loaded)) == 0
+    assert num_iterations.value >= 1
+    LIB.LGBM_BoosterFree(loaded)
+    assert LIB.LGBM_BoosterCancelTraining(booster) == 0
+    assert LIB.LGBM_BoosterWaitTraining(booster, ctypes.byref(status)) == 0
+    assert LIB.LGBM_BoosterShuffleModels(booster, 0, -1) == 0
+    assert LIB.LGBM_BoosterSetLeafValue(booster, 0, 0, ctypes.c_double(1.0)) == 0
+    LIB.LGBM_BoosterFree(other)
+    LIB.LGBM_BoosterFree(booster)
+    free_dataset(train)
+
+
+def test_booster_predict_for_bins():
+    train = load_from_mat(os.path.join(os.path.dirname(os.path.realpath(__file__)),
+                                       '../../examples/binary_classification/binary.train'), None)
+    booster = ctypes.c_void_p()
+    LIB.LGBM_BoosterCreate(
+        train,
+        c_str("app=binary num_leaves=31 verbose=-1"),
+        ctypes.byref(booster))
+    is_finished = ctypes.c_int(0)
+    for _ in range(20):
+        LIB.LGBM_BoosterUpdateOneIter(booster, ctypes.byref(is_finished))
+    mat = np.loadtxt(os.path.join(os.path.dirname(os.path.realpath(__file__)),
+                                  '../../examples/binary_classification/binary.test'))[:, 1:]
+    mat[::7, 3] = np.nan
+    mat[::5, 5] = 0.0
+    # the bins must follow the changes of the model
+    for step in range(2):
+        if step > 0:
+            LIB.LGBM_BoosterSetLeafValue(booster, 0, 0, ctypes.c_double(1.0))
+            for _ in range(5):
+                LIB.LGBM_BoosterUpdateOneIter(booster, ctypes.byref(is_finished))
+        bins = np.zeros(mat.shape, dtype=np.uint16)
+        for j in range(mat.shape[1]):
+            bounds = np.zeros(mat.shape[0] + 2, dtype=np.float64)
+            num_bounds = ctypes.c_int64(0)
+            assert LIB.LGBM_BoosterGetFeatureBinUpperBounds(
+                booster, j, bounds.size, ctypes.byref(num_bounds),
+                bounds.ctypes.data_as(ctypes.POINTER(ctypes.c_double))) == 0
+            bounds = bounds[:num_bounds.value]
+            bins[:, j] = np.searchsorted(bounds, mat[:, j], side='left')
+            bins[np.isnan(mat[:, j]), j] = bounds.size + 1
+        expected = np.zeros(mat.shape[0], dtype=np.float64)
+        result = np.zeros(mat.shape[0], dtype=np.float64)
+        num_preb = ctypes.c_int64(0)
+        data = np.ascontiguousarray(mat)
+        LIB.LGBM_BoosterPredictForMat(
+            booster,
+            data.ctypes.data_as(ctypes.POINTER(ctypes.c_void_p)),
+            dtype_float64,
+            mat.shape[0],
+            mat.shape[1],
+            1,
+            1,
+            -1,
+            c_str(''),
+            ctypes.byref(num_preb),
+            expected.ctypes.data_as(ctypes.POINTER(ctypes.c_double)))
+        for bin_data, dtype in [(np.ascontiguousarray(bins), dtype_uint16),
+                                (np.ascontiguousarray(bins.astype(np.uint8)), dtype_uint8)]:
+            assert LIB.LGBM_BoosterPredictForBins(
+                booster,
+                bin_data.ctypes.data_as(ctypes.POINTER(ctypes.c_void_p)),
+                dtype,
+                mat.shape[0],
+                mat.shape[1],
+                1,
+                1,
+                -1,
+                c_str(''),
+                ctypes.byref(num_preb),
+                result.ctypes.data_as(ctypes.POINTER(ctypes.c_double))) == 0
+            np.testing.assert_allclose(result, expected)
+    LIB.LGBM_BoosterFree(booster)
+    free_dataset(train)
+
+
+def test_booster_predict_float32():
+    train = load_from_mat(os.path.join(os.path.dirname(os.path.realpath(__file__)),
+                                       '../../examples/binary_classification/binary.train'), None)
+    booster = ctypes.c_void_p()
+    LIB.LGBM_BoosterCreate(
+        train,
+        c_str("app=binary num_leaves=31 verbose=-1"),
+        ctypes.byref(booster))
+    is_finished = ctypes.c_int(0)
+    for _ in range(20):
+        LIB.LGBM_BoosterUpdateOneIter(booster, ctypes.byref(is_finished))
+    mat = np.loadtxt(os.path.join(os.path.dirname(os.path.realpath(__file__)),
+                                  '../../examples/binary_classification/binary.test'))[:, 1:]
+    mat[::7, 3] = np.nan
+    mat32 = np.ascontiguousarray(mat, dtype=np.float32)
+    mat64 = np.ascontiguousarray(mat32, dtype=np.float64)
+    num_preb = ctypes.c_int64(0)
+    for predict_type, num_pred_one_row in [(0, 1), (2, 20)]:
+        expected = np.zeros(mat.shape[0] * num_pred_one_row, dtype=np.float64)
+        result = np.zeros(mat.shape[0] * num_pred_one_row, dtype=np.float64)
+        for data, dtype, out in [(mat64, dtype_float64, expected), (mat32, dtype_float32, result)]:
+            LIB.LGBM_BoosterPredictForMat(
+                booster,
+                data.ctypes.data_as(ctypes.POINTER(ctypes.c_void_p)),
+                dtype,
+                mat.shape[0],
+                mat.shape[1],
+                1,
+                predict_type,
+                -1,
+                c_str(''),
+                ctypes.byref(num_preb),
+                out.ctypes.data_as(ctypes.POINTER(ctypes.c_double)))
+        np.testing.assert_array_equal(result, expected)
+    LIB.LGBM_BoosterFree(booster)
+    free_dataset(train)
+
+
+def test_booster_init_score_on_bins():
+    # initial scores of an input model are only computed by the command line application
+    cli_path = find_cli_path()
+    if not cli_path:
+        return
+    exe = cli_path[0]
+    mat = np.loadtxt(os.path.join(os.path.dirname(os.path.realpath(__file__)),
+                                  '../../examples/binary_classification/binary.train'))
+    np.savetxt('init_score.train', mat, delimiter='\t')
+    if os.path.exists('init_score.train.init_score_cache'):
+        os.remove('init_score.train.init_score_cache')
+    params = ['task=train', 'data=init_score.train', 'objective=binary', 'num_leaves=15', 'verbose=1']
+    subprocess.check_output([exe] + params + ['num_trees=10', 'output_model=init_score_model.txt'])
+    booster = ctypes.c_void_p()
+    num_total_model = ctypes.c_int(0)
+    LIB.LGBM_BoosterCreateFromModelfile(c_str('init_score_model.txt'), ctypes.byref(num_total_model),
+                                        ctypes.byref(booster))
+    data = np.ascontiguousarray(mat[:, 1:])
+    expected = np.zeros(data.shape[0], dtype=np.float64)
+    num_preb = ctypes.c_int64(0)
+    LIB.LGBM_BoosterPredictForMat(
+        booster,
+        data.ctypes.data_as(ctypes.POINTER(ctypes.c_void_p)),
+        dtype_float64,
+        data.shape[0],
+        data.shape[1],
+        1,
+        1,
+        -1,
+        c_str(''),
+        ctypes.byref(num_preb),
+        expected.ctypes.data_as(ctypes.POINTER(ctypes.c_double)))
+    LIB.LGBM_BoosterFree(booster)
+    models = []
+    for step in range(2):
+        log = subprocess.check_output([exe] + params + ['num_trees=5', 'input_model=init_score_model.txt',
+                                                        'init_score_cache=true',
+                                                        'output_model=init_score_model_%d.txt' % step])
+        # the scores are computed on the bins, then read from the cache file
+        assert (b'Loaded initial scores from cache file' in log) == (step > 0)
+        with open('init_score.train.init_score_cache', 'rb') as cache:
+            content = cache.read()
+        header_size = len(b'______LightGBM_Init_Score_Cache______\n') + 3 * ctypes.sizeof(ctypes.c_size_t)
+        np.testing.assert_allclose(np.frombuffer(content[header_size:], dtype=np.float64), expected, rtol=1e-12)
+        with open('init_score_model_%d.txt' % step, 'r') as model_file:
+            trees = model_file.read()
+        models.append(trees[trees.index('Tree=0'):trees.index('end of trees')])
+    assert models[0] == models[1]
+
+
+def test_booster_checkpoint():
+    # checkpoints are only saved and resumed by the command line application
+    cli_path = find_cli_path()
+    if not cli_path:
+        return
+    exe = cli_path[0]
+    params = ['task=train', 'objective=binary', 'metric=auc', 'num_leaves=15', 'verbose=1',
+              'bagging_fraction=0.7', 'bagging_freq=2', 'feature_fraction=0.8', 'early_stopping_round=50',
+              'data=' + os.path.join(os.path.dirname(os.path.realpath(__file__)),
+                                     '../../examples/binary_classification/binary.train'),
+              'valid=' + os.path.join(os.path.dirname(os.path.realpath(__file__)),
+                                      '../../examples/binary_classification/binary.test')]
+    checkpoint_params = ['checkpoint_freq=4', 'checkpoint_prefix=checkpoint_model']
+    subprocess.check_output([exe] + params + ['num_trees=5', 'output_model=checkpoint_init.txt'])
+    # training from scratch, and continued training whose input model is not part of the checkpoints
+    for init_params in ([], ['input_model=checkpoint_init.txt']):
+        for filename in os.listdir('.'):
+            if filename.startswith('checkpoint_model.'):
+                os.remove(filename)
+        subprocess.check_output([exe] + params + init_params + ['num_trees=20', 'output_model=checkpoint_straight.txt'])
+        # stop after the checkpoint of iteration 12, then resume from it
+        subprocess.check_output([exe] + params + init_params + checkpoint_params
+                                + ['num_trees=13', 'output_model=checkpoint_part.txt'])
+        log = subprocess.check_output([exe] + params + init_params + checkpoint_params
+                                      + ['num_trees=20', 'output_model=checkpoint_resumed.txt'])
+        assert b'Resumed training from checkpoint checkpoint_model.rank_0.iter_12' in log
+        models = []
+        for filename in ('checkpoint_straight.txt', 'checkpoint_resumed.txt'):
+            with open(filename, 'r') as model_file:
+                model = model_file.read()
+            # only the parameters differ
+            models.append(model[:model.index('\nparameters:')] + model[model.index('end of parameters'):])
+        assert models[0] == models[1]
+        # only the last two checkpoints are kept
+        assert sorted(filename for filename in os.listdir('.') if filename.startswith('checkpoint_model.')) \
+            == ['checkpoint_model.rank_0.iter_16', 'checkpoint_model.rank_0.iter_20', 'checkpoint_model.rank_0.latest']
+
+
+def test_booster_predict_by_map():
+    # sparse rows of a model with many features are predicted by map
+    num_data, num_feature = 1000, 200000
+    rng = np.random.RandomState(0)
+    cols = np.array([np.sort(rng.choice(100, 5, replace=False)) * 2000 for _ in range(num_data)])
+    vals = rng.rand(num_data, 5)
+    csr = sparse.csr_matrix((vals.ravel(), cols.ravel(), np.arange(0, num_data * 5 + 1, 5)),
+                            shape=(num_data, num_feature))
+    label = np.where(cols < 20000, vals, 0.0).sum(axis=1).astype(np.float32)
+    train = ctypes.c_void_p()
+    LIB.LGBM_DatasetCreateFromCSR(
+        csr.indptr.ctypes.data_as(ctypes.POINTER(ctypes.c_int32)),
+        dtype_int32,
+        csr.indices.ctypes.data_as(ctypes.POINTER(ctypes.c_int32)),
+        csr.data.ctypes.data_as(ctypes.POINTER(ctypes.c_void_p)),
+        dtype_float64,
+        ctypes.c_int64(len(csr.indptr)),
+        ctypes.c_int64(len(csr.data)),
+        ctypes.c_int64(num_feature),
+        c_str('min_data_in_leaf=5 verbose=-1'),
+        None,
+        ctypes.byref(train))
+    LIB.LGBM_DatasetSetField(train, c_str('label'), label.ctypes.data_as(ctypes.c_void_p), num_data, dtype_float32)
+    booster = ctypes.c_void_p()
+    LIB.LGBM_BoosterCreate(
+        train,
+        c_str("app=regression num_leaves=7 verbose=-1"),
+        ctypes.byref(booster))
+    is_finished = ctypes.c_int(0)
+    for _ in range(10):
+        LIB.LGBM_BoosterUpdateOneIter(booster, ctypes.byref(is_finished))
+
+    def predict_rows(handle):
+        preds = np.zeros(num_data, dtype=np.float64)
+        num_preb = ctypes.c_int64(0)
+        for i in range(num_data):
+            row = csr[i]
+            LIB.LGBM_BoosterPredictForCSRSingleRow(
+                handle,
+                row.indptr.ctypes.data_as(ctypes.POINTER(ctypes.c_int32)),
+                dtype_int32,
+                row.indices.ctypes.data_as(ctypes.POINTER(ctypes.c_int32)),
+                row.data.ctypes.data_as(ctypes.POINTER(ctypes.c_void_p)),
+                dtype_float64,
+                ctypes.c_int64(len(row.indptr)),
+                ctypes.c_int64(len(row.data)),
+                ctypes.c_int64(num_feature),
+                0,
+                -1,
+                c_str(''),
+                ctypes.byref(num_preb),
+                preds[i:].ctypes.data_as(ctypes.POINTER(ctypes.c_double)))
+        return preds
+
+    predict_rows(booster)
+    # replaces the last trees by different ones, the total number of trees is the same
+    LIB.LGBM_BoosterRollbackOneIter(booster)
+    LIB.LGBM_BoosterResetParameter(booster, c_str("learning_rate=0.5"))
+    LIB.LGBM_BoosterUpdateOneIter(booster, ctypes.byref(is_finished))
+    preds = predict_rows(booster)
+    model_str = ctypes.create_string_buffer(1 << 22)
+    out_len = ctypes.c_int64(0)
+    LIB.LGBM_BoosterSaveModelToString(booster, 0, -1, ctypes.c_int64(len(model_str)), ctypes.byref(out_len), model_str)
+    loaded_booster = ctypes.c_void_p()
+    num_total_model = ctypes.c_int(0)
+    LIB.LGBM_BoosterLoadModelFromString(model_str, ctypes.byref(num_total_model), ctypes.byref(loaded_booster))
+    np.testing.assert_allclose(preds, predict_rows(loaded_booster))
+    LIB.LGBM_BoosterFree(loaded_booster)
+    LIB.LGBM_BoosterFree(booster)
+    free_dataset(train)
+
+
+def test_booster_num_threads():
+    # several row blocks per leaf
+    num_data, num_feature = 50000, 3
+    rng = np.random.RandomState(0)
+    mat = rng.rand(num_data, num_feature)
+    label = (mat[:, 0] + mat[:, 1] * mat[:, 2] + rng.rand(num_data) > 1.0).astype(np.float32)
+    models = []
+    for num_threads in (1, 4):
+        train = ctypes.c_void_p()
+        LIB.LGBM_DatasetCreateFromMat(
+            mat.ctypes.data_as(ctypes.POINTER(ctypes.c_void_p)),
+            dtype_float64,
+            num_data,
+            num_feature,
+            1,
+            c_str('verbose=-1 num_threads=%d' % num_threads),
+            None,
+            ctypes.byref(train))
+        LIB.LGBM_DatasetSetField(train, c_str('label'), label.ctypes.data_as(ctypes.c_void_p), num_data, dtype_float32)
+        booster = ctypes.c_void_p()
+        LIB.LGBM_BoosterCreate(
+            train,
+            c_str("app=binary num_leaves=31 verbose=-1 num_threads=%d" % num_threads),
+            ctypes.byref(booster))
+        is_finished = ctypes.c_int(0)
+        for _ in range(20):
+            LIB.LGBM_BoosterUpdateOneIter(booster, ctypes.byref(is_finished))
+        model_str = ctypes.create_string_buffer(1 << 22)
+        out_len = ctypes.c_int64(0)
+        LIB.LGBM_BoosterSaveModelToString(booster, 0, -1, ctypes.c_int64(len(model_str)), ctypes.byref(out_len),
+                                          model_str)
+        trees = model_str.value.decode('ascii')
+        models.append(trees[trees.index('Tree=0'):trees.index('end of trees')])
+        LIB.LGBM_BoosterFree(booster)
+        free_dataset(train)
+    # histograms are summed in the same order with any number of threads
+    assert models[0] == models[1]
+
+
+def test_booster_predict_multi():
+    train = load_from_mat(os.path.join(os.path.dirname(os.path.realpath(__file__)),
+                                       '../../examples/binary_classification/binary.train'), None)
+    boosters = []
+    for num_leaves in [7, 31, 63]:
+        booster = ctypes.c_void_p()
+        LIB.LGBM_BoosterCreate(
+            train,
+            c_str("app=binary num_leaves=%d verbose=-1" % num_leaves),
+            ctypes.byref(booster))
+        is_finished = ctypes.c_int(0)
+        for _ in range(10):
+            LIB.LGBM_BoosterUpdateOneIter(booster, ctypes.byref(is_finished))
+        boosters.append(booster)
+    mat = np.loadtxt(os.path.join(os.path.dirname(os.path.realpath(__file__)),
+                                  '../../examples/binary_classification/binary.test'))[:, 1:]
+    mat[::7, 3] = np.nan
+    mat = np.asfortranarray(mat)
+    handles = (ctypes.c_void_p * len(boosters))(*[booster.value for booster in boosters])
+    num_preb = ctypes.c_int64(0)
+    for predict_type, num_pred_one_row in [(0, 1), (2, 10), (3, mat.shape[1] + 1)]:
+        expected = []
+        for booster in boosters:
+            out = np.zeros(mat.shape[0] * num_pred_one_row, dtype=np.float64)
+            LIB.LGBM_BoosterPredictForMat(
+                booster,
+                mat.ctypes.data_as(ctypes.POINTER(ctypes.c_void_p)),
+                dtype_float64,
+                mat.shape[0],
+                mat.shape[1],
+                0,
+                predict_type,
+                -1,
+                c_str(''),
+                ctypes.byref(num_preb),
+                out.ctypes.data_as(ctypes.POINTER(ctypes.c_double)))
+            expected.append(out.reshape(mat.shape[0], num_pred_one_row))
+        result = np.zeros(mat.shape[0] * num_pred_one_row * len(boosters), dtype=np.float64)
+        LIB.LGBM_BoosterPredictForMatMulti(
+            handles,
+            len(boosters),
+            mat.ctypes.data_as(ctypes.POINTER(ctypes.c_void_p)),
+            dtype_float64,
+            mat.shape[0],
+            mat.shape[1],
+            0,
+            predict_type,
+            -1,
+            c_str(''),
+            ctypes.byref(num_preb),
+            result.ctypes.data_as(ctypes.POINTER(ctypes.c_double)))
+        assert num_preb.value == result.size
+        np.testing.assert_allclose(result.reshape(mat.shape[0], -1), np.hstack(expected))
+    for booster in boosters:
+        LIB.LGBM_BoosterFree(booster)
+    free_dataset(train)
+
+
+def test_booster_single_row_predictor_reuse():
+    train = load_from_mat(os.path.join(os.path.dirname(os.path.realpath(__file__)),
+                                       '../../examples/binary_classification/binary.train'), None)
+    booster = ctypes.c_void_p()
+    LIB.LGBM_BoosterCreate(
+        train,
+        c_str("app=binary num_leaves=31 verbose=-1"),
+        ctypes.byref(booster))
+    is_finished = ctypes.c_int(0)
+    for _ in range(20):
+        LIB.LGBM_BoosterUpdateOneIter(booster, ctypes.byref(is_finished))
+    mat = np.loadtxt(os.path.join(os.path.dirname(os.path.realpath(__file__)),
+                                  '../../examples/binary_classification/binary.test'))[:50, 1:]
+    mat = np.ascontiguousarray(mat, dtype=np.float64)
+    num_preb = ctypes.c_int64(0)
+
+    def predict_rows():
+        result = np.zeros(mat.shape[0], dtype=np.float64)
+        for i in range(mat.shape[0]):
+            LIB.LGBM_BoosterPredictForMatSingleRow(
+                booster,
+                mat[i].ctypes.data_as(ctypes.POINTER(ctypes.c_void_p)),
+                dtype_float64,
+                mat.shape[1],
+                1,
+                0,
+                -1,
+                c_str(''),
+                ctypes.byref(num_preb),
+                result[i:].ctypes.data_as(ctypes.POINTER(ctypes.c_double)))
+        return result
+
+    expected = predict_rows()
+    # a batch prediction with other settings in between must not change the reused single row predictor
+    batch_result = np.zeros(mat.shape[0], dtype=np.float64)
+    LIB.LGBM_BoosterPredictForMat(
+        booster,
+        mat.ctypes.data_as(ctypes.POINTER(ctypes.c_void_p)),
+        dtype_float64,
+        mat.shape[0],
+        mat.shape[1],
+        1,
+        0,
+        5,
+        c_str('pred_tree_parallel_threshold=1'),
+        ctypes.byref(num_preb),
+        batch_result.ctypes.data_as(ctypes.POINTER(ctypes.c_double)))
+    assert not np.allclose(batch_result, expected)
+    np.testing.assert_array_equal(predict_rows(), expected)
+    LIB.LGBM_BoosterFree(booster)
+    free_dataset(train)
+
+
+def test_booster_predict_cache():
+    train = load_from_mat(os.path.join(os.path.dirname(os.path.realpath(__file__)),
+                                       '../../examples/binary_classification/binary.train'), None)
+    booster = ctypes.c_void_p()
+    LIB.LGBM_BoosterCreate(
+        train,
+        c_str("app=binary num_leaves=31 verbose=-1"),
+        ctypes.byref(booster))
+    is_finished = ctypes.c_int(0)
+    for _ in range(10):
+        LIB.LGBM_BoosterUpdateOneIter(booster, ctypes.byref(is_finished))
+    mat = np.loadtxt(os.path.join(os.path.dirname(os.path.realpath(__file__)),
+                                  '../../examples/binary_classification/binary.test'))[:100, 1:]
+    mat = np.ascontiguousarray(mat, dtype=np.float64)
+    num_preb = ctypes.c_int64(0)
+
+    def predict_rows(parameter):
+        result = np.zeros(mat.shape[0], dtype=np.float64)
+        for i in range(mat.shape[0]):
+            LIB.LGBM_BoosterPredictForMatSingleRow(
+                booster,
+                mat[i].ctypes.data_as(ctypes.POINTER(ctypes.c_void_p)),
+                dtype_float64,
+                mat.shape[1],
+                1,
+                0,
+                -1,
+                c_str(parameter),
+                ctypes.byref(num_preb),
+                result[i:].ctypes.data_as(ctypes.POINTER(ctypes.c_double)))
+        return result
+
+    def cache_stats():
+        stats = [ctypes.c_int64(0) for _ in range(3)]
+        LIB.LGBM_BoosterGetPredictCacheStats(booster, *[ctypes.byref(stat) for stat in stats])
+        return [stat.value for stat in stats]
+
+    expected = predict_rows('')
+    np.testing.assert_array_equal(predict_rows('pred_cache_size=1600'), expected)
+    np.testing.assert_array_equal(predict_rows('pred_cache_size=1600'), expected)
+    assert cache_stats() == [mat.shape[0], mat.shape[0], mat.shape[0]]
+    LIB.LGBM_BoosterSetLeafValue(booster, 0, 0, ctypes.c_double(1.0))
+    assert cache_stats()[2] == 0
+    np.testing.assert_array_equal(predict_rows('pred_cache_size=1600'), predict_rows(''))
+    # predictions with early stopping are cached apart from the full ones
+    early_stop = 'pred_early_stop=true pred_early_stop_freq=1 pred_early_stop_margin=0.5'
+    predict_rows('pred_cache_size=1600')
+    expected = predict_rows(early_stop)
+    assert not np.allclose(expected, predict_rows(''))
+    np.testing.assert_array_equal(predict_rows('pred_cache_size=1600 ' + early_stop), expected)
+    np.testing.assert_array_equal(predict_rows('pred_cache_size=1600 ' + early_stop.replace('0.5', '1.5')),
+                                  predict_rows(early_stop.replace('0.5', '1.5')))
+    LIB.LGBM_BoosterFree(booster)
+    free_dataset(train)
+
+
+def test_booster_compact_model():
+    train = load_from_mat(os.path.join(os.path.dirname(os.path.realpath(__file__)),
+                                       '../../examples/binary_classification/binary.train'), None)
+    booster = ctypes.c_void_p()
+    LIB.LGBM_BoosterCreate(
+        train,
+        c_str("app=binary num_leaves=2 verbose=-1"),
+        ctypes.byref(booster))
+    is_finished = ctypes.c_int(0)
+    for _ in range(50):
+        LIB.LGBM_BoosterUpdateOneIter(booster, ctypes.byref(is_finished))
+    mat = np.loadtxt(os.path.join(os.path.dirname(os.path.realpath(__file__)),
+                                  '../../examples/binary_classification/binary.test'))[:, 1:]
+    num_preb = ctypes.c_int64(0)
+
+    def predict(predict_type, num_pred_one_row):
+        result = np.zeros(mat.shape[0] * num_pred_one_row, dtype=np.float64)
+        LIB.LGBM_BoosterPredictForMat(
+            booster,
+            mat.ctypes.data_as(ctypes.POINTER(ctypes.c_void_p)),
+            dtype_float64,
+            mat.shape[0],
+            mat.shape[1],
+            1,
+            predict_type,
+            -1,
+            c_str(''),
+            ctypes.byref(num_preb),
+            result.ctypes.data_as(ctypes.POINTER(ctypes.c_double)))
+        return result
+
+    expected = predict(1, 1)
+    leaf_preds = np.ascontiguousarray(predict(2, 50), dtype=np.int32)
+    num_removed_iterations = ctypes.c_int(0)
+    # leaf indices out of the trees and rows of another number of trees are rejected
+    bad_leaf_preds = leaf_preds.copy()
+    bad_leaf_preds[-1] = 2
+    assert LIB.LGBM_BoosterCompactModel(
+        booster,
+        bad_leaf_preds.ctypes.data_as(ctypes.POINTER(ctypes.c_int32)),
+        mat.shape[0],
+        50,
+        ctypes.byref(num_removed_iterations)) != 0
+    assert LIB.LGBM_BoosterCompactModel(
+        booster,
+        leaf_preds.ctypes.data_as(ctypes.POINTER(ctypes.c_int32)),
+        1,
+        49,
+        ctypes.byref(num_removed_iterations)) != 0
+    LIB.LGBM_BoosterCompactModel(
+        booster,
+        leaf_preds.ctypes.data_as(ctypes.POINTER(ctypes.c_int32)),
+        mat.shape[0],
+        50,
+        ctypes.byref(num_removed_iterations))
+    assert num_removed_iterations.value > 0
+    num_iterations = ctypes.c_int(0)
+    LIB.LGBM_BoosterGetCurrentIteration(booster, ctypes.byref(num_iterations))
+    assert num_iterations.value == 50 - num_removed_iterations.value
+    np.testing.assert_allclose(predict(1, 1), expected)
+    LIB.LGBM_BoosterFree(booster)
+    free_dataset(train)
+
+
+def test_booster_memory_usage():
+    train = load_from_mat(os.path.join(os.path.dirname(os.path.realpath(__file__)),
+                                       '../../examples/binary_classification/binary.train'), None)
+    usages = []
+    for params in ("app=binary num_leaves=31 verbose=-1",
+                   "app=binary num_leaves=31 verbose=-1 memory_budget=1.5"):
+        booster = ctypes.c_void_p()
+        LIB.LGBM_BoosterCreate(
+            train,
+            c_str(params),
+            ctypes.byref(booster))
+        is_finished = ctypes.c_int(0)
+        for _ in range(10):
+            LIB.LGBM_BoosterUpdateOneIter(booster, ctypes.byref(is_finished))
+        LIB.LGBM_BoosterRollbackOneIter(booster)
+        LIB.LGBM_BoosterUpdateOneIter(booster, ctypes.byref(is_finished))
+        usage = get_memory_usage(booster)
+        assert usage['total']['current'] == sum(v['current'] for k, v in usage.items() if k != 'total')
+        assert all(v['peak'] >= v['current'] for v in usage.values())
+        # the size of the trees counted while training is the one of a full count
+        leaf_value = ctypes.c_double(0)
+        LIB.LGBM_BoosterGetLeafValue(booster, 0, 0, ctypes.byref(leaf_value))
+        LIB.LGBM_BoosterSetLeafValue(booster, 0, 0, leaf_value)
+        assert get_memory_usage(booster)['models']['current'] == usage['models']['current']
+        usages.append(usage)
+        LIB.LGBM_BoosterFree(booster)
+    assert usages[1]['histogram_pool']['peak'] < usages[0]['histogram_pool']['peak']
+    assert usages[1]['total']['current'] <= 1.5 * 1024 * 1024
+
+
+def test_booster_feature_pruning():
+    train = load_from_mat(os.path.join(os.path.dirname(os.path.realpath(__file__)),
+                                       '../../examples/binary_classification/binary.train'), None)
+    num_feature = ctypes.c_int(0)
+    LIB.LGBM_DatasetGetNumFeature(train, ctypes.byref(num_feature))
+
+    num_used_features = []
+    for params in ("app=binary num_leaves=15 verbose=-1",
+                   "app=binary num_leaves=15 verbose=-1 feature_pruning_rounds=2 "
+                   "feature_pruning_gain_ratio=0.5 feature_pruning_recheck_freq=100"):
+        booster = ctypes.c_void_p()
+        LIB.LGBM_BoosterCreate(
+            train,
+            c_str(params),
+            ctypes.byref(booster))
+        is_finished = ctypes.c_int(0)
+        for _ in range(30):
+            LIB.LGBM_BoosterUpdateOneIter(booster, ctypes.byref(is_finished))
+            # the features with the largest gains are never pruned
+            assert is_finished.value == 0
+        split_counts = (ctypes.c_double * num_feature.value)()
+        LIB.LGBM_BoosterFeatureImportance(
+            booster,
+            ctypes.c_int(-1),
+            ctypes.c_int(0),
+            split_counts)
+        num_used_features.append(sum(1 for count in split_counts if count > 0))
+        LIB.LGBM_BoosterFree(booster)
+    assert num_used_features[1] < num_used_features[0]
+    free_dataset(train)
+
+    # feature k only tells class k apart, each class prunes the features of the others
+    num_data, num_feature, num_class = 3000, 8, 3
+    rng = np.random.RandomState(0)
+    label = rng.randint(num_class, size=num_data)
+    mat = rng.rand(num_data, num_feature)
+    mat[np.arange(num_data), label] += 1.0
+    train = ctypes.c_void_p()
+    LIB.LGBM_DatasetCreateFromMat(
+        mat.ctypes.data_as(ctypes.POINTER(ctypes.c_void_p)),
+        dtype_float64,
+        num_data,
+        num_feature,
+        1,
+        c_str('verbose=-1'),
+        None,
+        ctypes.byref(train))
+    label = label.astype(np.float32)
+    LIB.LGBM_DatasetSetField(train, c_str('label'), label.ctypes.data_as(ctypes.c_void_p), num_data, dtype_float32)
+    booster = ctypes.c_void_p()
+    LIB.LGBM_BoosterCreate(
+        train,
+        c_str("app=multiclass num_class=%d num_leaves=7 verbose=-1 feature_pruning_rounds=2 "
+              "feature_pruning_gain_ratio=0.5 feature_pruning_recheck_freq=100" % num_class),
+        ctypes.byref(booster))
+    is_finished = ctypes.c_int(0)
+    for _ in range(20):
+        LIB.LGBM_BoosterUpdateOneIter(booster, ctypes.byref(is_finished))
+    model_str = ctypes.create_string_buffer(1 << 22)
+    out_len = ctypes.c_int64(0)
+    LIB.LGBM_BoosterSaveModelToString(booster, 0, -1, ctypes.c_int64(len(model_str)), ctypes.byref(out_len),
+                                      model_str)
+    split_features = [line[len('split_feature='):].split()
+                      for line in model_str.value.decode('ascii').split('\n') if line.startswith('split_feature=')]
+    for i in range(10 * num_class, len(split_features)):
+        assert str(i % num_class) in split_features[i]
+    LIB.LGBM_BoosterFree(booster)
+    free_dataset(train)
+
+
+def test_booster_histogram_sources():
+    train = load_from_mat(os.path.join(os.path.dirname(os.path.realpath(__file__)),
+                                       '../../examples/binary_classification/binary.train'), None)
+    with open('forced_splits.json', 'w') as forced_splits_file:
+        json.dump({'feature': 25, 'threshold': 1.3, 'left': {'feature': 26, 'threshold': 0.9}}, forced_splits_file)
+    train_loglosses = []
+    stats = []
+    split_features = []
+    for extra_params in ('', 'cegb_penalty_split=0.0001', 'forcedsplits_filename=forced_splits.json'):
+        booster = train_booster(train, "app=binary metric=binary_logloss num_leaves=31 min_data_in_leaf=500 verbose=-1 "
+                                + extra_params)
+        train_loglosses.append(get_train_metric(booster))
+        stats.append(get_training_stats(booster))
+        split_features.append([line[len('split_feature='):].split()
+                               for line in get_trees(booster).split('\n') if line.startswith('split_feature=')])
+        LIB.LGBM_BoosterFree(booster)
+    free_dataset(train)
+    # leaves with less than 2 * min_data_in_leaf data can't be split, so their histograms are skipped
+    assert stats[0]['skipped_histograms'] > 0
+    assert train_loglosses[0] < 0.6
+    # CEGB keeps the splits of all leaves: the same trees, with the skipped histograms subtracted
+    assert train_loglosses[1] == train_loglosses[0]
+    assert stats[1]['skipped_histograms'] == 0
+    assert stats[1]['constructed_histograms'] == stats[0]['constructed_histograms']
+    assert stats[1]['subtracted_histograms'] == stats[0]['subtracted_histograms'] + stats[0]['skipped_histograms']
+    # the forced split of a small leaf is kept
+    assert all(features[:2] == ['25', '26'] for features in split_features[2])
+
+
+def test_booster_leaf_batch():
+    train = load_from_mat(os.path.join(os.path.dirname(os.path.realpath(__file__)),
+                                       '../../examples/binary_classification/binary.train'), None)
+
+    def max_leaf_depths(trees):
+        depths = []
+        for tree in trees.split('Tree=')[1:]:
+            fields = dict(line.split('=', 1) for line in tree.split('\n')[1:] if '=' in line)
+            if int(fields['num_leaves']) == 1:
+                depths.append(0)
+                continue
+            children = [[int(child) for child in fields[name].split()] for name in ('left_child', 'right_child')]
+            # internal nodes are numbered after their parents, leaves are negative
+            node_depths = {0: 0}
+            max_depth = 0
+            for node in range(len(children[0])):
+                for child in (children[0][node], children[1][node]):
+                    if child >= 0:
+                        node_depths[child] = node_depths[node] + 1
+                    else:
+                        max_depth = max(max_depth, node_depths[node] + 1)
+            depths.append(max_depth)
+        return depths
+
+    train_loglosses = []
+    models = []
+    for extra_params in ('', 'leaf_batch_size=1', 'leaf_batch_size=4', 'leaf_batch_size=16'):
+        booster = train_booster(train, "app=binary metric=binary_logloss num_leaves=16 verbose=-1 " + extra_params)
+        train_loglosses.append(get_train_metric(booster))
+        models.append(get_trees(booster))
+        LIB.LGBM_BoosterFree(booster)
+    free_dataset(train)
+    # one leaf per round is leaf-wise growth
+    assert models[1] == models[0]
+    # every splittable leaf is split in each round, so 15 splits take at most 5 rounds,
+    # while leaf-wise growth builds deeper trees
+    assert max(max_leaf_depths(models[0])) > 5
+    assert max(max_leaf_depths(models[3])) <= 5
+    assert models[2] != models[0]
+    # the leaves with the largest gains are still split first, so the fit is close to the leaf-wise one
+    assert train_loglosses[2] < 1.02 * train_loglosses[0]
+    assert train_loglosses[3] < 1.05 * train_loglosses[0]
+
+
+def test_booster_leaf_id_partition():
+    train = load_from_mat(os.path.join(os.path.dirname(os.path.realpath(__file__)),
+                                       '../../examples/binary_classification/binary.train'), None)
+    models = []
+    stats = []
+    for leaf_id_partition_fraction in (0.0, 0.1, 0.5):
+        booster = train_booster(train, "app=binary metric=binary_logloss num_leaves=31 bagging_fraction=0.8 "
+                                "bagging_freq=1 verbose=-1 leaf_id_partition_fraction=%f" % leaf_id_partition_fraction)
+        models.append(get_trees(booster))
+        stats.append(get_training_stats(booster))
+        LIB.LGBM_BoosterFree(booster)
+    free_dataset(train)
+    # only the representation of the leaves changes, not the trees
+    assert models[1] == models[0]
+    assert models[2] == models[0]
+    assert stats[0]['leaf_id_histograms'] == 0
+    assert stats[1]['leaf_id_histograms'] > 0
+
+    # leaves of more than 32K data are constructed by row blocks, which have to hold the same data with leaf ids
+    num_data, num_feature = 100000, 2
+    rng = np.random.RandomState(0)
+    mat = rng.rand(num_data, num_feature)
+    label = (np.where(mat[:, 0] > 0.5, 1e3, 0.0) + 10 ** rng.uniform(-6, 6, num_data)).astype(np.float32)
+    train = ctypes.c_void_p()
+    LIB.LGBM_DatasetCreateFromMat(
+        mat.ctypes.data_as(ctypes.POINTER(ctypes.c_void_p)),
+        dtype_float64,
+        num_data,
+        num_feature,
+        1,
+        c_str('verbose=-1'),
+        None,
+        ctypes.byref(train))
+    LIB.LGBM_DatasetSetField(train, c_str('label'), label.ctypes.data_as(ctypes.c_void_p), num_data, dtype_float32)
+    models = []
+    stats = []
+    for leaf_id_partition_fraction in (0.0, 0.3):
+        booster = train_booster(train, "app=regression num_leaves=15 verbose=-1 leaf_id_partition_fraction=%f"
+                                % leaf_id_partition_fraction, num_iterations=10)
+        models.append(get_trees(booster))
+        stats.append(get_training_stats(booster))
+        LIB.LGBM_BoosterFree(booster)
+    free_dataset(train)
+    assert models[1] == models[0]
+    assert stats[1]['leaf_id_histograms'] > 0
+
+
+def test_booster_bitmap_bin():
+    # dense flag features, each of them is a group with 2 bins
+    num_data, num_feature = 10000, 20
+    rng = np.random.RandomState(0)
+    mat = (rng.rand(num_data, num_feature) < 0.5).astype(np.float64)
+    label = (mat[:, :3].sum(axis=1) + rng.rand(num_data) > 2.0).astype(np.float32)
+    train_loglosses = []
+    dataset_sizes = []
+    for enable_bitmap_bin in ("false", "true"):
+        train = ctypes.c_void_p()
+        LIB.LGBM_DatasetCreateFromMat(
+            mat.ctypes.data_as(ctypes.POINTER(ctypes.c_void_p)),
+            dtype_float64,
+            num_data,
+            num_feature,
+            1,
+            c_str("verbose=-1 enable_bitmap_bin=%s" % enable_bitmap_bin),
+            None,
+            ctypes.byref(train))
+        LIB.LGBM_DatasetSetField(train, c_str('label'), label.ctypes.data_as(ctypes.c_void_p), num_data, dtype_float32)
+        booster = train_booster(train, "app=binary metric=binary_logloss num_leaves=31 verbose=-1")
+        train_loglosses.append(get_train_metric(booster))
+        dataset_sizes.append(get_memory_usage(booster)['dataset']['current'])
+        LIB.LGBM_BoosterFree(booster)
+        free_dataset(train)
+    # only the order of summing the gradients changes
+    assert abs(train_loglosses[1] - train_loglosses[0]) < 1e-3 * train_loglosses[0]
+    # a bit per data instead of 4 bits, unlike in binary files
+    assert dataset_sizes[1] < 0.6 * dataset_sizes[0]
+
+
+def test_booster_distributed_auc():
+    reducer_type = ctypes.CFUNCTYPE(None, ctypes.c_void_p, ctypes.c_void_p, ctypes.c_int, ctypes.c_int32)
+    reduce_scatter_type = ctypes.CFUNCTYPE(None, ctypes.c_void_p, ctypes.c_int32, ctypes.c_int,
+                                           ctypes.POINTER(ctypes.c_int32), ctypes.POINTER(ctypes.c_int32),
+                                           ctypes.c_int, ctypes.c_void_p, ctypes.c_int32, ctypes.c_void_p)
+    allgather_type = ctypes.CFUNCTYPE(None, ctypes.c_void_p, ctypes.c_int32, ctypes.POINTER(ctypes.c_int32),
+                                      ctypes.POINTER(ctypes.c_int32), ctypes.c_int, ctypes.c_void_p, ctypes.c_int32)
+    # acts as rank 0 of two machines, the other machine holds the same data
+    reduced_blocks = {}
+
+    def reduce_scatter(input, input_size, type_size, block_start, block_len, num_block, output, output_size, reducer):
+        reduce = ctypes.cast(ctypes.cast(reducer, ctypes.POINTER(ctypes.c_void_p))[0], reducer_type)
+        for i in range(num_block):
+            block = ctypes.create_string_buffer(ctypes.string_at(input + block_start[i], block_len[i]), block_len[i])
+            reduce(input + block_start[i], ctypes.addressof(block), type_size, block_len[i])
+            reduced_blocks[i] = block.raw
+        ctypes.memmove(output, reduced_blocks[0], block_len[0])
+
+    def allgather(input, input_size, block_start, block_len, num_block, output, output_size):
+        for i in range(num_block):
+            data = reduced_blocks.get(i, b'') if i > 0 else b''
+            if len(data) != block_len[i]:
+                data = ctypes.string_at(input, input_size)
+            ctypes.memmove(output + block_start[i], data, block_len[i])
+        reduced_blocks.clear()
+
+    reduce_scatter_fun = reduce_scatter_type(reduce_scatter)
+    allgather_fun = allgather_type(allgather)
+
+    train = load_from_file(os.path.join(os.path.dirname(os.path.realpath(__file__)),
+                                        '../../examples/binary_classification/binary.train'), None)
+    num_data = ctypes.c_int(0)
+    LIB.LGBM_DatasetGetNumData(train, ctypes.byref(num_data))
+    label = ctypes.POINTER(ctypes.c_float)()
+    out_len = ctypes.c_int(0)
+    out_type = ctypes.c_int(0)
+    LIB.LGBM_DatasetGetField(train, c_str('label'), ctypes.byref(out_len), ctypes.byref(label),
+                             ctypes.byref(out_type))
+    labels = np.ctypeslib.as_array(label, shape=(num_data.value,))
+    # a few huge scores must not collapse the bins of the others
+    init_score = np.random.RandomState(0).normal(labels, 1.0)
+    init_score[0] = np.inf
+    init_score[1] = -np.inf
+    init_score[2] = 1e300
+    LIB.LGBM_DatasetSetField(train, c_str('init_score'), init_score.ctypes.data_as(ctypes.c_void_p),
+                             num_data.value, dtype_float64)
+    aucs = []
+    for num_machines in (1, 2):
+        if num_machines > 1:
+            assert LIB.LGBM_NetworkInitWithFunctions(num_machines, 0, reduce_scatter_fun, allgather_fun) == 0
+        booster = ctypes.c_void_p()
+        LIB.LGBM_BoosterCreate(
+            train,
+            c_str("app=binary metric=auc tree_learner=data num_machines=%d verbose=-1" % num_machines),
+            ctypes.byref(booster))
+        result = np.array([0.0], dtype=np.float64)
+        LIB.LGBM_BoosterGetEval(
+            booster,
+            0,
+            ctypes.byref(out_len),
+            result.ctypes.data_as(ctypes.POINTER(ctypes.c_double)))
+        aucs.append(result[0])
+        LIB.LGBM_BoosterFree(booster)
+        if num_machines > 1:
+            LIB.LGBM_NetworkFree()
+    free_dataset(train)
+    # the distributed AUC only loses the order of scores within a bin
+    assert abs(aucs[1] - aucs[0]) < 1e-3